@@ -0,0 +1,122 @@
+/**
+  * @file activity_registry_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief ActivityRegistry dispatch benchmark.
+  *
+  */
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <vector>
+
+#include <tsw/metadata.h>
+
+#include <impl/activity_registry.h>
+
+#include <gtest/gtest.h>
+
+
+typedef std::function<bool(int&)> TestHandler;
+typedef tsw::impl::ActivityRegistry<TestHandler> TestRegistry;
+
+
+static bool increment(int &counter) { ++counter; return true; }
+
+
+static tsw::EAMetadataList make_metadata(size_t count, size_t first = 0)
+{
+    tsw::EAMetadataList result;
+
+    for (size_t i = first; i < first + count; ++i)
+    {
+        result.emplace_back("activity_" + std::to_string(i), nullptr, "", tsw::FieldUIDFieldHeaderMap());
+    }
+
+    return result;
+}
+
+
+static void run_handlers(const TestRegistry &registry, tsw::UID module_uid, const tsw::String &name, int &counter)
+{
+    auto handlers = registry.get_handlers(module_uid, name);
+
+    if (!handlers) return;
+
+    for (const auto &handler: *handlers) handler(counter);
+}
+
+
+TEST(ActivityRegistry, Benchmark)
+{
+    const size_t modules_count = 10;
+    const size_t activities_count = 1000;
+    const size_t dispatches = 100000;
+    TestRegistry registry;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t m = 0; m < modules_count; ++m)
+    {
+        registry.append(m, make_metadata(activities_count));
+        for (size_t a = 0; a < activities_count; ++a)
+        {
+            registry.add_handler(m, "activity_" + std::to_string(a), increment);
+        }
+    }
+
+    auto registration_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(registry.size(), modules_count * activities_count);
+
+    std::vector<tsw::String> names;
+
+    for (size_t a = 0; a < activities_count; ++a) names.push_back("activity_" + std::to_string(a));
+
+    int counter = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < dispatches; ++i)
+    {
+        run_handlers(registry, i % modules_count, names[i % activities_count], counter);
+    }
+
+    auto registry_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(counter, static_cast<int>(dispatches));
+
+    // Previous storage: activity with its handlers was copied on every dispatch.
+    struct ActivityData
+    {
+        tsw::EAMetadata metadata;
+        std::list<TestHandler> handlers;
+    };
+
+    std::map<tsw::UID, std::map<tsw::String, ActivityData>> copied;
+
+    for (size_t m = 0; m < modules_count; ++m)
+    {
+        for (const auto &metadata: make_metadata(activities_count))
+        {
+            copied[m].emplace(metadata.get_name(), ActivityData{ metadata, { increment } });
+        }
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < dispatches; ++i)
+    {
+        auto activity = copied[i % modules_count].at(names[i % activities_count]);
+
+        for (auto handler: activity.handlers) handler(counter);
+    }
+
+    auto copy_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(counter, static_cast<int>(2 * dispatches));
+
+    std::cout << modules_count * activities_count << " activities: registration " << registration_time * 1000 << " ms, "
+              << "dispatch " << dispatches / registry_time << " /s, with copying " << dispatches / copy_time << " /s"
+              << std::endl;
+}
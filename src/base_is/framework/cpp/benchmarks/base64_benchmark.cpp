@@ -0,0 +1,50 @@
+/**
+  * @file base64_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief BASE64 engines benchmark.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+
+#include <tsw/base64.h>
+
+#include <gtest/gtest.h>
+
+
+TEST(Base64, Benchmark)
+{
+    const size_t iterations = 20;
+    const tsw::BinData data(4 * 1024 * 1024, 0x5a);
+    const tsw::String default_engine = tsw::base64_engine();
+
+    for (const auto &engine: tsw::base64_engines())
+    {
+        tsw::set_base64_engine(engine);
+
+        tsw::String text;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) text = tsw::to_base64_no_lb(data);
+        auto encode_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        const auto text_lb = tsw::to_base64(data);
+        tsw::BinData decoded;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) decoded = tsw::from_base64(text);
+        auto decode_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) decoded = tsw::from_base64(text_lb);
+        auto decode_lb_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        EXPECT_EQ(decoded, data);
+
+        const double gbytes = static_cast<double>(iterations * data.size()) / 1e9;
+        std::cout << engine << ": encode " << gbytes / encode_time.count() << " GB/s, decode "
+                  << gbytes / decode_time.count() << " GB/s, decode with line breaks "
+                  << gbytes / decode_lb_time.count() << " GB/s" << std::endl;
+    }
+
+    tsw::set_base64_engine(default_engine);
+}
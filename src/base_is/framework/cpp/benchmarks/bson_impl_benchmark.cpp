@@ -0,0 +1,63 @@
+/**
+  * @file bson_impl_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief BSON arrays decoding benchmarks.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+
+#include <impl/bson_impl.h>
+
+#include <gtest/gtest.h>
+
+
+TEST(BsonImpl, LargeNumericArrayBenchmark)
+{
+    const size_t samples_count = 100000;
+    const size_t iterations = 20;
+    tsw::impl::BsonSerializerImpl bson_simpl;
+    tsw::impl::BsonDeserializerImpl bson_dsimpl;
+    tsw::ValueArray samples;
+
+    samples.reserve(samples_count);
+    for (size_t i = 0; i < samples_count; ++i) samples.push_back(i * 0.5);
+
+    bson_simpl.append_field("samples", samples);
+    auto bd = bson_simpl.get_buffer();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        auto v = bson_dsimpl.Deserialize(bd.data(), bd.size());
+        ASSERT_EQ(v["samples"].as_array().size(), samples_count);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "BSON numeric array decoding: " << samples_count * iterations / elapsed.count() << " elements/s" << std::endl;
+}
+
+
+TEST(BsonImpl, PackedArrayBenchmark)
+{
+    const size_t samples_count = 100000;
+    const size_t iterations = 20;
+    tsw::impl::BsonSerializerImpl bson_simpl;
+    tsw::impl::BsonDeserializerImpl bson_dsimpl;
+    tsw::DoubleArray samples(samples_count);
+
+    for (size_t i = 0; i < samples_count; ++i) samples[i] = i * 0.5;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        bson_simpl.append_field("samples", samples);
+        auto bd = bson_simpl.take_buffer();
+        auto v = bson_dsimpl.Deserialize(bd.data(), bd.size());
+        ASSERT_EQ(v["samples"].as_double_array().size(), samples_count);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "BSON packed array round trip: " << samples_count * iterations / elapsed.count() << " elements/s" << std::endl;
+}
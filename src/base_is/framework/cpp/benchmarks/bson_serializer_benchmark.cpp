@@ -0,0 +1,46 @@
+/**
+  * @file bson_serializer_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief BSON serializer benchmark.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/message.h>
+
+#include <gtest/gtest.h>
+
+
+static tsw::NameValueMap test_fields()
+{
+    return tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("uid", tsw::Value(int64_t(54321098000l))),
+        std::make_pair("data", tsw::BinData(64, 0xaa)),
+        std::make_pair("samples", tsw::ValueArray{1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0}),
+        std::make_pair("meta", tsw::Object{std::make_pair("a", "b"), std::make_pair("enabled", true)})
+    };
+}
+
+
+TEST(BsonSerializer, Benchmark)
+{
+    const size_t iterations = 100000;
+    tsw::BsonSerializer serializer;
+    tsw::Message message(tsw::MessageType::Event, test_fields());
+    size_t total_size = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) total_size += serializer.SerializeMessage(message).size();
+    auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "BSON message serialization: " << iterations / elapsed.count() << " msg/s, "
+              << total_size / elapsed.count() / (1 << 20) << " MB/s" << std::endl;
+    EXPECT_GT(total_size, 0);
+}
@@ -0,0 +1,58 @@
+/**
+  * @file compression_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Magistral frames compression benchmark.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+
+#include <tsw/compression.h>
+#include <tsw/json_serializer.h>
+#include <tsw/message.h>
+
+#include <gtest/gtest.h>
+
+
+static tsw::Message typical_message()
+{
+    return tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("unit", "V"),
+        std::make_pair("m_time", tsw::Time(1500000000123456789)),
+        std::make_pair("description", "Sensor measurement, sensor measurement, sensor measurement"),
+        std::make_pair("samples", tsw::ValueArray(50, tsw::Object{ {"value", 1.0}, {"valid", true} }))
+    });
+}
+
+
+TEST(Compression, Benchmark)
+{
+    const size_t iterations = 20000;
+    auto data = tsw::JsonSerializer(tsw::JsonStyle::Compact).SerializeMessage(typical_message());
+
+    for (auto compression: tsw::supported_compressions())
+    {
+        tsw::FrameCompressor compressor(compression);
+        tsw::BinData frame;
+        tsw::BinData result;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) compressor.compress(data, frame);
+        auto compress_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) compressor.decompress(frame.data(), frame.size(), result);
+        auto decompress_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        EXPECT_EQ(result, data);
+
+        std::cout << tsw::compression_name(compression) << ": " << data.size() << " -> " << frame.size()
+                  << " bytes, compress " << iterations / compress_time.count() << " frames/s, decompress "
+                  << iterations / decompress_time.count() << " frames/s" << std::endl;
+    }
+}
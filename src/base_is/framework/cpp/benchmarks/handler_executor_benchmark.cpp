@@ -0,0 +1,75 @@
+/**
+  * @file handler_executor_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief HandlerExecutor benchmark: sequential and joined handlers.
+  *
+  */
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <impl/handler_executor.h>
+#include <impl/thread_pool.h>
+
+#include <gtest/gtest.h>
+
+
+typedef std::function<void(std::atomic<int>&)> TestHandler;
+typedef tsw::impl::Subscription<TestHandler> TestSubscription;
+typedef std::vector<TestSubscription> TestHandlers;
+
+
+static std::shared_ptr<const TestHandlers> make_handlers(size_t count, TestHandler handler)
+{
+    TestHandlers result;
+
+    // Every subscription has own state, as the subscribed ones.
+    for (size_t i = 0; i < count; ++i) result.emplace_back(handler);
+
+    return std::make_shared<const TestHandlers>(std::move(result));
+}
+
+
+static std::chrono::milliseconds run_handlers(tsw::impl::HandlerExecutor &executor,
+                                              const std::shared_ptr<const TestHandlers> &handlers,
+                                              std::atomic<int> &counter)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    executor.run(handlers, [&counter](const TestHandler &handler) { handler(counter); });
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+
+TEST(HandlerExecutor, Benchmark)
+{
+    const size_t subscribers = 16;
+    const auto work = std::chrono::milliseconds(5);
+    std::atomic<int> counter(0);
+    auto handlers = make_handlers(subscribers, [work](std::atomic<int> &counter)
+    {
+        std::this_thread::sleep_for(work);
+        ++counter;
+    });
+
+    tsw::impl::HandlerExecutor executor;
+    auto sequential = run_handlers(executor, handlers, counter);
+
+    tsw::HandlerExecutionPolicy policy;
+
+    policy.execution = tsw::HandlerExecution::Join;
+    executor.set_policy(policy);
+
+    auto joined = run_handlers(executor, handlers, counter);
+
+    EXPECT_EQ(counter, static_cast<int>(2 * subscribers));
+    EXPECT_LT(joined, sequential);
+
+    std::cout << subscribers << " subscribers: sequential " << sequential.count() << " ms, joined on "
+              << tsw::impl::ThreadPool::shared()->size() << " threads " << joined.count() << " ms" << std::endl;
+}
@@ -0,0 +1,120 @@
+/**
+  * @file json_impl_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief JSON strings recognition and SAX deserializer benchmarks.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <vector>
+
+#include <tsw/base64.h>
+
+#include <impl/json_impl.h>
+
+#include <gtest/gtest.h>
+
+
+TEST(JsonImpl, StringsBenchmark)
+{
+    // Reference: regular expressions, which were used for the recognition.
+    const std::regex base64_regex(R"((?:[A-Za-z0-9+/]{4}|\n|(?:\r\n))*(?:[A-Za-z0-9+/]{2}==|[A-Za-z0-9+/]{3}=)?)");
+    const std::regex time_regex(R"_(^P?(?:(\d+)[Y-]{1})(?:(\d+)[M-]{1})(?:(\d+)D?)T(?:(\d+)[H:]{1})(?:(\d+)[M:]{1})(?:(\d+)S?)(?:\.(\d+))Z$)_");
+    const size_t iterations = 200;
+    const size_t prefix_size = sizeof(tsw::base64_prefix);
+
+    std::vector<tsw::String> strings
+    {
+        "sensor_event", "Sensor measurement with the long description, which is usual for the modules metadata",
+        "2017-10-01T18:52:23.123456789Z", tsw::to_base64_no_lb(tsw::BinData(300, 0x55)),
+        tsw::to_base64(tsw::BinData(300, 0xaa)), "BASE64:\nnot base64 data", "V"
+    };
+
+    size_t matches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        for (const auto &s: strings)
+        {
+            std::smatch time_matches;
+            matches += s.compare(0, prefix_size, reinterpret_cast<const char*>(tsw::base64_prefix), prefix_size) == 0 &&
+                       std::regex_match(s.begin() + prefix_size, s.end(), base64_regex);
+            matches += std::regex_search(s, time_matches, time_regex);
+        }
+    }
+    auto regex_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    size_t recognized = 0;
+    tsw::Time t;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        for (const auto &s: strings)
+        {
+            recognized += tsw::is_base64(s);
+            recognized += tsw::impl::JsonDeserializerImpl::parse_time(s.c_str(), s.size(), t);
+        }
+    }
+    auto parser_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(recognized, matches);
+    EXPECT_EQ(recognized, 3 * iterations);
+
+    std::cout << "Strings recognition: regex " << regex_time.count() << " s, parsers " << parser_time.count()
+              << " s, speedup " << regex_time.count() / parser_time.count() << std::endl;
+}
+
+
+TEST(JsonImpl, SaxBenchmark)
+{
+    const size_t iterations = 20;
+    tsw::impl::JsonSerializerImpl json_simpl(false);
+    tsw::ValueArray events;
+
+    // Large module description.
+    for (int i = 0; i < 2000; ++i)
+    {
+        events.push_back(tsw::Object{ {"name", "event_" + std::to_string(i)},
+                                      {"description", "Event description, which is long enough for the test"},
+                                      {"fields", tsw::ValueArray{ tsw::Object{ {"name", "value"}, {"type", "double"} },
+                                                                  tsw::Object{ {"name", "m_time"}, {"type", "time"} } }},
+                                      {"counter", i}, {"weight", 0.5 * i} });
+    }
+
+    json_simpl.append_field("events", events);
+    const auto data = json_simpl.take_buffer();
+
+    tsw::impl::JsonDeserializerImpl json_dsimpl;
+    tsw::NameValueMap result;
+
+    // Former implementation built the DOM first: the DOM parsing alone is a lower bound of its time.
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        rapidjson::Document doc;
+        doc.Parse<rapidjson::kParseStopWhenDoneFlag>(reinterpret_cast<const char*>(data.data()), data.size());
+        ASSERT_TRUE(doc.IsObject());
+    }
+    auto dom_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) result = json_dsimpl.Deserialize(data.data(), data.size());
+    auto sax_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    double insitu_time = 0;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        auto buffer = data;
+
+        start = std::chrono::steady_clock::now();
+        result = json_dsimpl.DeserializeInsitu(buffer);
+        insitu_time += std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    EXPECT_EQ(result["events"], tsw::Value(events));
+
+    std::cout << data.size() << " bytes: DOM only " << dom_time.count() / iterations << " s, SAX to Value "
+              << sax_time.count() / iterations << " s, in situ " << insitu_time / iterations << " s" << std::endl;
+}
@@ -0,0 +1,48 @@
+/**
+  * @file json_serializer_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief JSON serializer benchmark.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+
+#include <tsw/json_serializer.h>
+#include <tsw/message.h>
+
+#include <gtest/gtest.h>
+
+
+static tsw::Message test_message()
+{
+    return tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("m_time", tsw::Time(1500000000123456789)),
+        std::make_pair("raw", tsw::BinData{0x00, 0x01, 0xff}),
+        std::make_pair("nested", tsw::Object{ {"a", tsw::ValueArray{1, "two", true}} })
+    });
+}
+
+
+TEST(JsonSerializer, Benchmark)
+{
+    const size_t iterations = 20000;
+    auto message = test_message();
+
+    for (auto style: { tsw::JsonStyle::Pretty, tsw::JsonStyle::Compact })
+    {
+        tsw::JsonSerializer serializer(style);
+        tsw::BinData buffer;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) serializer.SerializeMessageTo(message, buffer);
+        auto time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        std::cout << (tsw::JsonStyle::Pretty == style ? "pretty" : "compact") << ": " << buffer.size() << " bytes, "
+                  << iterations / time.count() << " msg/s" << std::endl;
+    }
+}
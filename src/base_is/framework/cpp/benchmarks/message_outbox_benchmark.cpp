@@ -0,0 +1,99 @@
+/**
+  * @file message_outbox_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MessageOutbox group commit benchmark.
+  *
+  */
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/message.h>
+#include <tsw/message_outbox.h>
+
+#include <gtest/gtest.h>
+
+
+// Outbox file, which is removed after the test.
+class OutboxFile
+{
+public:
+    OutboxFile() :
+        path_(std::filesystem::temp_directory_path() / ("tsw_outbox_" + std::to_string(::getpid()) + "_" +
+                                                       std::to_string(counter_++) + ".log"))
+    {
+        std::filesystem::remove(path_);
+    }
+    ~OutboxFile() { std::filesystem::remove(path_); }
+
+    const tsw::Path &path() const { return path_; }
+    size_t size() const { return std::filesystem::file_size(path_); }
+
+private:
+    static std::atomic<int> counter_;
+    tsw::Path path_;
+};
+
+std::atomic<int> OutboxFile::counter_(0);
+
+
+TEST(MessageOutbox, Benchmark)
+{
+    const size_t iterations = 2000;
+    const size_t threads_count = 4;
+    tsw::BsonSerializer serializer;
+    auto frame = serializer.SerializeMessage(tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123)
+    }));
+
+    // In-memory path: frame is copied to the send queue.
+    std::vector<tsw::BinData> queue;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; ++i) queue.push_back(frame);
+
+    auto memory_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "in-memory: " << iterations / memory_time << " frames/s" << std::endl;
+
+    for (bool sync: { false, true })
+    {
+        OutboxFile file;
+        tsw::MessageOutbox::Options options;
+
+        options.sync = sync;
+
+        tsw::MessageOutbox outbox(file.path(), options);
+        std::vector<std::thread> threads;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&]()
+            {
+                for (size_t i = 0; i < iterations / threads_count; ++i)
+                {
+                    outbox.acknowledge(outbox.append(tsw::MessageType::Event, tsw::Time::zero(), frame));
+                }
+            });
+        }
+        for (auto &thread: threads) thread.join();
+
+        auto outbox_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        EXPECT_EQ(outbox.pending_count(), 0u);
+        std::cout << "outbox" << (sync ? " with sync" : "") << ", " << threads_count << " senders: "
+                  << iterations / outbox_time << " frames/s, "
+                  << static_cast<double>(iterations) / outbox.commits_count() << " frames per commit" << std::endl;
+    }
+}
@@ -0,0 +1,94 @@
+/**
+  * @file schema_serializer_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Schema-based serializer benchmark.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/message.h>
+#include <tsw/metadata.h>
+#include <tsw/schema_deserializer.h>
+#include <tsw/schema_registry.h>
+#include <tsw/schema_serializer.h>
+
+#include <gtest/gtest.h>
+
+
+static tsw::EAMetadata sensor_event_metadata()
+{
+    return tsw::EAMetadata("sensor_event", nullptr, "Sensor measurement",
+    tsw::FieldUIDFieldHeaderMap
+    {
+        { 1, tsw::FieldHeader{ 1, tsw::ValueType::DoubleNumber, "value", 1, "Measured value" } },
+        { 2, tsw::FieldHeader{ 2, tsw::ValueType::Int32Number, "counter", 0, "Measurement number" } },
+        { 3, tsw::FieldHeader{ 3, tsw::ValueType::String, "unit", 2, "Value unit" } },
+        { 4, tsw::FieldHeader{ 4, tsw::ValueType::Time, "m_time", 3, "Measurement time" } },
+        { 5, tsw::FieldHeader{ 5, tsw::ValueType::DoubleArray, "samples", 4, "Raw samples" } }
+    });
+}
+
+
+static tsw::NameValueMap sensor_event_fields()
+{
+    return tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("unit", "V"),
+        std::make_pair("m_time", tsw::Time(1500000000123456789)),
+        std::make_pair("samples", tsw::DoubleArray{1.0, 2.0, 3.0, 4.0})
+    };
+}
+
+
+class SchemaSerializerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        registry_ = std::make_shared<tsw::SchemaRegistry>();
+        hash_ = registry_->register_scheme(tsw::MessageType::Event, sensor_event_metadata());
+        registry_->confirm_scheme(hash_);
+    }
+
+protected:
+    std::shared_ptr<tsw::SchemaRegistry> registry_;
+    uint64_t hash_;
+};
+
+
+TEST_F(SchemaSerializerTest, Benchmark)
+{
+    const size_t iterations = 100000;
+    tsw::Message message(tsw::MessageType::Event, sensor_event_fields());
+
+    auto measure = [&](tsw::Serializer &serializer, tsw::Deserializer &deserializer, const char *name)
+    {
+        tsw::BinData buffer;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            serializer.SerializeMessageTo(message, buffer);
+            deserializer.DeserializeMessage(buffer).get_fields();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        std::cout << name << ": " << buffer.size() << " bytes, " << iterations / elapsed.count() << " msg/s" << std::endl;
+    };
+
+    tsw::BsonSerializer bson_serializer;
+    tsw::BsonDeserializer bson_deserializer;
+    tsw::SchemaSerializer schema_serializer(registry_);
+    tsw::SchemaDeserializer schema_deserializer(registry_);
+
+    measure(bson_serializer, bson_deserializer, "BSON round trip");
+    measure(schema_serializer, schema_deserializer, "Schema round trip");
+}
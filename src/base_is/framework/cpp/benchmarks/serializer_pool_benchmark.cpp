@@ -0,0 +1,65 @@
+/**
+  * @file serializer_pool_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief SerializerPool benchmark: pooled serialization from the several threads.
+  *
+  */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/message.h>
+
+#include <impl/serializer_pool.h>
+
+#include <gtest/gtest.h>
+
+
+// Serialize messages from the several threads, return messages per second.
+static double serialize_in_threads(tsw::impl::SerializerPool &pool, size_t threads_count, size_t iterations)
+{
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&pool, t, iterations]()
+        {
+            tsw::Message message(tsw::MessageType::Event, tsw::NameValueMap
+            {
+                std::make_pair("thread", static_cast<int32_t>(t)),
+                std::make_pair("samples", tsw::DoubleArray(32, 0.5))
+            });
+
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                auto context = pool.acquire();
+                context->serializer->SerializeMessageTo(message, context->buffer);
+            }
+        });
+    }
+
+    for (auto &thread: threads) thread.join();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    return threads_count * iterations / elapsed.count();
+}
+
+
+TEST(SerializerPool, Benchmark)
+{
+    tsw::impl::SerializerPool pool(std::make_shared<tsw::BsonSerializer>());
+    const size_t threads_count = std::max(2u, std::thread::hardware_concurrency());
+
+    auto single_rate = serialize_in_threads(pool, 1, 50000);
+    auto multi_rate = serialize_in_threads(pool, threads_count, 50000);
+
+    std::cout << "Pooled serialization: 1 thread: " << single_rate << " msg/s, "
+              << threads_count << " threads: " << multi_rate << " msg/s" << std::endl;
+}
@@ -0,0 +1,77 @@
+/**
+  * @file typed_message_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief TSW_MESSAGE structs (de)serialization benchmark.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/typed_message.h>
+
+#include <gtest/gtest.h>
+
+
+TSW_MESSAGE(Position, (double, x), (double, y))
+
+TSW_MESSAGE(SensorEvent,
+            (int32_t, counter),
+            (int64_t, sequence),
+            (double, value),
+            (bool, valid),
+            (tsw::String, unit),
+            (tsw::Time, m_time),
+            (tsw::BinData, raw),
+            (tsw::DoubleArray, samples),
+            (tsw::Int32Array, codes),
+            (Position, position))
+
+
+static SensorEvent sensor_event()
+{
+    SensorEvent event;
+
+    event.counter = 123;
+    event.sequence = 1LL << 40;
+    event.value = 0.777;
+    event.valid = true;
+    event.unit = "V";
+    event.m_time = tsw::Time(1500000000123456789);
+    event.raw = {0x01, 0x00, 0xff};
+    event.samples = {1.0, 2.5, -3.0};
+    event.codes = {1, -2, 3};
+    event.position = Position{10.5, -20.25};
+
+    return event;
+}
+
+
+TEST(TypedMessage, Benchmark)
+{
+    const size_t iterations = 100000;
+    auto event = sensor_event();
+    tsw::BsonSerializer serializer;
+    tsw::BinData buffer;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        serializer.SerializeObject(tsw::to_object(event)).swap(buffer);
+        tsw::from_object<SensorEvent>(tsw::BsonDeserializer().DeserializeObject(buffer));
+    }
+    auto value_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        tsw::write_bson([&event](tsw::FieldWriter &writer) { tsw::write_fields(writer, event); }, buffer);
+        tsw::from_bson<SensorEvent>(buffer);
+    }
+    auto direct_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "Value round trip: " << iterations / value_time.count() << " msg/s, "
+              << "direct round trip: " << iterations / direct_time.count() << " msg/s" << std::endl;
+}
@@ -0,0 +1,101 @@
+/**
+  * @file wire_format_benchmark.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Wire formats comparison benchmark.
+  *
+  */
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <tsw/message.h>
+#include <tsw/wire_format.h>
+
+#include <gtest/gtest.h>
+
+
+// Typical bus traffic: small events, actions with the parameters, module descriptions and bulk samples.
+static std::vector<tsw::Message> messages_mix()
+{
+    std::vector<tsw::Message> result;
+
+    result.emplace_back(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("unit", "V"),
+        std::make_pair("m_time", tsw::Time(1500000000123456789))
+    });
+
+    result.emplace_back(tsw::MessageType::Action, tsw::NameValueMap
+    {
+        std::make_pair("name", "set_mode"),
+        std::make_pair("mode", "auto"),
+        std::make_pair("timeout", int64_t(5000)),
+        std::make_pair("force", false)
+    });
+
+    result.emplace_back(tsw::MessageType::IntegrateModule, tsw::NameValueMap
+    {
+        std::make_pair("name", "module_description"),
+        std::make_pair("events", tsw::ValueArray
+        {
+            tsw::Object{ {"name", "sensor_event"}, {"description", "Sensor measurement"}, {"fields_count", 5} },
+            tsw::Object{ {"name", "alarm"}, {"description", "Sensor alarm"}, {"fields_count", 2} }
+        }),
+        std::make_pair("actions", tsw::ValueArray
+        {
+            tsw::Object{ {"name", "set_mode"}, {"description", "Set sensor mode"}, {"fields_count", 3} }
+        })
+    });
+
+    result.emplace_back(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "samples_event"),
+        std::make_pair("samples", tsw::DoubleArray(1000, 0.5)),
+        std::make_pair("raw", tsw::BinData(512, 0x55))
+    });
+
+    return result;
+}
+
+
+TEST(WireFormat, Benchmark)
+{
+    const size_t iterations = 20000;
+    auto messages = messages_mix();
+
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor, tsw::WireFormat::Envelope })
+    {
+        auto serializer = tsw::make_serializer(format);
+        auto deserializer = tsw::make_deserializer(format);
+        std::vector<tsw::BinData> buffers(messages.size());
+        size_t total_size = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            for (size_t m = 0; m < messages.size(); ++m) serializer->SerializeMessageTo(messages[m], buffers[m]);
+        }
+        auto encode_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            for (const auto &buffer: buffers) deserializer->DeserializeMessage(buffer).get_fields();
+        }
+        auto decode_time = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        for (size_t m = 0; m < messages.size(); ++m)
+        {
+            EXPECT_EQ(deserializer->DeserializeMessage(buffers[m]).get_fields(), messages[m].get_fields());
+            total_size += buffers[m].size();
+        }
+
+        std::cout << tsw::wire_format_name(format) << ": " << total_size << " bytes per mix, encode "
+                  << iterations * messages.size() / encode_time.count() << " msg/s, decode "
+                  << iterations * messages.size() / decode_time.count() << " msg/s" << std::endl;
+    }
+}
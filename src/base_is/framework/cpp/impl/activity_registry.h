@@ -0,0 +1,191 @@
+/**
+  * @file activity_registry.h
+  * @author Artiom N.(cl)2017
+  * @brief ActivityRegistry class: metadata and handlers of the modules activities.
+  *
+  */
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "tsw/metadata.h"
+#include "tsw/types.h"
+
+#include "functional_helper.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Hash-indexed registry of the activities (events or actions) by the module UID and the activity name.
+ *
+ * Readers take snapshots: they don't lock the registry and don't copy the activities or the handlers.
+ * Writers are serialized by the mutex and replace the changed parts atomically (copy on write):
+ * - announce and denounce copy the index of the module and the module list (pointers only);
+ * - handler subscription copies the handler list of the activity only.
+ * Snapshot, which is taken by a reader, lives until the reader releases it.
+ */
+template<typename HandlerType>
+class ActivityRegistry
+{
+public:
+    typedef std::vector<HandlerType> HandlerList;
+
+    struct Activity
+    {
+        explicit Activity(const EAMetadata &m) : metadata(m), handlers(std::make_shared<const HandlerList>()) {}
+
+        const EAMetadata metadata;
+        // Replaced atomically: running handlers keep the list, which they were called from.
+        std::shared_ptr<const HandlerList> handlers;
+    };
+
+    typedef std::unordered_map<String, std::shared_ptr<Activity>> ModuleActivities;
+
+public:
+    ActivityRegistry() : modules_(std::make_shared<const Modules>()) {}
+
+public:
+    /**
+     * @brief Add activities of the module. Announced activity keeps its metadata and handlers.
+     */
+    void append(UID module_uid, const EAMetadataList &metadata)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex_);
+        auto activities = copy_module(module_uid);
+
+        for (const auto &m: metadata)
+        {
+            if (activities->find(m.get_name()) == activities->end())
+            {
+                activities->emplace(m.get_name(), std::make_shared<Activity>(m));
+            }
+        }
+
+        replace_module(module_uid, std::move(activities));
+    }
+
+    void remove(UID module_uid, const StringList &names)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex_);
+        auto activities = copy_module(module_uid);
+
+        for (const auto &name: names) activities->erase(name);
+
+        replace_module(module_uid, std::move(activities));
+    }
+
+    /**
+     * @brief Subscribe the handler to the activity.
+     * @return false, if activity isn't announced.
+     */
+    bool add_handler(UID module_uid, const String &activity_name, const HandlerType &handler)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex_);
+        auto activity = find(module_uid, activity_name);
+
+        if (!activity) return false;
+
+        auto handlers = std::make_shared<HandlerList>(*std::atomic_load(&activity->handlers));
+
+        handlers->push_back(handler);
+        std::atomic_store(&activity->handlers, std::shared_ptr<const HandlerList>(std::move(handlers)));
+
+        return true;
+    }
+
+    void remove_handler(UID module_uid, const String &activity_name, const HandlerType &handler)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex_);
+        auto activity = find(module_uid, activity_name);
+
+        if (!activity) return;
+
+        auto handlers = std::make_shared<HandlerList>(*std::atomic_load(&activity->handlers));
+
+        handlers->erase(std::remove_if(handlers->begin(), handlers->end(),
+                                       [&handler](const HandlerType &h) { return h == handler; }), handlers->end());
+        std::atomic_store(&activity->handlers, std::shared_ptr<const HandlerList>(std::move(handlers)));
+    }
+
+    /**
+     * @brief Return snapshot of the activity handlers or nullptr, if activity isn't announced.
+     */
+    std::shared_ptr<const HandlerList> get_handlers(UID module_uid, const String &activity_name) const
+    {
+        auto activity = find(module_uid, activity_name);
+
+        return activity ? std::atomic_load(&activity->handlers) : nullptr;
+    }
+
+    /**
+     * @brief Return snapshot of the module activities or nullptr, if module has no activities.
+     */
+    std::shared_ptr<const ModuleActivities> get_module(UID module_uid) const
+    {
+        auto modules = std::atomic_load(&modules_);
+        auto module = modules->find(module_uid);
+
+        return module != modules->end() ? module->second : nullptr;
+    }
+
+    size_t size() const
+    {
+        size_t result = 0;
+
+        for (const auto &module: *std::atomic_load(&modules_)) result += module.second->size();
+
+        return result;
+    }
+
+private:
+    typedef std::unordered_map<UID, std::shared_ptr<const ModuleActivities>> Modules;
+
+private:
+    std::shared_ptr<Activity> find(UID module_uid, const String &activity_name) const
+    {
+        auto module = get_module(module_uid);
+
+        if (!module) return nullptr;
+
+        auto activity = module->find(activity_name);
+
+        return activity != module->end() ? activity->second : nullptr;
+    }
+
+    // Mutex must be locked.
+    std::shared_ptr<ModuleActivities> copy_module(UID module_uid) const
+    {
+        auto module = get_module(module_uid);
+
+        return module ? std::make_shared<ModuleActivities>(*module) : std::make_shared<ModuleActivities>();
+    }
+
+    // Mutex must be locked.
+    void replace_module(UID module_uid, std::shared_ptr<ModuleActivities> &&activities)
+    {
+        auto modules = std::make_shared<Modules>(*std::atomic_load(&modules_));
+
+        if (activities->empty()) modules->erase(module_uid);
+        else (*modules)[module_uid] = std::move(activities);
+
+        std::atomic_store(&modules_, std::shared_ptr<const Modules>(std::move(modules)));
+    }
+
+private:
+    std::shared_ptr<const Modules>  modules_;
+    std::mutex                      update_mutex_;
+};
+
+} // namespace impl
+
+} // namespace tsw
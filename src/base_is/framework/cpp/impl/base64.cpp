@@ -4,126 +4,323 @@
   * @brief Base64 routines implementation.
   *
   */
-#include <iostream>
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
-#include <iterator>
-#include <regex>
-
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/insert_linebreaks.hpp>
-#include <boost/archive/iterators/remove_whitespace.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
 
 #include <tsw/base64.h>
 #include <tsw/error.h>
 #include <tsw/types.h>
 
+#include "base64_simd.h"
+
 
 namespace tsw
 {
 
+class Base64Exception : public Exception
+{
+public:
+    using Exception::Exception;
+};
+
+
 static constexpr size_t line_break_length = 72;
+// Input bytes, which are encoded into the one line.
+static constexpr size_t line_data_length = line_break_length / 4 * 3;
 // String length.
 static constexpr size_t base64_prefix_size = sizeof(base64_prefix);
-static const std::regex base64_regex(R"((?:[A-Za-z0-9+/]{4}|\n|(?:\r\n))*(?:[A-Za-z0-9+/]{2}==|[A-Za-z0-9+/]{3}=)?)",
-                                     std::regex::ECMAScript );
 
+static const char encode_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-bool is_base64(const uint8_t* data, size_t size)
+// Characters to 6-bit values.
+static constexpr uint8_t invalid_char = 0xff;
+static constexpr uint8_t space_char = 0xfe;
+
+struct DecodeTable
 {
-    using namespace boost::archive::iterators;
+    uint8_t values[256];
 
-    if (size < base64_prefix_size || memcmp(base64_prefix, data, base64_prefix_size)) return false;
-    /*
-    size_t spaces_count = 0;
-    for (size_t i = 0; i < size; ++i)
+    constexpr DecodeTable() : values()
     {
-        if (data[i] == ' ') ++spaces_count;
+        for (auto &v: values) v = invalid_char;
+        for (int i = 0; i < 64; ++i) values[static_cast<uint8_t>(encode_table[i])] = static_cast<uint8_t>(i);
+        // Same, as the isspace().
+        for (auto c: {' ', '\t', '\n', '\v', '\f', '\r'}) values[static_cast<uint8_t>(c)] = space_char;
     }
+};
+
+static constexpr DecodeTable decode_table;
+
+
+//----------------------------------------------------------------------------
+// Codec engines
+//----------------------------------------------------------------------------
 
-    if ((size - spaces_count - base64_prefix_size) % 4 != 0) return false;*/
+static size_t encode_scalar(const uint8_t *src, size_t size, char *dst)
+{
+    const size_t done = size / 3 * 3;
+
+    for (const uint8_t *src_end = src + done; src != src_end; src += 3, dst += 4)
+    {
+        const uint32_t triple = (static_cast<uint32_t>(src[0]) << 16) | (src[1] << 8) | src[2];
 
-    const auto *data_start = data + base64_prefix_size;
-    const auto *data_end = data_start + size - base64_prefix_size;
+        dst[0] = encode_table[triple >> 18];
+        dst[1] = encode_table[(triple >> 12) & 0x3f];
+        dst[2] = encode_table[(triple >> 6) & 0x3f];
+        dst[3] = encode_table[triple & 0x3f];
+    }
 
-    return std::regex_match(reinterpret_cast<const char*>(data_start),
-                            reinterpret_cast<const char*>(data_end), base64_regex);
+    return done;
 }
 
 
-using namespace boost::archive::iterators;
-// Convert binary values to base64 characters.
-typedef base64_from_binary<transform_width<const tsw::BinData::value_type*, 6, 8>> base_64_text_without_lb;
+static size_t decode_scalar(const char *, size_t, uint8_t *)
+{
+    // Groups are decoded by the common loop.
+    return 0;
+}
 
 
-template<typename Converter>
-String to_base64_converter(const uint8_t* data, size_t size)
+static bool scalar_supported()
 {
-    String result(base64_prefix, base64_prefix + base64_prefix_size);
+    return true;
+}
+
+
+static const impl::Base64Engine scalar_engine{"scalar", encode_scalar, decode_scalar, scalar_supported};
 
-    std::copy(
-       Converter(data),
-       Converter(data + size),
-       std::back_inserter(result)
-    );
+
+static const impl::Base64Engine *detect_engine()
+{
+    for (auto engine = impl::base64_simd_engines(); *engine; ++engine)
+    {
+        if ((*engine)->supported()) return *engine;
+    }
+
+    return &scalar_engine;
+}
+
+
+static std::atomic<const impl::Base64Engine*> &current_engine()
+{
+    static std::atomic<const impl::Base64Engine*> engine(detect_engine());
+
+    return engine;
+}
+
+
+const char *base64_engine()
+{
+    return current_engine().load(std::memory_order_relaxed)->name;
+}
+
+
+std::vector<String> base64_engines()
+{
+    std::vector<String> result;
+
+    for (auto engine = impl::base64_simd_engines(); *engine; ++engine)
+    {
+        if ((*engine)->supported()) result.emplace_back((*engine)->name);
+    }
+    result.emplace_back(scalar_engine.name);
 
     return result;
 }
 
 
-inline void fill_result(size_t rs, String &result)
+bool set_base64_engine(const String &name)
 {
-    while (rs++ % 4)
+    for (auto engine = impl::base64_simd_engines(); *engine; ++engine)
     {
-        result.push_back('=');
+        if (name == (*engine)->name && (*engine)->supported())
+        {
+            current_engine() = *engine;
+            return true;
+        }
     }
+
+    if (name != scalar_engine.name) return false;
+    current_engine() = &scalar_engine;
+
+    return true;
+}
+
+
+static inline bool is_base64_char(uint8_t c)
+{
+    return decode_table.values[c] < 64;
+}
+
+
+// Body is a sequence of the 4 characters groups and line breaks, last group may be padded.
+bool is_base64(const uint8_t* data, size_t size)
+{
+    if (size < base64_prefix_size || memcmp(base64_prefix, data, base64_prefix_size)) return false;
+
+    const uint8_t *p = data + base64_prefix_size;
+    const uint8_t *data_end = data + size;
+    size_t group_size = 0;
+
+    for (; p != data_end; ++p)
+    {
+        if (is_base64_char(*p))
+        {
+            group_size = (group_size + 1) & 3;
+            continue;
+        }
+
+        // Groups are not split.
+        if (group_size) break;
+
+        if ('\n' == *p) continue;
+        if ('\r' == *p && p + 1 != data_end && '\n' == p[1])
+        {
+            ++p;
+            continue;
+        }
+
+        return false;
+    }
+
+    if (p == data_end) return 0 == group_size;
+
+    // Padding: "xx==" or "xxx=" at the end.
+    if ('=' != *p || group_size < 2) return false;
+    if (2 == group_size && (++p == data_end || '=' != *p)) return false;
+
+    return p + 1 == data_end;
+}
+
+
+// Encode data with the padding.
+static char *encode(const impl::Base64Engine &engine, const uint8_t *data, size_t size, char *dst)
+{
+    const size_t done = engine.encode(data, size, dst);
+
+    dst += done / 3 * 4;
+    dst += encode_scalar(data + done, size - done, dst) / 3 * 4;
+
+    const size_t tail_start = size / 3 * 3;
+
+    if (tail_start == size) return dst;
+
+    const uint32_t first = data[tail_start];
+    const uint32_t second = tail_start + 1 < size ? data[tail_start + 1] : 0;
+
+    *dst++ = encode_table[first >> 2];
+    *dst++ = encode_table[((first & 0x03) << 4) | (second >> 4)];
+    *dst++ = tail_start + 1 < size ? encode_table[(second & 0x0f) << 2] : '=';
+    *dst++ = '=';
+
+    return dst;
+}
+
+
+static inline size_t encoded_size(size_t size)
+{
+    return (size + 2) / 3 * 4;
 }
 
 
 String to_base64(const uint8_t* data, size_t size)
 {
-    // Insert line breaks every line_break_length characters.
-    typedef insert_linebreaks<base_64_text_without_lb, line_break_length> base64_text;
+    const auto &engine = *current_engine().load(std::memory_order_relaxed);
+    const size_t text_size = encoded_size(size);
+    // Line break is inserted between the lines: the last one doesn't end with it.
+    const size_t breaks_count = text_size ? (text_size - 1) / line_break_length : 0;
+    String result(base64_prefix_size + text_size + breaks_count, '\n');
+    char *dst = &result[base64_prefix_size];
 
-    String result = std::move(to_base64_converter<base64_text>(data, size));
+    std::copy(base64_prefix, base64_prefix + base64_prefix_size, result.begin());
 
-    fill_result(result.size() - base64_prefix_size - result.size() / line_break_length, result);
+    for (size_t offset = 0; offset < size; offset += line_data_length)
+    {
+        // Line break is already in the string.
+        if (offset) ++dst;
+        dst = encode(engine, data + offset, std::min(line_data_length, size - offset), dst);
+    }
 
-    return std::move(result);
+    return result;
 }
 
 
 String to_base64_no_lb(const uint8_t* data, size_t size)
 {
-    String result = std::move(to_base64_converter<base_64_text_without_lb>(data, size));
+    String result(base64_prefix_size + encoded_size(size), '\0');
 
-    fill_result(result.size() - base64_prefix_size, result);
+    std::copy(base64_prefix, base64_prefix + base64_prefix_size, result.begin());
+    encode(*current_engine().load(std::memory_order_relaxed), data, size, &result[base64_prefix_size]);
 
-    return std::move(result);
+    return result;
 }
 
 
+// Decoding stops on the first padding character, whitespaces are skipped.
 BinData from_base64(const char* data, size_t size)
 {
-    using namespace boost::archive::iterators;
-    BinData result;
+    const auto &engine = *current_engine().load(std::memory_order_relaxed);
+    const char *data_end = static_cast<const char*>(memchr(data, '=', size));
+    const char *p = ::memcmp(reinterpret_cast<const char*>(base64_prefix), data,
+                             std::min(base64_prefix_size, size)) == 0 ? data + base64_prefix_size : data;
 
-    typedef transform_width<binary_from_base64<remove_whitespace<const char*>>, 8, 6> bin_base64;
+    if (!data_end) data_end = data + size;
+    if (p > data_end) p = data_end;
 
-    const char *data_end = static_cast<const char*>(memchr(data, '=', size));
-    const char *data_start = ::memcmp(reinterpret_cast<const char*>(base64_prefix), data,
-                                      std::min(base64_prefix_size, size)) == 0 ? data + base64_prefix_size : data;
+    BinData result((data_end - p) / 4 * 3 + 3);
+    uint8_t *dst = result.data();
+    uint32_t group = 0;
+    size_t group_size = 0;
 
-    if (!data_end) data_end = data_start + size;
+    while (p != data_end)
+    {
+        // Vectorized decoding works on the whole groups.
+        const size_t done = engine.decode(p, data_end - p, dst);
+
+        p += done;
+        dst += done / 4 * 3;
+
+        // Scalar decoding: through the next whitespace and up to the group end.
+        for (bool space_found = false; p != data_end && (!space_found || group_size); ++p)
+        {
+            const uint8_t value = decode_table.values[static_cast<uint8_t>(*p)];
+
+            if (space_char == value)
+            {
+                space_found = true;
+                continue;
+            }
+
+            if (invalid_char == value) TSW_THROW(Base64Exception, "attempt to decode a value not in base64 char set");
+
+            group = (group << 6) | value;
+            if (4 == ++group_size)
+            {
+                *dst++ = static_cast<uint8_t>(group >> 16);
+                *dst++ = static_cast<uint8_t>(group >> 8);
+                *dst++ = static_cast<uint8_t>(group);
+                group_size = 0;
+            }
+        }
+    }
+
+    // Incomplete group: bits, which don't form a byte, are dropped.
+    switch (group_size)
+    {
+        case 1:
+            TSW_THROW(Base64Exception, "incomplete base64 group");
+        case 2:
+            *dst++ = static_cast<uint8_t>(group >> 4);
+        break;
+        case 3:
+            *dst++ = static_cast<uint8_t>(group >> 10);
+            *dst++ = static_cast<uint8_t>(group >> 2);
+        break;
+    }
 
-    std::copy(
-       bin_base64(data_start),
-       bin_base64(data_end),
-       std::back_inserter(result)
-    );
+    result.resize(dst - result.data());
 
     return result;
 }
@@ -0,0 +1,402 @@
+/**
+  * @file base64_simd.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Vectorized BASE64 kernels: AVX2 and SSE4.1 with the runtime dispatching, NEON on AArch64.
+  *
+  * Algorithms are from W. Mula and D. Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+  */
+
+#include <cstring>
+
+#include "base64_simd.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#   define TSW_BASE64_X86
+#   include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#   define TSW_BASE64_NEON
+#   include <arm_neon.h>
+#endif
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+#if defined(TSW_BASE64_X86)
+
+//----------------------------------------------------------------------------
+// SSE4.1
+//----------------------------------------------------------------------------
+
+// 12 bytes to 16 6-bit indices, every 3 bytes are spread into 4 bytes.
+__attribute__((target("sse4.1")))
+static inline __m128i encode_reshuffle(__m128i in)
+{
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+    return _mm_or_si128(t1, t3);
+}
+
+
+// Indices to the alphabet characters: the offset is chosen by the index range.
+__attribute__((target("sse4.1")))
+static inline __m128i encode_translate(__m128i in)
+{
+    const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                            '/' - 63, 'A', 0, 0);
+    __m128i result = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), in);
+
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, result), in);
+}
+
+
+// Characters to 6-bit values. Mask has the set bits for the non-alphabet characters.
+__attribute__((target("sse4.1")))
+static inline __m128i decode_translate(__m128i in, int &error_mask)
+{
+    const __m128i higher_nibble = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    const __m128i lower_nibble = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+    const __m128i shift_lut = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_lut = _mm_setr_epi8(static_cast<char>(0xa8),
+                                           static_cast<char>(0xf8), static_cast<char>(0xf8), static_cast<char>(0xf8),
+                                           static_cast<char>(0xf8), static_cast<char>(0xf8), static_cast<char>(0xf8),
+                                           static_cast<char>(0xf8), static_cast<char>(0xf8), static_cast<char>(0xf8),
+                                           static_cast<char>(0xf0), 0x54, 0x50, 0x50, 0x50, 0x54);
+    const __m128i bitpos_lut = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80),
+                                             0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m128i shift = _mm_blendv_epi8(_mm_shuffle_epi8(shift_lut, higher_nibble), _mm_set1_epi8(16),
+                                          _mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f)));
+    const __m128i mask = _mm_shuffle_epi8(mask_lut, lower_nibble);
+    const __m128i bit = _mm_shuffle_epi8(bitpos_lut, higher_nibble);
+
+    error_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(mask, bit), _mm_setzero_si128()));
+
+    return _mm_add_epi8(in, shift);
+}
+
+
+// 16 6-bit values to 12 bytes in the low part of the register.
+__attribute__((target("sse4.1")))
+static inline __m128i decode_pack(__m128i values)
+{
+    const __m128i merge_ab_and_bc = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i out = _mm_madd_epi16(merge_ab_and_bc, _mm_set1_epi32(0x00011000));
+
+    return _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+
+__attribute__((target("sse4.1")))
+static size_t encode_sse41(const uint8_t *src, size_t size, char *dst)
+{
+    size_t done = 0;
+
+    // Load reads 16 bytes, 12 are used.
+    for (; size - done >= 16; done += 12, dst += 16)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), encode_translate(encode_reshuffle(in)));
+    }
+
+    return done;
+}
+
+
+__attribute__((target("sse4.1")))
+static size_t decode_sse41(const char *src, size_t size, uint8_t *dst)
+{
+    size_t done = 0;
+
+    for (; size - done >= 16; done += 16, dst += 12)
+    {
+        int error_mask;
+        const __m128i values = decode_translate(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done)),
+                                                error_mask);
+
+        if (error_mask) break;
+
+        uint8_t out[16];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), decode_pack(values));
+        memcpy(dst, out, 12);
+    }
+
+    return done;
+}
+
+
+static bool sse41_supported()
+{
+    return __builtin_cpu_supports("sse4.1");
+}
+
+//----------------------------------------------------------------------------
+// AVX2
+//----------------------------------------------------------------------------
+
+// Same algorithms, as for the SSE, in both 128-bit lanes.
+__attribute__((target("avx2")))
+static inline __m256i encode_reshuffle(__m256i in)
+{
+    in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                                 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+
+    return _mm256_or_si256(t1, t3);
+}
+
+
+__attribute__((target("avx2")))
+static inline __m256i encode_translate(__m256i in)
+{
+    const __m256i shift_lut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                               '/' - 63, 'A', 0, 0,
+                                               'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                               '/' - 63, 'A', 0, 0);
+    __m256i result = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+    const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), in);
+
+    result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+    return _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, result), in);
+}
+
+
+__attribute__((target("avx2")))
+static inline __m256i decode_translate(__m256i in, int &error_mask)
+{
+    const __m256i higher_nibble = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+    const __m256i lower_nibble = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+    const __m256i shift_lut = _mm256_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                               0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const char m0 = static_cast<char>(0xa8), m1 = static_cast<char>(0xf8), m2 = static_cast<char>(0xf0);
+    const __m256i mask_lut = _mm256_setr_epi8(m0, m1, m1, m1, m1, m1, m1, m1, m1, m1, m2, 0x54, 0x50, 0x50, 0x50, 0x54,
+                                              m0, m1, m1, m1, m1, m1, m1, m1, m1, m1, m2, 0x54, 0x50, 0x50, 0x50, 0x54);
+    const char b7 = static_cast<char>(0x80);
+    const __m256i bitpos_lut = _mm256_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, b7, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, b7, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m256i shift = _mm256_blendv_epi8(_mm256_shuffle_epi8(shift_lut, higher_nibble), _mm256_set1_epi8(16),
+                                             _mm256_cmpeq_epi8(in, _mm256_set1_epi8(0x2f)));
+    const __m256i mask = _mm256_shuffle_epi8(mask_lut, lower_nibble);
+    const __m256i bit = _mm256_shuffle_epi8(bitpos_lut, higher_nibble);
+
+    error_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(mask, bit), _mm256_setzero_si256()));
+
+    return _mm256_add_epi8(in, shift);
+}
+
+
+// 32 6-bit values to 24 bytes in the low part of the register.
+__attribute__((target("avx2")))
+static inline __m256i decode_pack(__m256i values)
+{
+    const __m256i merge_ab_and_bc = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    __m256i out = _mm256_madd_epi16(merge_ab_and_bc, _mm256_set1_epi32(0x00011000));
+
+    out = _mm256_shuffle_epi8(out, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    return _mm256_permutevar8x32_epi32(out, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+}
+
+
+__attribute__((target("avx2")))
+static size_t encode_avx2(const uint8_t *src, size_t size, char *dst)
+{
+    size_t done = 0;
+
+    // Every lane loads 16 bytes and uses 12: the second lane starts at the 12th byte.
+    for (; size - done >= 28; done += 24, dst += 32)
+    {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done + 12));
+        const __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), encode_translate(encode_reshuffle(in)));
+    }
+
+    return done + encode_sse41(src + done, size - done, dst);
+}
+
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const char *src, size_t size, uint8_t *dst)
+{
+    size_t done = 0;
+
+    for (; size - done >= 32; done += 32, dst += 24)
+    {
+        int error_mask;
+        const __m256i values = decode_translate(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done)),
+                                                error_mask);
+
+        if (error_mask) return done;
+
+        uint8_t out[32];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), decode_pack(values));
+        memcpy(dst, out, 24);
+    }
+
+    return done + decode_sse41(src + done, size - done, dst);
+}
+
+
+static bool avx2_supported()
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+
+static const Base64Engine avx2_engine{"avx2", encode_avx2, decode_avx2, avx2_supported};
+static const Base64Engine sse41_engine{"sse4.1", encode_sse41, decode_sse41, sse41_supported};
+static const Base64Engine *const engines[] = {&avx2_engine, &sse41_engine, nullptr};
+
+#elif defined(TSW_BASE64_NEON)
+
+//----------------------------------------------------------------------------
+// NEON
+//----------------------------------------------------------------------------
+
+static const uint8_t encode_lut[64] =
+{
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+
+// Characters 0..127 to 6-bit values, 0xff for the non-alphabet characters.
+static const uint8_t decode_lut[128] =
+{
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,   62, 0xff, 0xff, 0xff,   63,
+      52,   53,   54,   55,   56,   57,   58,   59,   60,   61, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff,    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+      15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff,   26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+      41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+
+static inline uint8x16x4_t load_table(const uint8_t *table)
+{
+    uint8x16x4_t result;
+
+    result.val[0] = vld1q_u8(table);
+    result.val[1] = vld1q_u8(table + 16);
+    result.val[2] = vld1q_u8(table + 32);
+    result.val[3] = vld1q_u8(table + 48);
+
+    return result;
+}
+
+
+static size_t encode_neon(const uint8_t *src, size_t size, char *dst)
+{
+    const uint8x16x4_t lut = load_table(encode_lut);
+    const uint8x16_t mask = vdupq_n_u8(0x3f);
+    size_t done = 0;
+
+    // Deinterleaving load: every register gets one byte of the 16 triples.
+    for (; size - done >= 48; done += 48, dst += 64)
+    {
+        const uint8x16x3_t in = vld3q_u8(src + done);
+        uint8x16x4_t out;
+
+        out.val[0] = vshrq_n_u8(in.val[0], 2);
+        out.val[1] = vandq_u8(vorrq_u8(vshrq_n_u8(in.val[1], 4), vshlq_n_u8(in.val[0], 4)), mask);
+        out.val[2] = vandq_u8(vorrq_u8(vshrq_n_u8(in.val[2], 6), vshlq_n_u8(in.val[1], 2)), mask);
+        out.val[3] = vandq_u8(in.val[2], mask);
+
+        for (int i = 0; i < 4; ++i) out.val[i] = vqtbl4q_u8(lut, out.val[i]);
+
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst), out);
+    }
+
+    return done;
+}
+
+
+static size_t decode_neon(const char *src, size_t size, uint8_t *dst)
+{
+    const uint8x16x4_t lut_lo = load_table(decode_lut);
+    const uint8x16x4_t lut_hi = load_table(decode_lut + 64);
+    const uint8x16_t offset = vdupq_n_u8(64);
+    size_t done = 0;
+
+    for (; size - done >= 64; done += 64, dst += 48)
+    {
+        uint8x16x4_t in = vld4q_u8(reinterpret_cast<const uint8_t*>(src + done));
+        uint8x16_t error = vdupq_n_u8(0);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            // Characters >= 128 are out of both tables and stay as is: they have the high bit set, as the errors.
+            const uint8x16_t c = in.val[i];
+            uint8x16_t v = vqtbx4q_u8(c, lut_lo, c);
+
+            v = vqtbx4q_u8(v, lut_hi, vsubq_u8(c, offset));
+            error = vorrq_u8(error, v);
+            in.val[i] = v;
+        }
+
+        if (vmaxvq_u8(error) & 0x80) break;
+
+        uint8x16x3_t out;
+
+        out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2), vshrq_n_u8(in.val[1], 4));
+        out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4), vshrq_n_u8(in.val[2], 2));
+        out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+
+        vst3q_u8(dst, out);
+    }
+
+    return done;
+}
+
+
+static bool neon_supported()
+{
+    return true;
+}
+
+
+static const Base64Engine neon_engine{"neon", encode_neon, decode_neon, neon_supported};
+static const Base64Engine *const engines[] = {&neon_engine, nullptr};
+
+#else
+
+static const Base64Engine *const engines[] = {nullptr};
+
+#endif
+
+
+const Base64Engine *const *base64_simd_engines()
+{
+    return engines;
+}
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,55 @@
+/**
+  * @file base64_simd.h
+  * @author Artiom N.(cl)2017
+  * @brief Vectorized BASE64 kernels.
+  *
+  */
+
+#ifndef _TSW_BASE64_SIMD_H
+#define _TSW_BASE64_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief BASE64 codec kernels for one instruction set.
+ *
+ * Kernels process only the whole blocks and never read or write outside of the given ranges.
+ */
+struct Base64Engine
+{
+    const char *name;
+
+    /**
+     * @brief Encode blocks without padding and line breaks.
+     * @return count of the encoded bytes, multiple of 3. Output size is 4/3 of it.
+     */
+    size_t (*encode)(const uint8_t *src, size_t size, char *dst);
+
+    /**
+     * @brief Decode blocks until the end or the first block with a non-alphabet character.
+     * @return count of the decoded characters, multiple of 4. Output size is 3/4 of it.
+     */
+    size_t (*decode)(const char *src, size_t size, uint8_t *dst);
+
+    bool (*supported)();
+};
+
+
+/**
+ * @brief Engines, which are built for the target, from the fastest. Last one is nullptr.
+ */
+const Base64Engine *const *base64_simd_engines();
+
+} // namespace impl
+
+} // namespace tsw
+
+#endif // _TSW_BASE64_SIMD_H
@@ -8,6 +8,10 @@
 #ifndef _TSW_BINARY_MESSAGE_H
 #define _TSW_BINARY_MESSAGE_H
 
+#include <memory>
+
+#include "tsw/bson_view.h"
+#include "tsw/message.h"
 #include "tsw/types.h"
 
 namespace tsw
@@ -22,8 +26,10 @@ public:
                   const UID sender_module_uid, String&& sender_module_name,
                   ModuleClass&& sender_module_class,
                   Time&& creation_time) :
-        Message(message_type, fields, receiver_module_uid, receiver_module_name, receiver_module_class,
-                sender_module_uid, sender_module_name, sender_module_class, creation_time)
+        Message(message_type, std::move(fields),
+                receiver_module_uid, std::move(receiver_module_name), std::move(receiver_module_class),
+                sender_module_uid, std::move(sender_module_name), std::move(sender_module_class),
+                std::move(creation_time))
     {}
     BinaryMessage(const MessageType message_type, const NameValueMap& fields,
                   const UID receiver_module_uid, const String& receiver_module_name,
@@ -34,6 +40,18 @@ public:
         Message(message_type, fields, receiver_module_uid, receiver_module_name, receiver_module_class,
                 sender_module_uid, sender_module_name, sender_module_class, creation_time)
     {}
+    BinaryMessage(const MessageType message_type, const BsonView& fields_view,
+                  std::shared_ptr<BinData> fields_buffer,
+                  const UID receiver_module_uid, String&& receiver_module_name,
+                  ModuleClass&& receiver_module_class,
+                  const UID sender_module_uid, String&& sender_module_name,
+                  ModuleClass&& sender_module_class,
+                  Time&& creation_time) :
+        Message(message_type, fields_view, std::move(fields_buffer),
+                receiver_module_uid, std::move(receiver_module_name), std::move(receiver_module_class),
+                sender_module_uid, std::move(sender_module_name), std::move(sender_module_class),
+                std::move(creation_time))
+    {}
 };
 
 } // namespace tsw
@@ -5,7 +5,10 @@
   *
   */
 
+#include <memory>
+
 #include <tsw/bson_deserializer.h>
+#include <tsw/bson_view.h>
 #include <tsw/types.h>
 
 #include "bson_impl.h"
@@ -36,9 +39,10 @@ Object BsonDeserializer::DeserializeObject(const BinData &data)
 
 Message BsonDeserializer::DeserializeMessage(const BinData::value_type *data, size_t size)
 {
-    auto obj = bsrec_->Deserialize(data, size);
+    // Message keeps the buffer and decodes fields lazily.
+    auto buffer = std::make_shared<BinData>(data, data + size);
 
-    return MessageFromObject(std::move(obj));
+    return MessageFromView(BsonView(buffer->data(), buffer->size()), buffer);
 }
 
 
@@ -47,4 +51,16 @@ Object BsonDeserializer::DeserializeObject(const BinData::value_type *data, size
     return bsrec_->Deserialize(data, size);
 }
 
+
+MessageType BsonDeserializer::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    return static_cast<MessageType>(BsonView(data, size).as_int32("type"));
+}
+
+
+void BsonDeserializer::DeserializeMessageTo(const BinData::value_type *data, size_t size, Message &message)
+{
+    AssignMessageFromView(data, size, message);
+}
+
 } // namespace tsw
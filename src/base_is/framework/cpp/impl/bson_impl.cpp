@@ -5,6 +5,7 @@
   *
   */
 
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -22,12 +23,6 @@ namespace tsw
 namespace impl
 {
 
-class BsonException : public Exception
-{
-    using Exception::Exception;
-};
-
-
 static void bson_error_handler(const char *errmsg)
 {
     TSW_THROW(BsonException, errmsg);
@@ -38,19 +33,17 @@ static void bson_error_handler(const char *errmsg)
 // BsonSerializerImpl
 //----------------------------------------------------------------------------
 
+// Fields are written by the BsonWriter directly, without ejdb bson structure.
+// Duplicate keys are not checked: they are impossible in the NameValueMap.
+
 BsonSerializerImpl::BsonSerializerImpl()
 {
-    set_bson_err_handler(&bson_error_handler);
     init();
 }
 
 
 BsonSerializerImpl::~BsonSerializerImpl()
 {
-    int result = bson_finish(&bs_rec_);
-    TSW_ASSERT(result == BSON_OK);
-
-    bson_destroy(&bs_rec_);
 }
 
 
@@ -58,224 +51,271 @@ void BsonSerializerImpl::init(bool need_init)
 {
     if (!need_init) return;
 
-    // If result is not Ok, error will be thrown in the error_handler.
-    int result = bson_safe_init(&bs_rec_);
-    TSW_ASSERT(BSON_OK == result);
+    writer_.clear();
+    writer_.start_document();
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, const String &data)
+void BsonSerializerImpl::write_field(std::string_view name, const String &data)
 {
-    init(bs_rec_.finished);
-
-    // error_handler will not be called in bson_append_* methods.
-    if (bson_append_string_n(&bs_rec_, name.c_str(), data.c_str(), data.size()) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as a string \"" + data + "\" into a BSON document");
-    }
+    writer_.append_string(name, data);
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, const String::value_type *data)
+void BsonSerializerImpl::write_field(std::string_view name, const String::value_type *data)
 {
-    init(bs_rec_.finished);
-
-    if (bson_append_string(&bs_rec_, name.c_str(), data) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as a char* \"" + String(data) + "\" into a BSON document");
-    }
+    writer_.append_string(name, data);
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, int data)
+void BsonSerializerImpl::write_field(std::string_view name, int data)
 {
-    init(bs_rec_.finished);
-
-    if (bson_append_int(&bs_rec_, name.c_str(), data) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as an integer \"" + std::to_string(data) + "\" into a BSON document");
-    }
+    writer_.append_int32(name, data);
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, int64_t data)
+void BsonSerializerImpl::write_field(std::string_view name, int64_t data)
 {
-    init(bs_rec_.finished);
+    writer_.append_int64(name, data);
+}
 
-    if (bson_append_long(&bs_rec_, name.c_str(), data) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as an int64 \"" + std::to_string(data) + "\" into a BSON document");
-    }
+
+void BsonSerializerImpl::write_field(std::string_view name, double data)
+{
+    writer_.append_double(name, data);
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, double data)
+void BsonSerializerImpl::write_field(std::string_view name, bool data)
 {
-    init(bs_rec_.finished);
+    writer_.append_bool(name, data);
+}
 
-    if (bson_append_double(&bs_rec_, name.c_str(), data) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as a double \"" + std::to_string(data) + "\" into a BSON document");
-    }
+
+void BsonSerializerImpl::write_field(std::string_view name, const NameValueMap &data)
+{
+    writer_.start_object(name);
+    for (const auto &field: data) write_field(field.first, field.second);
+    writer_.finish_object();
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, bool data)
+void BsonSerializerImpl::write_field(std::string_view name, const BinData &data)
 {
-    init(bs_rec_.finished);
+    writer_.append_binary(name, BsonBinarySubtype::Generic, data.data(), data.size());
+}
 
-    if (bson_append_bool(&bs_rec_, name.c_str(), data) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as a boolean \"" + std::to_string(data) + "\" into a BSON document");
-    }
+
+void BsonSerializerImpl::write_field(std::string_view name, const Time &data)
+{
+    static_assert(sizeof(Time::rep) <= sizeof(int64_t), "Time can't be stored as BSON date");
+    writer_.append_date(name, data.count());
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, const Value &data)
+void BsonSerializerImpl::write_field(std::string_view name, const Value &data)
 {
-    init(bs_rec_.finished);
     std::visit([&](auto &&element)
     {
         using T = std::decay_t<decltype(element)>;
         if constexpr (std::is_same_v<T, Null>)
         {
-            this->append_null_field(name);
+            writer_.append_null(name);
         }
         else if constexpr (std::is_same_v<T, Undefined>)
         {
-            this->append_undefined_field(name);
+            writer_.append_undefined(name);
         }
         else
         {
-            this->append_field(name, element);
+            this->write_field(name, element);
         }
     }, static_cast<const ValueBase&>(data));
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, const NameValueMap &data)
+template<typename IterableType>
+void BsonSerializerImpl::write_array(std::string_view name, const IterableType &data)
 {
-    init(bs_rec_.finished);
+    BsonArrayKey key;
+    size_t field_num = 0;
 
-    if (bson_append_start_object2(&bs_rec_, name.c_str(), name.size()) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't start appending field \"" + name + "\" as a NameValueMap into a BSON document");
-    }
+    writer_.start_array(name);
+    for (const auto &field: data) write_field(key(field_num++), field);
+    writer_.finish_array();
+}
 
-    for (const auto field: data) append_field(field.first, field.second);
 
-    if (bson_append_finish_object(&bs_rec_) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't finish appending field \"" + name + "\" as a NameValueMap into a BSON document");
-    }
+void BsonSerializerImpl::write_field(std::string_view name, const ValueArray &data)
+{
+    write_array(name, data);
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, const BinData &data)
+void BsonSerializerImpl::write_field(std::string_view name, const ValueList &data)
 {
-    init(bs_rec_.finished);
+    write_array(name, data);
+}
 
-    if (bson_append_binary(&bs_rec_, name.c_str(), BSON_BIN_BINARY,
-                           reinterpret_cast<const char*>(data.data()), data.size()) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as a BinaryData into a BSON document");
-    }
+
+void BsonSerializerImpl::write_field(std::string_view name, const DoubleArray &data)
+{
+    writer_.append_packed(name, BsonBinarySubtype::DoubleArray, data.data(), data.size());
 }
 
 
-template<typename IterableType, typename std::enable_if<is_iterable<IterableType>::value, int>::type>
-void BsonSerializerImpl::append_field(const String &name, const IterableType &data)
+void BsonSerializerImpl::write_field(std::string_view name, const Int32Array &data)
 {
-    init(bs_rec_.finished);
+    writer_.append_packed(name, BsonBinarySubtype::Int32Array, data.data(), data.size());
+}
 
-    if (bson_append_start_array2(&bs_rec_, name.c_str(), name.size()) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't start appending field \"" + name + "\" as an iterable type into a BSON document");
-    }
 
-    size_t field_num = 0;
-    for (const auto field: data)
-    {
-        append_field(std::to_string(field_num++), field);
-        TSW_ASSERT(field_num < std::numeric_limits<size_t>::max());
-    }
+void BsonSerializerImpl::append_field(const String &name, const String &data)
+{
+    init(need_init());
+    write_field(name, data);
+}
 
-    if (bson_append_finish_array(&bs_rec_) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't finish appending field \"" + name + "\" as an iterable type into a BSON document");
-    }
+
+void BsonSerializerImpl::append_field(const String &name, const String::value_type *data)
+{
+    init(need_init());
+    write_field(name, data);
 }
 
 
-void BsonSerializerImpl::append_field(const String &name, const Time &data)
+void BsonSerializerImpl::append_field(const String &name, int data)
 {
-    init(bs_rec_.finished);
+    init(need_init());
+    write_field(name, data);
+}
 
-    TSW_ASSERT(sizeof(Time) <= sizeof(bson_date_t));
-    if (bson_append_date(&bs_rec_, name.c_str(), bson_date_t(data.count())) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as Time \"" + std::to_string(data.count()) + "\" into a BSON document");
-    }
+
+void BsonSerializerImpl::append_field(const String &name, int64_t data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, double data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, bool data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, const Value &data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, const NameValueMap &data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, const BinData &data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+template<typename IterableType, typename std::enable_if<is_iterable<IterableType>::value, int>::type>
+void BsonSerializerImpl::append_field(const String &name, const IterableType &data)
+{
+    init(need_init());
+    write_array(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, const Time &data)
+{
+    init(need_init());
+    write_field(name, data);
 }
 
 
 void BsonSerializerImpl::append_uid(const String &name, UID data, size_t size)
 {
-    init(bs_rec_.finished);
+    init(need_init());
 
-    if (bson_append_binary(&bs_rec_, name.c_str(), BSON_BIN_UUID, reinterpret_cast<const char*>(&data), size) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append field \"" + name + "\" as an UID \"" + std::to_string(data) + "\" into a BSON document");
-    }
+    TSW_ASSERT(size <= sizeof(data));
+    writer_.append_binary(name, BsonBinarySubtype::UUID, &data, size);
 }
 
 
 void BsonSerializerImpl::append_null_field(const String &name)
 {
-    init(bs_rec_.finished);
-
-    if (bson_append_null(&bs_rec_, name.c_str()) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append Null field \"" + name + "\" into a BSON document");
-    }
+    init(need_init());
+    writer_.append_null(name);
 }
 
 
 void BsonSerializerImpl::append_undefined_field(const String &name)
 {
-    init(bs_rec_.finished);
+    init(need_init());
+    writer_.append_undefined(name);
+}
 
-    if (bson_append_undefined(&bs_rec_, name.c_str()) != BSON_OK)
-    {
-        TSW_THROW(BsonException, "Can't append Undefined field \"" + name + "\" into a BSON document");
-    }
+
+void BsonSerializerImpl::append_fields(const String &name, const FieldsWriter &fields)
+{
+    BsonFieldWriter field_writer(*this);
+
+    init(need_init());
+    writer_.start_object(name);
+    fields(field_writer);
+    writer_.finish_object();
+}
+
+
+void BsonSerializerImpl::finish()
+{
+    if (writer_.buffer().empty()) init();
+    if (!writer_.finished()) writer_.finish_document();
 }
 
 
 BinData BsonSerializerImpl::get_buffer()
 {
-    const char* buffer;
-    int buffer_size;
+    finish();
 
-    bson_finish(&bs_rec_);
+    return writer_.buffer();
+}
 
-    if (bson_check_duplicate_keys(&bs_rec_))
-    {
-        // Heavy operation.
-        bson bs_out;
 
-        bson_safe_init(&bs_out);
-        bson_fix_duplicate_keys(&bs_rec_, &bs_out);
-        bson_finish(&bs_out);
+BinData BsonSerializerImpl::take_buffer()
+{
+    finish();
 
-        buffer = bson_data2(&bs_out, &buffer_size);
-    }
-    else buffer = bson_data2(&bs_rec_, &buffer_size);
+    return writer_.release();
+}
 
-    TSW_ASSERT(buffer_size > 0);
-    TSW_ASSERT(sizeof(buffer_size) <= sizeof(size_t));
 
-    return BinData(buffer, buffer + buffer_size);
+void BsonSerializerImpl::reset(BinData &buffer)
+{
+    writer_.swap(buffer);
+    init();
+}
+
+
+void BsonSerializerImpl::take_buffer(BinData &buffer)
+{
+    finish();
+    writer_.swap(buffer);
 }
 
 
@@ -287,20 +327,111 @@ void BsonSerializerImpl::print_buffer()
 
 void BsonSerializerImpl::clear()
 {
-    bson_destroy(&bs_rec_);
     init();
 }
 
 
 void BsonSerializerImpl::append_field(const String &name, const ValueArray &data)
 {
-    append_field<ValueArray>(name, data);
+    init(need_init());
+    write_field(name, data);
 }
 
 
 void BsonSerializerImpl::append_field(const String &name, const ValueList &data)
 {
-    append_field<ValueList>(name, data);
+    init(need_init());
+    write_field(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, const DoubleArray &data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+void BsonSerializerImpl::append_field(const String &name, const Int32Array &data)
+{
+    init(need_init());
+    write_field(name, data);
+}
+
+
+//----------------------------------------------------------------------------
+// BsonFieldWriter
+//----------------------------------------------------------------------------
+
+void BsonFieldWriter::write(const char *name, bool data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, int32_t data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, int64_t data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, double data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, const String &data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, const BinData &data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, const Time &data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, const DoubleArray &data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, const Int32Array &data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::write(const char *name, const Value &data)
+{
+    serializer_.write_field(name, data);
+}
+
+
+void BsonFieldWriter::start_object(const char *name)
+{
+    serializer_.writer_.start_object(name);
+}
+
+
+void BsonFieldWriter::finish_object()
+{
+    serializer_.writer_.finish_object();
 }
 
 
@@ -308,7 +439,48 @@ void BsonSerializerImpl::append_field(const String &name, const ValueList &data)
 // BsonDeserializerImpl
 //----------------------------------------------------------------------------
 
-BsonDeserializerImpl::BsonDeserializerImpl()
+template<typename ArrayType>
+ArrayType read_packed(const bson_iterator *i)
+{
+    typedef typename ArrayType::value_type T;
+
+    const size_t size = static_cast<size_t>(bson_iterator_bin_len(i));
+    const char *data = bson_iterator_bin_data(i);
+
+    if (size % sizeof(T))
+    {
+        TSW_THROW(BsonException, String("packed array \"") + BSON_ITERATOR_KEY(i) + "\" has incorrect size: " +
+                                 std::to_string(size));
+    }
+
+    ArrayType result(size / sizeof(T));
+
+    if constexpr (bson_native_byte_order)
+    {
+        memcpy(result.data(), data, size);
+    }
+    else
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(data);
+
+        for (auto &element: result)
+        {
+            std::conditional_t<sizeof(T) == sizeof(uint64_t), uint64_t, uint32_t> bits = 0;
+
+            for (size_t b = 0; b < sizeof(T); ++b) bits |= static_cast<decltype(bits)>(*bytes++) << (b * 8);
+            memcpy(&element, &bits, sizeof(T));
+        }
+    }
+
+    return result;
+}
+
+
+template DoubleArray read_packed<DoubleArray>(const bson_iterator *i);
+template Int32Array read_packed<Int32Array>(const bson_iterator *i);
+
+
+BsonDeserializerImpl::BsonDeserializerImpl() : raise_on_unknown_(true)
 {
     set_bson_err_handler(&bson_error_handler);
     //init();
@@ -325,11 +497,7 @@ NameValueMap BsonDeserializerImpl::DeserializeInternal(const BinData::value_type
 {
     NameValueMap result;
     bson_iterator i;
-    bson_type bson_iter_type;
 
-    const char *key;
-    //bson_timestamp_t ts;
-    //char oidhex[25];
     if (static_cast<size_t>(bson_size2(bin_data)) != size)
         TSW_THROW(BsonException, (std::to_string(bson_size2(bin_data)) + " != " + std::to_string(size)).c_str());
 
@@ -337,96 +505,120 @@ NameValueMap BsonDeserializerImpl::DeserializeInternal(const BinData::value_type
 
     while (bson_iterator_next(&i))
     {
-        bson_iter_type = BSON_ITERATOR_TYPE(&i);
-        if (bson_iter_type == 0) break;
+        if (BSON_ITERATOR_TYPE(&i) == 0) break;
+
+        result[BSON_ITERATOR_KEY(&i)] = DeserializeElement(&i);
+    } // while
 
-        key = BSON_ITERATOR_KEY(&i);
+    return result;
+}
 
-        switch (bson_iter_type)
-        {
-            case BSON_DOUBLE:
-                result[key] = bson_iterator_double(&i);
-            break;
-            case BSON_STRING:
-            case BSON_SYMBOL:
-                result[key] = bson_iterator_string(&i);
-            break;
-            case BSON_REGEX:
-                result[key] = bson_iterator_string(&i);
-            break;
-            case BSON_BOOL:
-                result[key] = bson_iterator_bool(&i) == true;
-            break;
-            case BSON_DATE:
-                // bson_date_t is a milliseconds since epoch UTC.
-                // Time is a nanoseconds, but I write Time type and need to return nanoseconds.
-                result[key] = std::move(Time(bson_iterator_date(&i)));
-            break;
-            case BSON_BINDATA:
-            {
-                int bd_len = bson_iterator_bin_len(&i);
-                const char *bd_buffer = bson_iterator_bin_data(&i);
-                result[key] = std::move(BinData(bd_buffer, bd_buffer + bd_len));
-                break;
-            }
-            case BSON_UNDEFINED:
-                result[key] = Value();
-            break;
-            case BSON_NULL:
-                result[key] = Null();
-            break;
-            case BSON_INT:
-                result[key] = static_cast<int32_t>(bson_iterator_int(&i));
-            break;
-            case BSON_LONG:
-                result[key] = bson_iterator_long(&i);
-            break;
-            case BSON_OBJECT:
-            {
-                auto bi_val = bson_iterator_value(&i);
-                result[key] = std::move(DeserializeInternal(reinterpret_cast<const BinData::value_type*>(bi_val), bson_size2(bi_val)));
-                break;
-            }
-            case BSON_ARRAY:
-            {
-                auto bi_val = bson_iterator_value(&i);
-                NameValueMap nvm = std::move(DeserializeInternal(reinterpret_cast<const BinData::value_type*>(bi_val), bson_size2(bi_val)));
-                ValueArray va;
 
-                va.clear();
-                for (auto i: nvm) va.push_back(std::move(i.second));
+ValueArray BsonDeserializerImpl::DeserializeArray(const BinData::value_type *bin_data, size_t size)
+{
+    ValueArray result;
+    bson_iterator i;
+    size_t elements_count = 0;
 
-                result[key] = std::move(va);
-                break;
-            }
-            case BSON_CODE:
-                result[key] = bson_iterator_code(&i);
-            break;
-            case BSON_CODEWSCOPE:
-                // This will work, but need too use "bson_iterator_code_scope".
-                result[key] = bson_iterator_code(&i);
-            break;
-            case BSON_OID:
+    if (static_cast<size_t>(bson_size2(bin_data)) != size)
+        TSW_THROW(BsonException, (std::to_string(bson_size2(bin_data)) + " != " + std::to_string(size)).c_str());
+
+    // BSON array is a document with "0", "1", ... keys in the elements order:
+    // keys are skipped, elements are appended as is.
+    BSON_ITERATOR_FROM_BUFFER(&i, bin_data);
+    while (bson_iterator_next(&i)) ++elements_count;
+
+    result.reserve(elements_count);
+
+    BSON_ITERATOR_FROM_BUFFER(&i, bin_data);
+    while (bson_iterator_next(&i))
+    {
+        result.emplace_back(DeserializeElement(&i));
+    }
+
+    return result;
+}
+
+
+Value BsonDeserializerImpl::DeserializeElement(const bson_iterator *i)
+{
+    const bson_type bson_iter_type = BSON_ITERATOR_TYPE(i);
+
+    //bson_timestamp_t ts;
+    //char oidhex[25];
+    switch (bson_iter_type)
+    {
+        case BSON_DOUBLE:
+            return bson_iterator_double(i);
+        case BSON_STRING:
+        case BSON_SYMBOL:
+            return bson_iterator_string(i);
+        case BSON_REGEX:
+            return bson_iterator_string(i);
+        case BSON_BOOL:
+            return bson_iterator_bool(i) == true;
+        case BSON_DATE:
+            // bson_date_t is a milliseconds since epoch UTC.
+            // Time is a nanoseconds, but I write Time type and need to return nanoseconds.
+            return Time(bson_iterator_date(i));
+        case BSON_BINDATA:
+        {
+            switch (static_cast<BsonBinarySubtype>(bson_iterator_bin_type(i)))
             {
-                auto data = reinterpret_cast<const BinData::value_type *>(bson_iterator_oid(&i));
-                result[key] = BinData(data, data + sizeof(bson_oid_t));
+                case BsonBinarySubtype::DoubleArray:
+                    return read_packed<DoubleArray>(i);
+                case BsonBinarySubtype::Int32Array:
+                    return read_packed<Int32Array>(i);
+                default:
                 break;
             }
-            case BSON_TIMESTAMP:
-            {
-                auto bi_val = bson_iterator_timestamp(&i);
-                auto seconds = std::chrono::seconds(bi_val.t);
-                // It's not fully correct: i is not milliseconds, it's "operation ordinal".
-                result[key] = seconds + std::chrono::milliseconds(bi_val.i);
-            }
-            default:
-                if (raise_on_unknown_) TSW_THROW(BsonException, String("can't deserialize field \"") +
-                                                 key + "\" with type: " + std::to_string(bson_iter_type));
-            break;
-        } // switch
-    } // while
 
-    return result;
+            int bd_len = bson_iterator_bin_len(i);
+            const char *bd_buffer = bson_iterator_bin_data(i);
+            return BinData(bd_buffer, bd_buffer + bd_len);
+        }
+        case BSON_UNDEFINED:
+            return Value();
+        case BSON_NULL:
+            return Null();
+        case BSON_INT:
+            return static_cast<int32_t>(bson_iterator_int(i));
+        case BSON_LONG:
+            return bson_iterator_long(i);
+        case BSON_OBJECT:
+        {
+            auto bi_val = bson_iterator_value(i);
+            return DeserializeInternal(reinterpret_cast<const BinData::value_type*>(bi_val), bson_size2(bi_val));
+        }
+        case BSON_ARRAY:
+        {
+            auto bi_val = bson_iterator_value(i);
+            return DeserializeArray(reinterpret_cast<const BinData::value_type*>(bi_val), bson_size2(bi_val));
+        }
+        case BSON_CODE:
+            return bson_iterator_code(i);
+        case BSON_CODEWSCOPE:
+            // This will work, but need too use "bson_iterator_code_scope".
+            return bson_iterator_code(i);
+        case BSON_OID:
+        {
+            auto data = reinterpret_cast<const BinData::value_type *>(bson_iterator_oid(i));
+            return BinData(data, data + sizeof(bson_oid_t));
+        }
+        case BSON_TIMESTAMP:
+        {
+            auto bi_val = bson_iterator_timestamp(i);
+            auto seconds = std::chrono::seconds(bi_val.t);
+            // It's not fully correct: i is not milliseconds, it's "operation ordinal".
+            return Time(seconds + std::chrono::milliseconds(bi_val.i));
+        }
+        default:
+            if (raise_on_unknown_) TSW_THROW(BsonException, String("can't deserialize field \"") +
+                                             BSON_ITERATOR_KEY(i) + "\" with type: " + std::to_string(bson_iter_type));
+        break;
+    } // switch
+
+    return Value();
 }
 
 } // namespace impl
@@ -11,9 +11,13 @@
 
 #include <ejdb/ejdb.h>
 
+#include "tsw/error.h"
+#include "tsw/field_access.h"
 #include "tsw/types.h"
 #include "tsw/type_traits.h"
 
+#include "bson_writer.h"
+
 
 namespace tsw
 {
@@ -40,11 +44,18 @@ public:
     void append_field(const String &name, const Value &data);
     void append_field(const String &name, const ValueArray &data);
     void append_field(const String &name, const ValueList &data);
+    void append_field(const String &name, const DoubleArray &data);
+    void append_field(const String &name, const Int32Array &data);
 
     void append_uid(const String &name, UID data, size_t size);
     void append_null_field(const String &name);
     void append_undefined_field(const String &name);
 
+    /**
+     * @brief Append nested document, which fields are written by the callback.
+     */
+    void append_fields(const String &name, const FieldsWriter &fields);
+
     template<typename IterableType, typename std::enable_if<is_iterable<IterableType>::value, int>::type = 0>
     void append_field(const String &name, const IterableType &data);
 
@@ -52,17 +63,90 @@ public:
     void clear();
     BinData get_buffer();
 
+    /**
+     * @brief Finish the document and move the buffer out, without copying.
+     */
+    BinData take_buffer();
+
+    /**
+     * @brief Start a new document in the buffer memory. Buffer gets the previous writer's memory.
+     */
+    void reset(BinData &buffer);
+
+    /**
+     * @brief Finish the document and exchange it with the buffer.
+     */
+    void take_buffer(BinData &buffer);
+
 public:
     void print_buffer();
 
 protected:
     void init(bool need_init = true);
+    // Next field will start a new document.
+    bool need_init() const { return writer_.buffer().empty() || writer_.finished(); }
+    void finish();
+
+private:
+    template<typename IterableType>
+    inline void write_array(std::string_view name, const IterableType &data);
+
+    inline void write_field(std::string_view name, const String &data);
+    inline void write_field(std::string_view name, const String::value_type *data);
+    inline void write_field(std::string_view name, int data);
+    inline void write_field(std::string_view name, int64_t data);
+    inline void write_field(std::string_view name, double data);
+    inline void write_field(std::string_view name, bool data);
+    inline void write_field(std::string_view name, const NameValueMap &data);
+    inline void write_field(std::string_view name, const BinData &data);
+    inline void write_field(std::string_view name, const Time &data);
+    inline void write_field(std::string_view name, const Value &data);
+    inline void write_field(std::string_view name, const ValueArray &data);
+    inline void write_field(std::string_view name, const ValueList &data);
+    inline void write_field(std::string_view name, const DoubleArray &data);
+    inline void write_field(std::string_view name, const Int32Array &data);
+
+private:
+    friend class BsonFieldWriter;
+    BsonWriter<BinData> writer_;
+};
+
+
+/**
+ * @brief FieldWriter, which appends fields to the current BsonSerializerImpl document.
+ */
+class BsonFieldWriter : public FieldWriter
+{
+public:
+    explicit BsonFieldWriter(BsonSerializerImpl &serializer) : serializer_(serializer) {}
+
+public:
+    using FieldWriter::write;
+
+    void write(const char *name, bool data) override;
+    void write(const char *name, int32_t data) override;
+    void write(const char *name, int64_t data) override;
+    void write(const char *name, double data) override;
+    void write(const char *name, const String &data) override;
+    void write(const char *name, const BinData &data) override;
+    void write(const char *name, const Time &data) override;
+    void write(const char *name, const DoubleArray &data) override;
+    void write(const char *name, const Int32Array &data) override;
+    void write(const char *name, const Value &data) override;
+
+    void start_object(const char *name) override;
+    void finish_object() override;
 
 private:
-    bson bs_rec_;
+    BsonSerializerImpl &serializer_;
 };
 
 
+// Decode BSON binary element with the packed array subtype.
+template<typename ArrayType>
+ArrayType read_packed(const bson_iterator *i);
+
+
 class BsonDeserializerImpl
 {
 public:
@@ -76,8 +160,12 @@ public:
         return DeserializeInternal(bin_data, size);
     }
 
+    // Decode element, on which iterator points.
+    Value DeserializeElement(const bson_iterator *i);
+
 private:
     NameValueMap DeserializeInternal(const BinData::value_type* bin_data, size_t size);
+    ValueArray DeserializeArray(const BinData::value_type* bin_data, size_t size);
 
 private:
     bool raise_on_unknown_;
@@ -5,8 +5,11 @@
   *
   */
 
+#include <memory>
+
 #include <tsw/bson_serializer.h>
 #include <tsw/types.h>
+#include <tsw/wire_format.h>
 
 #include "bson_impl.h"
 
@@ -24,7 +27,37 @@ BsonSerializer::~BsonSerializer()
 
 BinData BsonSerializer::SerializeMessage(const Message &message)
 {
-    return std::move(Serializer::SerializeMessage<impl::BsonSerializerImpl>(message, *bsrec_));
+    return Serializer::SerializeMessage<impl::BsonSerializerImpl>(message, *bsrec_);
+}
+
+
+void BsonSerializer::SerializeMessageTo(const Message &message, BinData &buffer)
+{
+    // Writer encodes directly into the caller's memory.
+    bsrec_->reset(buffer);
+    WriteMessage<impl::BsonSerializerImpl>(message, *bsrec_);
+    bsrec_->take_buffer(buffer);
+}
+
+
+void BsonSerializer::SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer)
+{
+    bsrec_->reset(buffer);
+    WriteEnvelope<impl::BsonSerializerImpl>(envelope, *bsrec_);
+    bsrec_->append_fields("fields", fields);
+    bsrec_->take_buffer(buffer);
+}
+
+
+std::unique_ptr<Serializer> BsonSerializer::Clone() const
+{
+    return std::make_unique<BsonSerializer>();
+}
+
+
+WireFormat BsonSerializer::Format() const
+{
+    return WireFormat::Bson;
 }
 
 
@@ -32,9 +65,9 @@ BinData BsonSerializer::SerializeObject(const Object &fields)
 {
     bsrec_->clear();
 
-    for (const auto field: fields) bsrec_->append_field(field.first, field.second);
+    for (const auto &field: fields) bsrec_->append_field(field.first, field.second);
 
-    return bsrec_->get_buffer();
+    return bsrec_->take_buffer();
 }
 
 
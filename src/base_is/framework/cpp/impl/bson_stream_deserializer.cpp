@@ -0,0 +1,383 @@
+/**
+  * @file bson_stream_deserializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Incremental BSON message deserializer implementation.
+  *
+  */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <variant>
+
+#include <tsw/bson_stream_deserializer.h>
+#include <tsw/error.h>
+#include <tsw/types.h>
+
+#include "binary_message.h"
+#include "bson_impl.h"
+
+
+namespace tsw
+{
+
+using impl::BsonException;
+
+// Size of the document without elements: int32 length and trailing zero.
+static constexpr size_t empty_document_size = 5;
+
+// Message fields document name.
+static const char fields_name[] = "fields";
+
+
+static inline size_t read_size(const BinData::value_type *data, size_t min_size)
+{
+    int32_t size = static_cast<int32_t>(static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+                                        (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24));
+
+    if (size < 0 || static_cast<size_t>(size) < min_size)
+    {
+        TSW_THROW(BsonException, "Incorrect BSON size: " + std::to_string(size));
+    }
+
+    return static_cast<size_t>(size);
+}
+
+
+static BinaryMessage envelope_from_object(Object &envelope)
+{
+    try
+    {
+        auto deadline = envelope.find("deadline");
+        auto id = envelope.find("m_id");
+        BinaryMessage message(
+                    static_cast<MessageType>(envelope["type"].as_int32()),
+                    NameValueMap(),
+                    static_cast<UID>(envelope["receiver_m_uid"].as_int64()),
+                    std::move(envelope["receiver_m_name"].as_string()),
+                    std::move(envelope["receiver_m_class"].as_string()),
+                    static_cast<UID>(envelope["sender_m_uid"].as_int64()),
+                    std::move(envelope["sender_m_name"].as_string()),
+                    std::move(envelope["sender_m_class"].as_string()),
+                    std::move(envelope["c_time"].as_time())
+               );
+
+        if (deadline != envelope.end()) message.set_deadline(deadline->second.as_time());
+        if (id != envelope.end()) message.set_id(static_cast<UID>(id->second.as_int64()));
+
+        return message;
+    }
+    catch (const std::bad_variant_access&)
+    {
+        TSW_THROW(BsonException, "Incorrect message envelope");
+    }
+}
+
+
+BsonStreamDeserializer::BsonStreamDeserializer(StreamHandler &handler, size_t stream_threshold,
+                                               size_t max_element_size) :
+    handler_(handler),
+    stream_threshold_(std::max<size_t>(stream_threshold, 1)),
+    max_element_size_(max_element_size)
+{
+    reset();
+}
+
+
+void BsonStreamDeserializer::feed(const BinData::value_type *data, size_t size)
+{
+    try
+    {
+        while (size)
+        {
+            switch (state_)
+            {
+                case State::DocumentSize:
+                    if (!fill(sizeof(int32_t), data, size)) break;
+                    document_end_ = read_size(element_.data(), empty_document_size);
+                    element_.clear();
+                    state_ = State::ElementType;
+                break;
+                case State::FieldsSize:
+                {
+                    if (!fill(value_offset_ + sizeof(int32_t), data, size)) break;
+                    // Fields document is followed at least by the message terminator.
+                    fields_end_ = position_ - sizeof(int32_t) + read_size(element_.data() + value_offset_, empty_document_size);
+                    if (fields_end_ >= document_end_) TSW_THROW(BsonException, "Fields are out of the message");
+                    element_.clear();
+                    in_fields_ = true;
+                    state_ = State::ElementType;
+                    send_envelope();
+                }
+                break;
+                case State::ElementType:
+                    if (!fill(1, data, size)) break;
+                    if (element_[0] == BSON_EOO)
+                    {
+                        element_.clear();
+                        finish_document();
+                    }
+                    else
+                    {
+                        state_ = State::ElementName;
+                    }
+                break;
+                case State::ElementName:
+                {
+                    auto name_end = static_cast<const BinData::value_type*>(std::memchr(data, 0, size));
+                    size_t name_size = name_end ? name_end - data + 1 : size;
+
+                    if (element_.size() + name_size > max_element_size_)
+                    {
+                        TSW_THROW(BsonException, "BSON element name is too long");
+                    }
+                    element_.insert(element_.end(), data, data + name_size);
+                    data += name_size;
+                    size -= name_size;
+                    position_ += name_size;
+                    if (name_end) start_element_value();
+                }
+                break;
+                case State::ValueSize:
+                {
+                    auto type = static_cast<bson_type>(element_[0]);
+
+                    if (type != BSON_BINDATA)
+                    {
+                        if (!fill(value_offset_ + sizeof(int32_t), data, size)) break;
+
+                        auto value_size = element_.data() + value_offset_;
+
+                        switch (type)
+                        {
+                            case BSON_OBJECT:
+                            case BSON_ARRAY:
+                                start_value(read_size(value_size, empty_document_size));
+                            break;
+                            case BSON_CODEWSCOPE:
+                                start_value(read_size(value_size, 2 * sizeof(int32_t) + 1 + empty_document_size));
+                            break;
+                            default:
+                                // String: length with the terminator and the data.
+                                start_value(sizeof(int32_t) + read_size(value_size, 1));
+                        }
+                        break;
+                    }
+
+                    // Binary data: length, subtype and the data.
+                    if (!fill(value_offset_ + sizeof(int32_t) + 1, data, size)) break;
+
+                    size_t data_size = read_size(element_.data() + value_offset_, 0);
+                    auto subtype = static_cast<impl::BsonBinarySubtype>(element_.back());
+
+                    if (!in_fields_ || data_size < stream_threshold_ ||
+                        subtype == impl::BsonBinarySubtype::DoubleArray || subtype == impl::BsonBinarySubtype::Int32Array)
+                    {
+                        start_value(sizeof(int32_t) + 1 + data_size);
+                        break;
+                    }
+
+                    if (position_ + data_size >= fields_end_) TSW_THROW(BsonException, "BSON element is out of the document");
+
+                    binary_name_.assign(reinterpret_cast<const char*>(element_.data() + 1));
+                    binary_offset_ = 0;
+                    binary_size_ = data_size;
+                    element_.clear();
+                    state_ = State::BinaryChunks;
+                }
+                break;
+                case State::Value:
+                    if (fill(element_size_, data, size)) finish_element();
+                break;
+                case State::BinaryChunks:
+                {
+                    size_t chunk_size = std::min(size, binary_size_ - binary_offset_);
+
+                    handler_.on_binary_chunk(binary_name_, data, chunk_size, binary_offset_, binary_size_);
+                    data += chunk_size;
+                    size -= chunk_size;
+                    position_ += chunk_size;
+                    binary_offset_ += chunk_size;
+                    if (binary_offset_ == binary_size_) state_ = State::ElementType;
+                }
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        reset();
+        throw;
+    }
+}
+
+
+void BsonStreamDeserializer::finish()
+{
+    bool incomplete = in_message();
+
+    reset();
+
+    if (incomplete) TSW_THROW(BsonException, "Stream ends inside of the message");
+}
+
+
+void BsonStreamDeserializer::reset()
+{
+    state_ = State::DocumentSize;
+    element_.clear();
+    value_offset_ = 0;
+    element_size_ = 0;
+    position_ = 0;
+    document_end_ = 0;
+    fields_end_ = 0;
+    in_fields_ = false;
+    envelope_.clear();
+    binary_name_.clear();
+    binary_offset_ = 0;
+    binary_size_ = 0;
+}
+
+
+bool BsonStreamDeserializer::fill(size_t target_size, const BinData::value_type *&data, size_t &size)
+{
+    size_t count = std::min(target_size - element_.size(), size);
+
+    element_.insert(element_.end(), data, data + count);
+    data += count;
+    size -= count;
+    position_ += count;
+
+    return element_.size() == target_size;
+}
+
+
+void BsonStreamDeserializer::start_element_value()
+{
+    value_offset_ = element_.size();
+
+    switch (static_cast<bson_type>(element_[0]))
+    {
+        case BSON_UNDEFINED:
+        case BSON_NULL:
+            start_value(0);
+        break;
+        case BSON_BOOL:
+            start_value(1);
+        break;
+        case BSON_INT:
+            start_value(sizeof(int32_t));
+        break;
+        case BSON_DOUBLE:
+        case BSON_DATE:
+        case BSON_TIMESTAMP:
+        case BSON_LONG:
+            start_value(sizeof(int64_t));
+        break;
+        case BSON_OID:
+            start_value(12);
+        break;
+        case BSON_OBJECT:
+            if (!in_fields_ && !fields_end_ && !std::strcmp(reinterpret_cast<const char*>(element_.data() + 1), fields_name))
+            {
+                state_ = State::FieldsSize;
+                break;
+            }
+            state_ = State::ValueSize;
+        break;
+        case BSON_STRING:
+        case BSON_CODE:
+        case BSON_SYMBOL:
+        case BSON_ARRAY:
+        case BSON_BINDATA:
+        case BSON_CODEWSCOPE:
+            state_ = State::ValueSize;
+        break;
+        default:
+            TSW_THROW(BsonException, "Unsupported BSON element type: " + std::to_string(element_[0]));
+    }
+}
+
+
+void BsonStreamDeserializer::start_value(size_t value_size)
+{
+    element_size_ = value_offset_ + value_size;
+
+    if (element_size_ > max_element_size_)
+    {
+        TSW_THROW(BsonException, "BSON element is too large: " + std::to_string(element_size_));
+    }
+
+    // Element is followed at least by the document terminator.
+    if (position_ - element_.size() + element_size_ >= (in_fields_ ? fields_end_ : document_end_))
+    {
+        TSW_THROW(BsonException, "BSON element is out of the document");
+    }
+
+    state_ = State::Value;
+
+    if (element_.size() == element_size_) finish_element();
+}
+
+
+void BsonStreamDeserializer::finish_element()
+{
+    switch (static_cast<bson_type>(element_[0]))
+    {
+        case BSON_STRING:
+        case BSON_CODE:
+        case BSON_SYMBOL:
+            if (element_.back()) TSW_THROW(BsonException, "BSON string is not terminated");
+        break;
+        default:
+        break;
+    }
+
+    bson_iterator i;
+
+    i.cur = reinterpret_cast<const char*>(element_.data());
+    i.first = 0;
+
+    String name(reinterpret_cast<const char*>(element_.data() + 1));
+    auto value = impl::BsonDeserializerImpl().DeserializeElement(&i);
+
+    element_.clear();
+    state_ = State::ElementType;
+
+    if (in_fields_)
+    {
+        handler_.on_field(name, std::move(value));
+    }
+    else
+    {
+        envelope_[name] = std::move(value);
+    }
+}
+
+
+void BsonStreamDeserializer::finish_document()
+{
+    if (in_fields_)
+    {
+        if (position_ != fields_end_) TSW_THROW(BsonException, "Incorrect fields document size");
+        in_fields_ = false;
+        state_ = State::ElementType;
+        return;
+    }
+
+    if (position_ != document_end_) TSW_THROW(BsonException, "Incorrect BSON document size");
+    if (!fields_end_) TSW_THROW(BsonException, "Message has no fields");
+
+    reset();
+    handler_.on_message_end();
+}
+
+
+void BsonStreamDeserializer::send_envelope()
+{
+    handler_.on_envelope(envelope_from_object(envelope_));
+    envelope_.clear();
+}
+
+
+} // namespace tsw
@@ -0,0 +1,391 @@
+/**
+  * @file bson_view.cpp
+  * @author Artiom N.(cl)2017
+  * @brief BsonView class implementation.
+  *
+  */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <tsw/bson_view.h>
+#include <tsw/error.h>
+#include <tsw/types.h>
+
+#include "bson_impl.h"
+
+
+namespace tsw
+{
+
+using impl::BsonException;
+
+// Size of the document without elements: int32 length and trailing zero.
+static constexpr size_t empty_document_size = 5;
+
+
+static inline bson_iterator iterator_from_element(const BinData::value_type *element)
+{
+    bson_iterator i;
+
+    i.cur = reinterpret_cast<const char*>(element);
+    i.first = 0;
+
+    return i;
+}
+
+
+static ValueType value_type_from_bson(bson_type type)
+{
+    switch (type)
+    {
+        case BSON_DOUBLE:
+            return ValueType::DoubleNumber;
+        case BSON_STRING:
+        case BSON_SYMBOL:
+        case BSON_REGEX:
+        case BSON_CODE:
+        case BSON_CODEWSCOPE:
+            return ValueType::String;
+        case BSON_BOOL:
+            return ValueType::Boolean;
+        case BSON_DATE:
+        case BSON_TIMESTAMP:
+            return ValueType::Time;
+        case BSON_BINDATA:
+        case BSON_OID:
+            return ValueType::BinData;
+        case BSON_NULL:
+            return ValueType::Null;
+        case BSON_INT:
+            return ValueType::Int32Number;
+        case BSON_LONG:
+            return ValueType::Int64Number;
+        case BSON_OBJECT:
+            return ValueType::Object;
+        case BSON_ARRAY:
+            return ValueType::Array;
+        default:
+            return ValueType::Undefined;
+    }
+}
+
+
+static inline void check_type(const char *name, bson_type actual, bson_type expected)
+{
+    if (actual != expected)
+    {
+        TSW_THROW(BsonException, String("field \"") + name + "\" has type " + std::to_string(actual) +
+                                 ", but " + std::to_string(expected) + " was requested");
+    }
+}
+
+
+// Size of the value is taken from the received document: value must be inside of the document.
+static inline void check_bounds(const BinData::value_type *document, size_t document_size, const char *name,
+                                const void *value, int64_t size)
+{
+    auto offset = static_cast<const BinData::value_type*>(value) - document;
+
+    if (size < 0 || offset < 0 || static_cast<uint64_t>(offset) + static_cast<uint64_t>(size) > document_size)
+    {
+        TSW_THROW(BsonException, String("field \"") + name + "\" is out of the BSON document bounds");
+    }
+}
+
+
+static inline int32_t read_int32(const char *data)
+{
+    int32_t result;
+
+    memcpy(&result, data, sizeof(result));
+
+    return result;
+}
+
+
+// Binary value: int32 length, subtype byte and the data.
+static inline void check_binary_bounds(const BinData::value_type *document, size_t document_size, const char *name,
+                                       const bson_iterator *i)
+{
+    auto value = bson_iterator_value(i);
+
+    check_bounds(document, document_size, name, value, sizeof(int32_t) + 1);
+    check_bounds(document, document_size, name, value, int64_t(sizeof(int32_t) + 1) + read_int32(value));
+}
+
+
+// Element sizes are taken from the document: the next element must start inside of it.
+static inline bool next_element(bson_iterator *i, const BinData::value_type *document, size_t document_size)
+{
+    if (bson_iterator_next(i) == BSON_EOO) return false;
+
+    if (reinterpret_cast<const BinData::value_type*>(i->cur) >= document + document_size - 1)
+    {
+        TSW_THROW(BsonException, "BSON document element is out of the document bounds");
+    }
+
+    return true;
+}
+
+
+BsonView::BsonView(const BinData::value_type *data, size_t size) : data_(data), size_(size)
+{
+    if (size_ < empty_document_size || static_cast<size_t>(bson_size2(data_)) != size_ || data_[size_ - 1])
+    {
+        TSW_THROW(BsonException, "Incorrect BSON document size: " + std::to_string(size_));
+    }
+}
+
+
+bool BsonView::empty() const
+{
+    return size_ <= empty_document_size;
+}
+
+
+const BinData::value_type *BsonView::find(const char *name) const
+{
+    if (empty()) return nullptr;
+
+    if (!index_.empty())
+    {
+        auto entry = std::lower_bound(index_.cbegin(), index_.cend(), std::string_view(name),
+                                      [](const IndexEntry &e, std::string_view n) { return e.first < n; });
+        return (entry != index_.cend() && entry->first == name) ? entry->second : nullptr;
+    }
+
+    bson_iterator i;
+
+    BSON_ITERATOR_FROM_BUFFER(&i, data_);
+
+    while (next_element(&i, data_, size_))
+    {
+        if (!strcmp(BSON_ITERATOR_KEY(&i), name)) return reinterpret_cast<const BinData::value_type*>(i.cur);
+    }
+
+    return nullptr;
+}
+
+
+const BinData::value_type *BsonView::find_existing(const char *name) const
+{
+    auto element = find(name);
+
+    if (!element) TSW_THROW(BsonException, String("field \"") + name + "\" was not found in the BSON document");
+
+    return element;
+}
+
+
+void BsonView::build_index()
+{
+    if (empty() || !index_.empty()) return;
+
+    bson_iterator i;
+
+    BSON_ITERATOR_FROM_BUFFER(&i, data_);
+
+    while (next_element(&i, data_, size_))
+    {
+        index_.emplace_back(BSON_ITERATOR_KEY(&i), reinterpret_cast<const BinData::value_type*>(i.cur));
+    }
+
+    // Stable: the first of the duplicated keys will be found, as without index.
+    std::stable_sort(index_.begin(), index_.end(),
+                     [](const IndexEntry &a, const IndexEntry &b) { return a.first < b.first; });
+}
+
+
+bool BsonView::has_field(const char *name) const
+{
+    return find(name) != nullptr;
+}
+
+
+ValueType BsonView::field_type(const char *name) const
+{
+    auto element = find(name);
+
+    if (!element) return ValueType::Undefined;
+
+    auto i = iterator_from_element(element);
+    auto type = BSON_ITERATOR_TYPE(&i);
+
+    if (type == BSON_BINDATA)
+    {
+        switch (static_cast<impl::BsonBinarySubtype>(bson_iterator_bin_type(&i)))
+        {
+            case impl::BsonBinarySubtype::DoubleArray:
+                return ValueType::DoubleArray;
+            case impl::BsonBinarySubtype::Int32Array:
+                return ValueType::Int32Array;
+            default:
+            break;
+        }
+    }
+
+    return value_type_from_bson(type);
+}
+
+
+bool BsonView::as_bool(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_BOOL);
+
+    return bson_iterator_bool(&i);
+}
+
+
+double BsonView::as_double(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_DOUBLE);
+
+    return bson_iterator_double(&i);
+}
+
+
+int32_t BsonView::as_int32(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_INT);
+
+    return bson_iterator_int(&i);
+}
+
+
+int64_t BsonView::as_int64(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_LONG);
+
+    return bson_iterator_long(&i);
+}
+
+
+size_t BsonView::int64_offset(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_LONG);
+
+    return reinterpret_cast<const BinData::value_type*>(bson_iterator_value(&i)) - data_;
+}
+
+
+std::string_view BsonView::as_string(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_STRING);
+
+    auto value = bson_iterator_value(&i);
+
+    check_bounds(data_, size_, name, value, sizeof(int32_t));
+
+    // String length prefix includes the trailing zero.
+    int32_t length = read_int32(value);
+
+    if (length < 1) TSW_THROW(BsonException, String("field \"") + name + "\" has incorrect string length");
+    check_bounds(data_, size_, name, value, int64_t(sizeof(int32_t)) + length);
+
+    return std::string_view(bson_iterator_string(&i), length - 1);
+}
+
+
+Time BsonView::as_time(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_DATE);
+
+    return Time(bson_iterator_date(&i));
+}
+
+
+BinData BsonView::as_bindata(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_BINDATA);
+    check_binary_bounds(data_, size_, name, &i);
+
+    auto data = reinterpret_cast<const BinData::value_type*>(bson_iterator_bin_data(&i));
+
+    return BinData(data, data + bson_iterator_bin_len(&i));
+}
+
+
+template<typename ArrayType>
+static ArrayType as_packed(const BinData::value_type *document, size_t document_size, const char *name,
+                           const BinData::value_type *element, impl::BsonBinarySubtype subtype)
+{
+    auto i = iterator_from_element(element);
+
+    check_type(name, BSON_ITERATOR_TYPE(&i), BSON_BINDATA);
+    check_binary_bounds(document, document_size, name, &i);
+
+    if (static_cast<impl::BsonBinarySubtype>(bson_iterator_bin_type(&i)) != subtype)
+    {
+        TSW_THROW(BsonException, String("field \"") + name + "\" is not a packed array of the requested type");
+    }
+
+    return impl::read_packed<ArrayType>(&i);
+}
+
+
+DoubleArray BsonView::as_double_array(const char *name) const
+{
+    return as_packed<DoubleArray>(data_, size_, name, find_existing(name), impl::BsonBinarySubtype::DoubleArray);
+}
+
+
+Int32Array BsonView::as_int32_array(const char *name) const
+{
+    return as_packed<Int32Array>(data_, size_, name, find_existing(name), impl::BsonBinarySubtype::Int32Array);
+}
+
+
+BsonView BsonView::as_view(const char *name) const
+{
+    auto i = iterator_from_element(find_existing(name));
+    auto type = BSON_ITERATOR_TYPE(&i);
+
+    if (type != BSON_ARRAY) check_type(name, type, BSON_OBJECT);
+
+    auto bi_val = bson_iterator_value(&i);
+
+    check_bounds(data_, size_, name, bi_val, sizeof(int32_t));
+    check_bounds(data_, size_, name, bi_val, bson_size2(bi_val));
+
+    return BsonView(reinterpret_cast<const BinData::value_type*>(bi_val), bson_size2(bi_val));
+}
+
+
+Value BsonView::get_value(const char *name) const
+{
+    auto element = find(name);
+
+    if (!element) return Value();
+
+    auto i = iterator_from_element(element);
+
+    return impl::BsonDeserializerImpl().DeserializeElement(&i);
+}
+
+
+NameValueMap BsonView::to_object() const
+{
+    if (empty()) return NameValueMap();
+
+    return impl::BsonDeserializerImpl().Deserialize(data_, size_);
+}
+
+} // namespace tsw
@@ -0,0 +1,337 @@
+/**
+  * @file bson_writer.h
+  * @author Artiom N.(cl)2017
+  * @brief BsonWriter class: direct BSON encoder over a reusable buffer.
+  *
+  */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tsw/error.h"
+#include "tsw/types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+class BsonException : public Exception
+{
+    using Exception::Exception;
+};
+
+
+// BSON element types and binary subtypes (bsonspec.org).
+enum class BsonType : uint8_t
+{
+    Double = 0x01,
+    String = 0x02,
+    Object = 0x03,
+    Array = 0x04,
+    Binary = 0x05,
+    Undefined = 0x06,
+    Bool = 0x08,
+    Date = 0x09,
+    Null = 0x0A,
+    Int32 = 0x10,
+    Int64 = 0x12
+};
+
+
+enum class BsonBinarySubtype : uint8_t
+{
+    Generic = 0x00,
+    UUID = 0x03,
+    // User defined subtypes: packed little-endian numeric arrays.
+    DoubleArray = 0x80,
+    Int32Array = 0x81
+};
+
+
+// Host byte order is the BSON one: packed arrays may be copied as is.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+constexpr bool bson_native_byte_order = true;
+#else
+constexpr bool bson_native_byte_order = false;
+#endif
+
+
+/**
+ * @brief BSON encoder, which writes elements directly into the buffer.
+ *
+ * Buffer is a contiguous byte container (BinData by default). Writer never shrinks it:
+ * after clear() the same memory is reused for the next document.
+ * Keys are not checked for duplicates: it's a caller's duty.
+ */
+template<typename Buffer = BinData>
+class BsonWriter
+{
+public:
+    typedef typename Buffer::value_type byte_type;
+
+public:
+    BsonWriter() = default;
+    explicit BsonWriter(size_t reserve) { buffer_.reserve(reserve); }
+
+public:
+    void start_document()
+    {
+        open_level();
+    }
+
+    void finish_document()
+    {
+        close_level();
+    }
+
+    void start_object(std::string_view name)
+    {
+        write_header(BsonType::Object, name);
+        open_level();
+    }
+
+    void start_array(std::string_view name)
+    {
+        write_header(BsonType::Array, name);
+        open_level();
+    }
+
+    void finish_object() { close_level(); }
+    void finish_array() { close_level(); }
+
+public:
+    void append_double(std::string_view name, double data)
+    {
+        uint64_t bits;
+
+        static_assert(sizeof(bits) == sizeof(data), "double must be 64 bit");
+        memcpy(&bits, &data, sizeof(bits));
+        write_header(BsonType::Double, name);
+        write_le(bits);
+    }
+
+    void append_string(std::string_view name, std::string_view data)
+    {
+        write_header(BsonType::String, name);
+        write_le(static_cast<uint32_t>(to_int32(data.size() + 1)));
+        write_bytes(data.data(), data.size());
+        buffer_.push_back(0);
+    }
+
+    void append_int32(std::string_view name, int32_t data)
+    {
+        write_header(BsonType::Int32, name);
+        write_le(static_cast<uint32_t>(data));
+    }
+
+    void append_int64(std::string_view name, int64_t data)
+    {
+        write_header(BsonType::Int64, name);
+        write_le(static_cast<uint64_t>(data));
+    }
+
+    void append_bool(std::string_view name, bool data)
+    {
+        write_header(BsonType::Bool, name);
+        buffer_.push_back(data ? 1 : 0);
+    }
+
+    void append_date(std::string_view name, int64_t data)
+    {
+        write_header(BsonType::Date, name);
+        write_le(static_cast<uint64_t>(data));
+    }
+
+    void append_binary(std::string_view name, BsonBinarySubtype subtype, const void *data, size_t size)
+    {
+        write_header(BsonType::Binary, name);
+        write_le(static_cast<uint32_t>(to_int32(size)));
+        buffer_.push_back(static_cast<byte_type>(subtype));
+        write_bytes(data, size);
+    }
+
+    /**
+     * @brief Write numeric array as a single binary element.
+     */
+    template<typename T>
+    void append_packed(std::string_view name, BsonBinarySubtype subtype, const T *data, size_t count)
+    {
+        static_assert(std::is_arithmetic_v<T>, "only numbers can be packed");
+
+        const size_t size = count * sizeof(T);
+
+        write_header(BsonType::Binary, name);
+        write_le(static_cast<uint32_t>(to_int32(size)));
+        buffer_.push_back(static_cast<byte_type>(subtype));
+
+        if constexpr (bson_native_byte_order)
+        {
+            write_bytes(data, size);
+        }
+        else
+        {
+            typedef std::conditional_t<sizeof(T) == sizeof(uint64_t), uint64_t, uint32_t> UInt;
+            static_assert(sizeof(UInt) == sizeof(T), "unsupported packed element size");
+
+            buffer_.reserve(buffer_.size() + size);
+            for (size_t i = 0; i < count; ++i)
+            {
+                UInt bits;
+                memcpy(&bits, data + i, sizeof(bits));
+                write_le(bits);
+            }
+        }
+    }
+
+    void append_null(std::string_view name)
+    {
+        write_header(BsonType::Null, name);
+    }
+
+    void append_undefined(std::string_view name)
+    {
+        write_header(BsonType::Undefined, name);
+    }
+
+public:
+    // Document is complete: all levels were closed.
+    bool finished() const { return !buffer_.empty() && levels_.empty(); }
+
+    const Buffer &buffer() const { return buffer_; }
+
+    /**
+     * @brief Move the buffer out of the writer. Writer becomes empty.
+     */
+    Buffer release()
+    {
+        Buffer result(std::move(buffer_));
+
+        buffer_.clear();
+        levels_.clear();
+
+        return result;
+    }
+
+    /**
+     * @brief Exchange buffers with the caller. Unfinished document levels are dropped.
+     */
+    void swap(Buffer &other)
+    {
+        buffer_.swap(other);
+        levels_.clear();
+    }
+
+    /**
+     * @brief Reset writer, keeping allocated memory.
+     */
+    void clear()
+    {
+        buffer_.clear();
+        levels_.clear();
+    }
+
+private:
+    template<typename T>
+    inline void write_le(T data)
+    {
+        byte_type bytes[sizeof(T)];
+
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            bytes[i] = static_cast<byte_type>(data >> (i * 8));
+        }
+
+        write_bytes(bytes, sizeof(T));
+    }
+
+    inline void write_bytes(const void *data, size_t size)
+    {
+        auto d = static_cast<const byte_type*>(data);
+        buffer_.insert(buffer_.end(), d, d + size);
+    }
+
+    inline void write_header(BsonType type, std::string_view name)
+    {
+        TSW_ASSERT(!levels_.empty());
+        buffer_.push_back(static_cast<byte_type>(type));
+        write_bytes(name.data(), name.size());
+        buffer_.push_back(0);
+    }
+
+    inline void open_level()
+    {
+        levels_.push_back(buffer_.size());
+        // Length placeholder, will be patched in the close_level().
+        write_le(uint32_t(0));
+    }
+
+    inline void close_level()
+    {
+        TSW_ASSERT(!levels_.empty());
+        buffer_.push_back(0);
+
+        const size_t start = levels_.back();
+        const uint32_t length = static_cast<uint32_t>(to_int32(buffer_.size() - start));
+
+        levels_.pop_back();
+        for (size_t i = 0; i < sizeof(length); ++i)
+        {
+            buffer_[start + i] = static_cast<byte_type>(length >> (i * 8));
+        }
+    }
+
+    static inline int32_t to_int32(size_t size)
+    {
+        if (size > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+        {
+            TSW_THROW(BsonException, "BSON size limit exceeded: " + std::to_string(size));
+        }
+
+        return static_cast<int32_t>(size);
+    }
+
+private:
+    Buffer              buffer_;
+    // Start offsets of the open documents.
+    std::vector<size_t> levels_;
+};
+
+
+/**
+ * @brief Array index to BSON key conversion without memory allocation.
+ */
+class BsonArrayKey
+{
+public:
+    std::string_view operator()(size_t index)
+    {
+        char *end = key_ + sizeof(key_);
+        char *begin = end;
+
+        do
+        {
+            *--begin = static_cast<char>('0' + index % 10);
+            index /= 10;
+        } while (index);
+
+        return std::string_view(begin, end - begin);
+    }
+
+private:
+    char key_[std::numeric_limits<size_t>::digits10 + 1];
+};
+
+} // namespace impl
+
+} // namespace tsw
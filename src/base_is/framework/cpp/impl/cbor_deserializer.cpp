@@ -0,0 +1,56 @@
+/**
+  * @file cbor_deserializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief CborDeserializer class implementation.
+  *
+  */
+
+#include <memory>
+
+#include <tsw/cbor_deserializer.h>
+#include <tsw/types.h>
+
+#include "cbor_impl.h"
+
+
+namespace tsw
+{
+
+CborDeserializer::CborDeserializer() : impl_(new impl::CborDeserializerImpl)
+{}
+
+
+CborDeserializer::~CborDeserializer()
+{}
+
+
+Message CborDeserializer::DeserializeMessage(const BinData &data)
+{
+    return DeserializeMessage(data.data(), data.size());
+}
+
+
+Object CborDeserializer::DeserializeObject(const BinData &data)
+{
+    return impl_->Deserialize(data.data(), data.size());
+}
+
+
+Message CborDeserializer::DeserializeMessage(const BinData::value_type *data, size_t size)
+{
+    return MessageFromObject(impl_->Deserialize(data, size));
+}
+
+
+Object CborDeserializer::DeserializeObject(const BinData::value_type *data, size_t size)
+{
+    return impl_->Deserialize(data, size);
+}
+
+
+MessageType CborDeserializer::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    return impl_->DeserializeMessageType(data, size);
+}
+
+} // namespace tsw
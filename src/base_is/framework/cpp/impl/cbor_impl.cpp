@@ -0,0 +1,504 @@
+/**
+  * @file cbor_impl.cpp
+  * @author Artiom N.(cl)2017
+  * @brief CBOR serializer/deserializer implementation.
+  *
+  */
+
+#include <cmath>
+#include <limits>
+
+#include "cbor_impl.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+// Simple values and the break code.
+static constexpr uint8_t cbor_false = 0xf4;
+static constexpr uint8_t cbor_true = 0xf5;
+static constexpr uint8_t cbor_null = 0xf6;
+static constexpr uint8_t cbor_undefined = 0xf7;
+static constexpr uint8_t cbor_double = 0xfb;
+static constexpr uint8_t cbor_break = 0xff;
+static constexpr uint8_t cbor_indefinite = 31;
+
+
+//----------------------------------------------------------------------------
+// CborEncoder
+//----------------------------------------------------------------------------
+
+void CborEncoder::write_head(BinData &buffer, MajorType type, uint64_t argument)
+{
+    const uint8_t major = static_cast<uint8_t>(type << 5);
+
+    if (argument < 24)
+    {
+        buffer.push_back(static_cast<uint8_t>(major | argument));
+    }
+    else if (argument <= std::numeric_limits<uint8_t>::max())
+    {
+        buffer.push_back(major | 24);
+        buffer.push_back(static_cast<uint8_t>(argument));
+    }
+    else if (argument <= std::numeric_limits<uint16_t>::max())
+    {
+        buffer.push_back(major | 25);
+        write_be(buffer, static_cast<uint16_t>(argument));
+    }
+    else if (argument <= std::numeric_limits<uint32_t>::max())
+    {
+        buffer.push_back(major | 26);
+        write_be(buffer, static_cast<uint32_t>(argument));
+    }
+    else
+    {
+        buffer.push_back(major | 27);
+        write_be(buffer, argument);
+    }
+}
+
+
+void CborEncoder::start_document(BinData &buffer)
+{
+    buffer.push_back(static_cast<uint8_t>(MajorType::Map << 5) | cbor_indefinite);
+}
+
+
+void CborEncoder::finish_document(BinData &buffer, size_t)
+{
+    buffer.push_back(cbor_break);
+}
+
+
+void CborEncoder::write_undefined(BinData &buffer)
+{
+    buffer.push_back(cbor_undefined);
+}
+
+
+void CborEncoder::write_null(BinData &buffer)
+{
+    buffer.push_back(cbor_null);
+}
+
+
+void CborEncoder::write_bool(BinData &buffer, bool data)
+{
+    buffer.push_back(data ? cbor_true : cbor_false);
+}
+
+
+void CborEncoder::write_int32(BinData &buffer, int32_t data)
+{
+    if (data >= 0) write_head(buffer, MajorType::Unsigned, static_cast<uint64_t>(data));
+    else write_head(buffer, MajorType::Negative, static_cast<uint64_t>(-1 - static_cast<int64_t>(data)));
+}
+
+
+void CborEncoder::write_int64(BinData &buffer, int64_t data)
+{
+    // The longest argument form marks the Int64 type.
+    if (data >= 0)
+    {
+        buffer.push_back(static_cast<uint8_t>(MajorType::Unsigned << 5) | 27);
+        write_be(buffer, static_cast<uint64_t>(data));
+    }
+    else
+    {
+        buffer.push_back(static_cast<uint8_t>(MajorType::Negative << 5) | 27);
+        write_be(buffer, static_cast<uint64_t>(-1 - data));
+    }
+}
+
+
+void CborEncoder::write_double(BinData &buffer, double data)
+{
+    buffer.push_back(cbor_double);
+    write_be(buffer, double_bits(data));
+}
+
+
+void CborEncoder::write_string(BinData &buffer, const char *data, size_t size)
+{
+    write_head(buffer, MajorType::Text, size);
+    write_bytes(buffer, data, size);
+}
+
+
+void CborEncoder::write_binary(BinData &buffer, const uint8_t *data, size_t size)
+{
+    write_head(buffer, MajorType::Bytes, size);
+    write_bytes(buffer, data, size);
+}
+
+
+void CborEncoder::write_time(BinData &buffer, const Time &data)
+{
+    auto [seconds, nanoseconds] = split_time(data);
+
+    write_head(buffer, MajorType::Tag, Tags::ExtendedTime);
+    write_map_header(buffer, nanoseconds ? 2 : 1);
+    write_int32(buffer, time_seconds_key);
+    write_int64(buffer, seconds);
+
+    if (nanoseconds)
+    {
+        write_int32(buffer, time_nanoseconds_key);
+        write_head(buffer, MajorType::Unsigned, nanoseconds);
+    }
+}
+
+
+void CborEncoder::write_double_array(BinData &buffer, const DoubleArray &data)
+{
+    write_head(buffer, MajorType::Tag, Tags::DoubleArrayLE);
+    write_head(buffer, MajorType::Bytes, data.size() * sizeof(double));
+    write_packed_le(buffer, data);
+}
+
+
+void CborEncoder::write_int32_array(BinData &buffer, const Int32Array &data)
+{
+    write_head(buffer, MajorType::Tag, Tags::Int32ArrayLE);
+    write_head(buffer, MajorType::Bytes, data.size() * sizeof(int32_t));
+    write_packed_le(buffer, data);
+}
+
+
+void CborEncoder::write_array_header(BinData &buffer, size_t size)
+{
+    write_head(buffer, MajorType::Array, size);
+}
+
+
+void CborEncoder::write_map_header(BinData &buffer, size_t size)
+{
+    write_head(buffer, MajorType::Map, size);
+}
+
+
+//----------------------------------------------------------------------------
+// CborDeserializerImpl
+//----------------------------------------------------------------------------
+
+static double half_to_double(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    double value;
+
+    if (!exponent) value = std::ldexp(mantissa, -24);
+    else if (exponent != 31) value = std::ldexp(mantissa + 1024, exponent - 25);
+    else value = mantissa ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+
+    return (half & 0x8000) ? -value : value;
+}
+
+
+Object CborDeserializerImpl::Deserialize(const BinData::value_type *data, size_t size)
+{
+    CompactReader reader(data, size);
+    auto head = read_head(reader);
+
+    if (head.type != CborEncoder::MajorType::Map) TSW_THROW(CompactCodecException, "document is not a map");
+
+    auto result = read_map(reader, head);
+
+    if (!reader.at_end()) TSW_THROW(CompactCodecException, "trailing data after the document");
+
+    return result;
+}
+
+
+MessageType CborDeserializerImpl::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    CompactReader reader(data, size);
+    auto head = read_head(reader);
+
+    if (head.type != CborEncoder::MajorType::Map) TSW_THROW(CompactCodecException, "document is not a map");
+
+    // Serializer writes the type first: other fields are not decoded.
+    for (uint64_t i = 0; head.indefinite ? !at_break(reader) : i < head.argument; ++i)
+    {
+        auto name = read_key(reader);
+        auto value = read_value(reader);
+
+        if (name == "type")
+        {
+            if (!value.is_int32()) TSW_THROW(CompactCodecException, "message type is not an integer");
+            return static_cast<MessageType>(value.as_int32());
+        }
+    }
+
+    TSW_THROW(CompactCodecException, "message has no type");
+}
+
+
+CborDeserializerImpl::Head CborDeserializerImpl::read_head(CompactReader &reader)
+{
+    uint8_t initial = reader.read_byte();
+    Head head{static_cast<CborEncoder::MajorType>(initial >> 5), static_cast<uint8_t>(initial & 0x1f), 0, false};
+
+    if (head.info < 24) head.argument = head.info;
+    else if (head.info == 24) head.argument = reader.read_byte();
+    else if (head.info == 25) head.argument = reader.read_be<uint16_t>();
+    else if (head.info == 26) head.argument = reader.read_be<uint32_t>();
+    else if (head.info == 27) head.argument = reader.read_be<uint64_t>();
+    else if (head.info == cbor_indefinite && head.type >= CborEncoder::MajorType::Bytes &&
+             head.type <= CborEncoder::MajorType::Map) head.indefinite = true;
+    else TSW_THROW(CompactCodecException, "invalid CBOR item head");
+
+    return head;
+}
+
+
+bool CborDeserializerImpl::at_break(CompactReader &reader)
+{
+    if (reader.peek() != cbor_break) return false;
+
+    reader.read_byte();
+
+    return true;
+}
+
+
+String CborDeserializerImpl::read_string(CompactReader &reader, const Head &head)
+{
+    if (!head.indefinite)
+    {
+        auto data = reader.read_bytes(head.argument);
+        return String(reinterpret_cast<const char*>(data), head.argument);
+    }
+
+    // Chunks are definite strings of the same major type.
+    String result;
+
+    while (!at_break(reader))
+    {
+        auto chunk = read_head(reader);
+
+        if (chunk.type != head.type || chunk.indefinite) TSW_THROW(CompactCodecException, "invalid string chunk");
+        result += read_string(reader, chunk);
+    }
+
+    return result;
+}
+
+
+String CborDeserializerImpl::read_key(CompactReader &reader)
+{
+    auto head = read_head(reader);
+
+    if (head.type != CborEncoder::MajorType::Text) TSW_THROW(CompactCodecException, "map key is not a string");
+
+    return read_string(reader, head);
+}
+
+
+Object CborDeserializerImpl::read_map(CompactReader &reader, const Head &head)
+{
+    Object result;
+
+    if (!head.indefinite && head.argument > reader.remaining())
+    {
+        TSW_THROW(CompactCodecException, "map is larger than the data");
+    }
+
+    reader.enter();
+    for (uint64_t i = 0; head.indefinite ? !at_break(reader) : i < head.argument; ++i)
+    {
+        auto name = read_key(reader);
+
+        result.emplace_hint(result.end(), std::move(name), read_value(reader));
+    }
+    reader.leave();
+
+    return result;
+}
+
+
+ValueArray CborDeserializerImpl::read_array(CompactReader &reader, const Head &head)
+{
+    ValueArray result;
+
+    if (!head.indefinite)
+    {
+        // Every element takes at least one byte: malformed size will not exhaust the memory.
+        if (head.argument > reader.remaining()) TSW_THROW(CompactCodecException, "array is larger than the data");
+        result.reserve(head.argument);
+    }
+
+    reader.enter();
+    for (uint64_t i = 0; head.indefinite ? !at_break(reader) : i < head.argument; ++i)
+    {
+        result.push_back(read_value(reader));
+    }
+    reader.leave();
+
+    return result;
+}
+
+
+Value CborDeserializerImpl::read_tag(CompactReader &reader, uint64_t tag)
+{
+    switch (tag)
+    {
+        case CborEncoder::Tags::EpochTime:
+        {
+            auto seconds = read_value(reader);
+
+            if (seconds.is_int32()) return join_time(seconds.as_int32(), 0);
+            if (seconds.is_int64()) return join_time(seconds.as_int64(), 0);
+            if (seconds.is_double()) return Time(static_cast<Time::rep>(std::llround(seconds.as_double() * 1e9)));
+            TSW_THROW(CompactCodecException, "invalid epoch time");
+        }
+        case CborEncoder::Tags::ExtendedTime:
+        {
+            auto head = read_head(reader);
+
+            if (head.type != CborEncoder::MajorType::Map) TSW_THROW(CompactCodecException, "invalid extended time");
+
+            int64_t seconds = 0;
+            uint32_t nanoseconds = 0;
+
+            reader.enter();
+            for (uint64_t i = 0; head.indefinite ? !at_break(reader) : i < head.argument; ++i)
+            {
+                auto key = read_value(reader);
+                auto value = read_value(reader);
+
+                if (!key.is_int32()) TSW_THROW(CompactCodecException, "invalid extended time key");
+
+                if (key.as_int32() == CborEncoder::time_seconds_key)
+                {
+                    if (value.is_int32()) seconds = value.as_int32();
+                    else if (value.is_int64()) seconds = value.as_int64();
+                    else TSW_THROW(CompactCodecException, "invalid extended time seconds");
+                }
+                else if (key.as_int32() == CborEncoder::time_nanoseconds_key)
+                {
+                    if (!value.is_int32() || value.as_int32() < 0) TSW_THROW(CompactCodecException, "invalid extended time nanoseconds");
+                    nanoseconds = static_cast<uint32_t>(value.as_int32());
+                }
+            }
+            reader.leave();
+
+            return join_time(seconds, nanoseconds);
+        }
+        case CborEncoder::Tags::DoubleArrayLE:
+        case CborEncoder::Tags::Int32ArrayLE:
+        {
+            auto head = read_head(reader);
+
+            if (head.type != CborEncoder::MajorType::Bytes) TSW_THROW(CompactCodecException, "typed array is not a byte string");
+
+            if (!head.indefinite)
+            {
+                auto bytes = reader.read_bytes(head.argument);
+
+                if (tag == CborEncoder::Tags::DoubleArrayLE) return read_packed_le<DoubleArray>(bytes, head.argument);
+                return read_packed_le<Int32Array>(bytes, head.argument);
+            }
+
+            auto data = read_string(reader, head);
+            auto bytes = reinterpret_cast<const BinData::value_type*>(data.data());
+
+            if (tag == CborEncoder::Tags::DoubleArrayLE) return read_packed_le<DoubleArray>(bytes, data.size());
+            return read_packed_le<Int32Array>(bytes, data.size());
+        }
+    }
+
+    // Unknown tags are ignored: the tagged item is returned as is.
+    return read_value(reader);
+}
+
+
+Value CborDeserializerImpl::read_value(CompactReader &reader)
+{
+    return read_value(reader, read_head(reader));
+}
+
+
+Value CborDeserializerImpl::read_value(CompactReader &reader, const Head &head)
+{
+    switch (head.type)
+    {
+        case CborEncoder::MajorType::Unsigned:
+        case CborEncoder::MajorType::Negative:
+        {
+            if (head.argument > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+            {
+                TSW_THROW(CompactCodecException, "integer is out of the Int64 range");
+            }
+
+            int64_t value = static_cast<int64_t>(head.argument);
+
+            if (head.type == CborEncoder::MajorType::Negative) value = -1 - value;
+
+            // Int64 type is kept, even if the value is small.
+            if (head.info == 27 || value < std::numeric_limits<int32_t>::min() ||
+                value > std::numeric_limits<int32_t>::max()) return value;
+
+            return static_cast<int32_t>(value);
+        }
+        case CborEncoder::MajorType::Bytes:
+        {
+            if (!head.indefinite)
+            {
+                auto data = reader.read_bytes(head.argument);
+                return BinData(data, data + head.argument);
+            }
+
+            auto data = read_string(reader, head);
+            return BinData(data.begin(), data.end());
+        }
+        case CborEncoder::MajorType::Text:
+            return read_string(reader, head);
+        case CborEncoder::MajorType::Array:
+            return read_array(reader, head);
+        case CborEncoder::MajorType::Map:
+            return read_map(reader, head);
+        case CborEncoder::MajorType::Tag:
+        {
+            reader.enter();
+            auto result = read_tag(reader, head.argument);
+            reader.leave();
+
+            return result;
+        }
+        case CborEncoder::MajorType::Simple:
+            switch (head.info)
+            {
+                case cbor_false & 0x1f: return false;
+                case cbor_true & 0x1f: return true;
+                case cbor_null & 0x1f: return Null();
+                case cbor_undefined & 0x1f: return Undefined();
+                case 25: return half_to_double(static_cast<uint16_t>(head.argument));
+                case 26:
+                {
+                    uint32_t bits = static_cast<uint32_t>(head.argument);
+                    float value;
+
+                    memcpy(&value, &bits, sizeof(value));
+                    return static_cast<double>(value);
+                }
+                case 27:
+                {
+                    double value;
+
+                    memcpy(&value, &head.argument, sizeof(value));
+                    return value;
+                }
+            }
+    }
+
+    TSW_THROW(CompactCodecException, "unsupported CBOR item");
+}
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,115 @@
+/**
+  * @file cbor_impl.h
+  * @author Artiom N.(cl)2017
+  * @brief CBOR serializer/deserializer implementation's classes definition.
+  *
+  */
+
+#pragma once
+
+#include "tsw/message.h"
+#include "tsw/types.h"
+
+#include "compact_codec.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief CBOR (RFC 8949) items encoder.
+ *
+ * Int32 values are written in the shortest form, Int64 always with the 8 bytes argument,
+ * so both types survive the round trip. Time is the extended time tag (RFC 9581),
+ * packed arrays are the typed arrays tags (RFC 8746).
+ */
+struct CborEncoder
+{
+    enum MajorType : uint8_t
+    {
+        Unsigned = 0,
+        Negative = 1,
+        Bytes = 2,
+        Text = 3,
+        Array = 4,
+        Map = 5,
+        Tag = 6,
+        Simple = 7
+    };
+
+    enum Tags : uint64_t
+    {
+        EpochTime = 1,
+        // Little-endian typed arrays.
+        Int32ArrayLE = 78,
+        DoubleArrayLE = 86,
+        ExtendedTime = 1001
+    };
+
+    // Extended time map keys.
+    static constexpr int64_t time_seconds_key = 1;
+    static constexpr int64_t time_nanoseconds_key = -9;
+
+    // Document is an indefinite length map.
+    static void start_document(BinData &buffer);
+    static void finish_document(BinData &buffer, size_t fields_count);
+
+    static void write_undefined(BinData &buffer);
+    static void write_null(BinData &buffer);
+    static void write_bool(BinData &buffer, bool data);
+    static void write_int32(BinData &buffer, int32_t data);
+    static void write_int64(BinData &buffer, int64_t data);
+    static void write_double(BinData &buffer, double data);
+    static void write_string(BinData &buffer, const char *data, size_t size);
+    static void write_binary(BinData &buffer, const uint8_t *data, size_t size);
+    static void write_time(BinData &buffer, const Time &data);
+    static void write_double_array(BinData &buffer, const DoubleArray &data);
+    static void write_int32_array(BinData &buffer, const Int32Array &data);
+    static void write_array_header(BinData &buffer, size_t size);
+    static void write_map_header(BinData &buffer, size_t size);
+
+    static void write_head(BinData &buffer, MajorType type, uint64_t argument);
+};
+
+
+typedef CompactSerializerImpl<CborEncoder> CborSerializerImpl;
+
+
+class CborDeserializerImpl
+{
+public:
+    Object Deserialize(const BinData::value_type *data, size_t size);
+
+    /**
+     * @brief Read the "type" field only.
+     */
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size);
+
+private:
+    // Item head: major type and argument. Indefinite length is marked by the flag.
+    struct Head
+    {
+        CborEncoder::MajorType type;
+        uint8_t info;
+        uint64_t argument;
+        bool indefinite;
+    };
+
+private:
+    Head read_head(CompactReader &reader);
+    Value read_value(CompactReader &reader);
+    Value read_value(CompactReader &reader, const Head &head);
+    Object read_map(CompactReader &reader, const Head &head);
+    ValueArray read_array(CompactReader &reader, const Head &head);
+    String read_string(CompactReader &reader, const Head &head);
+    Value read_tag(CompactReader &reader, uint64_t tag);
+    String read_key(CompactReader &reader);
+    bool at_break(CompactReader &reader);
+};
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,63 @@
+/**
+  * @file cbor_serializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief CborSerializer class implementation.
+  *
+  */
+
+#include <memory>
+
+#include <tsw/cbor_serializer.h>
+#include <tsw/types.h>
+#include <tsw/wire_format.h>
+
+#include "cbor_impl.h"
+
+
+namespace tsw
+{
+
+CborSerializer::CborSerializer() : impl_(new impl::CborSerializerImpl)
+{}
+
+
+CborSerializer::~CborSerializer()
+{}
+
+
+BinData CborSerializer::SerializeMessage(const Message &message)
+{
+    return Serializer::SerializeMessage<impl::CborSerializerImpl>(message, *impl_);
+}
+
+
+void CborSerializer::SerializeMessageTo(const Message &message, BinData &buffer)
+{
+    impl_->reset(buffer);
+    WriteMessage<impl::CborSerializerImpl>(message, *impl_);
+    impl_->take_buffer(buffer);
+}
+
+
+std::unique_ptr<Serializer> CborSerializer::Clone() const
+{
+    return std::make_unique<CborSerializer>();
+}
+
+
+WireFormat CborSerializer::Format() const
+{
+    return WireFormat::Cbor;
+}
+
+
+BinData CborSerializer::SerializeObject(const Object &fields)
+{
+    impl_->clear();
+
+    for (const auto &field: fields) impl_->append_field(field.first, field.second);
+
+    return impl_->take_buffer();
+}
+
+} // namespace tsw
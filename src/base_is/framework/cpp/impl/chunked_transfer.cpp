@@ -0,0 +1,330 @@
+/**
+  * @file chunked_transfer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Chunked transfer of the messages with large binary fields.
+  *
+  */
+
+#include <algorithm>
+#include <string>
+#include <variant>
+
+#include <tsw/logger.h>
+#include <tsw/types.h>
+
+#include "binary_message.h"
+#include "chunked_transfer.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+// Frame fields.
+static const char transfer_id_field[] = "transfer_id";
+static const char message_type_field[] = "message_type";
+static const char creation_time_field[] = "c_time";
+static const char deadline_field[] = "deadline";
+static const char id_field[] = "m_id";
+static const char fields_field[] = "fields";
+static const char binaries_field[] = "binaries";
+static const char field_name_field[] = "field";
+static const char offset_field[] = "offset";
+static const char data_field[] = "data";
+
+
+static inline bool is_large(const Value &value, size_t chunk_size)
+{
+    return value.is_bindata() && value.as_bindata().size() > chunk_size;
+}
+
+
+static BinaryMessage make_message(MessageType type, NameValueMap &&fields, const Message &envelope, const Time &creation_time,
+                                  const Time &deadline, UID id)
+{
+    BinaryMessage message(type, std::move(fields),
+                          envelope.get_receiver_module_uid(), String(envelope.get_receiver_module_name()),
+                          ModuleClass(envelope.get_receiver_module_class()),
+                          envelope.get_sender_module_uid(), String(envelope.get_sender_module_name()),
+                          ModuleClass(envelope.get_sender_module_class()),
+                          Time(creation_time));
+
+    message.set_deadline(deadline);
+    message.set_id(id);
+
+    return message;
+}
+
+
+//----------------------------------------------------------------------------
+// TransferSplitter
+//----------------------------------------------------------------------------
+
+TransferSplitter::TransferSplitter(const Message &message, UID transfer_id, size_t chunk_size, UID message_id) :
+    message_(message), transfer_id_(transfer_id), chunk_size_(std::max<size_t>(chunk_size, 1)),
+    message_id_(message_id ? message_id : message.get_id())
+{
+    for (const auto &field: message_.get_fields())
+    {
+        if (!is_large(field.second, chunk_size_)) continue;
+
+        const auto &data = field.second.as_bindata();
+
+        for (size_t offset = 0; offset < data.size(); offset += chunk_size_)
+        {
+            chunks_.push_back(Chunk{ &field.first, &data, offset });
+        }
+    }
+
+    frames_count_ = chunks_.size() + 1;
+}
+
+
+Message TransferSplitter::frame(size_t index) const
+{
+    if (!index)
+    {
+        NameValueMap fields;
+        NameValueMap binaries;
+
+        for (const auto &field: message_.get_fields())
+        {
+            if (is_large(field.second, chunk_size_))
+            {
+                binaries.emplace(field.first, static_cast<int64_t>(field.second.as_bindata().size()));
+            }
+            else
+            {
+                fields.emplace(field);
+            }
+        }
+
+        NameValueMap head
+        {
+            std::make_pair(transfer_id_field, static_cast<int64_t>(transfer_id_)),
+            std::make_pair(message_type_field, static_cast<int>(message_.get_type())),
+            std::make_pair(creation_time_field, message_.get_creation_time()),
+            std::make_pair(fields_field, std::move(fields)),
+            std::make_pair(binaries_field, std::move(binaries))
+        };
+
+        // Frames aren't dropped on the way, reassembled message is dropped, if it's late.
+        if (message_.has_deadline()) head.emplace(deadline_field, message_.get_deadline());
+        if (message_id_) head.emplace(id_field, static_cast<int64_t>(message_id_));
+
+        return Message(MessageType::DataTransfer, std::move(head), message_.get_receiver_module_uid());
+    }
+
+    const auto &chunk = chunks_.at(index - 1);
+    auto data = chunk.data->data() + chunk.offset;
+
+    return Message(MessageType::DataTransfer, NameValueMap
+    {
+        std::make_pair(transfer_id_field, static_cast<int64_t>(transfer_id_)),
+        std::make_pair(field_name_field, *chunk.name),
+        std::make_pair(offset_field, static_cast<int64_t>(chunk.offset)),
+        std::make_pair(data_field, BinData(data, data + std::min(chunk_size_, chunk.data->size() - chunk.offset)))
+    }, message_.get_receiver_module_uid());
+}
+
+
+bool TransferSplitter::need_split(const Message &message, size_t chunk_size)
+{
+    const auto &fields = message.get_fields();
+
+    return std::any_of(fields.begin(), fields.end(),
+                       [chunk_size](const NameValueMap::value_type &field) { return is_large(field.second, chunk_size); });
+}
+
+
+//----------------------------------------------------------------------------
+// TransferAssembler
+//----------------------------------------------------------------------------
+
+TransferAssembler::TransferAssembler(MessageHandler handler, size_t max_transfers, size_t max_transfer_size) :
+    handler_(handler), stream_handler_(nullptr), max_transfers_(std::max<size_t>(max_transfers, 1)),
+    max_transfer_size_(max_transfer_size), dropped_frames_(0)
+{}
+
+
+bool TransferAssembler::add_frame(const Message &frame)
+{
+    const auto &fields = frame.get_fields();
+
+    try
+    {
+        auto transfer_id = static_cast<UID>(fields.at(transfer_id_field).as_int64());
+
+        if (fields.count(message_type_field))
+        {
+            // Head of the resumed transfer is repeated.
+            if (transfers_.count(transfer_id)) return true;
+
+            if (!start_transfer(transfer_id, frame))
+            {
+                LOG_TO("magistral", LogLevel::Warning, "Transfer %llu is larger than %zu bytes and dropped",
+                       static_cast<unsigned long long>(transfer_id), max_transfer_size_);
+                ++dropped_frames_;
+
+                return true;
+            }
+
+            auto transfer = transfers_.find(transfer_id);
+
+            return transfer->second.incomplete ? true : finish_transfer(transfer_id, transfer->second);
+        }
+
+        return add_chunk(transfer_id, fields);
+    }
+    catch (const std::out_of_range&)
+    {
+    }
+    catch (const std::bad_variant_access&)
+    {
+    }
+
+    // Peer's error doesn't break the connection: frame is dropped.
+    LOG_TO("magistral", LogLevel::Warning, "Incorrect transfer frame is dropped");
+    ++dropped_frames_;
+
+    return true;
+}
+
+
+bool TransferAssembler::start_transfer(UID transfer_id, const Message &head)
+{
+    const auto &fields = head.get_fields();
+    auto type = static_cast<MessageType>(fields.at(message_type_field).as_int32());
+    const auto &binaries = fields.at(binaries_field).as_object();
+
+    auto deadline = fields.find(deadline_field);
+    auto id = fields.find(id_field);
+    Transfer transfer{ make_message(type, NameValueMap(), head, fields.at(creation_time_field).as_time(),
+                                    deadline != fields.end() ? deadline->second.as_time() : Time::zero(),
+                                    id != fields.end() ? static_cast<UID>(id->second.as_int64()) : 0),
+                       fields.at(fields_field).as_object(), {}, 0 };
+
+    size_t total_size = 0;
+
+    for (const auto &binary: binaries)
+    {
+        // Sizes come from the peer: memory isn't reserved for them, until they are checked.
+        auto size = binary.second.as_int64();
+
+        if (size < 0 || static_cast<uint64_t>(size) > max_transfer_size_ - total_size) return false;
+
+        total_size += static_cast<size_t>(size);
+        transfer.binaries.emplace(binary.first, BinaryField{ 0, static_cast<size_t>(size) });
+        if (size) ++transfer.incomplete;
+    }
+
+    if (stream_handler_)
+    {
+        stream_handler_->on_envelope(transfer.envelope);
+        for (auto &field: transfer.fields) stream_handler_->on_field(field.first, std::move(field.second));
+        transfer.fields.clear();
+    }
+    else
+    {
+        for (const auto &binary: transfer.binaries)
+        {
+            BinData data;
+
+            data.reserve(binary.second.size);
+            transfer.fields[binary.first] = std::move(data);
+        }
+    }
+
+    if (transfers_order_.size() >= max_transfers_) drop_transfer(transfers_order_.front());
+
+    transfers_.emplace(transfer_id, std::move(transfer));
+    transfers_order_.push_back(transfer_id);
+
+    return true;
+}
+
+
+bool TransferAssembler::add_chunk(UID transfer_id, const NameValueMap &fields)
+{
+    auto transfer = transfers_.find(transfer_id);
+
+    // Head was lost or transfer was dropped: the rest is useless.
+    if (transfer == transfers_.end()) return true;
+
+    const auto &name = fields.at(field_name_field).as_string();
+    auto offset = static_cast<size_t>(fields.at(offset_field).as_int64());
+    const auto &data = fields.at(data_field).as_bindata();
+    auto binary = transfer->second.binaries.find(name);
+
+    if (binary == transfer->second.binaries.end() || offset + data.size() > binary->second.size)
+    {
+        drop_transfer(transfer_id);
+        LOG_TO("magistral", LogLevel::Warning, "Chunk is out of the transferred field \"%s\", transfer is dropped",
+               name.c_str());
+        ++dropped_frames_;
+
+        return true;
+    }
+
+    // Repeated chunk of the resumed transfer.
+    if (offset + data.size() <= binary->second.received) return true;
+
+    if (offset != binary->second.received)
+    {
+        drop_transfer(transfer_id);
+        LOG_TO("magistral", LogLevel::Warning, "Chunk of the field \"%s\" was lost, transfer is dropped", name.c_str());
+        ++dropped_frames_;
+
+        return true;
+    }
+
+    if (stream_handler_)
+    {
+        stream_handler_->on_binary_chunk(name, data.data(), data.size(), offset, binary->second.size);
+    }
+    else
+    {
+        auto &buffer = transfer->second.fields[name].as_bindata();
+        buffer.insert(buffer.end(), data.begin(), data.end());
+    }
+
+    binary->second.received += data.size();
+
+    if (binary->second.received < binary->second.size || --transfer->second.incomplete) return true;
+
+    return finish_transfer(transfer_id, transfer->second);
+}
+
+
+bool TransferAssembler::finish_transfer(UID transfer_id, Transfer &transfer)
+{
+    if (stream_handler_)
+    {
+        drop_transfer(transfer_id);
+        stream_handler_->on_message_end();
+
+        return true;
+    }
+
+    auto message = make_message(transfer.envelope.get_type(), std::move(transfer.fields), transfer.envelope,
+                                transfer.envelope.get_creation_time(), transfer.envelope.get_deadline(),
+                                transfer.envelope.get_id());
+
+    drop_transfer(transfer_id);
+
+    return handler_(message);
+}
+
+
+void TransferAssembler::drop_transfer(UID transfer_id)
+{
+    transfers_.erase(transfer_id);
+    transfers_order_.erase(std::remove(transfers_order_.begin(), transfers_order_.end(), transfer_id),
+                           transfers_order_.end());
+}
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,142 @@
+/**
+  * @file chunked_transfer.h
+  * @author Artiom N.(cl)2017
+  * @brief Splitting of the messages with large binary fields into frames and their reassembly.
+  *
+  */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "tsw/bson_stream_deserializer.h"
+#include "tsw/message.h"
+#include "tsw/types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Splitter of the message into the DataTransfer frames.
+ *
+ * Head frame keeps the envelope and small fields, chunk frames keep the parts of the binary fields,
+ * which are larger than the chunk size. Frames are the same for the same message, so the sending
+ * may be resumed from any frame.
+ */
+class TransferSplitter
+{
+public:
+    /**
+     * @param message_id identifier, which is sent instead of the message one, zero: message identifier.
+     */
+    TransferSplitter(const Message &message, UID transfer_id, size_t chunk_size, UID message_id = 0);
+
+public:
+    size_t frames_count() const { return frames_count_; }
+
+    /**
+     * @brief Build frame with the given index: head is the first.
+     */
+    Message frame(size_t index) const;
+
+    /**
+     * @brief Return true, if the message has fields, which need the chunked transfer.
+     */
+    static bool need_split(const Message &message, size_t chunk_size);
+
+private:
+    struct Chunk
+    {
+        const String *name;
+        const BinData *data;
+        size_t offset;
+    };
+
+private:
+    const Message &message_;
+    const UID transfer_id_;
+    const size_t chunk_size_;
+    const UID message_id_;
+    size_t frames_count_;
+    std::vector<Chunk> chunks_;
+};
+
+
+/**
+ * @brief Assembler of the DataTransfer frames.
+ *
+ * Message is reassembled in memory and passed to the message handler or, if stream handler is set,
+ * its parts are passed to the stream handler as they arrive. Repeated frames of the resumed
+ * transfer are skipped. Calls for the concurrent transfers may interleave.
+ * Incorrect frame or lost chunk doesn't break the connection: the frame and its transfer are dropped and logged.
+ */
+class TransferAssembler
+{
+public:
+    // Incomplete transfers count, after which the oldest one is dropped.
+    static constexpr size_t default_max_transfers = 16;
+    // Total size of the binary fields of one message, which is accepted: head with larger sizes is dropped.
+    static constexpr size_t default_max_transfer_size = 256 * 1024 * 1024;
+
+public:
+    explicit TransferAssembler(MessageHandler handler, size_t max_transfers = default_max_transfers,
+                               size_t max_transfer_size = default_max_transfer_size);
+
+public:
+    void set_stream_handler(StreamHandler *handler) { stream_handler_ = handler; }
+
+    /**
+     * @brief Process the received frame.
+     * @return message handler result for the completed message, true otherwise.
+     */
+    bool add_frame(const Message &frame);
+
+    size_t transfers_count() const { return transfers_.size(); }
+
+    /// Count of the incorrect frames and lost chunks, which broke their transfers.
+    uint64_t dropped_count() const { return dropped_frames_; }
+
+private:
+    struct BinaryField
+    {
+        size_t received;
+        size_t size;
+    };
+
+    struct Transfer
+    {
+        // Message without fields.
+        Message envelope;
+        NameValueMap fields;
+        std::map<String, BinaryField> binaries;
+        size_t incomplete;
+    };
+
+private:
+    // Return false, if transfer is too large.
+    bool start_transfer(UID transfer_id, const Message &head);
+    bool add_chunk(UID transfer_id, const NameValueMap &fields);
+    bool finish_transfer(UID transfer_id, Transfer &transfer);
+    void drop_transfer(UID transfer_id);
+
+private:
+    MessageHandler handler_;
+    StreamHandler *stream_handler_;
+    const size_t max_transfers_;
+    const size_t max_transfer_size_;
+    std::map<UID, Transfer> transfers_;
+    // Transfers in the start order.
+    std::deque<UID> transfers_order_;
+    uint64_t dropped_frames_;
+};
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,350 @@
+/**
+  * @file compact_codec.h
+  * @author Artiom N.(cl)2017
+  * @brief Common parts of the MessagePack and CBOR codecs.
+  *
+  */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <variant>
+
+#include "tsw/error.h"
+#include "tsw/types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+class CompactCodecException : public Exception
+{
+    using Exception::Exception;
+};
+
+
+// Packed arrays are little-endian: on such hosts they are copied as is.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+constexpr bool compact_packed_native = true;
+#else
+constexpr bool compact_packed_native = false;
+#endif
+
+
+// Both formats are big-endian.
+template<typename T>
+inline void write_be(BinData &buffer, T value)
+{
+    static_assert(std::is_unsigned_v<T>, "only unsigned integers are written");
+
+    for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8)
+    {
+        buffer.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+
+inline void write_bytes(BinData &buffer, const void *data, size_t size)
+{
+    const auto *bytes = static_cast<const uint8_t*>(data);
+
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+
+inline uint64_t double_bits(double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+
+// Time as the seconds and the non-negative nanoseconds part, as both formats need.
+inline std::pair<int64_t, uint32_t> split_time(const Time &time)
+{
+    const int64_t ns_per_second = 1000000000;
+    int64_t seconds = time.count() / ns_per_second;
+    int64_t nanoseconds = time.count() % ns_per_second;
+
+    if (nanoseconds < 0)
+    {
+        --seconds;
+        nanoseconds += ns_per_second;
+    }
+
+    return std::make_pair(seconds, static_cast<uint32_t>(nanoseconds));
+}
+
+
+inline Time join_time(int64_t seconds, uint32_t nanoseconds)
+{
+    if (nanoseconds > 999999999) TSW_THROW(CompactCodecException, "invalid nanoseconds value");
+
+    return Time(seconds * 1000000000 + nanoseconds);
+}
+
+
+/**
+ * @brief Bounds checked big-endian input, shared by the decoders.
+ */
+class CompactReader
+{
+public:
+    // Nested containers limit: input comes from the network.
+    static constexpr int max_depth = 128;
+
+public:
+    CompactReader(const BinData::value_type *data, size_t size) : pos_(data), end_(data + size) {}
+
+public:
+    bool at_end() const { return pos_ == end_; }
+    size_t remaining() const { return end_ - pos_; }
+
+    uint8_t peek() const
+    {
+        need(1);
+        return *pos_;
+    }
+
+    uint8_t read_byte()
+    {
+        need(1);
+        return *pos_++;
+    }
+
+    template<typename T>
+    T read_be()
+    {
+        need(sizeof(T));
+
+        T value = 0;
+
+        for (size_t i = 0; i < sizeof(T); ++i) value = static_cast<T>((value << 8) | pos_[i]);
+        pos_ += sizeof(T);
+
+        return value;
+    }
+
+    const BinData::value_type *read_bytes(size_t size)
+    {
+        need(size);
+
+        auto result = pos_;
+        pos_ += size;
+
+        return result;
+    }
+
+    double read_double()
+    {
+        uint64_t bits = read_be<uint64_t>();
+        double result;
+
+        memcpy(&result, &bits, sizeof(result));
+
+        return result;
+    }
+
+    float read_float()
+    {
+        uint32_t bits = read_be<uint32_t>();
+        float result;
+
+        memcpy(&result, &bits, sizeof(result));
+
+        return result;
+    }
+
+    void enter()
+    {
+        if (++depth_ > max_depth) TSW_THROW(CompactCodecException, "nesting is too deep");
+    }
+
+    void leave() { --depth_; }
+
+private:
+    void need(size_t size) const
+    {
+        if (size > remaining()) TSW_THROW(CompactCodecException, "unexpected end of data");
+    }
+
+private:
+    const BinData::value_type *pos_;
+    const BinData::value_type *end_;
+    int depth_ = 0;
+};
+
+
+/**
+ * @brief Decode little-endian packed numeric array payload (the same layout, as in BSON).
+ */
+template<typename ArrayType>
+ArrayType read_packed_le(const BinData::value_type *data, size_t size)
+{
+    typedef typename ArrayType::value_type T;
+    typedef std::conditional_t<sizeof(T) == sizeof(uint64_t), uint64_t, uint32_t> UInt;
+
+    if (size % sizeof(T)) TSW_THROW(CompactCodecException, "packed array size is not a multiple of the element size");
+
+    ArrayType result(size / sizeof(T));
+
+    if constexpr (compact_packed_native)
+    {
+        if (size) memcpy(result.data(), data, size);
+        return result;
+    }
+
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        UInt bits = 0;
+
+        for (size_t b = 0; b < sizeof(T); ++b) bits |= static_cast<UInt>(data[i * sizeof(T) + b]) << (b * 8);
+        memcpy(&result[i], &bits, sizeof(T));
+    }
+
+    return result;
+}
+
+
+template<typename ArrayType>
+void write_packed_le(BinData &buffer, const ArrayType &data)
+{
+    typedef typename ArrayType::value_type T;
+    typedef std::conditional_t<sizeof(T) == sizeof(uint64_t), uint64_t, uint32_t> UInt;
+
+    if constexpr (compact_packed_native)
+    {
+        write_bytes(buffer, data.data(), data.size() * sizeof(T));
+        return;
+    }
+
+    buffer.reserve(buffer.size() + data.size() * sizeof(T));
+
+    for (const auto &element: data)
+    {
+        UInt bits;
+
+        memcpy(&bits, &element, sizeof(bits));
+        for (size_t b = 0; b < sizeof(T); ++b) buffer.push_back(static_cast<uint8_t>(bits >> (b * 8)));
+    }
+}
+
+
+/**
+ * @brief Serializer over a format Encoder, compatible with the Serializer templates.
+ *
+ * Encoder writes the items into the buffer: document (top level map, which fields count
+ * is known only at the end), strings, numbers, containers and the Value-specific types.
+ */
+template<typename Encoder>
+class CompactSerializerImpl
+{
+public:
+    CompactSerializerImpl() { start(); }
+
+public:
+    template<typename T>
+    void append_field(const String &name, const T &data)
+    {
+        if (need_init_) start();
+
+        Encoder::write_string(buffer_, name.data(), name.size());
+        write(data);
+        ++fields_count_;
+    }
+
+    void append_field(const String &name, const String::value_type *data) { append_field(name, String(data)); }
+
+public:
+    void clear() { start(); }
+
+    BinData take_buffer()
+    {
+        BinData result;
+
+        take_buffer(result);
+
+        return result;
+    }
+
+    /**
+     * @brief Start a new document in the buffer memory. Buffer gets the previous writer's memory.
+     */
+    void reset(BinData &buffer)
+    {
+        buffer_.swap(buffer);
+        start();
+    }
+
+    /**
+     * @brief Finish the document and exchange it with the buffer.
+     */
+    void take_buffer(BinData &buffer)
+    {
+        if (need_init_) start();
+
+        Encoder::finish_document(buffer_, fields_count_);
+        need_init_ = true;
+        buffer_.swap(buffer);
+    }
+
+private:
+    void start()
+    {
+        buffer_.clear();
+        Encoder::start_document(buffer_);
+        fields_count_ = 0;
+        need_init_ = false;
+    }
+
+private:
+    void write(const Undefined&) { Encoder::write_undefined(buffer_); }
+    void write(const Null&) { Encoder::write_null(buffer_); }
+    void write(bool data) { Encoder::write_bool(buffer_, data); }
+    void write(int32_t data) { Encoder::write_int32(buffer_, data); }
+    void write(int64_t data) { Encoder::write_int64(buffer_, data); }
+    void write(double data) { Encoder::write_double(buffer_, data); }
+    void write(const String &data) { Encoder::write_string(buffer_, data.data(), data.size()); }
+    void write(const BinData &data) { Encoder::write_binary(buffer_, data.data(), data.size()); }
+    void write(const Time &data) { Encoder::write_time(buffer_, data); }
+    void write(const DoubleArray &data) { Encoder::write_double_array(buffer_, data); }
+    void write(const Int32Array &data) { Encoder::write_int32_array(buffer_, data); }
+
+    void write(const ValueArray &data)
+    {
+        Encoder::write_array_header(buffer_, data.size());
+        for (const auto &element: data) write(element);
+    }
+
+    void write(const Object &data)
+    {
+        Encoder::write_map_header(buffer_, data.size());
+        for (const auto &field: data)
+        {
+            Encoder::write_string(buffer_, field.first.data(), field.first.size());
+            write(field.second);
+        }
+    }
+
+    void write(const Value &data)
+    {
+        std::visit([this](const auto &element) { write(element); }, static_cast<const ValueBase&>(data));
+    }
+
+private:
+    BinData buffer_;
+    size_t fields_count_ = 0;
+    bool need_init_ = true;
+};
+
+} // namespace impl
+
+} // namespace tsw
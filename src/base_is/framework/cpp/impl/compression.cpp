@@ -0,0 +1,366 @@
+/**
+  * @file compression.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Magistral frames compression implementation.
+  *
+  */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(TSW_WITH_LZ4)
+#include <lz4.h>
+#endif
+
+#if defined(TSW_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#include <tsw/bson_serializer.h>
+#include <tsw/compression.h>
+#include <tsw/error.h>
+#include <tsw/json_serializer.h>
+
+
+namespace tsw
+{
+
+// Header: magic, flags, BSON breaker and source size.
+static constexpr size_t header_size = 8;
+static constexpr size_t dictionary_id_size = 4;
+static constexpr BinData::value_type header_magic[] = { 'T', 'Z' };
+static constexpr BinData::value_type header_breaker = 0xff;
+static constexpr uint8_t compression_mask = 0x0f;
+static constexpr uint8_t dictionary_flag = 0x10;
+
+#if defined(TSW_WITH_ZSTD)
+static constexpr int zstd_level = 3;
+#endif
+
+
+static inline void write_uint32(BinData::value_type *data, uint32_t value)
+{
+    for (size_t i = 0; i < sizeof(value); ++i) data[i] = static_cast<BinData::value_type>(value >> (8 * i));
+}
+
+
+static inline uint32_t read_uint32(const BinData::value_type *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+
+// FNV-1a.
+static uint32_t dictionary_id(const BinData &dictionary)
+{
+    uint32_t hash = 2166136261u;
+
+    for (auto c: dictionary) hash = (hash ^ c) * 16777619u;
+
+    return hash;
+}
+
+
+const char *compression_name(Compression compression)
+{
+    switch (compression)
+    {
+        case Compression::Lz4: return "lz4";
+        case Compression::Zstd: return "zstd";
+        default: return "none";
+    }
+}
+
+
+Compression compression_from_name(const String &name)
+{
+    for (auto compression: { Compression::Lz4, Compression::Zstd })
+    {
+        if (name == compression_name(compression)) return compression;
+    }
+
+    return Compression::None;
+}
+
+
+Compressions supported_compressions()
+{
+    Compressions result;
+
+#if defined(TSW_WITH_ZSTD)
+    result.push_back(Compression::Zstd);
+#endif
+#if defined(TSW_WITH_LZ4)
+    result.push_back(Compression::Lz4);
+#endif
+
+    return result;
+}
+
+
+Compression choose_compression(const ValueArray &offered, const Compressions &supported)
+{
+    for (const auto &name: offered)
+    {
+        if (!name.is_string()) continue;
+
+        auto compression = compression_from_name(name.as_string());
+
+        if (compression != Compression::None &&
+            std::find(supported.begin(), supported.end(), compression) != supported.end()) return compression;
+    }
+
+    return Compression::None;
+}
+
+
+const BinData &default_compression_dictionary()
+{
+    static const BinData dictionary = []()
+    {
+        const Object envelope
+        {
+            { "type", 0 },
+            { "sender_m_uid", int64_t(0) },
+            { "sender_m_name", "" },
+            { "sender_m_class", "" },
+            { "receiver_m_uid", int64_t(0) },
+            { "receiver_m_name", "" },
+            { "receiver_m_class", "" },
+            { "c_time", Time(0) },
+            { "fields", Object{ { "name", "" }, { "m_time", Time(0) } } }
+        };
+
+        BinData result = BsonSerializer().SerializeObject(envelope);
+        BinData json = JsonSerializer(JsonStyle::Compact).SerializeObject(envelope);
+
+        result.insert(result.end(), json.begin(), json.end());
+
+        return result;
+    }();
+
+    return dictionary;
+}
+
+
+//----------------------------------------------------------------------------
+// Codecs
+//----------------------------------------------------------------------------
+
+struct FrameCompressor::Dictionaries
+{
+#if defined(TSW_WITH_ZSTD)
+    ZSTD_CDict *zstd_cdict = nullptr;
+    ZSTD_DDict *zstd_ddict = nullptr;
+
+    ~Dictionaries()
+    {
+        ZSTD_freeCDict(zstd_cdict);
+        ZSTD_freeDDict(zstd_ddict);
+    }
+#endif
+};
+
+
+#if defined(TSW_WITH_LZ4)
+static size_t lz4_compress(const BinData::value_type *data, size_t size, BinData::value_type *output, size_t capacity,
+                           const BinData &dictionary)
+{
+    // Stream keeps the dictionary hash table: every thread needs own one.
+    thread_local std::unique_ptr<LZ4_stream_t, decltype(&LZ4_freeStream)> stream(LZ4_createStream(), LZ4_freeStream);
+
+    LZ4_resetStream_fast(stream.get());
+    if (!dictionary.empty())
+    {
+        LZ4_loadDict(stream.get(), reinterpret_cast<const char*>(dictionary.data()), static_cast<int>(dictionary.size()));
+    }
+
+    int result = LZ4_compress_fast_continue(stream.get(), reinterpret_cast<const char*>(data),
+                                            reinterpret_cast<char*>(output), static_cast<int>(size),
+                                            static_cast<int>(capacity), 1);
+
+    return result > 0 ? static_cast<size_t>(result) : 0;
+}
+
+
+static void lz4_decompress(const BinData::value_type *data, size_t size, BinData::value_type *output, size_t output_size,
+                           const BinData *dictionary)
+{
+    int result = dictionary ?
+        LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(output),
+                                      static_cast<int>(size), static_cast<int>(output_size),
+                                      reinterpret_cast<const char*>(dictionary->data()), static_cast<int>(dictionary->size())) :
+        LZ4_decompress_safe(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(output),
+                            static_cast<int>(size), static_cast<int>(output_size));
+
+    if (result < 0 || static_cast<size_t>(result) != output_size) TSW_THROW(CompressionException, "LZ4 frame is corrupted");
+}
+#endif
+
+
+#if defined(TSW_WITH_ZSTD)
+static size_t zstd_compress(const BinData::value_type *data, size_t size, BinData::value_type *output, size_t capacity,
+                            const ZSTD_CDict *dictionary)
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+
+    size_t result = dictionary ?
+        ZSTD_compress_usingCDict(context.get(), output, capacity, data, size, dictionary) :
+        ZSTD_compressCCtx(context.get(), output, capacity, data, size, zstd_level);
+
+    return ZSTD_isError(result) ? 0 : result;
+}
+
+
+static void zstd_decompress(const BinData::value_type *data, size_t size, BinData::value_type *output, size_t output_size,
+                            const ZSTD_DDict *dictionary)
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+
+    size_t result = dictionary ?
+        ZSTD_decompress_usingDDict(context.get(), output, output_size, data, size, dictionary) :
+        ZSTD_decompressDCtx(context.get(), output, output_size, data, size);
+
+    if (ZSTD_isError(result))
+    {
+        TSW_THROW(CompressionException, String("zstd frame is corrupted: ") + ZSTD_getErrorName(result));
+    }
+    if (result != output_size) TSW_THROW(CompressionException, "zstd frame is corrupted");
+}
+#endif
+
+
+//----------------------------------------------------------------------------
+// FrameCompressor
+//----------------------------------------------------------------------------
+
+FrameCompressor::FrameCompressor(Compression compression, size_t threshold, const BinData &dictionary,
+                                 size_t max_frame_size) :
+    compression_(compression),
+    threshold_(std::max(threshold, header_size + dictionary_id_size)),
+    max_frame_size_(std::min(max_frame_size, static_cast<size_t>(std::numeric_limits<int32_t>::max()))),
+    dictionary_(dictionary),
+    dictionary_id_(tsw::dictionary_id(dictionary)),
+    dictionaries_(new Dictionaries)
+{
+    auto supported = supported_compressions();
+
+    if (compression_ != Compression::None && std::find(supported.begin(), supported.end(), compression_) == supported.end())
+    {
+        TSW_THROW(CompressionException, String("compression \"") + compression_name(compression_) + "\" is not supported");
+    }
+
+#if defined(TSW_WITH_ZSTD)
+    if (!dictionary_.empty())
+    {
+        dictionaries_->zstd_cdict = ZSTD_createCDict(dictionary_.data(), dictionary_.size(), zstd_level);
+        dictionaries_->zstd_ddict = ZSTD_createDDict(dictionary_.data(), dictionary_.size());
+        if (!dictionaries_->zstd_cdict || !dictionaries_->zstd_ddict)
+        {
+            TSW_THROW(CompressionException, "zstd dictionary can't be created");
+        }
+    }
+#endif
+}
+
+
+FrameCompressor::~FrameCompressor()
+{}
+
+
+bool FrameCompressor::compress(const BinData::value_type *data, size_t size, BinData &output) const
+{
+    // Peer can't decompress the larger frame.
+    if (compression_ == Compression::None || size < threshold_ || size > max_frame_size_) return false;
+
+    bool use_dictionary = !dictionary_.empty();
+    size_t data_offset = header_size + (use_dictionary ? dictionary_id_size : 0);
+    // Compressed frame, which isn't less, is useless.
+    size_t capacity = size - data_offset;
+    size_t compressed_size = 0;
+
+    output.resize(data_offset + capacity);
+
+    switch (compression_)
+    {
+#if defined(TSW_WITH_LZ4)
+        case Compression::Lz4:
+            compressed_size = lz4_compress(data, size, output.data() + data_offset, capacity, dictionary_);
+        break;
+#endif
+#if defined(TSW_WITH_ZSTD)
+        case Compression::Zstd:
+            compressed_size = zstd_compress(data, size, output.data() + data_offset, capacity, dictionaries_->zstd_cdict);
+        break;
+#endif
+        default:
+        break;
+    }
+
+    if (!compressed_size) return false;
+
+    output.resize(data_offset + compressed_size);
+    output[0] = header_magic[0];
+    output[1] = header_magic[1];
+    output[2] = static_cast<uint8_t>(compression_) | (use_dictionary ? dictionary_flag : 0);
+    output[3] = header_breaker;
+    write_uint32(output.data() + 4, static_cast<uint32_t>(size));
+    if (use_dictionary) write_uint32(output.data() + header_size, dictionary_id_);
+
+    return true;
+}
+
+
+void FrameCompressor::decompress(const BinData::value_type *data, size_t size, BinData &output) const
+{
+    if (!is_compressed(data, size)) TSW_THROW(CompressionException, "frame is not compressed");
+
+    auto compression = static_cast<Compression>(data[2] & compression_mask);
+    bool use_dictionary = data[2] & dictionary_flag;
+    size_t output_size = read_uint32(data + 4);
+    size_t data_offset = header_size;
+
+    // Size is taken from the frame: it's checked before the allocation.
+    if (output_size > max_frame_size_)
+    {
+        TSW_THROW(CompressionException, "decompressed frame size " + std::to_string(output_size) + " exceeds the limit");
+    }
+
+    if (use_dictionary)
+    {
+        if (size < header_size + dictionary_id_size || read_uint32(data + header_size) != dictionary_id_ || dictionary_.empty())
+        {
+            TSW_THROW(CompressionException, "frame is compressed with an unknown dictionary");
+        }
+        data_offset += dictionary_id_size;
+    }
+
+    output.resize(output_size);
+
+    switch (compression)
+    {
+#if defined(TSW_WITH_LZ4)
+        case Compression::Lz4:
+            lz4_decompress(data + data_offset, size - data_offset, output.data(), output_size,
+                           use_dictionary ? &dictionary_ : nullptr);
+        break;
+#endif
+#if defined(TSW_WITH_ZSTD)
+        case Compression::Zstd:
+            zstd_decompress(data + data_offset, size - data_offset, output.data(), output_size,
+                            use_dictionary ? dictionaries_->zstd_ddict : nullptr);
+        break;
+#endif
+        default:
+            TSW_THROW(CompressionException, String("compression \"") + compression_name(compression) + "\" is not supported");
+    }
+}
+
+
+bool FrameCompressor::is_compressed(const BinData::value_type *data, size_t size)
+{
+    return size >= header_size && data[0] == header_magic[0] && data[1] == header_magic[1] && data[3] == header_breaker;
+}
+
+} // namespace tsw
@@ -7,16 +7,17 @@
 
 #pragma once
 
-#include <list>
-#include <map>
+#include <stdexcept>
 
 #include "tsw/error.h"
 #include <tsw/magistral.h>
 #include "tsw/message.h"
 #include "tsw/metadata.h"
+#include "tsw/schema_registry.h"
 #include "tsw/types.h"
 
-#include "functional_helper.h"
+#include "activity_registry.h"
+#include "handler_executor.h"
 
 
 namespace tsw
@@ -37,32 +38,28 @@ public:
 
 public:
     /**
-     * @brief Append metadata to the controller map.
+     * @brief Append metadata to the controller registry.
      */
     void append_metadata(const UID module_uid, const EAMetadataList &metadata)
     {
-        auto module_metadata = metadata_container_[module_uid];
-
-        for (auto i: metadata)
-        {
-            module_metadata.emplace(i.get_name(), i);
-        }
+        registry_.append(module_uid, metadata);
     }
 
     void remove_metadata(UID module_uid, const StringList &metadata)
     {
-        auto module_metadata = metadata_container_[module_uid];
-
-        for (auto i: metadata)
-        {
-            module_metadata.erase(i);
-        }
+        registry_.remove(module_uid, metadata);
     }
 
     void announce_metadata(UID module_uid, const EAMetadataList &metadata, MessageType message_type)
     {
         append_metadata(module_uid, metadata);
 
+        // Announced activities are sent with their schemes, when the schema format is used.
+        if (auto schema_registry = magistral_->get_schema_registry())
+        {
+            for (auto const& i : metadata) schema_registry->register_scheme(activity_type(message_type), i);
+        }
+
         NameValueMap msg_fields;
         ValueArray md;
 
@@ -96,13 +93,18 @@ public:
 
         msg_fields["metadata"] = std::move(md);
 
-        magistral_->send_message(message_type, msg_fields, module_uid);
+        magistral_->send_message(message_type, std::move(msg_fields), module_uid);
     }
 
     void denounce_metadata(UID module_uid, const StringList &metadata_list, MessageType message_type)
     {
         remove_metadata(module_uid, metadata_list);
 
+        if (auto schema_registry = magistral_->get_schema_registry())
+        {
+            for (auto const& i : metadata_list) schema_registry->unregister_scheme(activity_type(message_type), i);
+        }
+
         Object md;
         ValueArray va;
 
@@ -114,10 +116,10 @@ public:
     void generate_activity(UID module_uid, const String activity_name, const NameValueMap &fields,
                            MessageType message_type)
     {
-        auto msg_fields = std::move(fields);
+        auto msg_fields = fields;
 
         msg_fields["name"] = activity_name;
-        magistral_->send_message(message_type, fields, module_uid);
+        magistral_->send_message(message_type, std::move(msg_fields), module_uid);
     }
 
     EAMetadataList &&get_metadata(MessageType message_type)
@@ -131,9 +133,13 @@ public:
 
         auto metadata_from_storage = [&]()
         {
-            for (auto activity: metadata_container_.at(module_uid))
+            auto module = registry_.get_module(module_uid);
+
+            if (!module) throw std::out_of_range("module has no metadata");
+
+            for (const auto &activity: *module)
             {
-                result.push_back(activity.second.metadata);
+                result.push_back(activity.second->metadata);
             }
         };
 
@@ -147,61 +153,76 @@ public:
             metadata_from_storage();
         }
 
-        //metadata_container_;
-
         //[](const Message& message) -> bool { return true; }
         return std::move(result);
     }
 
     void register_activity_handler(UID module_uid, const String &activity_name, HandlerType handler)
     {
-        auto module_activity = metadata_container_[module_uid].at(activity_name);
-        module_activity.handlers.push_back(handler);
+        if (!registry_.add_handler(module_uid, activity_name, handler))
+        {
+            throw std::out_of_range("activity \"" + activity_name + "\" is not announced");
+        }
     }
 
     void unregister_activity_handler(UID module_uid, String activity_name, HandlerType handler)
     {
-        auto module_activity = metadata_container_[module_uid][activity_name];
-        HandlerList &handlers = module_activity.handlers;
-
-        for (auto i = handlers.begin(); i != handlers.end(); ++i)
-        {
-            if (*i == handler) handlers.erase(i);
-        }
+        registry_.remove_handler(module_uid, activity_name, handler);
     }
 
-    void run_activity_handlers(UID module_uid, const String &activity_name, const NameValueMap &parameters, Module &generator)
+    /**
+     * @brief Call handlers of the activity by the execution policy.
+     * Detached handlers may be called after the return: they get the copies of the activity and the generator.
+     */
+    void run_activity_handlers(UID module_uid, const String &activity_name, const ActivityType &activity, Module &generator)
     {
-        auto module_metadata = metadata_container_[module_uid][activity_name];
+        // Handlers are called from the snapshot: registry isn't locked and the list isn't copied.
+        auto handlers = registry_.get_handlers(module_uid, activity_name);
+
+        if (!handlers || handlers->empty()) return;
 
-        for (auto i: module_metadata.handlers)
+        if (!executor_.is_detached())
         {
-            i(generator, parameters);
+            executor_.run(handlers, [&activity, &generator](const HandlerType &handler) { handler(generator, activity); });
+            return;
         }
+
+        // Activity and generator are copied once for all handlers, which may outlive the caller.
+        auto owned = std::make_shared<const ActivityType>(activity);
+        auto owned_generator = std::make_shared<Module>(generator);
+
+        executor_.run(handlers, [owned, owned_generator](const HandlerType &handler) { handler(*owned_generator, *owned); });
     }
 
-private:
-    typedef std::list<HandlerType> HandlerList;
+    void set_execution_policy(const HandlerExecutionPolicy &policy)
+    {
+        executor_.set_policy(policy);
+    }
 
-    struct ActivityData
+    HandlerTimings get_handler_timings(UID module_uid, const String &activity_name) const
     {
-        ActivityData(const EAMetadata &m) : metadata(m) {}
-        ActivityData(EAMetadata &&m) : metadata(std::move(m)) {}
-        ActivityData() : metadata("", nullptr, "", FieldUIDFieldHeaderMap())
-        {
-            static_assert(true, "ActivityData is not default constructible!");
-        }
-        ActivityData &operator=(const ActivityData&) = default;
+        HandlerTimings result;
+        auto handlers = registry_.get_handlers(module_uid, activity_name);
 
-        const EAMetadata metadata;
-        HandlerList handlers;
-    };
+        if (!handlers) return result;
 
-    typedef std::map<String, ActivityData> ModuleMetadata;
+        for (const auto &subscription: *handlers) result.push_back(subscription.state->timing());
+
+        return result;
+    }
+
+private:
+    // Type of the activity messages by the type of the announcement.
+    static MessageType activity_type(MessageType message_type)
+    {
+        return message_type == MessageType::AnnounceModuleActions || message_type == MessageType::DenounceModuleActions ?
+            MessageType::Action : MessageType::Event;
+    }
 
 private:
     std::shared_ptr<Magistral> magistral_;
-    std::map<UID, ModuleMetadata> metadata_container_;
+    ActivityRegistry<Subscription<HandlerType>> registry_;
+    HandlerExecutor executor_;
 };
 
 } // namespace impl
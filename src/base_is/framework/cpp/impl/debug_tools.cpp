@@ -42,6 +42,14 @@ struct ValueVisualizeVisitor
         for (int i = 0; i < depth; ++i) std::cout << ' ';
     }
 
+    template<typename ArrayType>
+    void print_packed(const ArrayType &val) const
+    {
+        std::cout << "[";
+        for (size_t i = 0; i < val.size(); ++i) std::cout << (i ? ", " : "") << val[i];
+        std::cout << "]" << (depth_ > depth_shift ? "," : "") << std::endl;
+    }
+
     void operator()(const Undefined &) const
     {
         std::cout << "Undefined" << (depth_ > depth_shift ? "," : "") << std::endl;
@@ -101,6 +109,16 @@ struct ValueVisualizeVisitor
         std::cout << "}" << (depth_ > depth_shift ? "," : "") << std::endl;
     }
 
+    void operator()(const DoubleArray &val) const
+    {
+        print_packed(val);
+    }
+
+    void operator()(const Int32Array &val) const
+    {
+        print_packed(val);
+    }
+
     void operator()(const bool &val) const
     {
         std::cout << (val ? "true" : "false") << std::endl;
@@ -14,19 +14,146 @@
 namespace tsw
 {
 
+// Text formats don't keep the integer width: small UID is parsed as Int32.
+static UID uid_from_value(const Value &value)
+{
+    return static_cast<UID>(value.is_int32() ? value.as_int32() : value.as_int64());
+}
+
+
+// Deadline is optional: it's written only for the messages, which have it.
+static Time deadline_from_view(const BsonView &envelope)
+{
+    auto deadline = envelope.get_value("deadline");
+
+    return deadline.is_time() ? deadline.as_time() : Time::zero();
+}
+
+
+static UID id_from_view(const BsonView &envelope)
+{
+    auto id = envelope.get_value("m_id");
+
+    return id.is_int64() ? static_cast<UID>(id.as_int64()) : 0;
+}
+
+
 Message Deserializer::MessageFromObject(Object &&obj)
 {
-    return BinaryMessage(
-                std::move(static_cast<MessageType>(obj["type"].as_int32())),
+    auto deadline = obj.find("deadline");
+    auto id = obj.find("m_id");
+    Message message = BinaryMessage(
+                static_cast<MessageType>(obj["type"].as_int32()),
                 std::move(obj["fields"].as_object()),
-                std::move(static_cast<UID>(obj["receiver_m_uid"].as_int64())),
+                uid_from_value(obj["receiver_m_uid"]),
                 std::move(obj["receiver_m_name"].as_string()),
                 std::move(obj["receiver_m_class"].as_string()),
-                std::move(static_cast<UID>(obj["sender_m_uid"].as_int64())),
+                uid_from_value(obj["sender_m_uid"]),
                 std::move(obj["sender_m_name"].as_string()),
                 std::move(obj["sender_m_class"].as_string()),
                 std::move(obj["c_time"].as_time())
          );
+
+    if (deadline != obj.end() && deadline->second.is_time()) message.set_deadline(deadline->second.as_time());
+    if (id != obj.end()) message.set_id(uid_from_value(id->second));
+
+    return message;
+}
+
+
+Message Deserializer::MessageFromView(const BsonView &envelope, std::shared_ptr<BinData> buffer)
+{
+    // Envelope fields are decoded, message fields will be decoded on demand.
+    Message message = BinaryMessage(
+                static_cast<MessageType>(envelope.as_int32("type")),
+                envelope.as_view("fields"),
+                std::move(buffer),
+                static_cast<UID>(envelope.as_int64("receiver_m_uid")),
+                String(envelope.as_string("receiver_m_name")),
+                ModuleClass(envelope.as_string("receiver_m_class")),
+                static_cast<UID>(envelope.as_int64("sender_m_uid")),
+                String(envelope.as_string("sender_m_name")),
+                ModuleClass(envelope.as_string("sender_m_class")),
+                envelope.as_time("c_time")
+         );
+
+    message.set_deadline(deadline_from_view(envelope));
+    message.set_id(id_from_view(envelope));
+
+    return message;
+}
+
+
+void Deserializer::AssignMessageFromView(const BinData::value_type *data, size_t size, Message &message)
+{
+    auto &buffer = RecycleBuffer(message);
+
+    buffer.assign(data, data + size);
+
+    BsonView envelope(buffer.data(), buffer.size());
+
+    AssignEnvelope(message,
+                   static_cast<MessageType>(envelope.as_int32("type")),
+                   static_cast<UID>(envelope.as_int64("receiver_m_uid")),
+                   envelope.as_string("receiver_m_name"),
+                   envelope.as_string("receiver_m_class"),
+                   static_cast<UID>(envelope.as_int64("sender_m_uid")),
+                   envelope.as_string("sender_m_name"),
+                   envelope.as_string("sender_m_class"),
+                   envelope.as_time("c_time"),
+                   deadline_from_view(envelope),
+                   id_from_view(envelope),
+                   envelope.as_view("fields"));
+}
+
+
+BinData &Deserializer::RecycleBuffer(Message &message)
+{
+    auto &buffer = message.fields_buffer_;
+
+    // Message stays consistent, if the new content is malformed.
+    message.fields_view_ = BsonView();
+    message.fields_.clear();
+    message.fields_decoded_.decoded.store(true, std::memory_order_relaxed);
+
+    // Retained copy of the message shares the buffer: it can't be overwritten.
+    if (!buffer || buffer.use_count() > 1) buffer = std::make_shared<BinData>();
+
+    return *buffer;
+}
+
+
+void Deserializer::AssignEnvelope(Message &message, MessageType message_type,
+                                  UID receiver_module_uid, std::string_view receiver_module_name,
+                                  std::string_view receiver_module_class,
+                                  UID sender_module_uid, std::string_view sender_module_name,
+                                  std::string_view sender_module_class,
+                                  Time creation_time, Time deadline, UID message_id, const BsonView &fields_view)
+{
+    message.message_type_ = message_type;
+    message.receiver_module_uid_ = receiver_module_uid;
+    message.receiver_module_name_.assign(receiver_module_name);
+    message.receiver_module_class_.assign(receiver_module_class);
+    message.sender_module_uid_ = sender_module_uid;
+    message.sender_module_name_.assign(sender_module_name);
+    message.sender_module_class_.assign(sender_module_class);
+    message.creation_time_ = creation_time;
+    message.deadline_ = deadline;
+    message.id_ = message_id;
+    message.fields_view_ = fields_view;
+    message.fields_decoded_.decoded.store(false, std::memory_order_release);
+}
+
+
+MessageType Deserializer::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    return DeserializeMessage(data, size).get_type();
+}
+
+
+void Deserializer::DeserializeMessageTo(const BinData::value_type *data, size_t size, Message &message)
+{
+    message = DeserializeMessage(data, size);
 }
 
 } // namespace tsw
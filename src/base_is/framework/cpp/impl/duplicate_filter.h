@@ -0,0 +1,83 @@
+/**
+  * @file duplicate_filter.h
+  * @author Artiom N.(cl)2017
+  * @brief DuplicateFilter class: recently received message identifiers.
+  *
+  */
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <unordered_set>
+
+#include "tsw/types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Window of the recently received messages: replayed message, which was already handled, is dropped.
+ *
+ * Filter isn't thread-safe: it's used by the receiving thread.
+ */
+class DuplicateFilter
+{
+public:
+    static constexpr size_t default_window = 16384;
+
+public:
+    explicit DuplicateFilter(size_t window = default_window) : window_(std::max<size_t>(window, 1)) {}
+
+public:
+    /**
+     * @brief Remember the message.
+     * @return true, if the message with the same sender and identifier is in the window.
+     */
+    bool is_duplicate(UID sender_module_uid, UID message_id)
+    {
+        const Key key{ sender_module_uid, message_id };
+
+        if (!keys_.insert(key).second) return true;
+
+        order_.push_back(key);
+        if (order_.size() > window_)
+        {
+            keys_.erase(order_.front());
+            order_.pop_front();
+        }
+
+        return false;
+    }
+
+private:
+    struct Key
+    {
+        UID sender;
+        UID id;
+
+        bool operator==(const Key &other) const { return sender == other.sender && id == other.id; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            return std::hash<UID>()(key.id) ^ (std::hash<UID>()(key.sender) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+private:
+    const size_t                            window_;
+    std::unordered_set<Key, KeyHash>        keys_;
+    std::deque<Key>                         order_;
+};
+
+} // namespace impl
+
+} // namespace tsw
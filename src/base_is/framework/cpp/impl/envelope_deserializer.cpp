@@ -0,0 +1,103 @@
+/**
+  * @file envelope_deserializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief EnvelopeDeserializer class implementation.
+  *
+  */
+
+#include <memory>
+
+#include <tsw/envelope_deserializer.h>
+#include <tsw/types.h>
+
+#include "binary_message.h"
+#include "bson_impl.h"
+#include "envelope_impl.h"
+
+
+namespace tsw
+{
+
+EnvelopeDeserializer::EnvelopeDeserializer(std::shared_ptr<const EnvelopeNames> names) :
+    names_(names), bsrec_(new impl::BsonDeserializerImpl)
+{}
+
+
+EnvelopeDeserializer::~EnvelopeDeserializer()
+{}
+
+
+Message EnvelopeDeserializer::DeserializeMessage(const BinData &data)
+{
+    return DeserializeMessage(data.data(), data.size());
+}
+
+
+Object EnvelopeDeserializer::DeserializeObject(const BinData &data)
+{
+    return bsrec_->Deserialize(data.data(), data.size());
+}
+
+
+Message EnvelopeDeserializer::DeserializeMessage(const BinData::value_type *data, size_t size)
+{
+    // Message keeps the buffer and decodes fields lazily.
+    auto buffer = std::make_shared<BinData>(data, data + size);
+    EnvelopeHeader header;
+    impl::EnvelopeStrings strings;
+
+    impl::read_envelope(buffer->data(), buffer->size(), names_.get(), header, strings);
+
+    BinaryMessage message(
+                header.type,
+                BsonView(buffer->data() + header.body_offset, header.body_size),
+                buffer,
+                header.receiver_uid,
+                String(strings.receiver_name),
+                ModuleClass(strings.receiver_class),
+                header.sender_uid,
+                String(strings.sender_name),
+                ModuleClass(strings.sender_class),
+                Time(header.creation_time)
+         );
+
+    message.set_deadline(header.deadline);
+    message.set_id(header.message_id);
+
+    return message;
+}
+
+
+Object EnvelopeDeserializer::DeserializeObject(const BinData::value_type *data, size_t size)
+{
+    return bsrec_->Deserialize(data, size);
+}
+
+
+MessageType EnvelopeDeserializer::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    EnvelopeHeader header;
+
+    if (!read_envelope_header(data, size, header)) TSW_THROW(impl::EnvelopeException, "malformed envelope header");
+
+    return header.type;
+}
+
+
+void EnvelopeDeserializer::DeserializeMessageTo(const BinData::value_type *data, size_t size, Message &message)
+{
+    auto &buffer = RecycleBuffer(message);
+    EnvelopeHeader header;
+    impl::EnvelopeStrings strings;
+
+    buffer.assign(data, data + size);
+    impl::read_envelope(buffer.data(), buffer.size(), names_.get(), header, strings);
+
+    AssignEnvelope(message, header.type,
+                   header.receiver_uid, strings.receiver_name, strings.receiver_class,
+                   header.sender_uid, strings.sender_name, strings.sender_class,
+                   header.creation_time, header.deadline, header.message_id,
+                   BsonView(buffer.data() + header.body_offset, header.body_size));
+}
+
+} // namespace tsw
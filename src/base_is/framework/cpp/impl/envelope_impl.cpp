@@ -0,0 +1,284 @@
+/**
+  * @file envelope_impl.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Envelope header codec and EnvelopeNames implementation.
+  *
+  */
+
+#include <limits>
+#include <mutex>
+
+#include <tsw/envelope_header.h>
+#include <tsw/error.h>
+
+#include "envelope_impl.h"
+
+
+namespace tsw
+{
+
+static constexpr BinData::value_type header_magic[] = { 'T', 'E' };
+// BSON document can't start so: its length would be too large.
+static constexpr BinData::value_type header_breaker = 0xff;
+
+static constexpr size_t version_offset = 2;
+static constexpr size_t type_offset = 4;
+static constexpr size_t flags_offset = 6;
+static constexpr size_t sender_uid_offset = 8;
+static constexpr size_t receiver_uid_offset = 16;
+static constexpr size_t c_time_offset = 24;
+static constexpr size_t ids_offset = 32;
+static constexpr size_t body_offset_offset = 48;
+static constexpr size_t body_size_offset = 52;
+
+
+template<typename T>
+static inline void write_le(BinData::value_type *data, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i) data[i] = static_cast<BinData::value_type>(value >> (8 * i));
+}
+
+
+template<typename T>
+static inline T read_le(const BinData::value_type *data)
+{
+    T result = 0;
+
+    for (size_t i = 0; i < sizeof(T); ++i) result |= static_cast<T>(data[i]) << (8 * i);
+
+    return result;
+}
+
+
+// Optional fields follow the fixed header.
+static inline size_t names_offset(uint16_t flags)
+{
+    return EnvelopeHeader::size + (flags & EnvelopeHeader::HasDeadline ? sizeof(int64_t) : 0) +
+           (flags & EnvelopeHeader::HasId ? sizeof(uint64_t) : 0);
+}
+
+
+uint32_t envelope_name_id(std::string_view name)
+{
+    if (name.empty()) return 0;
+
+    uint32_t hash = 2166136261u;
+
+    for (auto c: name) hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+
+    // Zero is reserved for the empty name.
+    return hash ? hash : 1;
+}
+
+
+bool read_envelope_header(const BinData::value_type *data, size_t size, EnvelopeHeader &header)
+{
+    if (size < EnvelopeHeader::size || data[0] != header_magic[0] || data[1] != header_magic[1] ||
+        data[3] != header_breaker) return false;
+
+    header.version = data[version_offset];
+    header.type = static_cast<MessageType>(read_le<uint16_t>(data + type_offset));
+    header.flags = read_le<uint16_t>(data + flags_offset);
+    header.sender_uid = read_le<uint64_t>(data + sender_uid_offset);
+    header.receiver_uid = read_le<uint64_t>(data + receiver_uid_offset);
+    header.creation_time = Time(static_cast<int64_t>(read_le<uint64_t>(data + c_time_offset)));
+    header.sender_name_id = read_le<uint32_t>(data + ids_offset);
+    header.sender_class_id = read_le<uint32_t>(data + ids_offset + 4);
+    header.receiver_name_id = read_le<uint32_t>(data + ids_offset + 8);
+    header.receiver_class_id = read_le<uint32_t>(data + ids_offset + 12);
+    header.body_offset = read_le<uint32_t>(data + body_offset_offset);
+    header.body_size = read_le<uint32_t>(data + body_size_offset);
+
+    if (header.version != EnvelopeHeader::current_version || header.body_offset < names_offset(header.flags) ||
+        static_cast<size_t>(header.body_offset) + header.body_size > size) return false;
+
+    size_t offset = EnvelopeHeader::size;
+
+    header.deadline = Time::zero();
+    header.message_id = 0;
+
+    if (header.flags & EnvelopeHeader::HasDeadline)
+    {
+        header.deadline = Time(static_cast<int64_t>(read_le<uint64_t>(data + offset)));
+        offset += sizeof(int64_t);
+    }
+
+    if (header.flags & EnvelopeHeader::HasId) header.message_id = read_le<uint64_t>(data + offset);
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// EnvelopeNames
+//----------------------------------------------------------------------------
+
+uint32_t EnvelopeNames::add(const String &name)
+{
+    auto id = envelope_name_id(name);
+
+    if (!id) return id;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto i = names_.emplace(id, name).first;
+
+    if (i->second != name)
+    {
+        TSW_THROW(Exception, "names \"" + name + "\" and \"" + i->second + "\" have the same identifier");
+    }
+
+    return id;
+}
+
+
+const String *EnvelopeNames::find(uint32_t id) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto i = names_.find(id);
+
+    // Names are never removed: pointer stays valid.
+    return i != names_.end() ? &i->second : nullptr;
+}
+
+
+namespace impl
+{
+
+// Name is inline, unless the peer knows it.
+static bool write_name(const String &name, uint32_t id, const EnvelopeNames *names, BinData &buffer)
+{
+    if (!id || (names && names->find(id))) return false;
+
+    if (name.size() > std::numeric_limits<uint16_t>::max())
+    {
+        TSW_THROW(EnvelopeException, "module name is too long: " + std::to_string(name.size()));
+    }
+
+    BinData::value_type length[sizeof(uint16_t)];
+
+    write_le(length, static_cast<uint16_t>(name.size()));
+    buffer.insert(buffer.end(), length, length + sizeof(length));
+    buffer.insert(buffer.end(), name.begin(), name.end());
+
+    return true;
+}
+
+
+void write_envelope_header(const Message &message, const EnvelopeNames *names, BinData &buffer)
+{
+    const uint32_t ids[] =
+    {
+        envelope_name_id(message.get_sender_module_name()),
+        envelope_name_id(message.get_sender_module_class()),
+        envelope_name_id(message.get_receiver_module_name()),
+        envelope_name_id(message.get_receiver_module_class())
+    };
+
+    buffer.resize(EnvelopeHeader::size);
+
+    auto data = buffer.data();
+
+    data[0] = header_magic[0];
+    data[1] = header_magic[1];
+    data[version_offset] = EnvelopeHeader::current_version;
+    data[3] = header_breaker;
+    write_le(data + type_offset, static_cast<uint16_t>(message.get_type()));
+    write_le(data + sender_uid_offset, static_cast<uint64_t>(message.get_sender_module_uid()));
+    write_le(data + receiver_uid_offset, static_cast<uint64_t>(message.get_receiver_module_uid()));
+    write_le(data + c_time_offset, static_cast<uint64_t>(message.get_creation_time().count()));
+    for (size_t i = 0; i < 4; ++i) write_le(data + ids_offset + 4 * i, ids[i]);
+
+    uint16_t flags = 0;
+
+    if (message.has_deadline())
+    {
+        BinData::value_type deadline[sizeof(int64_t)];
+
+        write_le(deadline, static_cast<uint64_t>(message.get_deadline().count()));
+        buffer.insert(buffer.end(), deadline, deadline + sizeof(deadline));
+        flags |= EnvelopeHeader::HasDeadline;
+    }
+
+    if (message.get_id())
+    {
+        BinData::value_type id[sizeof(uint64_t)];
+
+        write_le(id, static_cast<uint64_t>(message.get_id()));
+        buffer.insert(buffer.end(), id, id + sizeof(id));
+        flags |= EnvelopeHeader::HasId;
+    }
+
+    if (write_name(message.get_sender_module_name(), ids[0], names, buffer)) flags |= EnvelopeHeader::InlineSenderName;
+    if (write_name(message.get_sender_module_class(), ids[1], names, buffer)) flags |= EnvelopeHeader::InlineSenderClass;
+    if (write_name(message.get_receiver_module_name(), ids[2], names, buffer)) flags |= EnvelopeHeader::InlineReceiverName;
+    if (write_name(message.get_receiver_module_class(), ids[3], names, buffer)) flags |= EnvelopeHeader::InlineReceiverClass;
+
+    // Buffer could be reallocated by the names.
+    write_le(buffer.data() + flags_offset, flags);
+}
+
+
+void finish_envelope(BinData &buffer, size_t body_offset)
+{
+    if (buffer.size() > std::numeric_limits<uint32_t>::max())
+    {
+        TSW_THROW(EnvelopeException, "message is too large: " + std::to_string(buffer.size()));
+    }
+
+    write_le(buffer.data() + body_offset_offset, static_cast<uint32_t>(body_offset));
+    write_le(buffer.data() + body_size_offset, static_cast<uint32_t>(buffer.size() - body_offset));
+}
+
+
+void patch_envelope_uids(BinData::value_type *data, UID sender_module_uid, UID receiver_module_uid)
+{
+    write_le(data + sender_uid_offset, static_cast<uint64_t>(sender_module_uid));
+    write_le(data + receiver_uid_offset, static_cast<uint64_t>(receiver_module_uid));
+}
+
+
+static std::string_view read_name(uint16_t flag, uint32_t id, const EnvelopeHeader &header, const EnvelopeNames *names,
+                                  const BinData::value_type *data, size_t &offset)
+{
+    if (header.flags & flag)
+    {
+        if (offset + sizeof(uint16_t) > header.body_offset) TSW_THROW(EnvelopeException, "envelope names are truncated");
+
+        size_t length = read_le<uint16_t>(data + offset);
+
+        offset += sizeof(uint16_t);
+        if (offset + length > header.body_offset) TSW_THROW(EnvelopeException, "envelope names are truncated");
+
+        std::string_view result(reinterpret_cast<const char*>(data + offset), length);
+
+        offset += length;
+
+        return result;
+    }
+
+    if (!id) return std::string_view();
+
+    const String *name = names ? names->find(id) : nullptr;
+
+    if (!name) TSW_THROW(EnvelopeException, "name " + std::to_string(id) + " isn't interned");
+
+    return *name;
+}
+
+
+void read_envelope(const BinData::value_type *data, size_t size, const EnvelopeNames *names,
+                   EnvelopeHeader &header, EnvelopeStrings &strings)
+{
+    if (!read_envelope_header(data, size, header)) TSW_THROW(EnvelopeException, "malformed envelope header");
+
+    size_t offset = names_offset(header.flags);
+
+    strings.sender_name = read_name(EnvelopeHeader::InlineSenderName, header.sender_name_id, header, names, data, offset);
+    strings.sender_class = read_name(EnvelopeHeader::InlineSenderClass, header.sender_class_id, header, names, data, offset);
+    strings.receiver_name = read_name(EnvelopeHeader::InlineReceiverName, header.receiver_name_id, header, names, data, offset);
+    strings.receiver_class = read_name(EnvelopeHeader::InlineReceiverClass, header.receiver_class_id, header, names, data, offset);
+}
+
+} // namespace impl
+
+} // namespace tsw
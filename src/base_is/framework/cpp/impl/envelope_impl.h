@@ -0,0 +1,69 @@
+/**
+  * @file envelope_impl.h
+  * @author Artiom N.(cl)2017
+  * @brief Envelope header codec, shared by the EnvelopeSerializer and EnvelopeDeserializer.
+  *
+  */
+
+#pragma once
+
+#include <string_view>
+
+#include "tsw/envelope_header.h"
+#include "tsw/error.h"
+#include "tsw/message.h"
+#include "tsw/types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+class EnvelopeException : public Exception
+{
+    using Exception::Exception;
+};
+
+
+/**
+ * @brief Write header and inline names to the empty buffer.
+ * @param names interned names or nullptr.
+ */
+void write_envelope_header(const Message &message, const EnvelopeNames *names, BinData &buffer);
+
+/**
+ * @brief Patch body offset and size after the body was appended.
+ */
+void finish_envelope(BinData &buffer, size_t body_offset);
+
+
+/**
+ * @brief Replace UIDs in the header of the frame, which was checked by the read_envelope_header().
+ */
+void patch_envelope_uids(BinData::value_type *data, UID sender_module_uid, UID receiver_module_uid);
+
+
+/**
+ * @brief Names of the message envelope: views into the frame or into the interned names.
+ */
+struct EnvelopeStrings
+{
+    std::string_view sender_name;
+    std::string_view sender_class;
+    std::string_view receiver_name;
+    std::string_view receiver_class;
+};
+
+
+/**
+ * @brief Read header and resolve names.
+ * @throw EnvelopeException, if frame is malformed or name isn't interned.
+ */
+void read_envelope(const BinData::value_type *data, size_t size, const EnvelopeNames *names,
+                   EnvelopeHeader &header, EnvelopeStrings &strings);
+
+} // namespace impl
+
+} // namespace tsw
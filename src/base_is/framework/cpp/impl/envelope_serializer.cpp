@@ -0,0 +1,101 @@
+/**
+  * @file envelope_serializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief EnvelopeSerializer class implementation.
+  *
+  */
+
+#include <memory>
+
+#include <tsw/envelope_serializer.h>
+#include <tsw/types.h>
+#include <tsw/wire_format.h>
+
+#include "bson_impl.h"
+#include "envelope_impl.h"
+
+
+namespace tsw
+{
+
+EnvelopeSerializer::EnvelopeSerializer(std::shared_ptr<const EnvelopeNames> names) :
+    names_(names), bsrec_(new impl::BsonSerializerImpl)
+{}
+
+
+EnvelopeSerializer::~EnvelopeSerializer()
+{}
+
+
+BinData EnvelopeSerializer::SerializeMessage(const Message &message)
+{
+    BinData result;
+
+    SerializeMessageTo(message, result);
+
+    return result;
+}
+
+
+void EnvelopeSerializer::SerializeMessageTo(const Message &message, BinData &buffer)
+{
+    impl::write_envelope_header(message, names_.get(), buffer);
+
+    const size_t body_offset = buffer.size();
+    const auto &view = message.get_fields_view();
+
+    if (view.data())
+    {
+        // Received message is forwarded without the fields re-encoding.
+        buffer.insert(buffer.end(), view.data(), view.data() + view.size());
+    }
+    else
+    {
+        bsrec_->reset(body_);
+        for (const auto &field: message.get_fields()) bsrec_->append_field(field.first, field.second);
+        bsrec_->take_buffer(body_);
+        buffer.insert(buffer.end(), body_.begin(), body_.end());
+    }
+
+    impl::finish_envelope(buffer, body_offset);
+}
+
+
+void EnvelopeSerializer::SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer)
+{
+    impl::write_envelope_header(envelope, names_.get(), buffer);
+
+    const size_t body_offset = buffer.size();
+
+    impl::BsonFieldWriter writer(*bsrec_);
+
+    bsrec_->reset(body_);
+    fields(writer);
+    bsrec_->take_buffer(body_);
+    buffer.insert(buffer.end(), body_.begin(), body_.end());
+    impl::finish_envelope(buffer, body_offset);
+}
+
+
+BinData EnvelopeSerializer::SerializeObject(const Object &fields)
+{
+    bsrec_->clear();
+
+    for (const auto &field: fields) bsrec_->append_field(field.first, field.second);
+
+    return bsrec_->take_buffer();
+}
+
+
+std::unique_ptr<Serializer> EnvelopeSerializer::Clone() const
+{
+    return std::make_unique<EnvelopeSerializer>(names_);
+}
+
+
+WireFormat EnvelopeSerializer::Format() const
+{
+    return WireFormat::Envelope;
+}
+
+} // namespace tsw
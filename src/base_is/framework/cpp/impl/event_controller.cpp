@@ -89,4 +89,22 @@ void EventController::generate_event(const Module &module, const String& event_n
     controller_->generate_activity(module.get_uid(), event_name, fields, MessageType::Event);
 }
 
+
+void EventController::dispatch_event(Module &module, const Event& event)
+{
+    controller_->run_activity_handlers(module.get_uid(), event.get_metadata().get_name(), event, module);
+}
+
+
+void EventController::set_execution_policy(const HandlerExecutionPolicy& policy)
+{
+    controller_->set_execution_policy(policy);
+}
+
+
+HandlerTimings EventController::get_handler_timings(const Module &module, const String& event_name) const
+{
+    return controller_->get_handler_timings(module.get_uid(), event_name);
+}
+
 } // namespace tsw
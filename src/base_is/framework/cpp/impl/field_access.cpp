@@ -0,0 +1,297 @@
+/**
+  * @file field_access.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Object and BSON FieldWriter/FieldReader implementations.
+  *
+  */
+
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <tsw/bson_view.h>
+#include <tsw/error.h>
+#include <tsw/field_access.h>
+#include <tsw/message.h>
+#include <tsw/types.h>
+
+#include "bson_impl.h"
+
+
+namespace tsw
+{
+
+namespace
+{
+
+class ObjectFieldWriter : public FieldWriter
+{
+public:
+    explicit ObjectFieldWriter(Object &object) : objects_{&object} {}
+
+public:
+    using FieldWriter::write;
+
+    void write(const char *name, bool data) override { current()[name] = data; }
+    void write(const char *name, int32_t data) override { current()[name] = data; }
+    void write(const char *name, int64_t data) override { current()[name] = data; }
+    void write(const char *name, double data) override { current()[name] = data; }
+    void write(const char *name, const String &data) override { current()[name] = data; }
+    void write(const char *name, const BinData &data) override { current()[name] = data; }
+    void write(const char *name, const Time &data) override { current()[name] = data; }
+    void write(const char *name, const DoubleArray &data) override { current()[name] = data; }
+    void write(const char *name, const Int32Array &data) override { current()[name] = data; }
+    void write(const char *name, const Value &data) override { current()[name] = data; }
+
+    void start_object(const char *name) override
+    {
+        auto &nested = current()[name];
+
+        nested = Object();
+        objects_.push_back(&nested.as_object());
+    }
+
+    void finish_object() override
+    {
+        TSW_ASSERT(objects_.size() > 1);
+        objects_.pop_back();
+    }
+
+private:
+    Object &current() { return *objects_.back(); }
+
+private:
+    std::vector<Object*> objects_;
+};
+
+
+class ObjectFieldReader : public FieldReader
+{
+public:
+    explicit ObjectFieldReader(const Object &object) : object_(object) {}
+
+public:
+    bool read(const char *name, bool &data) override { return read_as(name, data); }
+    bool read(const char *name, int32_t &data) override { return read_as(name, data); }
+    bool read(const char *name, int64_t &data) override { return read_number(name, data); }
+    bool read(const char *name, double &data) override { return read_number(name, data); }
+    bool read(const char *name, String &data) override { return read_as(name, data); }
+    bool read(const char *name, BinData &data) override { return read_as(name, data); }
+    bool read(const char *name, Time &data) override { return read_as(name, data); }
+    bool read(const char *name, DoubleArray &data) override { return read_array(name, data); }
+    bool read(const char *name, Int32Array &data) override { return read_array(name, data); }
+
+    bool read(const char *name, Value &data) override
+    {
+        auto field = object_.find(name);
+
+        if (field == object_.end()) return false;
+        data = field->second;
+
+        return true;
+    }
+
+    bool read_object(const char *name, const FieldsReader &reader) override
+    {
+        Object nested;
+
+        if (!read_as(name, nested)) return false;
+
+        ObjectFieldReader nested_reader(nested);
+        reader(nested_reader);
+
+        return true;
+    }
+
+private:
+    template<typename T>
+    bool read_as(const char *name, T &data)
+    {
+        auto field = object_.find(name);
+
+        if (field == object_.end()) return false;
+        if (!std::holds_alternative<T>(field->second)) type_error(name);
+        data = field->second.as<T>();
+
+        return true;
+    }
+
+    template<typename T>
+    bool read_number(const char *name, T &data)
+    {
+        auto field = object_.find(name);
+
+        if (field == object_.end()) return false;
+        if (!to_number(field->second, data)) type_error(name);
+
+        return true;
+    }
+
+    // JSON keeps the packed arrays as the usual ones.
+    template<typename ArrayType>
+    bool read_array(const char *name, ArrayType &data)
+    {
+        auto field = object_.find(name);
+
+        if (field == object_.end()) return false;
+        if (std::holds_alternative<ArrayType>(field->second))
+        {
+            data = field->second.as<ArrayType>();
+            return true;
+        }
+        if (!std::holds_alternative<ValueArray>(field->second)) type_error(name);
+
+        ArrayType result;
+
+        for (const auto &element: field->second.as<ValueArray>())
+        {
+            typename ArrayType::value_type number;
+
+            if (!to_number(element, number)) type_error(name);
+            result.push_back(number);
+        }
+        data = std::move(result);
+
+        return true;
+    }
+
+    // Text and compact formats don't keep the integer width: Int32 is widened to int64, integers to double.
+    template<typename T>
+    static bool to_number(const Value &value, T &data)
+    {
+        if (std::holds_alternative<T>(value)) data = value.as<T>();
+        else if (std::holds_alternative<int32_t>(value)) data = static_cast<T>(value.as<int32_t>());
+        else if (std::is_same<T, double>::value && std::holds_alternative<int64_t>(value)) data = static_cast<T>(value.as<int64_t>());
+        else return false;
+
+        return true;
+    }
+
+    [[noreturn]] static void type_error(const char *name)
+    {
+        TSW_THROW(Exception, String("field \"") + name + "\" has another type");
+    }
+
+private:
+    const Object &object_;
+};
+
+
+class BsonViewFieldReader : public FieldReader
+{
+public:
+    explicit BsonViewFieldReader(const BsonView &view) : view_(view) {}
+
+public:
+    bool read(const char *name, bool &data) override { return read_as(name, data, &BsonView::as_bool); }
+    bool read(const char *name, int32_t &data) override { return read_as(name, data, &BsonView::as_int32); }
+    bool read(const char *name, int64_t &data) override { return read_as(name, data, &BsonView::as_int64); }
+    bool read(const char *name, double &data) override { return read_as(name, data, &BsonView::as_double); }
+    bool read(const char *name, BinData &data) override { return read_as(name, data, &BsonView::as_bindata); }
+    bool read(const char *name, Time &data) override { return read_as(name, data, &BsonView::as_time); }
+    bool read(const char *name, DoubleArray &data) override { return read_as(name, data, &BsonView::as_double_array); }
+    bool read(const char *name, Int32Array &data) override { return read_as(name, data, &BsonView::as_int32_array); }
+
+    bool read(const char *name, String &data) override
+    {
+        if (!view_.has_field(name)) return false;
+        data = view_.as_string(name);
+
+        return true;
+    }
+
+    bool read(const char *name, Value &data) override
+    {
+        if (!view_.has_field(name)) return false;
+        data = view_.get_value(name);
+
+        return true;
+    }
+
+    bool read_object(const char *name, const FieldsReader &reader) override
+    {
+        if (!view_.has_field(name)) return false;
+
+        BsonViewFieldReader nested_reader(view_.as_view(name));
+        reader(nested_reader);
+
+        return true;
+    }
+
+private:
+    template<typename T, typename R>
+    bool read_as(const char *name, T &data, R (BsonView::*getter)(const char*) const)
+    {
+        if (!view_.has_field(name)) return false;
+        data = (view_.*getter)(name);
+
+        return true;
+    }
+
+private:
+    BsonView view_;
+};
+
+} // namespace
+
+
+void write_bson(const FieldsWriter &fields, BinData &buffer)
+{
+    impl::BsonSerializerImpl serializer;
+    impl::BsonFieldWriter writer(serializer);
+
+    serializer.reset(buffer);
+    fields(writer);
+    serializer.take_buffer(buffer);
+}
+
+
+void read_bson(const BsonView &document, const FieldsReader &fields)
+{
+    BsonViewFieldReader reader(document);
+
+    fields(reader);
+}
+
+
+void write_object(const FieldsWriter &fields, Object &object)
+{
+    ObjectFieldWriter writer(object);
+
+    fields(writer);
+}
+
+
+void read_object(const Object &object, const FieldsReader &fields)
+{
+    ObjectFieldReader reader(object);
+
+    fields(reader);
+}
+
+
+bool read_message(const Message &message, const char *name, const FieldsReader &fields)
+{
+    const auto &view = message.get_fields_view();
+    static constexpr const char *name_field = "name";
+
+    if (!view.empty())
+    {
+        if (view.field_type(name_field) != ValueType::String || view.as_string(name_field) != name) return false;
+        read_bson(view, fields);
+
+        return true;
+    }
+
+    const auto &object = message.get_fields();
+    auto message_name = object.find(name_field);
+
+    if (message_name == object.end() || !message_name->second.is_string() ||
+        message_name->second.as_string() != name) return false;
+
+    read_object(object, fields);
+
+    return true;
+}
+
+} // namespace tsw
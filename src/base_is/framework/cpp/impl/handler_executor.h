@@ -0,0 +1,277 @@
+/**
+  * @file handler_executor.h
+  * @author Artiom N.(cl)2017
+  * @brief HandlerExecutor class: sequential or concurrent call of the activity handlers.
+  *
+  */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tsw/handler_execution.h"
+
+#include "functional_helper.h"
+#include "latency_recorder.h"
+#include "thread_pool.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Timing and the running calls of one subscribed handler. Updated from the pool threads.
+ */
+class HandlerState
+{
+public:
+    /**
+     * @brief Take the call slot.
+     * @return false, if the handler already runs max_calls times: call is skipped.
+     */
+    bool acquire(size_t max_calls)
+    {
+        if (running_.fetch_add(1, std::memory_order_acq_rel) < max_calls || !max_calls) return true;
+
+        running_.fetch_sub(1, std::memory_order_acq_rel);
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    void release() { running_.fetch_sub(1, std::memory_order_acq_rel); }
+
+    void record(std::chrono::nanoseconds time, bool failed)
+    {
+        calls_.fetch_add(1, std::memory_order_relaxed);
+        if (failed) failed_.fetch_add(1, std::memory_order_relaxed);
+        total_time_.fetch_add(time.count(), std::memory_order_relaxed);
+
+        auto max_time = max_time_.load(std::memory_order_relaxed);
+
+        while (max_time < time.count() &&
+               !max_time_.compare_exchange_weak(max_time, time.count(), std::memory_order_relaxed)) {}
+
+        histogram_.record(time);
+    }
+
+    void record_late() { late_.fetch_add(1, std::memory_order_relaxed); }
+
+    HandlerTiming timing() const
+    {
+        HandlerTiming result;
+
+        result.calls = calls_.load(std::memory_order_relaxed);
+        result.skipped = skipped_.load(std::memory_order_relaxed);
+        result.late = late_.load(std::memory_order_relaxed);
+        result.failed = failed_.load(std::memory_order_relaxed);
+        result.total_time = std::chrono::nanoseconds(total_time_.load(std::memory_order_relaxed));
+        result.max_time = std::chrono::nanoseconds(max_time_.load(std::memory_order_relaxed));
+        result.histogram = histogram_.histogram();
+
+        return result;
+    }
+
+private:
+    std::atomic<size_t>                     running_{0};
+    std::atomic<uint64_t>                   calls_{0};
+    std::atomic<uint64_t>                   skipped_{0};
+    std::atomic<uint64_t>                   late_{0};
+    std::atomic<uint64_t>                   failed_{0};
+    std::atomic<std::chrono::nanoseconds::rep> total_time_{0};
+    std::atomic<std::chrono::nanoseconds::rep> max_time_{0};
+    LatencyRecorder                         histogram_;
+};
+
+
+/**
+ * @brief Subscribed handler with its state. Subscriptions are equal, if their handlers are.
+ */
+template<typename HandlerType>
+struct Subscription
+{
+    Subscription(const HandlerType &h) : handler(h), state(std::make_shared<HandlerState>()) {}
+
+    bool operator==(const Subscription &other) const { return handler == other.handler; }
+
+    HandlerType                     handler;
+    std::shared_ptr<HandlerState>   state;
+};
+
+
+/**
+ * @brief Caller of the handlers by the execution policy.
+ *
+ * Every pool call is a separate task: slow handler delays only itself, and the limit of its
+ * running calls keeps the pool threads for the others. Exceptions of the pool calls are counted
+ * and dropped, exceptions of the sequential calls are passed to the caller.
+ */
+class HandlerExecutor
+{
+public:
+    HandlerExecutor() {}
+
+public:
+    /**
+     * @brief Set policy. Must be called before the handlers running.
+     */
+    void set_policy(const HandlerExecutionPolicy &policy)
+    {
+        policy_ = policy;
+        if (policy_.execution != HandlerExecution::Sequential && !pool_) pool_ = ThreadPool::shared();
+    }
+
+    const HandlerExecutionPolicy &get_policy() const { return policy_; }
+
+    /**
+     * @brief Return true, if handlers may run after the run() return: call must own its arguments.
+     */
+    bool is_detached() const
+    {
+        return policy_.execution == HandlerExecution::Detach ||
+               (policy_.execution == HandlerExecution::Join && policy_.join_timeout.count() >= 0);
+    }
+
+    /**
+     * @brief Call the handlers.
+     * @param handlers subscriptions snapshot: it's kept by the pool calls.
+     * @param call functor, which calls the handler: call(subscription.handler).
+     */
+    template<typename List, typename Call>
+    void run(const std::shared_ptr<const List> &handlers, const Call &call)
+    {
+        // Waiting in a pool thread for the pool tasks may deadlock: nested dispatch is sequential.
+        if (policy_.execution == HandlerExecution::Sequential || pool_->is_worker_thread())
+        {
+            for (const auto &subscription: *handlers) call_sequential(subscription, call);
+            return;
+        }
+
+        if (policy_.execution == HandlerExecution::Detach)
+        {
+            for (size_t i = 0; i < handlers->size(); ++i)
+            {
+                if (!(*handlers)[i].state->acquire(policy_.max_handler_calls)) continue;
+
+                pool_->post([handlers, call, i]() { call_isolated((*handlers)[i], call); });
+            }
+
+            return;
+        }
+
+        join(handlers, call);
+    }
+
+private:
+    // Calls of the one run() in the Join mode.
+    struct JoinState
+    {
+        std::mutex              mutex;
+        std::condition_variable finished;
+        size_t                  remaining = 0;
+        std::vector<bool>       done;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+private:
+    template<typename List, typename Call>
+    void join(const std::shared_ptr<const List> &handlers, const Call &call)
+    {
+        auto state = std::make_shared<JoinState>();
+
+        state->done.assign(handlers->size(), true);
+
+        for (size_t i = 0; i < handlers->size(); ++i)
+        {
+            if (!(*handlers)[i].state->acquire(policy_.max_handler_calls)) continue;
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->done[i] = false;
+                ++state->remaining;
+            }
+
+            pool_->post([handlers, call, state, i]()
+            {
+                call_isolated((*handlers)[i], call);
+
+                std::lock_guard<std::mutex> lock(state->mutex);
+
+                state->done[i] = true;
+                if (!--state->remaining) state->finished.notify_all();
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        auto all_done = [&state]() { return !state->remaining; };
+
+        if (policy_.join_timeout.count() < 0)
+        {
+            state->finished.wait(lock, all_done);
+            return;
+        }
+
+        if (state->finished.wait_for(lock, policy_.join_timeout, all_done)) return;
+
+        for (size_t i = 0; i < state->done.size(); ++i)
+        {
+            if (!state->done[i]) (*handlers)[i].state->record_late();
+        }
+    }
+
+    template<typename S, typename Call>
+    static void call_sequential(const S &subscription, const Call &call)
+    {
+        const auto start = Clock::now();
+
+        try
+        {
+            call(subscription.handler);
+        }
+        catch (...)
+        {
+            subscription.state->record(Clock::now() - start, true);
+            throw;
+        }
+
+        subscription.state->record(Clock::now() - start, false);
+    }
+
+    template<typename S, typename Call>
+    static void call_isolated(const S &subscription, const Call &call)
+    {
+        const auto start = Clock::now();
+        bool failed = false;
+
+        try
+        {
+            call(subscription.handler);
+        }
+        catch (...)
+        {
+            // Pool thread must survive the handler.
+            failed = true;
+        }
+
+        subscription.state->release();
+        subscription.state->record(Clock::now() - start, failed);
+    }
+
+private:
+    HandlerExecutionPolicy          policy_;
+    std::shared_ptr<ThreadPool>     pool_;
+};
+
+} // namespace impl
+
+} // namespace tsw
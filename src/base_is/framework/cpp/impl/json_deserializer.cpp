@@ -47,4 +47,22 @@ Object JsonDeserializer::DeserializeObject(const BinData::value_type *data, size
     return jsrec_->Deserialize(data, size);
 }
 
+
+MessageType JsonDeserializer::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    return jsrec_->DeserializeMessageType(data, size);
+}
+
+
+Message JsonDeserializer::DeserializeMessageInsitu(BinData &data)
+{
+    return MessageFromObject(jsrec_->DeserializeInsitu(data));
+}
+
+
+Object JsonDeserializer::DeserializeObjectInsitu(BinData &data)
+{
+    return jsrec_->DeserializeInsitu(data);
+}
+
 } // namespace tsw
@@ -5,18 +5,20 @@
   *
   */
 
+#include <charconv>
 #include <chrono>
 #include <ctime>
-#include <iomanip>
 #include <limits>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 #include "tsw/error.h"
 #include "tsw/base64.h"
 
+#include <rapidjson/memorystream.h>
+
 #include "json_impl.h"
 
 
@@ -41,7 +43,7 @@ public:
 // JsonSerializerImpl
 //----------------------------------------------------------------------------
 
-JsonSerializerImpl::JsonSerializerImpl() : need_init_(false), writer_(sb_)
+JsonSerializerImpl::JsonSerializerImpl(bool pretty) : need_init_(false), writer_(out_, pretty)
 {
     writer_.StartObject();
 }
@@ -104,7 +106,7 @@ void JsonSerializerImpl::write_field(bool data)
 void JsonSerializerImpl::write_field(const NameValueMap &data)
 {
     writer_.StartObject();
-    for (const auto field: data) append_field(field.first, field.second);
+    for (const auto &field: data) append_field(field.first, field.second);
     writer_.EndObject();
 }
 
@@ -117,14 +119,64 @@ void JsonSerializerImpl::write_field(const BinData &data)
 
 void JsonSerializerImpl::write_field(Time data)
 {
-    std::stringstream ss;
+    char buffer[max_time_length];
+
+    writer_.String(buffer, static_cast<rj::SizeType>(format_time(data, buffer)));
+}
+
+
+static inline char *put_two_digits(char *p, unsigned value)
+{
+    *p++ = static_cast<char>('0' + value / 10);
+    *p++ = static_cast<char>('0' + value % 10);
 
+    return p;
+}
+
+
+// Same, as put_time() with "%FT%T" and the nanoseconds count after the point.
+size_t JsonSerializerImpl::format_time(Time data, char *buffer)
+{
     auto seconds = std::chrono::duration_cast<std::chrono::seconds>(data);
-    auto ms = (data - seconds).count();
-    auto tm = seconds.count();
+    auto ns = (data - seconds).count();
+    int64_t tm = seconds.count();
+    int64_t days = tm / 86400;
+    int64_t day_seconds = tm % 86400;
+
+    if (day_seconds < 0)
+    {
+        day_seconds += 86400;
+        --days;
+    }
 
-    ss << std::put_time(std::gmtime(&tm), datetime_format) << "." << ms << "Z";
-    write_field(ss.str());
+    // Civil date from the days since epoch, proleptic Gregorian calendar.
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2);
+
+    char *p = std::to_chars(buffer, buffer + 20, year).ptr;
+
+    *p++ = '-';
+    p = put_two_digits(p, month);
+    *p++ = '-';
+    p = put_two_digits(p, day);
+    *p++ = 'T';
+    p = put_two_digits(p, static_cast<unsigned>(day_seconds / 3600));
+    *p++ = ':';
+    p = put_two_digits(p, static_cast<unsigned>(day_seconds % 3600 / 60));
+    *p++ = ':';
+    p = put_two_digits(p, static_cast<unsigned>(day_seconds % 60));
+    *p++ = '.';
+    p = std::to_chars(p, p + 20, ns).ptr;
+    *p++ = 'Z';
+
+    return static_cast<size_t>(p - buffer);
 }
 
 
@@ -278,15 +330,58 @@ BinData JsonSerializerImpl::get_buffer()
         writer_.EndObject();
         need_init_ = true;
     }
-    const char *data = sb_.GetString();
-    return BinData(data, data + sb_.GetLength());
+
+    return out_.buffer();
+}
+
+
+BinData JsonSerializerImpl::take_buffer()
+{
+    BinData result;
+
+    take_buffer(result);
+
+    return result;
+}
+
+
+void JsonSerializerImpl::reset(BinData &buffer)
+{
+    out_.buffer().swap(buffer);
+    clear();
+}
+
+
+void JsonSerializerImpl::take_buffer(BinData &buffer)
+{
+    if (!writer_.IsComplete()) writer_.EndObject();
+
+    out_.buffer().swap(buffer);
+    clear();
+}
+
+
+void JsonSerializerImpl::reset(std::ostream &stream)
+{
+    out_.set_stream(&stream);
+    clear();
+}
+
+
+void JsonSerializerImpl::finish()
+{
+    if (!writer_.IsComplete()) writer_.EndObject();
+
+    out_.Flush();
+    out_.set_stream(nullptr);
+    clear();
 }
 
 
 void JsonSerializerImpl::clear()
 {
-    sb_.Clear();
-    writer_.Reset(sb_);
+    out_.buffer().clear();
+    writer_.Reset(out_);
     writer_.StartObject();
     need_init_ = false;
 }
@@ -304,26 +399,274 @@ void JsonSerializerImpl::append_field(const String &name, const ValueList &data)
 }
 
 
+// Packed arrays are written as usual JSON arrays: after parsing they become ValueArray.
+void JsonSerializerImpl::append_field(const String &name, const DoubleArray &data)
+{
+    append_field<const DoubleArray&>(name, data);
+}
+
+
+void JsonSerializerImpl::append_field(const String &name, const Int32Array &data)
+{
+    append_field<const Int32Array&>(name, data);
+}
+
+
+void JsonSerializerImpl::append_fields(const String &name, const FieldsWriter &fields)
+{
+    JsonFieldWriter field_writer(*this);
+
+    if (need_init_) clear();
+    write_name(name);
+    writer_.StartObject();
+    fields(field_writer);
+    writer_.EndObject();
+}
+
+
 //----------------------------------------------------------------------------
-// JsonDeserializerImpl
+// JsonFieldWriter
 //----------------------------------------------------------------------------
 
-// R"_(^P?(?:(\d+)[Y-]{1})?(?:(\d+)[M-]{1})?(?:(\d+)D?)?T(?:(\d+)[H:]{1})?(?:(\d+)[M:]{1})?(?:(\d+)S?)?(?:\.(\d+))?Z?$)_"
-// All groups are mandatory.
-const std::regex JsonDeserializerImpl::iso8601_check_regex_(R"_(^P?(?:(\d+)[Y-]{1})(?:(\d+)[M-]{1})(?:(\d+)D?)T(?:(\d+)[H:]{1})(?:(\d+)[M:]{1})(?:(\d+)S?)(?:\.(\d+))Z$)_");
+void JsonFieldWriter::start_object(const char *name)
+{
+    serializer_.writer_.Key(name);
+    serializer_.writer_.StartObject();
+}
+
 
-enum class iso8601_regex_group
+void JsonFieldWriter::finish_object()
 {
-    year = 1,
-    month = 2,
-    day = 3,
-    hour = 4,
-    minute = 5,
-    second = 6,
-    fraction = 7
-};
+    serializer_.writer_.EndObject();
+}
+
+
+template<typename T>
+void JsonFieldWriter::write_named(const char *name, const T &data)
+{
+    serializer_.writer_.Key(name);
+    serializer_.write_field(data);
+}
+
+
+void JsonFieldWriter::write(const char *name, bool data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, int32_t data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, int64_t data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, double data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, const String &data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, const BinData &data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, const Time &data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, const DoubleArray &data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, const Int32Array &data)
+{
+    write_named(name, data);
+}
+
+
+void JsonFieldWriter::write(const char *name, const Value &data)
+{
+    write_named(name, data);
+}
+
+
+//----------------------------------------------------------------------------
+// JsonValueHandler
+//----------------------------------------------------------------------------
+
+JsonValueHandler::JsonValueHandler() : root_(NameValueMap()), root_started_(false)
+{
+}
+
+
+Value *JsonValueHandler::add_value(Value &&value)
+{
+    if (containers_.empty()) return nullptr;
+
+    Value &container = *containers_.back();
+
+    if (container.is_array())
+    {
+        auto &array = container.as_array();
+
+        array.push_back(std::move(value));
+        return &array.back();
+    }
+
+    // Serializers write the sorted keys: the hint makes insertion constant.
+    auto &object = container.as_object();
+    auto iter = object.emplace_hint(object.end(), std::move(key_), Value());
+
+    // The last duplicated key wins.
+    iter->second = std::move(value);
+
+    return &iter->second;
+}
+
+
+// Container is filled, until the end event. The parent isn't changed meanwhile, so the pointer stays valid.
+bool JsonValueHandler::start_container(Value &&container)
+{
+    Value *added = add_value(std::move(container));
+
+    if (!added) return false;
+    containers_.push_back(added);
+
+    return true;
+}
+
+
+bool JsonValueHandler::Null()
+{
+    return add_value(tsw::Null()) != nullptr;
+}
+
+
+bool JsonValueHandler::Bool(bool data)
+{
+    return add_value(data) != nullptr;
+}
+
+
+bool JsonValueHandler::Int(int data)
+{
+    return add_value(data) != nullptr;
+}
+
+
+bool JsonValueHandler::Uint(unsigned data)
+{
+    if (data <= static_cast<unsigned>(std::numeric_limits<int32_t>::max()))
+    {
+        return add_value(static_cast<int32_t>(data)) != nullptr;
+    }
+
+    return add_value(static_cast<int64_t>(data)) != nullptr;
+}
+
+
+bool JsonValueHandler::Int64(int64_t data)
+{
+    return add_value(data) != nullptr;
+}
+
+
+bool JsonValueHandler::Uint64(uint64_t data)
+{
+    if (data <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+    {
+        return add_value(static_cast<int64_t>(data)) != nullptr;
+    }
+
+    return add_value(static_cast<double>(data)) != nullptr;
+}
+
+
+bool JsonValueHandler::Double(double data)
+{
+    return add_value(data) != nullptr;
+}
+
+
+bool JsonValueHandler::RawNumber(const char *data, rj::SizeType length, bool copy)
+{
+    // Numbers are not parsed as strings.
+    return false;
+}
+
+
+bool JsonValueHandler::String(const char *data, rj::SizeType length, bool copy)
+{
+    return add_value(JsonDeserializerImpl::StringValue(data, length)) != nullptr;
+}
+
+
+bool JsonValueHandler::StartObject()
+{
+    if (!containers_.empty()) return start_container(NameValueMap());
+
+    // Document must be an object.
+    if (root_started_) return false;
+
+    root_started_ = true;
+    containers_.push_back(&root_);
+
+    return true;
+}
+
+
+bool JsonValueHandler::Key(const char *data, rj::SizeType length, bool copy)
+{
+    key_.assign(data, length);
+
+    return true;
+}
+
+
+bool JsonValueHandler::EndObject(rj::SizeType member_count)
+{
+    containers_.pop_back();
+
+    return true;
+}
 
 
+bool JsonValueHandler::StartArray()
+{
+    return start_container(ValueArray());
+}
+
+
+bool JsonValueHandler::EndArray(rj::SizeType element_count)
+{
+    containers_.pop_back();
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// JsonDeserializerImpl
+//----------------------------------------------------------------------------
+
 JsonDeserializerImpl::JsonDeserializerImpl()
 {
 }
@@ -334,27 +677,108 @@ JsonDeserializerImpl::~JsonDeserializerImpl()
 }
 
 
+template<unsigned flags, typename InputStream>
+NameValueMap JsonDeserializerImpl::Parse(InputStream &stream)
+{
+    rj::Reader reader;
+    JsonValueHandler handler;
+
+    rj::ParseResult parse_result = reader.Parse<flags | rj::kParseStopWhenDoneFlag>(stream, handler);
+
+    if (!parse_result) TSW_THROW(JsonException, parse_result.Code(), parse_result.Offset());
+
+    return handler.take_result();
+}
+
+
+// There are no unknown types in the SAX events: raise_on_unknown is used by the DOM values parsing only.
 NameValueMap JsonDeserializerImpl::Deserialize(const BinData::value_type* bin_data, size_t size, bool raise_on_unknown)
 {
-    NameValueMap result;
-    rj::Document doc;
+    rj::MemoryStream stream(reinterpret_cast<const char*>(bin_data), size);
 
     raise_on_unknown_ = raise_on_unknown;
 
-    rj::ParseResult parse_result = doc.Parse<rj::kParseStopWhenDoneFlag>(reinterpret_cast<const char*>(bin_data), size);
+    return Parse<rj::kParseNoFlags>(stream);
+}
+
 
-    if (!parse_result) TSW_THROW(JsonException, parse_result.Code(), parse_result.Offset());
+NameValueMap JsonDeserializerImpl::DeserializeInsitu(BinData &buffer)
+{
+    if (buffer.empty() || buffer.back()) buffer.push_back(0);
 
-    for (rj::Value::ConstMemberIterator iter = doc.MemberBegin(); iter != doc.MemberEnd(); ++iter)
+    rj::InsituStringStream stream(reinterpret_cast<char*>(buffer.data()));
+
+    return Parse<rj::kParseInsituFlag>(stream);
+}
+
+
+// Handler, which stops the parsing on the envelope "type" field.
+class JsonMessageTypeHandler : public rj::BaseReaderHandler<rj::UTF8<>, JsonMessageTypeHandler>
+{
+public:
+    bool Default() { return !type_expected_; }
+    bool Int(int data) { return found(data); }
+    bool Uint(unsigned data) { return data <= static_cast<unsigned>(std::numeric_limits<int>::max()) ? found(data) : Default(); }
+    bool Int64(int64_t) { return Default(); }
+    bool Uint64(uint64_t) { return Default(); }
+
+    bool StartObject() { return ++depth_, Default(); }
+    bool EndObject(rj::SizeType) { return --depth_, true; }
+    bool StartArray() { return ++depth_, Default(); }
+    bool EndArray(rj::SizeType) { return --depth_, true; }
+
+    bool Key(const char *data, rj::SizeType length, bool)
     {
-        const rj::Value &v = iter->value;
-        const String &name = iter->name.GetString();
+        type_expected_ = depth_ == 1 && std::string_view(data, length) == "type";
+        return true;
+    }
+
+public:
+    bool has_type() const { return has_type_; }
+    MessageType get_type() const { return type_; }
+
+private:
+    bool found(int data)
+    {
+        if (!type_expected_) return true;
+
+        type_ = static_cast<MessageType>(data);
+        has_type_ = true;
 
-        cur_value_name_ = &name;
-        result[name] = std::move(ParseValue(v));
+        return false;
     }
 
-    return result;
+private:
+    int         depth_ = 0;
+    bool        type_expected_ = false;
+    bool        has_type_ = false;
+    MessageType type_ = MessageType::Event;
+};
+
+
+MessageType JsonDeserializerImpl::DeserializeMessageType(const BinData::value_type* bin_data, size_t size)
+{
+    rj::MemoryStream stream(reinterpret_cast<const char*>(bin_data), size);
+    rj::Reader reader;
+    JsonMessageTypeHandler handler;
+
+    rj::ParseResult parse_result = reader.Parse<rj::kParseStopWhenDoneFlag>(stream, handler);
+
+    if (handler.has_type()) return handler.get_type();
+    if (!parse_result) TSW_THROW(JsonException, parse_result.Code(), parse_result.Offset());
+
+    TSW_THROW(JsonException, "message has no integer type");
+}
+
+
+Value JsonDeserializerImpl::StringValue(const char *data, size_t size)
+{
+    Time time;
+
+    if (is_base64(reinterpret_cast<const BinData::value_type*>(data), size)) return from_base64(data, size);
+    else if (parse_time(data, size, time)) return time;
+
+    return String(data, size);
 }
 
 
@@ -368,75 +792,7 @@ Value JsonDeserializerImpl::ParseValue(const rj::Value &value)
             else if (value.IsDouble() || value.IsLosslessDouble()) return value.GetDouble();
         break;
         case rj::Type::kStringType:
-        {
-            const String &s = value.GetString();
-            std::smatch matches;
-
-            if (is_base64(s)) return std::move(from_base64(s));
-            else if (std::regex_search(s, matches, iso8601_check_regex_))
-            {
-                // Date/time.
-                std::tm timeinfo;
-                Time frac;
-                memset(&timeinfo, 0, sizeof(tm));
-
-                for (size_t i = 0; i < matches.size(); ++i )
-                {
-                    const auto &mi = matches[i];
-                    if (!mi.matched) continue;
-                    switch (static_cast<const iso8601_regex_group>(i))
-                    {
-                    case iso8601_regex_group::year:
-                    {
-                        timeinfo.tm_year = stoi(mi.str()) - 1900;
-                        break;
-                    }
-                    case iso8601_regex_group::month:
-                    {
-                        timeinfo.tm_mon = stoi(mi.str()) - 1;
-                        break;
-                    }
-                    case iso8601_regex_group::day:
-                    {
-                        timeinfo.tm_mday = stoi(mi.str());
-                        break;
-                    }
-                    case iso8601_regex_group::hour:
-                    {
-                        timeinfo.tm_hour = stoi(mi.str());
-                        break;
-                    }
-                    case iso8601_regex_group::minute:
-                    {
-                        timeinfo.tm_min = stoi(mi.str());
-                        break;
-                    }
-                    case iso8601_regex_group::second:
-                    {
-                        timeinfo.tm_sec = stoi(mi.str());
-                        break;
-                    }
-                    case iso8601_regex_group::fraction:
-                    {
-                        frac = Time(stoi(mi.str()));
-                        break;
-                    }
-                    default:
-                    {
-                        // TODO: warning.
-                        break;
-                    }
-                    }
-                }
-
-                timeinfo.tm_isdst = -1;
-                // _mkgmtime on win
-                auto tp = std::chrono::high_resolution_clock::from_time_t(timegm(&timeinfo)) + frac;
-                return std::chrono::duration_cast<Time>(tp.time_since_epoch());
-            }
-            else return std::move(value.GetString());
-            break;
-        }
+            return StringValue(value.GetString(), value.GetStringLength());
         case rj::Type::kArrayType:
         {
             ValueArray va;
@@ -471,6 +827,293 @@ Value JsonDeserializerImpl::ParseValue(const rj::Value &value)
     return Value();
 }
 
+// Read decimal number, which has no more than max_digits digits.
+static inline bool read_number(const char *&p, const char *data_end, int max_digits, int64_t &result)
+{
+    const char *start = p;
+
+    result = 0;
+    for (; p != data_end && *p >= '0' && *p <= '9'; ++p)
+    {
+        if (p - start == max_digits) return false;
+        result = result * 10 + (*p - '0');
+    }
+
+    return p != start;
+}
+
+
+// Read separator, which may be one of the two characters.
+static inline bool read_separator(const char *&p, const char *data_end, char first, char second)
+{
+    if (p == data_end || (*p != first && *p != second)) return false;
+    ++p;
+
+    return true;
+}
+
+
+static inline void skip_optional(const char *&p, const char *data_end, char c)
+{
+    if (p != data_end && *p == c) ++p;
+}
+
+
+// Days since epoch from the civil date, proleptic Gregorian calendar.
+static inline int64_t days_from_civil(int64_t year, unsigned month, unsigned day)
+{
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+
+// Recognizes strings, matching "^P?(\d+)[Y-](\d+)[M-](\d+)D?T(\d+)[H:](\d+)[M:](\d+)S?\.(\d+)Z$",
+// with the valid field values.
+bool JsonDeserializerImpl::parse_time(const char *data, size_t size, Time &result)
+{
+    const char *p = data;
+    const char *data_end = data + size;
+    int64_t year, month, day, hour, minute, second, fraction;
+
+    // Fast rejection of the usual strings.
+    if (size < 13 || data[size - 1] != 'Z') return false;
+
+    skip_optional(p, data_end, 'P');
+    if (!read_number(p, data_end, 9, year) || !read_separator(p, data_end, 'Y', '-')) return false;
+    if (!read_number(p, data_end, 2, month) || !read_separator(p, data_end, 'M', '-')) return false;
+    if (!read_number(p, data_end, 2, day)) return false;
+    skip_optional(p, data_end, 'D');
+    if (!read_separator(p, data_end, 'T', 'T')) return false;
+    if (!read_number(p, data_end, 2, hour) || !read_separator(p, data_end, 'H', ':')) return false;
+    if (!read_number(p, data_end, 2, minute) || !read_separator(p, data_end, 'M', ':')) return false;
+    if (!read_number(p, data_end, 2, second)) return false;
+    skip_optional(p, data_end, 'S');
+    if (!read_separator(p, data_end, '.', '.') || !read_number(p, data_end, 9, fraction)) return false;
+    if (p + 1 != data_end) return false;
+
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) return false;
+
+    const int64_t seconds = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+                            hour * 3600 + minute * 60 + second;
+
+    result = std::chrono::seconds(seconds) + Time(fraction);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// JsonFieldReader
+//----------------------------------------------------------------------------
+
+JsonFieldReader::JsonFieldReader(JsonDeserializerImpl &parser, const rj::Value &object) :
+    parser_(parser), object_(object)
+{
+    // Unknown values are returned as Undefined.
+    parser_.raise_on_unknown_ = false;
+    if (!object_.IsObject()) TSW_THROW(JsonException, "JSON value is not an object");
+}
+
+
+const rj::Value *JsonFieldReader::find(const char *name) const
+{
+    auto member = object_.FindMember(name);
+
+    return member != object_.MemberEnd() ? &member->value : nullptr;
+}
+
+
+void JsonFieldReader::type_error(const char *name)
+{
+    TSW_THROW(JsonException, String("field \"") + name + "\" has another type");
+}
+
+
+bool JsonFieldReader::read(const char *name, bool &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+    if (!value->IsBool()) type_error(name);
+    data = value->GetBool();
+
+    return true;
+}
+
+
+bool JsonFieldReader::read(const char *name, int32_t &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+    if (!value->IsInt()) type_error(name);
+    data = value->GetInt();
+
+    return true;
+}
+
+
+bool JsonFieldReader::read(const char *name, int64_t &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+    if (!value->IsInt64()) type_error(name);
+    data = value->GetInt64();
+
+    return true;
+}
+
+
+bool JsonFieldReader::read(const char *name, double &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+    if (!value->IsNumber()) type_error(name);
+    data = value->GetDouble();
+
+    return true;
+}
+
+
+bool JsonFieldReader::read(const char *name, String &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+    if (!value->IsString()) type_error(name);
+    data.assign(value->GetString(), value->GetStringLength());
+
+    return true;
+}
+
+
+// BinData and Time are encoded as strings: their recognition is the same, as for the Value.
+template<typename T>
+bool JsonFieldReader::read_parsed(const char *name, T &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+
+    Value parsed = parser_.ParseValue(*value);
+
+    if (!std::holds_alternative<T>(parsed)) type_error(name);
+    data = std::move(parsed.as<T>());
+
+    return true;
+}
+
+
+bool JsonFieldReader::read(const char *name, BinData &data)
+{
+    return read_parsed(name, data);
+}
+
+
+bool JsonFieldReader::read(const char *name, Time &data)
+{
+    return read_parsed(name, data);
+}
+
+
+template<typename ArrayType>
+bool JsonFieldReader::read_array(const char *name, ArrayType &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+    if (!value->IsArray()) type_error(name);
+
+    const auto &array = value->GetArray();
+
+    data.clear();
+    data.reserve(array.Size());
+
+    for (const auto &element: array)
+    {
+        if constexpr (std::is_floating_point_v<typename ArrayType::value_type>)
+        {
+            if (!element.IsNumber()) type_error(name);
+            data.push_back(element.GetDouble());
+        }
+        else
+        {
+            if (!element.IsInt()) type_error(name);
+            data.push_back(element.GetInt());
+        }
+    }
+
+    return true;
+}
+
+
+bool JsonFieldReader::read(const char *name, DoubleArray &data)
+{
+    return read_array(name, data);
+}
+
+
+bool JsonFieldReader::read(const char *name, Int32Array &data)
+{
+    return read_array(name, data);
+}
+
+
+bool JsonFieldReader::read(const char *name, Value &data)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+    data = parser_.ParseValue(*value);
+
+    return true;
+}
+
+
+bool JsonFieldReader::read_object(const char *name, const FieldsReader &reader)
+{
+    auto value = find(name);
+
+    if (!value) return false;
+
+    JsonFieldReader nested_reader(parser_, *value);
+    reader(nested_reader);
+
+    return true;
+}
+
+
 } // namespace impl
 
+
+void write_json(const FieldsWriter &fields, BinData &buffer)
+{
+    impl::JsonSerializerImpl serializer;
+    impl::JsonFieldWriter writer(serializer);
+
+    serializer.reset(buffer);
+    fields(writer);
+    serializer.take_buffer(buffer);
+}
+
+
+void read_json(const BinData::value_type *data, size_t size, const FieldsReader &fields)
+{
+    impl::rj::Document doc;
+    impl::JsonDeserializerImpl parser;
+
+    impl::rj::ParseResult parse_result = doc.Parse<impl::rj::kParseStopWhenDoneFlag>(reinterpret_cast<const char*>(data), size);
+
+    if (!parse_result) TSW_THROW(impl::JsonException, parse_result.Code(), parse_result.Offset());
+
+    impl::JsonFieldReader reader(parser, doc);
+    fields(reader);
+}
+
 } // namespace tsw
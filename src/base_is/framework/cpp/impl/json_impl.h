@@ -8,12 +8,17 @@
 #ifndef _TSW_JSON_IMPL_H
 #define _TSW_JSON_IMPL_H
 
-#include <regex>
+#include <ostream>
 #include <type_traits>
+#include <vector>
 
 #include <rapidjson/document.h>
 #include <rapidjson/prettywriter.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/writer.h>
 
+#include "tsw/field_access.h"
+#include "tsw/message.h"
 #include "tsw/types.h"
 #include "tsw/type_traits.h"
 
@@ -26,12 +31,91 @@ namespace impl
 
 namespace rj = rapidjson;
 
+/**
+ * @brief RapidJSON output stream, which writes into the BinData.
+ *
+ * When the file stream is set, the buffer is only a chunk: it's written to the stream,
+ * when filled and when the document is finished.
+ */
+class JsonOutputStream
+{
+public:
+    typedef char Ch;
+    static constexpr size_t stream_chunk_size = 64 * 1024;
+
+public:
+    JsonOutputStream() : stream_(nullptr) {}
+
+public:
+    void Put(Ch c)
+    {
+        buffer_.push_back(static_cast<BinData::value_type>(c));
+        if (stream_ && buffer_.size() >= stream_chunk_size) Flush();
+    }
+
+    void Flush()
+    {
+        if (!stream_ || buffer_.empty()) return;
+        stream_->write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size());
+        buffer_.clear();
+    }
+
+public:
+    BinData &buffer() { return buffer_; }
+    void set_stream(std::ostream *stream) { stream_ = stream; }
+
+private:
+    BinData         buffer_;
+    std::ostream   *stream_;
+};
+
+
+/**
+ * @brief Pretty or compact RapidJSON writer with the writer's interface.
+ */
+class JsonWriter
+{
+public:
+    JsonWriter(JsonOutputStream &stream, bool pretty) :
+        pretty_(pretty), compact_writer_(stream), pretty_writer_(stream) {}
+
+public:
+    bool is_pretty() const { return pretty_; }
+
+    void Reset(JsonOutputStream &stream) { compact_writer_.Reset(stream); pretty_writer_.Reset(stream); }
+    bool IsComplete() const { return pretty_ ? pretty_writer_.IsComplete() : compact_writer_.IsComplete(); }
+
+    template<typename ...Args> bool Key(Args&& ...args) { return call([&](auto &w) { return w.Key(args...); }); }
+    template<typename ...Args> bool String(Args&& ...args) { return call([&](auto &w) { return w.String(args...); }); }
+    bool Int(int data) { return call([=](auto &w) { return w.Int(data); }); }
+    bool Int64(int64_t data) { return call([=](auto &w) { return w.Int64(data); }); }
+    bool Double(double data) { return call([=](auto &w) { return w.Double(data); }); }
+    bool Bool(bool data) { return call([=](auto &w) { return w.Bool(data); }); }
+    bool Null() { return call([](auto &w) { return w.Null(); }); }
+    bool StartObject() { return call([](auto &w) { return w.StartObject(); }); }
+    bool EndObject() { return call([](auto &w) { return w.EndObject(); }); }
+    bool StartArray() { return call([](auto &w) { return w.StartArray(); }); }
+    bool EndArray() { return call([](auto &w) { return w.EndArray(); }); }
+
+private:
+    template<typename F>
+    bool call(F &&f) { return pretty_ ? f(pretty_writer_) : f(compact_writer_); }
+
+private:
+    const bool pretty_;
+    rj::Writer<JsonOutputStream> compact_writer_;
+    rj::PrettyWriter<JsonOutputStream> pretty_writer_;
+};
+
+
 class JsonSerializerImpl
 {
 public:
-    const char *datetime_format = "%FT%T";
+    /// Maximal length of the formatted time.
+    static constexpr size_t max_time_length = 48;
+
 public:
-    JsonSerializerImpl();
+    explicit JsonSerializerImpl(bool pretty = true);
     ~JsonSerializerImpl();
 
 public:
@@ -47,14 +131,47 @@ public:
     void append_field(const String &name, const Value &data);
     void append_field(const String &name, const ValueArray &data);
     void append_field(const String &name, const ValueList &data);
+    void append_field(const String &name, const DoubleArray &data);
+    void append_field(const String &name, const Int32Array &data);
 
     void append_uid(const String &name, UID data, size_t size);
     void append_null_field(const String &name);
     void append_undefined_field(const String &name);
 
+    /**
+     * @brief Append nested object, which fields are written by the callback.
+     */
+    void append_fields(const String &name, const FieldsWriter &fields);
+
 public:
     void clear();
+    /// @return copy of the finished document.
     BinData get_buffer();
+    BinData take_buffer();
+
+    /**
+     * @brief Start a new document in the buffer memory. Buffer gets the previous writer's memory.
+     */
+    void reset(BinData &buffer);
+
+    /**
+     * @brief Finish the document and exchange it with the buffer.
+     */
+    void take_buffer(BinData &buffer);
+
+    /**
+     * @brief Start a new document, which is written to the stream by chunks.
+     *
+     * Document is completely written after finish().
+     */
+    void reset(std::ostream &stream);
+    void finish();
+
+    /**
+     * @brief Format time as ISO 8601 UTC string, fraction contains nanoseconds.
+     * @return string length.
+     */
+    static size_t format_time(Time data, char *buffer);
 
 public:
     void print_buffer();
@@ -85,10 +202,53 @@ private:
     inline void write_undefined_field();
 
 private:
+    friend class JsonFieldWriter;
+
     // Fucking China programmer. RAPIDJson has private member hasRoot_ without getter.
     bool need_init_;
-    rj::StringBuffer sb_;
-    rj::PrettyWriter<rj::StringBuffer> writer_;
+    JsonOutputStream out_;
+    JsonWriter writer_;
+};
+
+
+/**
+ * @brief RapidJSON SAX handler, which builds the Values directly, without the DOM.
+ */
+class JsonValueHandler
+{
+public:
+    JsonValueHandler();
+
+public:
+    bool Null();
+    bool Bool(bool data);
+    bool Int(int data);
+    bool Uint(unsigned data);
+    bool Int64(int64_t data);
+    bool Uint64(uint64_t data);
+    bool Double(double data);
+    bool RawNumber(const char *data, rj::SizeType length, bool copy);
+    bool String(const char *data, rj::SizeType length, bool copy);
+    bool StartObject();
+    bool Key(const char *data, rj::SizeType length, bool copy);
+    bool EndObject(rj::SizeType member_count);
+    bool StartArray();
+    bool EndArray(rj::SizeType element_count);
+
+public:
+    NameValueMap take_result() { return std::move(root_.as_object()); }
+
+private:
+    /// Add value to the current container. @return added value or nullptr, if there is no container.
+    Value *add_value(Value &&value);
+    bool start_container(Value &&container);
+
+private:
+    Value               root_;
+    bool                root_started_;
+    // Containers, which are being filled.
+    std::vector<Value*> containers_;
+    tsw::String         key_;
 };
 
 
@@ -101,16 +261,106 @@ public:
 public:
     NameValueMap Deserialize(const BinData::value_type* bin_data, size_t size, bool raise_on_unknown = false);
 
+    /**
+     * @brief Deserialize document in the buffer memory: the strings are unescaped in place and copied once.
+     *
+     * Buffer content is modified, terminating zero is appended, if it's absent.
+     */
+    NameValueMap DeserializeInsitu(BinData &buffer);
+
+    /**
+     * @brief Read the "type" field only.
+     */
+    MessageType DeserializeMessageType(const BinData::value_type* bin_data, size_t size);
+
+    /// String value, which may be a BinData or a Time, recognized by the prefix and the format.
+    static Value StringValue(const char *data, size_t size);
+
+    /**
+     * @brief Parse time, which was formatted by the serializer: ISO 8601 UTC, fraction contains nanoseconds.
+     * @return false, if the string is not a time.
+     */
+    static bool parse_time(const char *data, size_t size, Time &result);
+
 private:
+    friend class JsonFieldReader;
+
+    template<unsigned flags, typename InputStream>
+    NameValueMap Parse(InputStream &stream);
+
     Value ParseValue(const rj::Value &value);
 
 private:
-    const static std::regex iso8601_check_regex_;
     bool raise_on_unknown_;
     // Need for the exception message.
     const String *cur_value_name_;
 };
 
+class JsonFieldWriter : public FieldWriter
+{
+public:
+    explicit JsonFieldWriter(JsonSerializerImpl &serializer) : serializer_(serializer) {}
+
+public:
+    using FieldWriter::write;
+
+    void write(const char *name, bool data) override;
+    void write(const char *name, int32_t data) override;
+    void write(const char *name, int64_t data) override;
+    void write(const char *name, double data) override;
+    void write(const char *name, const String &data) override;
+    void write(const char *name, const BinData &data) override;
+    void write(const char *name, const Time &data) override;
+    void write(const char *name, const DoubleArray &data) override;
+    void write(const char *name, const Int32Array &data) override;
+    void write(const char *name, const Value &data) override;
+
+    void start_object(const char *name) override;
+    void finish_object() override;
+
+private:
+    template<typename T>
+    void write_named(const char *name, const T &data);
+
+private:
+    JsonSerializerImpl &serializer_;
+};
+
+
+class JsonFieldReader : public FieldReader
+{
+public:
+    JsonFieldReader(JsonDeserializerImpl &parser, const rj::Value &object);
+
+public:
+    bool read(const char *name, bool &data) override;
+    bool read(const char *name, int32_t &data) override;
+    bool read(const char *name, int64_t &data) override;
+    bool read(const char *name, double &data) override;
+    bool read(const char *name, String &data) override;
+    bool read(const char *name, BinData &data) override;
+    bool read(const char *name, Time &data) override;
+    bool read(const char *name, DoubleArray &data) override;
+    bool read(const char *name, Int32Array &data) override;
+    bool read(const char *name, Value &data) override;
+
+    bool read_object(const char *name, const FieldsReader &reader) override;
+
+private:
+    const rj::Value *find(const char *name) const;
+    [[noreturn]] static void type_error(const char *name);
+
+    template<typename T>
+    bool read_parsed(const char *name, T &data);
+
+    template<typename ArrayType>
+    bool read_array(const char *name, ArrayType &data);
+
+private:
+    JsonDeserializerImpl    &parser_;
+    const rj::Value         &object_;
+};
+
 } // namespace impl
 
 } // namespace tsw
@@ -7,6 +7,7 @@
 
 #include <tsw/json_serializer.h>
 #include <tsw/types.h>
+#include <tsw/wire_format.h>
 
 #include "json_impl.h"
 
@@ -15,7 +16,8 @@ namespace tsw
 {
 
 
-JsonSerializer::JsonSerializer() : jsrec_(new impl::JsonSerializerImpl)
+JsonSerializer::JsonSerializer(JsonStyle style) :
+    style_(style), jsrec_(new impl::JsonSerializerImpl(JsonStyle::Pretty == style))
 {}
 
 
@@ -29,13 +31,59 @@ BinData JsonSerializer::SerializeMessage(const Message &message)
 }
 
 
+void JsonSerializer::SerializeMessageTo(const Message &message, BinData &buffer)
+{
+    // Writer encodes directly into the caller's memory.
+    jsrec_->reset(buffer);
+    WriteMessage<impl::JsonSerializerImpl>(message, *jsrec_);
+    jsrec_->take_buffer(buffer);
+}
+
+
+void JsonSerializer::SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer)
+{
+    jsrec_->reset(buffer);
+    WriteEnvelope<impl::JsonSerializerImpl>(envelope, *jsrec_);
+    jsrec_->append_fields("fields", fields);
+    jsrec_->take_buffer(buffer);
+}
+
+
+void JsonSerializer::SerializeMessageTo(const Message &message, std::ostream &stream)
+{
+    jsrec_->reset(stream);
+    WriteMessage<impl::JsonSerializerImpl>(message, *jsrec_);
+    jsrec_->finish();
+}
+
+
+void JsonSerializer::SerializeObjectTo(const Object &fields, std::ostream &stream)
+{
+    jsrec_->reset(stream);
+    for (const auto &field: fields) jsrec_->append_field(field.first, field.second);
+    jsrec_->finish();
+}
+
+
+std::unique_ptr<Serializer> JsonSerializer::Clone() const
+{
+    return std::unique_ptr<Serializer>(new JsonSerializer(style_));
+}
+
+
+WireFormat JsonSerializer::Format() const
+{
+    return WireFormat::Json;
+}
+
+
 BinData JsonSerializer::SerializeObject(const Object &fields)
 {
     jsrec_->clear();
 
-    for (const auto field: fields) jsrec_->append_field(field.first, field.second);
+    for (const auto &field: fields) jsrec_->append_field(field.first, field.second);
 
-    return jsrec_->get_buffer();
+    return jsrec_->take_buffer();
 }
 
 } // namespace tsw
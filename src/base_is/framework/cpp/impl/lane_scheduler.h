@@ -0,0 +1,142 @@
+/**
+  * @file lane_scheduler.h
+  * @author Artiom N.(cl)2017
+  * @brief LaneScheduler class: weighted round robin over the send queues of the priority lanes.
+  *
+  */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+
+#include "tsw/message_lanes.h"
+
+#include "latency_recorder.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Send queues of the lanes.
+ *
+ * Scheduler walks the lanes in the priority order, every lane sends up to its weight frames per round:
+ * queued control frame goes ahead of the data, but data isn't starved by the control flood.
+ * Scheduler isn't thread-safe: caller guards it.
+ */
+template<typename Frame>
+class LaneScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        Frame               frame;
+        Clock::time_point   queued;
+    };
+
+public:
+    explicit LaneScheduler(const LaneWeights &weights = default_lane_weights()) :
+        weights_(weights), credits_(weights)
+    {
+        for (auto &weight: weights_)
+        {
+            if (!weight) weight = 1;
+        }
+        credits_ = weights_;
+    }
+
+public:
+    void push(MessageLane lane, Frame &&frame)
+    {
+        queues_[index(lane)].push_back(Entry{ std::move(frame), Clock::now() });
+    }
+
+    /**
+     * @brief Choose the lane, which sends the next frame.
+     * @return false, if all queues are empty.
+     */
+    bool next(MessageLane &lane)
+    {
+        if (empty()) return false;
+
+        for (;;)
+        {
+            for (size_t i = 0; i < message_lanes_count; ++i)
+            {
+                if (!queues_[i].empty() && credits_[i])
+                {
+                    --credits_[i];
+                    lane = static_cast<MessageLane>(i);
+                    return true;
+                }
+            }
+
+            // Round is over.
+            credits_ = weights_;
+        }
+    }
+
+    /**
+     * @brief Return the credit, which was taken by next(), when the frame wasn't sent.
+     */
+    void refund(MessageLane lane)
+    {
+        auto &credit = credits_[index(lane)];
+
+        if (credit < weights_[index(lane)]) ++credit;
+    }
+
+    Entry &front(MessageLane lane) { return queues_[index(lane)].front(); }
+    void pop(MessageLane lane) { queues_[index(lane)].pop_front(); }
+
+    bool empty() const
+    {
+        for (const auto &queue: queues_)
+        {
+            if (!queue.empty()) return false;
+        }
+
+        return true;
+    }
+
+    size_t size(MessageLane lane) const { return queues_[index(lane)].size(); }
+
+    void clear()
+    {
+        for (auto &queue: queues_) queue.clear();
+        credits_ = weights_;
+    }
+
+    /**
+     * @brief Clear the queues, dropped(entry) is called for every queued frame.
+     */
+    template<typename Handler>
+    void clear(Handler dropped)
+    {
+        for (auto &queue: queues_)
+        {
+            for (auto &entry: queue) dropped(entry);
+        }
+
+        clear();
+    }
+
+private:
+    static size_t index(MessageLane lane) { return static_cast<size_t>(lane); }
+
+private:
+    LaneWeights                                         weights_;
+    LaneWeights                                         credits_;
+    std::array<std::deque<Entry>, message_lanes_count>  queues_;
+};
+
+} // namespace impl
+
+} // namespace tsw
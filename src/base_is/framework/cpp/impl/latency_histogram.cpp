@@ -0,0 +1,55 @@
+/**
+  * @file latency_histogram.cpp
+  * @author Artiom N.(cl)2017
+  * @brief LatencyHistogram implementation.
+  *
+  */
+
+#include <numeric>
+
+#include <tsw/latency_histogram.h>
+
+
+namespace tsw
+{
+
+uint64_t LatencyHistogram::count() const
+{
+    return std::accumulate(buckets.begin(), buckets.end(), uint64_t(0));
+}
+
+
+std::chrono::microseconds LatencyHistogram::percentile(double percentile) const
+{
+    const auto total = count();
+
+    if (!total) return std::chrono::microseconds(0);
+
+    const auto rank = static_cast<uint64_t>(percentile * total / 100);
+    uint64_t counted = 0;
+
+    for (size_t i = 0; i < buckets_count; ++i)
+    {
+        counted += buckets[i];
+        if (counted > rank || counted == total) return std::chrono::microseconds(uint64_t(1) << i);
+    }
+
+    return std::chrono::microseconds(uint64_t(1) << (buckets_count - 1));
+}
+
+
+size_t LatencyHistogram::bucket(std::chrono::nanoseconds latency)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    size_t result = 0;
+
+    while (us > 0 && result < buckets_count - 1)
+    {
+        us >>= 1;
+        ++result;
+    }
+
+    return result;
+}
+
+} // namespace tsw
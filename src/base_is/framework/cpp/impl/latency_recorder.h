@@ -0,0 +1,52 @@
+/**
+  * @file latency_recorder.h
+  * @author Artiom N.(cl)2017
+  * @brief LatencyRecorder class: latency histogram, which is filled concurrently.
+  *
+  */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "tsw/latency_histogram.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Latency histogram, which is filled from several threads.
+ */
+class LatencyRecorder
+{
+public:
+    void record(std::chrono::nanoseconds latency)
+    {
+        buckets_[LatencyHistogram::bucket(latency)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram histogram() const
+    {
+        LatencyHistogram result;
+
+        for (size_t i = 0; i < LatencyHistogram::buckets_count; ++i)
+        {
+            result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+
+        return result;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, LatencyHistogram::buckets_count> buckets_{};
+};
+
+} // namespace impl
+
+} // namespace tsw
@@ -5,18 +5,41 @@
   *
   */
 
+#include <algorithm>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include <boost/range/adaptor/map.hpp>
 
 #include <tsw/error.h>
+#include <tsw/field_access.h>
+#include <tsw/logger.h>
 #include <tsw/magistral.h>
 #include <tsw/message.h>
 #include <tsw/bson_deserializer.h>
 #include <tsw/bson_serializer.h>
+#include <tsw/bson_stream_deserializer.h>
+#include <tsw/compression.h>
+#include <tsw/latency_histogram.h>
+#include <tsw/message_capture.h>
+#include <tsw/message_lanes.h>
+#include <tsw/message_outbox.h>
+#include <tsw/schema_registry.h>
+#include <tsw/typed_message.h>
 #include <tsw/types.h>
+#include <tsw/uid_generator.h>
+#include <tsw/wire_format.h>
 
+#include "binary_message.h"
+#include "chunked_transfer.h"
+#include "duplicate_filter.h"
 #include "functional_helper.h"
+#include "message_pool.h"
+#include "serializer_pool.h"
 #include "zmq_magistral_impl.h"
 
 
@@ -27,12 +50,81 @@ using namespace std::placeholders;
 using namespace tsw::impl;
 
 
+static UID random_message_id()
+{
+    std::random_device random;
+
+    UID id = (static_cast<UID>(random()) << 32) | random();
+
+    // Zero means the message without identifier.
+    return id ? id : 1;
+}
+
+
+// Activities announcement or denouncement: their schemes are registered or removed.
+static bool is_announcement(MessageType message_type)
+{
+    return message_type == MessageType::AnnounceModuleEvents || message_type == MessageType::AnnounceModuleActions ||
+           message_type == MessageType::DenounceModuleEvents || message_type == MessageType::DenounceModuleActions;
+}
+
+
+// Scheme hashes are sent as signed numbers: formats may narrow the small ones to int32.
+static ValueArray hashes_to_array(const std::vector<uint64_t> &hashes)
+{
+    ValueArray result;
+
+    for (auto hash: hashes) result.push_back(static_cast<int64_t>(hash));
+
+    return result;
+}
+
+
+static std::vector<uint64_t> hashes_from_value(const Value &value)
+{
+    std::vector<uint64_t> result;
+
+    if (!value.is_array()) return result;
+
+    for (const auto &hash: value.as_array())
+    {
+        if (hash.is_int64()) result.push_back(static_cast<uint64_t>(hash.as_int64()));
+        else if (hash.is_int32()) result.push_back(static_cast<uint64_t>(static_cast<int64_t>(hash.as_int32())));
+    }
+
+    return result;
+}
+
+
+// Frames of one send_chunked() call, which are written to the socket. Frames of the lane are written in order.
+struct ChunkProgress
+{
+    std::mutex              mutex;
+    std::condition_variable settled;
+    size_t                  pending = 0;
+    size_t                  written = 0;
+    bool                    failed = false;
+};
+
+
 Magistral::Magistral(const String& magistral_param_string, bool activate_on_creation,
                      std::shared_ptr<Serializer> serializer, std::shared_ptr<Deserializer> deserializer) :
     serializer_(serializer),
     deserializer_(deserializer),
+    send_contexts_(new SerializerPool(serializer_)),
+    compression_threshold_(FrameCompressor::default_threshold),
+    compression_dictionary_(default_compression_dictionary()),
+    decompressor_(new FrameCompressor(Compression::None, compression_threshold_, compression_dictionary_)),
+    message_ids_(random_message_id()),
+    duplicates_(new DuplicateFilter),
+    duplicate_messages_(0),
+    corrupted_frames_(0),
+    received_messages_(std::make_shared<MessagePool>()),
+    chunk_size_(default_chunk_size),
+    transfer_assembler_(new TransferAssembler(std::bind(&Magistral::dispatch_message, this, _1))),
     magistral_(new MagistralImpl(magistral_param_string))
 {
+    for (size_t i = 0; i < message_lanes_.size(); ++i) message_lanes_[i] = default_message_lane(static_cast<MessageType>(i));
     magistral_->set_recv_handler(std::bind(&Magistral::default_recv_handler, this, _1));
     if (activate_on_creation) magistral_->activate();
 }
@@ -41,8 +133,20 @@ Magistral::Magistral(const String& magistral_param_string, bool activate_on_crea
 Magistral::Magistral(const String& magistral_param_string, bool activate_on_creation) :
     serializer_(new BsonSerializer()),
     deserializer_(new BsonDeserializer()),
+    send_contexts_(new SerializerPool(serializer_)),
+    compression_threshold_(FrameCompressor::default_threshold),
+    compression_dictionary_(default_compression_dictionary()),
+    decompressor_(new FrameCompressor(Compression::None, compression_threshold_, compression_dictionary_)),
+    message_ids_(random_message_id()),
+    duplicates_(new DuplicateFilter),
+    duplicate_messages_(0),
+    corrupted_frames_(0),
+    received_messages_(std::make_shared<MessagePool>()),
+    chunk_size_(default_chunk_size),
+    transfer_assembler_(new TransferAssembler(std::bind(&Magistral::dispatch_message, this, _1))),
     magistral_(new MagistralImpl(magistral_param_string))
 {
+    for (size_t i = 0; i < message_lanes_.size(); ++i) message_lanes_[i] = default_message_lane(static_cast<MessageType>(i));
     magistral_->set_recv_handler(std::bind(&Magistral::default_recv_handler, this, _1));
     if (activate_on_creation) magistral_->activate();
 }
@@ -56,6 +160,7 @@ Magistral::~Magistral()
 void Magistral::activate()
 {
     magistral_->activate();
+    if (std::atomic_load(&outbox_)) replay_outbox(outbox_replay_timeout);
 }
 
 
@@ -73,30 +178,549 @@ bool Magistral::active() const
 
 void Magistral::send_message(const Message& msg, int timeout)
 {
-    magistral_->send_data(serializer_->SerializeMessage(msg), timeout);
+    if (drop_expired(msg)) return;
+
+    if (TransferSplitter::need_split(msg, chunk_size_))
+    {
+        ChunkedTransfer transfer;
+
+        send_chunked(msg, transfer, timeout);
+        return;
+    }
+
+    if (std::atomic_load(&outbox_) && !msg.get_id())
+    {
+        send_identified(msg, timeout);
+        return;
+    }
+
+    send_frame(msg, timeout);
+}
+
+
+void Magistral::forward_message(const Message& msg, UID receiver_module_uid, int timeout)
+{
+    if (drop_expired(msg)) return;
+
+    const BinData *received = msg.get_received_frame();
+    auto send_contexts = std::atomic_load(&send_contexts_);
+
+    // Frame is relayed only in the format, which the peer expects from this sender.
+    if (received && detect_wire_format(received->data(), received->size()) == send_contexts->format())
+    {
+        auto context = send_contexts->acquire();
+
+        // Frame is shared with the other handlers: its copy is patched.
+        context->buffer.assign(received->begin(), received->end());
+        if (patch_message_uids(context->buffer.data(), context->buffer.size(), msg.get_sender_module_uid(), receiver_module_uid))
+        {
+            send_buffer(msg.get_type(), msg.get_deadline(), context->buffer, context->frame, timeout);
+            return;
+        }
+    }
+
+    BinaryMessage forwarded(msg.get_type(), msg.get_fields(),
+                            receiver_module_uid, msg.get_receiver_module_name(), msg.get_receiver_module_class(),
+                            msg.get_sender_module_uid(), msg.get_sender_module_name(), msg.get_sender_module_class(),
+                            msg.get_creation_time());
+
+    // Relayed message keeps its deadline and identifier, as the relayed frame does.
+    forwarded.set_deadline(msg.get_deadline());
+    forwarded.set_id(msg.get_id());
+    send_message(forwarded, timeout);
+}
+
+
+void Magistral::send_chunked(const Message& msg, ChunkedTransfer& transfer, int timeout)
+{
+    // Transfer, which was started, is finished: receiver drops the late message.
+    if (!transfer.sent_frames && drop_expired(msg)) return;
+    if (!transfer.transfer_id) transfer.transfer_id = UIDGenerator::generate_uid();
+    if (!transfer.message_id && !msg.get_id() && std::atomic_load(&outbox_)) transfer.message_id = next_message_id();
+
+    TransferSplitter splitter(msg, transfer.transfer_id, chunk_size_, transfer.message_id);
+    auto progress = std::make_shared<ChunkProgress>();
+    const size_t first_frame = transfer.sent_frames;
+
+    // Queued frame may be dropped later: progress stops on the first frame, which wasn't written.
+    auto on_sent = [progress](bool written)
+    {
+        std::lock_guard<std::mutex> lock(progress->mutex);
+
+        if (written && !progress->failed) ++progress->written;
+        else progress->failed = true;
+
+        if (!--progress->pending) progress->settled.notify_all();
+    };
+
+    // Transfer is resumed from the first frame, which isn't confirmed: the repeated chunks are skipped by the receiver.
+    auto confirmed = [&]()
+    {
+        std::lock_guard<std::mutex> lock(progress->mutex);
+
+        transfer.sent_frames = first_frame + progress->written;
+        return !progress->failed && !progress->pending;
+    };
+
+    for (size_t i = first_frame; i < splitter.frames_count(); ++i)
+    {
+        {
+            std::lock_guard<std::mutex> lock(progress->mutex);
+
+            if (progress->failed) break;
+            ++progress->pending;
+        }
+
+        try
+        {
+            send_frame(splitter.frame(i), timeout, on_sent);
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(progress->mutex);
+
+                progress->failed = true;
+                --progress->pending;
+            }
+
+            confirmed();
+            throw;
+        }
+
+        // Let the other senders take the socket between chunks.
+        std::this_thread::yield();
+    }
+
+    {
+        // Call returns, when the queued frames are written or dropped.
+        std::unique_lock<std::mutex> lock(progress->mutex);
+        auto settled = [&progress]() { return !progress->pending; };
+
+        if (timeout < 0) progress->settled.wait(lock, settled);
+        else progress->settled.wait_for(lock, std::chrono::milliseconds(timeout), settled);
+    }
+
+    if (!confirmed())
+    {
+        TSW_THROW(ZMQException, "chunked transfer was interrupted after " + std::to_string(transfer.sent_frames) +
+                  " frames");
+    }
+}
+
+
+void Magistral::send_serialized(MessageType message_type, const BinData& frame, int timeout)
+{
+    auto send_contexts = std::atomic_load(&send_contexts_);
+    auto context = send_contexts->acquire();
+
+    send_buffer(message_type, Time::zero(), frame, context->frame, timeout);
+}
+
+
+void Magistral::set_chunk_size(size_t chunk_size)
+{
+    chunk_size_ = std::max<size_t>(chunk_size, 1);
+}
+
+
+size_t Magistral::get_chunk_size() const
+{
+    return chunk_size_;
+}
+
+
+void Magistral::send_frame(const Message& msg, int timeout, std::function<void(bool written)> sent)
+{
+    // Context is owned by this thread until the data will be sent.
+    auto send_contexts = std::atomic_load(&send_contexts_);
+    auto context = send_contexts->acquire();
+
+    context->serializer->SerializeMessageTo(msg, context->buffer);
+    send_buffer(msg.get_type(), msg.get_deadline(), context->buffer, context->frame, timeout, std::move(sent));
+}
+
+
+void Magistral::send_identified(const Message& msg, int timeout)
+{
+    auto send_contexts = std::atomic_load(&send_contexts_);
+    auto context = send_contexts->acquire();
+
+    // Identifier is written with the envelope: fields of the message aren't copied.
+    BinaryMessage envelope(msg.get_type(), NameValueMap(),
+                           msg.get_receiver_module_uid(), msg.get_receiver_module_name(), msg.get_receiver_module_class(),
+                           msg.get_sender_module_uid(), msg.get_sender_module_name(), msg.get_sender_module_class(),
+                           msg.get_creation_time());
+
+    if (msg.has_deadline()) envelope.set_deadline(msg.get_deadline());
+    envelope.set_id(next_message_id());
+
+    context->serializer->SerializeFieldsTo(envelope, [&msg](FieldWriter& writer)
+    {
+        for (const auto &field: msg.get_fields()) writer.write(field.first.c_str(), field.second);
+    }, context->buffer);
+    send_buffer(msg.get_type(), msg.get_deadline(), context->buffer, context->frame, timeout);
 }
 
 
 void Magistral::send_message(const MessageType message_type, NameValueMap&& fields, int timeout)
 {
-    magistral_->send_data(serializer_->SerializeMessage(Message(message_type, fields, -1)), timeout);
+    Message msg(message_type, std::move(fields), -1);
+
+    identify(msg);
+    send_message(msg, timeout);
 }
 
 void Magistral::send_message(const MessageType message_type, const NameValueMap& fields, int timeout)
 {
-    magistral_->send_data(serializer_->SerializeMessage(Message(message_type, fields, -1)), timeout);
+    Message msg(message_type, fields, -1);
+
+    identify(msg);
+    send_message(msg, timeout);
 }
 
 
 void Magistral::send_message(const MessageType message_type, NameValueMap&& fields, UID receiver_module_uid, int timeout)
 {
-    magistral_->send_data(serializer_->SerializeMessage(Message(message_type, fields, receiver_module_uid)), timeout);
+    Message msg(message_type, std::move(fields), receiver_module_uid);
+
+    identify(msg);
+    send_message(msg, timeout);
 }
 
 
 void Magistral::send_message(const MessageType message_type, const NameValueMap& fields, UID receiver_module_uid, int timeout)
 {
-    magistral_->send_data(serializer_->SerializeMessage(Message(message_type, fields, receiver_module_uid)), timeout);
+    Message msg(message_type, fields, receiver_module_uid);
+
+    identify(msg);
+    send_message(msg, timeout);
+}
+
+
+void Magistral::send_fields(const Message& envelope, const FieldsWriter& fields, int timeout)
+{
+    if (drop_expired(envelope)) return;
+
+    Message identified(envelope);
+
+    identify(identified);
+
+    {
+        auto send_contexts = std::atomic_load(&send_contexts_);
+        auto context = send_contexts->acquire();
+
+        context->serializer->SerializeFieldsTo(identified, fields, context->buffer);
+
+        // Frame, which is less than the chunk, can't have the binary fields to split.
+        if (context->buffer.size() <= chunk_size_)
+        {
+            send_buffer(identified.get_type(), identified.get_deadline(), context->buffer, context->frame, timeout);
+            return;
+        }
+    }
+
+    // Large frame is sent as the message: it's split, if its binary fields are larger than the chunk.
+    NameValueMap collected;
+
+    write_object(fields, collected);
+
+    BinaryMessage message(identified.get_type(), std::move(collected),
+                          identified.get_receiver_module_uid(), String(identified.get_receiver_module_name()),
+                          ModuleClass(identified.get_receiver_module_class()),
+                          identified.get_sender_module_uid(), String(identified.get_sender_module_name()),
+                          ModuleClass(identified.get_sender_module_class()), Time(identified.get_creation_time()));
+
+    message.set_deadline(identified.get_deadline());
+    message.set_id(identified.get_id());
+    send_message(message, timeout);
+}
+
+
+void Magistral::send_fields(const MessageType message_type, UID receiver_module_uid, const FieldsWriter& fields,
+                            int timeout)
+{
+    send_fields(Message(message_type, NameValueMap(), receiver_module_uid), fields, timeout);
+}
+
+
+void Magistral::send_typed(const Message& envelope, const char* message_name, const FieldsWriter& fields, int timeout)
+{
+    send_fields(envelope, [message_name, &fields](FieldWriter& writer)
+    {
+        writer.write(typed_message_name_field, message_name);
+        fields(writer);
+    }, timeout);
+}
+
+
+void Magistral::send_buffer(MessageType message_type, const Time& deadline, const BinData& buffer, BinData& frame,
+                            int timeout, std::function<void(bool written)> sent)
+{
+    auto capture = std::atomic_load(&capture_);
+
+    if (capture) capture->record(CaptureDirection::Sent, message_type, buffer);
+
+    auto outbox = std::atomic_load(&outbox_);
+
+    if (outbox)
+    {
+        // Uncompressed frame is kept: compression may be switched before the replay.
+        send_logged(outbox, message_type, deadline, outbox->append(message_type, deadline, buffer), buffer, frame, timeout,
+                    std::move(sent));
+        return;
+    }
+
+    send_compressed(message_type, deadline, buffer, frame, timeout, std::move(sent));
+}
+
+
+void Magistral::send_compressed(MessageType message_type, const Time& deadline, const BinData& buffer, BinData& frame,
+                                int timeout, std::function<void(bool written)> sent)
+{
+    // Frame is compressed in the sender's thread, before the socket will be locked.
+    auto compressor = std::atomic_load(&compressor_);
+    auto lane = message_lanes_[static_cast<size_t>(message_type)];
+    auto expired = &expired_messages_[static_cast<size_t>(message_type)];
+
+    if (compressor && compressor->compress(buffer, frame))
+    {
+        magistral_->send_data(frame, timeout, lane, deadline, expired, std::move(sent));
+        return;
+    }
+
+    magistral_->send_data(buffer, timeout, lane, deadline, expired, std::move(sent));
+}
+
+
+bool Magistral::send_logged(const std::shared_ptr<MessageOutbox>& outbox, MessageType message_type, const Time& deadline,
+                            uint64_t sequence, const BinData& buffer, BinData& frame, int timeout,
+                            std::function<void(bool written)> sent)
+{
+    try
+    {
+        // Frame, which was queued, but wasn't written, stays in the outbox.
+        send_compressed(message_type, deadline, buffer, frame, timeout, [outbox, sequence, sent](bool written)
+        {
+            if (written) outbox->acknowledge(sequence);
+            if (sent) sent(written);
+        });
+    }
+    catch (const ZMQException& e)
+    {
+        // Frame isn't lost: it will be replayed.
+        LOG_TO("magistral", LogLevel::Warning, "Frame %llu is kept in the outbox: %s",
+               static_cast<unsigned long long>(sequence), e.what());
+        if (sent) sent(false);
+        return false;
+    }
+
+    return true;
+}
+
+
+void Magistral::identify(Message& msg)
+{
+    if (!msg.get_id() && std::atomic_load(&outbox_)) msg.set_id(next_message_id());
+}
+
+
+UID Magistral::next_message_id()
+{
+    return message_ids_.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void Magistral::set_outbox(std::shared_ptr<MessageOutbox> outbox)
+{
+    std::atomic_store(&outbox_, outbox);
+    if (outbox && active()) replay_outbox(outbox_replay_timeout);
+}
+
+
+size_t Magistral::replay_outbox(int timeout)
+{
+    auto outbox = std::atomic_load(&outbox_);
+
+    if (!outbox) return 0;
+
+    auto send_contexts = std::atomic_load(&send_contexts_);
+    auto context = send_contexts->acquire();
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    size_t resent = 0;
+
+    outbox->replay([&](const MessageOutbox::Entry& entry)
+    {
+        if (entry.deadline != Time::zero() && now >= entry.deadline)
+        {
+            expired_messages_[static_cast<size_t>(entry.type)].fetch_add(1, std::memory_order_relaxed);
+            outbox->acknowledge(entry.sequence);
+            return true;
+        }
+
+        if (!send_logged(outbox, entry.type, entry.deadline, entry.sequence, entry.frame, context->frame, timeout)) return false;
+
+        ++resent;
+        return true;
+    });
+
+    return resent;
+}
+
+
+void Magistral::set_capture(std::shared_ptr<MessageCapture> capture)
+{
+    std::atomic_store(&capture_, capture);
+}
+
+
+uint64_t Magistral::get_duplicate_count() const
+{
+    return duplicate_messages_.load(std::memory_order_relaxed);
+}
+
+
+uint64_t Magistral::get_corrupted_count() const
+{
+    return corrupted_frames_.load(std::memory_order_relaxed);
+}
+
+
+bool Magistral::drop_expired(const Message& msg)
+{
+    if (!msg.is_expired()) return false;
+
+    expired_messages_[static_cast<size_t>(msg.get_type())].fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+
+uint64_t Magistral::get_expired_count(MessageType message_type) const
+{
+    TSW_ASSERT(message_type < MessageType::ZLast);
+    return expired_messages_[static_cast<size_t>(message_type)].load(std::memory_order_relaxed);
+}
+
+
+void Magistral::set_message_lane(MessageType message_type, MessageLane lane)
+{
+    TSW_ASSERT(message_type < MessageType::ZLast);
+    message_lanes_[static_cast<size_t>(message_type)] = lane;
+}
+
+
+MessageLane Magistral::get_message_lane(MessageType message_type) const
+{
+    TSW_ASSERT(message_type < MessageType::ZLast);
+    return message_lanes_[static_cast<size_t>(message_type)];
+}
+
+
+LatencyHistogram Magistral::get_lane_latency(MessageLane lane) const
+{
+    return magistral_->get_latency(lane);
+}
+
+
+uint64_t Magistral::get_failed_count() const
+{
+    return magistral_->get_failed_count();
+}
+
+
+void Magistral::set_wire_formats(const WireFormats& formats)
+{
+    wire_formats_ = formats;
+    format_deserializers_.clear();
+
+    for (auto format: wire_formats_) format_deserializers_[format] = make_deserializer(format, schema_registry_);
+}
+
+
+void Magistral::set_schema_registry(std::shared_ptr<SchemaRegistry> registry)
+{
+    schema_registry_ = registry;
+}
+
+
+std::shared_ptr<SchemaRegistry> Magistral::get_schema_registry() const
+{
+    return schema_registry_;
+}
+
+
+void Magistral::negotiate_wire_format(int timeout)
+{
+    ValueArray offered;
+
+    for (auto format: wire_formats_) offered.push_back(wire_format_name(format));
+
+    Object fields{ { "wire_formats", offered } };
+
+    if (!compressions_.empty())
+    {
+        ValueArray offered_compressions;
+
+        for (auto compression: compressions_) offered_compressions.push_back(compression_name(compression));
+        fields["compressions"] = offered_compressions;
+    }
+
+    // Peer confirms the schemes, which it knows: only they are sent compact.
+    if (schema_registry_) fields["schemes"] = hashes_to_array(schema_registry_->get_hashes());
+
+    send_message(MessageType::EchoRequest, fields, timeout);
+}
+
+
+void Magistral::use_wire_format(WireFormat format)
+{
+    // Senders, which hold the old pool, finish with it.
+    std::atomic_store(&send_contexts_, std::make_shared<SerializerPool>(make_serializer(format, schema_registry_)));
+}
+
+
+void Magistral::set_compressions(const Compressions& compressions)
+{
+    set_compressions(compressions, FrameCompressor::default_threshold);
+}
+
+
+void Magistral::set_compressions(const Compressions& compressions, size_t threshold)
+{
+    auto supported = supported_compressions();
+
+    compressions_.clear();
+    compression_threshold_ = threshold;
+
+    for (auto compression: compressions)
+    {
+        if (std::find(supported.begin(), supported.end(), compression) != supported.end())
+        {
+            compressions_.push_back(compression);
+        }
+    }
+}
+
+
+void Magistral::set_compression_dictionary(const BinData& dictionary)
+{
+    compression_dictionary_ = dictionary;
+    std::atomic_store(&decompressor_, std::make_shared<FrameCompressor>(Compression::None, compression_threshold_,
+                                                                        compression_dictionary_));
+}
+
+
+void Magistral::use_compression(Compression compression)
+{
+    std::shared_ptr<FrameCompressor> compressor;
+
+    if (compression != Compression::None)
+    {
+        compressor = std::make_shared<FrameCompressor>(compression, compression_threshold_, compression_dictionary_);
+    }
+
+    std::atomic_store(&compressor_, compressor);
 }
 
 
@@ -135,25 +759,219 @@ void Magistral::remove_message_handler(MessageType message_type, MessageHandler
 }
 
 
-bool Magistral::default_recv_handler(const BinData& data)
+bool Magistral::default_recv_handler(const BinData& received)
 {
-    auto plain_message = deserializer_->DeserializeMessage(data);
+    const BinData *frame = &received;
 
-    for (auto mh: message_handlers_[plain_message.get_type()])
+    // Handler is called outside of the socket lock.
+    if (FrameCompressor::is_compressed(received.data(), received.size()))
+    {
+        try
+        {
+            std::atomic_load(&decompressor_)->decompress(received.data(), received.size(), decompressed_);
+        }
+        catch (const CompressionException& e)
+        {
+            // Broken frame doesn't stop the reader.
+            LOG_TO("magistral", LogLevel::Warning, "Compressed frame is dropped: %s", e.what());
+            corrupted_frames_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        frame = &decompressed_;
+    }
+
+    const auto &data = *frame;
+    auto deserializer = deserializer_.get();
+
+    if (!format_deserializers_.empty())
+    {
+        auto format_deserializer = format_deserializers_.find(detect_wire_format(data.data(), data.size()));
+
+        if (format_deserializer != format_deserializers_.end()) deserializer = format_deserializer->second.get();
+    }
+
+    // Frame, which can't be decoded (corrupted or with an unknown scheme), doesn't stop the reader.
+    auto drop_frame = [this](const Exception& e)
+    {
+        LOG_TO("magistral", LogLevel::Warning, "Frame can't be decoded and is dropped: %s", e.what());
+        corrupted_frames_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    };
+    MessageType message_type;
+
+    try
+    {
+        // Route by the message type only: message will not be created, if nobody needs it.
+        message_type = deserializer->DeserializeMessageType(data.data(), data.size());
+    }
+    catch (const Exception& e)
+    {
+        return drop_frame(e);
+    }
+
+    auto capture = std::atomic_load(&capture_);
+
+    if (capture) capture->record(CaptureDirection::Received, message_type, data);
+    auto handlers = message_handlers_.find(message_type);
+
+    if ((handlers == message_handlers_.end() || handlers->second.empty()) && message_type != MessageType::DataTransfer &&
+        message_type != MessageType::EchoRequest && message_type != MessageType::EchoReply &&
+        !(schema_registry_ && is_announcement(message_type))) return true;
+
+    // Message returns to the pool after the dispatch, unless a handler has retained it.
+    auto message = received_messages_->acquire();
+
+    try
+    {
+        deserializer->DeserializeMessageTo(data.data(), data.size(), *message);
+    }
+    catch (const Exception& e)
     {
-        if (!mh(plain_message)) return false;
+        return drop_frame(e);
     }
 
-    return default_message_handler(deserializer_->DeserializeMessage(data));
+    if (message_type == MessageType::DataTransfer) return transfer_assembler_->add_frame(*message);
+
+    return dispatch_message(*message);
+}
+
+
+bool Magistral::dispatch_message(const Message& message)
+{
+    // Late message isn't handled: handlers get only the messages with the time budget left.
+    if (drop_expired(message)) return true;
+
+    // Replayed message, which was handled before the peer's restart or reconnection.
+    if (message.get_id() && duplicates_->is_duplicate(message.get_sender_module_uid(), message.get_id()))
+    {
+        duplicate_messages_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    auto handlers = message_handlers_.find(message.get_type());
+
+    if (handlers != message_handlers_.end())
+    {
+        for (const auto &mh: handlers->second)
+        {
+            if (!mh(message)) return false;
+        }
+    }
+
+    return default_message_handler(message);
 }
 
 
 bool Magistral::default_message_handler(const Message& message)
 {
-    if (message.get_type() == MessageType::EchoRequest)
+    if (schema_registry_ && is_announcement(message.get_type()))
+    {
+        auto registered = schema_registry_->register_announced(message);
+
+        // Announcer sends the activities compact, after the schemes confirmation.
+        if (!registered.empty())
+        {
+            send_message(MessageType::EchoReply, Object{ { "schemes", hashes_to_array(registered) } });
+        }
+    }
+    else if (message.get_type() == MessageType::EchoRequest)
+    {
+        const auto &fields = message.get_fields();
+        auto offered = fields.find("wire_formats");
+        Object reply;
+
+        if (offered != fields.end() && offered->second.is_array())
+        {
+            auto format = choose_wire_format(offered->second.as_array(), wire_formats_);
+            if (format != WireFormat::Unknown) reply["wire_format"] = wire_format_name(format);
+        }
+
+        auto offered_compressions = fields.find("compressions");
+
+        if (offered_compressions != fields.end() && offered_compressions->second.is_array())
+        {
+            auto compression = choose_compression(offered_compressions->second.as_array(), compressions_);
+            if (compression != Compression::None) reply["compression"] = compression_name(compression);
+        }
+
+        auto offered_schemes = fields.find("schemes");
+
+        if (schema_registry_ && offered_schemes != fields.end())
+        {
+            std::vector<uint64_t> known;
+
+            for (auto hash: hashes_from_value(offered_schemes->second))
+            {
+                if (schema_registry_->has_scheme(hash)) known.push_back(hash);
+            }
+
+            reply["schemes"] = hashes_to_array(known);
+        }
+
+        send_message(MessageType::EchoReply, reply);
+    }
+    else if (message.get_type() == MessageType::EchoReply)
+    {
+        const auto &fields = message.get_fields();
+        auto chosen = fields.find("wire_format");
+
+        if (chosen != fields.end() && chosen->second.is_string())
+        {
+            auto format = wire_format_from_name(chosen->second.as_string());
+
+            // Peer may choose only from the offered formats.
+            if (std::find(wire_formats_.begin(), wire_formats_.end(), format) != wire_formats_.end())
+            {
+                use_wire_format(format);
+            }
+        }
+
+        auto chosen_compression = fields.find("compression");
+
+        if (chosen_compression != fields.end() && chosen_compression->second.is_string())
+        {
+            auto compression = compression_from_name(chosen_compression->second.as_string());
+
+            if (std::find(compressions_.begin(), compressions_.end(), compression) != compressions_.end())
+            {
+                use_compression(compression);
+            }
+        }
+
+        auto confirmed_schemes = fields.find("schemes");
+
+        if (schema_registry_ && confirmed_schemes != fields.end())
+        {
+            for (auto hash: hashes_from_value(confirmed_schemes->second)) schema_registry_->confirm_scheme(hash);
+        }
+    }
+    return true;
+}
+
+
+void Magistral::set_stream_handler(std::shared_ptr<StreamHandler> handler)
+{
+    stream_handler_ = handler;
+    transfer_assembler_->set_stream_handler(stream_handler_.get());
+
+    if (!stream_handler_)
     {
-        send_message(MessageType::EchoReply, Object());
+        stream_deserializer_.reset();
+        magistral_->set_part_handler(nullptr);
+        return;
     }
+
+    stream_deserializer_.reset(new BsonStreamDeserializer(*stream_handler_));
+    magistral_->set_part_handler(std::bind(&Magistral::stream_part_handler, this, _1, _2, _3));
+}
+
+
+bool Magistral::stream_part_handler(const BinData::value_type* data, size_t size, bool last)
+{
+    stream_deserializer_->feed(data, size);
+    if (last) stream_deserializer_->finish();
+
     return true;
 }
 
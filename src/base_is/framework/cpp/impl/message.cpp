@@ -13,6 +13,8 @@
 #include <tsw/module.h>
 #include <tsw/types.h>
 
+#include "message_pool.h"
+
 
 namespace tsw
 {
@@ -21,8 +23,8 @@ Message::Message(const MessageType message_type, NameValueMap&& fields) :
    message_type_(message_type),
    sender_module_uid_(-1), sender_module_name_(), sender_module_class_(),
    receiver_module_uid_(-1), receiver_module_name_(), receiver_module_class_(),
-   creation_time_(std::chrono::system_clock::now().time_since_epoch()),
-   fields_(std::move(fields))
+   creation_time_(std::chrono::system_clock::now().time_since_epoch()), deadline_(0), id_(0),
+   fields_(std::move(fields)), fields_decoded_(true)
 {
 }
 
@@ -31,8 +33,8 @@ Message::Message(const MessageType message_type, const NameValueMap& fields) :
    message_type_(message_type),
    sender_module_uid_(-1), sender_module_name_(), sender_module_class_(),
    receiver_module_uid_(-1), receiver_module_name_(), receiver_module_class_(),
-   creation_time_(std::chrono::system_clock::now().time_since_epoch()),
-   fields_(fields)
+   creation_time_(std::chrono::system_clock::now().time_since_epoch()), deadline_(0), id_(0),
+   fields_(fields), fields_decoded_(true)
 {
 }
 
@@ -42,8 +44,8 @@ Message::Message(const MessageType message_type, NameValueMap&& fields,
     message_type_(message_type),
     sender_module_uid_(-1), sender_module_name_(), sender_module_class_(),
     receiver_module_uid_(receiver_module_uid), receiver_module_name_(), receiver_module_class_(),
-    creation_time_(std::chrono::system_clock::now().time_since_epoch()),
-    fields_(std::move(fields))
+    creation_time_(std::chrono::system_clock::now().time_since_epoch()), deadline_(0), id_(0),
+    fields_(std::move(fields)), fields_decoded_(true)
 {
 }
 
@@ -53,8 +55,8 @@ Message::Message(const MessageType message_type, const NameValueMap& fields,
     message_type_(message_type),
     sender_module_uid_(-1), sender_module_name_(), sender_module_class_(),
     receiver_module_uid_(receiver_module_uid), receiver_module_name_(), receiver_module_class_(),
-    creation_time_(std::chrono::system_clock::now().time_since_epoch()),
-    fields_(fields)
+    creation_time_(std::chrono::system_clock::now().time_since_epoch()), deadline_(0), id_(0),
+    fields_(fields), fields_decoded_(true)
 {
 }
 
@@ -64,8 +66,8 @@ Message::Message(const MessageType message_type, NameValueMap&& fields,
     message_type_(message_type),
     sender_module_uid_(-1), sender_module_name_(), sender_module_class_(),
     receiver_module_uid_(-1), receiver_module_name_(receiver_module_name), receiver_module_class_(),
-    creation_time_(std::chrono::system_clock::now().time_since_epoch()),
-    fields_(std::move(fields))
+    creation_time_(std::chrono::system_clock::now().time_since_epoch()), deadline_(0), id_(0),
+    fields_(std::move(fields)), fields_decoded_(true)
 {
 }
 
@@ -75,8 +77,8 @@ Message::Message(const MessageType message_type, const NameValueMap& fields,
     message_type_(message_type),
     sender_module_uid_(-1), sender_module_name_(), sender_module_class_(),
     receiver_module_uid_(-1), receiver_module_name_(receiver_module_name), receiver_module_class_(),
-    creation_time_(std::chrono::system_clock::now().time_since_epoch()),
-    fields_(fields)
+    creation_time_(std::chrono::system_clock::now().time_since_epoch()), deadline_(0), id_(0),
+    fields_(fields), fields_decoded_(true)
 {
 }
 
@@ -93,8 +95,8 @@ Message::Message(const MessageType message_type, NameValueMap&& fields,
     sender_module_class_(std::move(sender_module_class)),
     receiver_module_uid_(receiver_module_uid), receiver_module_name_(std::move(receiver_module_name)),
     receiver_module_class_(std::move(receiver_module_class)),
-    creation_time_(std::move(creation_time)),
-    fields_(std::move(fields))
+    creation_time_(std::move(creation_time)), deadline_(0), id_(0),
+    fields_(std::move(fields)), fields_decoded_(true)
 {
 }
 
@@ -111,8 +113,28 @@ Message::Message(const MessageType message_type, const NameValueMap& fields,
     sender_module_class_(sender_module_class),
     receiver_module_uid_(receiver_module_uid), receiver_module_name_(receiver_module_name),
     receiver_module_class_(receiver_module_class),
-    creation_time_(creation_time),
-    fields_(fields)
+    creation_time_(creation_time), deadline_(0), id_(0),
+    fields_(fields), fields_decoded_(true)
+{
+}
+
+
+// protected constructor.
+Message::Message(const MessageType message_type, const BsonView& fields_view,
+                 std::shared_ptr<BinData> fields_buffer,
+                 const UID receiver_module_uid, String&& receiver_module_name,
+                 ModuleClass&& receiver_module_class,
+                 const UID sender_module_uid, String&& sender_module_name,
+                 ModuleClass&& sender_module_class,
+                 Time&& creation_time) :
+    message_type_(message_type),
+    sender_module_uid_(sender_module_uid), sender_module_name_(std::move(sender_module_name)),
+    sender_module_class_(std::move(sender_module_class)),
+    receiver_module_uid_(receiver_module_uid), receiver_module_name_(std::move(receiver_module_name)),
+    receiver_module_class_(std::move(receiver_module_class)),
+    creation_time_(std::move(creation_time)), deadline_(0), id_(0),
+    fields_(), fields_decoded_(false),
+    fields_view_(fields_view), fields_buffer_(std::move(fields_buffer))
 {
 }
 
@@ -128,6 +150,58 @@ const Time& Message::get_creation_time() const
 }
 
 
+void Message::set_id(const UID& id)
+{
+    id_ = id;
+}
+
+
+const UID& Message::get_id() const
+{
+    return id_;
+}
+
+
+void Message::set_ttl(const Time& ttl)
+{
+    deadline_ = creation_time_ + ttl;
+}
+
+
+void Message::set_deadline(const Time& deadline)
+{
+    deadline_ = deadline;
+}
+
+
+const Time& Message::get_deadline() const
+{
+    return deadline_;
+}
+
+
+bool Message::has_deadline() const
+{
+    return deadline_ != Time::zero();
+}
+
+
+bool Message::is_expired() const
+{
+    return has_deadline() && std::chrono::system_clock::now().time_since_epoch() >= deadline_;
+}
+
+
+Time Message::get_remaining_time() const
+{
+    if (!has_deadline()) return Time::max();
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+
+    return now < deadline_ ? deadline_ - now : Time::zero();
+}
+
+
 const MessageType& Message::get_type() const
 {
     return message_type_;
@@ -172,10 +246,42 @@ const ModuleClass& Message::get_receiver_module_class() const
 
 const NameValueMap& Message::get_fields() const
 {
+    if (!fields_decoded_.decoded.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(fields_decoded_.mutex);
+
+        if (!fields_decoded_.decoded.load(std::memory_order_relaxed))
+        {
+            fields_ = fields_view_.to_object();
+            fields_decoded_.decoded.store(true, std::memory_order_release);
+        }
+    }
+
     return fields_;
 }
 
 
+const BsonView& Message::get_fields_view() const
+{
+    return fields_view_;
+}
+
+
+const BinData* Message::get_received_frame() const
+{
+    return fields_buffer_.get();
+}
+
+
+MessagePtr Message::retain() const
+{
+    // Pooled or heap message is kept by the reference, other ones live in the caller's frame.
+    if (references_.count) return MessagePtr(this);
+
+    return MessagePtr(new Message(*this));
+}
+
+
 void Message::set_sender_module_uid(const UID& uid)
 {
     sender_module_uid_ = uid;
@@ -193,4 +299,23 @@ void Message::set_sender_module_class(const ModuleClass& module_class)
     sender_module_class_ = module_class;
 }
 
+
+void intrusive_ptr_add_ref(const Message *message)
+{
+    message->references_.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void intrusive_ptr_release(const Message *message)
+{
+    if (message->references_.count.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    auto recycled = const_cast<Message*>(message);
+    // Free message doesn't keep the pool: pool is destroyed, when its messages are.
+    auto pool = std::move(recycled->references_.pool);
+
+    if (pool) pool->release(recycled);
+    else delete recycled;
+}
+
 } // namespace tsw
@@ -0,0 +1,318 @@
+/**
+  * @file message_capture.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Capture of the Magistral frames and its replay implementation.
+  *
+  */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tsw/error.h>
+#include <tsw/message_capture.h>
+
+
+namespace tsw
+{
+
+class CaptureException : public Exception
+{
+    using Exception::Exception;
+};
+
+
+static const char capture_magic[] = "TSWCAP01";
+static constexpr size_t capture_magic_size = sizeof(capture_magic) - 1;
+// magic start_time:i64
+static constexpr size_t capture_header_size = capture_magic_size + 8;
+// time:u64 size:u32 type:u16 direction:u8
+static constexpr size_t capture_record_header_size = 15;
+
+
+template<typename T>
+static inline void write_le(BinData::value_type *data, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i) data[i] = static_cast<BinData::value_type>(value >> (8 * i));
+}
+
+
+template<typename T>
+static inline T get_le(const BinData::value_type *data)
+{
+    T result = 0;
+
+    for (size_t i = 0; i < sizeof(T); ++i) result |= static_cast<T>(data[i]) << (8 * i);
+
+    return result;
+}
+
+
+//----------------------------------------------------------------------------
+// MessageCapture
+//----------------------------------------------------------------------------
+
+MessageCapture::MessageCapture(const Path &path, size_t segment_size) :
+    segment_size_(std::max(segment_size, capture_header_size)), start_(Clock::now()),
+    fd_(-1), map_(nullptr), capacity_(0), size_(0), frames_(0)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd_ < 0) TSW_THROW(CaptureException, "can't create capture \"" + path.string() + "\": " + std::strerror(errno));
+
+    try
+    {
+        reserve(capture_header_size);
+    }
+    catch (...)
+    {
+        ::close(fd_);
+        throw;
+    }
+
+    const auto start_time = std::chrono::duration_cast<Time>(std::chrono::system_clock::now().time_since_epoch());
+
+    std::memcpy(map_, capture_magic, capture_magic_size);
+    write_le<int64_t>(map_ + capture_magic_size, start_time.count());
+    size_ = capture_header_size;
+}
+
+
+MessageCapture::~MessageCapture()
+{
+    close();
+}
+
+
+void MessageCapture::record(CaptureDirection direction, MessageType type, const BinData::value_type *data, size_t size)
+{
+    const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (fd_ < 0) return;
+
+    reserve(size_ + capture_record_header_size + size);
+
+    auto record = map_ + size_;
+
+    write_le<uint64_t>(record, static_cast<uint64_t>(time.count()));
+    write_le<uint32_t>(record + 8, static_cast<uint32_t>(size));
+    write_le<uint16_t>(record + 12, static_cast<uint16_t>(type));
+    record[14] = static_cast<BinData::value_type>(direction);
+    std::memcpy(record + capture_record_header_size, data, size);
+
+    size_ += capture_record_header_size + size;
+    ++frames_;
+}
+
+
+void MessageCapture::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (fd_ < 0) return;
+
+    ::munmap(map_, capacity_);
+    map_ = nullptr;
+    // Zero tail of the last segment is cut.
+    if (::ftruncate(fd_, static_cast<off_t>(size_)) < 0)
+    {
+        // Reader stops on the zero tail.
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+
+uint64_t MessageCapture::frames_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return frames_;
+}
+
+
+size_t MessageCapture::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return size_;
+}
+
+
+void MessageCapture::reserve(size_t required)
+{
+    if (required <= capacity_) return;
+
+    const size_t capacity = (required + segment_size_ - 1) / segment_size_ * segment_size_;
+
+    if (::ftruncate(fd_, static_cast<off_t>(capacity)) < 0)
+    {
+        TSW_THROW(CaptureException, String("capture extension failed: ") + std::strerror(errno));
+    }
+
+    void *map = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+
+    if (map == MAP_FAILED) TSW_THROW(CaptureException, String("capture mapping failed: ") + std::strerror(errno));
+
+    if (map_) ::munmap(map_, capacity_);
+    map_ = static_cast<BinData::value_type*>(map);
+    capacity_ = capacity;
+}
+
+
+//----------------------------------------------------------------------------
+// CaptureReader
+//----------------------------------------------------------------------------
+
+CaptureReader::CaptureReader(const Path &path) : fd_(-1), map_(nullptr), size_(0), offset_(capture_header_size)
+{
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd_ < 0) TSW_THROW(CaptureException, "can't open capture \"" + path.string() + "\": " + std::strerror(errno));
+
+    struct stat st;
+
+    if (::fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < capture_header_size)
+    {
+        ::close(fd_);
+        TSW_THROW(CaptureException, "\"" + path.string() + "\" is not a capture");
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+
+    void *map = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+
+    if (map == MAP_FAILED)
+    {
+        ::close(fd_);
+        TSW_THROW(CaptureException, String("capture mapping failed: ") + std::strerror(errno));
+    }
+
+    map_ = static_cast<const BinData::value_type*>(map);
+    // Frames are read sequentially.
+    ::madvise(map, size_, MADV_SEQUENTIAL);
+
+    if (std::memcmp(map_, capture_magic, capture_magic_size))
+    {
+        ::munmap(map, size_);
+        ::close(fd_);
+        TSW_THROW(CaptureException, "\"" + path.string() + "\" is not a capture");
+    }
+
+    start_time_ = Time(get_le<int64_t>(map_ + capture_magic_size));
+}
+
+
+CaptureReader::~CaptureReader()
+{
+    ::munmap(const_cast<BinData::value_type*>(map_), size_);
+    ::close(fd_);
+}
+
+
+bool CaptureReader::next(CapturedFrame &frame)
+{
+    if (offset_ + capture_record_header_size > size_) return false;
+
+    const auto record = map_ + offset_;
+    const size_t size = get_le<uint32_t>(record + 8);
+
+    // Zero tail of the capture, which wasn't closed.
+    if (!size || offset_ + capture_record_header_size + size > size_) return false;
+
+    frame.time = std::chrono::nanoseconds(get_le<uint64_t>(record));
+    frame.size = size;
+    frame.type = static_cast<MessageType>(get_le<uint16_t>(record + 12));
+    frame.direction = static_cast<CaptureDirection>(record[14]);
+    frame.data = record + capture_record_header_size;
+
+    offset_ += capture_record_header_size + size;
+
+    return true;
+}
+
+
+void CaptureReader::rewind()
+{
+    offset_ = capture_header_size;
+}
+
+
+Time CaptureReader::get_start_time() const
+{
+    return start_time_;
+}
+
+
+//----------------------------------------------------------------------------
+// CaptureReplayer
+//----------------------------------------------------------------------------
+
+CaptureReplayer::CaptureReplayer(CaptureReader &reader) : CaptureReplayer(reader, Options())
+{}
+
+
+CaptureReplayer::CaptureReplayer(CaptureReader &reader, const Options &options) :
+    reader_(reader), options_(options), stopped_(false)
+{}
+
+
+CaptureReplayer::Statistics CaptureReplayer::run(const FrameSink &sink)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Statistics statistics;
+    CapturedFrame frame;
+    const auto start = Clock::now();
+    bool first = true;
+    std::chrono::nanoseconds first_time(0);
+
+    stopped_ = false;
+    reader_.rewind();
+
+    while (!stopped_ && reader_.next(frame))
+    {
+        if (frame.direction != options_.direction) continue;
+
+        // Pace is counted from the first replayed frame: capture may start with a pause.
+        if (first)
+        {
+            first_time = frame.time;
+            first = false;
+        }
+
+        if (options_.speed > 0)
+        {
+            const auto scheduled = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::nano>((frame.time - first_time).count() / options_.speed));
+
+            std::this_thread::sleep_until(scheduled);
+            statistics.max_lag = std::max(statistics.max_lag,
+                                          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled));
+        }
+
+        sink(frame);
+
+        ++statistics.frames;
+        statistics.bytes += frame.size;
+    }
+
+    statistics.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+
+    return statistics;
+}
+
+
+void CaptureReplayer::stop()
+{
+    stopped_ = true;
+}
+
+} // namespace tsw
@@ -0,0 +1,49 @@
+/**
+  * @file message_lanes.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Priority lanes helpers implementation.
+  *
+  */
+
+#include <tsw/message_lanes.h>
+
+
+namespace tsw
+{
+
+const char *message_lane_name(MessageLane lane)
+{
+    switch (lane)
+    {
+        case MessageLane::Control: return "control";
+        case MessageLane::Data: return "data";
+        case MessageLane::Bulk: return "bulk";
+        default: return "unknown";
+    }
+}
+
+
+MessageLane default_message_lane(MessageType message_type)
+{
+    switch (message_type)
+    {
+        case MessageType::Action:
+        case MessageType::Event:
+        case MessageType::Reply:
+            return MessageLane::Data;
+        case MessageType::DataTransfer:
+            return MessageLane::Bulk;
+        default:
+            return MessageLane::Control;
+    }
+}
+
+
+const LaneWeights &default_lane_weights()
+{
+    static const LaneWeights weights{ 16, 4, 1 };
+
+    return weights;
+}
+
+} // namespace tsw
@@ -0,0 +1,450 @@
+/**
+  * @file message_outbox.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MessageOutbox class implementation.
+  *
+  */
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tsw/error.h>
+#include <tsw/message_outbox.h>
+
+
+namespace tsw
+{
+
+class OutboxException : public Exception
+{
+    using Exception::Exception;
+};
+
+
+enum class RecordKind : uint8_t
+{
+    Frame = 1,
+    Acknowledgement = 2
+};
+
+
+// size:u32 crc32:u32
+static constexpr size_t record_prefix_size = 8;
+// kind:u8 sequence:u64
+static constexpr size_t record_header_size = 9;
+// type:u16 deadline:i64
+static constexpr size_t frame_header_size = 10;
+
+
+template<typename T>
+static inline void put_le(BinData &buffer, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i) buffer.push_back(static_cast<BinData::value_type>(value >> (8 * i)));
+}
+
+
+template<typename T>
+static inline void write_le(BinData::value_type *data, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i) data[i] = static_cast<BinData::value_type>(value >> (8 * i));
+}
+
+
+template<typename T>
+static inline T get_le(const BinData::value_type *data)
+{
+    T result = 0;
+
+    for (size_t i = 0; i < sizeof(T); ++i) result |= static_cast<T>(data[i]) << (8 * i);
+
+    return result;
+}
+
+
+static uint32_t crc32(const BinData::value_type *data, size_t size)
+{
+    static const auto table = []()
+    {
+        std::array<uint32_t, 256> result;
+
+        for (uint32_t i = 0; i < result.size(); ++i)
+        {
+            uint32_t c = i;
+
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            result[i] = c;
+        }
+
+        return result;
+    }();
+
+    uint32_t crc = 0xffffffffu;
+
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+    return crc ^ 0xffffffffu;
+}
+
+
+// Append the record: body is the frame header and the frame itself.
+static void put_record(BinData &buffer, RecordKind kind, uint64_t sequence, const BinData::value_type *frame_header = nullptr,
+                       const BinData *frame = nullptr)
+{
+    const size_t start = buffer.size();
+    const size_t size = frame_header ? frame_header_size + frame->size() : 0;
+
+    put_le<uint32_t>(buffer, static_cast<uint32_t>(record_header_size + size));
+    put_le<uint32_t>(buffer, 0);
+    buffer.push_back(static_cast<BinData::value_type>(kind));
+    put_le<uint64_t>(buffer, sequence);
+    if (frame_header)
+    {
+        buffer.insert(buffer.end(), frame_header, frame_header + frame_header_size);
+        buffer.insert(buffer.end(), frame->begin(), frame->end());
+    }
+
+    const uint32_t crc = crc32(buffer.data() + start + record_prefix_size, buffer.size() - start - record_prefix_size);
+
+    write_le(buffer.data() + start + sizeof(uint32_t), crc);
+}
+
+
+static void write_all(int fd, const BinData &data)
+{
+    size_t written = 0;
+
+    while (written < data.size())
+    {
+        auto result = ::write(fd, data.data() + written, data.size() - written);
+
+        if (result < 0)
+        {
+            if (errno == EINTR) continue;
+            TSW_THROW(OutboxException, String("outbox write failed: ") + std::strerror(errno));
+        }
+
+        written += static_cast<size_t>(result);
+    }
+}
+
+
+MessageOutbox::MessageOutbox(const Path &path) : MessageOutbox(path, Options())
+{}
+
+
+MessageOutbox::MessageOutbox(const Path &path, const Options &options) :
+    path_(path), options_(options), fd_(-1), committing_(false),
+    last_sequence_(0), committed_sequence_(0),
+    log_size_(0), end_offset_(0), commits_(0)
+{
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    if (fd_ < 0) TSW_THROW(OutboxException, "can't open outbox \"" + path_.string() + "\": " + std::strerror(errno));
+
+    try
+    {
+        recover();
+    }
+    catch (...)
+    {
+        ::close(fd_);
+        throw;
+    }
+}
+
+
+MessageOutbox::~MessageOutbox()
+{
+    try
+    {
+        flush();
+    }
+    catch (const std::exception&)
+    {
+        // Lost acknowledgements cause the duplicates only.
+    }
+
+    ::close(fd_);
+}
+
+
+void MessageOutbox::recover()
+{
+    struct stat st;
+
+    if (::fstat(fd_, &st) < 0) TSW_THROW(OutboxException, String("outbox stat failed: ") + std::strerror(errno));
+
+    BinData log(static_cast<size_t>(st.st_size));
+    size_t read_size = 0;
+
+    while (read_size < log.size())
+    {
+        auto result = ::pread(fd_, log.data() + read_size, log.size() - read_size, static_cast<off_t>(read_size));
+
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) TSW_THROW(OutboxException, String("outbox read failed: ") + std::strerror(errno));
+        read_size += static_cast<size_t>(result);
+    }
+
+    size_t offset = 0;
+
+    while (offset + record_prefix_size + record_header_size <= log.size())
+    {
+        const auto data = log.data() + offset;
+        const size_t size = get_le<uint32_t>(data);
+
+        if (size < record_header_size || offset + record_prefix_size + size > log.size() ||
+            crc32(data + record_prefix_size, size) != get_le<uint32_t>(data + 4)) break;
+
+        const auto kind = static_cast<RecordKind>(data[record_prefix_size]);
+        const auto sequence = get_le<uint64_t>(data + record_prefix_size + 1);
+        const auto body = data + record_prefix_size + record_header_size;
+        const size_t body_size = size - record_header_size;
+
+        if (kind == RecordKind::Frame && body_size >= frame_header_size)
+        {
+            unacknowledged_[sequence] = Location
+            {
+                offset + record_prefix_size + record_header_size + frame_header_size,
+                static_cast<uint32_t>(body_size - frame_header_size),
+                static_cast<MessageType>(get_le<uint16_t>(body)),
+                Time(static_cast<int64_t>(get_le<uint64_t>(body + 2)))
+            };
+        }
+        else if (kind == RecordKind::Acknowledgement)
+        {
+            unacknowledged_.erase(sequence);
+        }
+
+        last_sequence_ = std::max(last_sequence_, sequence);
+        offset += record_prefix_size + size;
+    }
+
+    // Record, which was torn by the crash, is dropped: its sender didn't get the confirmation.
+    if (offset < log.size() && ::ftruncate(fd_, static_cast<off_t>(offset)) < 0)
+    {
+        TSW_THROW(OutboxException, String("outbox truncation failed: ") + std::strerror(errno));
+    }
+
+    committed_sequence_ = last_sequence_;
+    log_size_ = end_offset_ = offset;
+
+    if (unacknowledged_.empty() && log_size_) compact();
+}
+
+
+uint64_t MessageOutbox::append(MessageType type, const Time &deadline, const BinData &frame)
+{
+    if (frame.size() > std::numeric_limits<uint32_t>::max() - record_header_size - frame_header_size)
+    {
+        TSW_THROW(OutboxException, "frame is too large for the outbox: " + std::to_string(frame.size()));
+    }
+
+    BinData::value_type frame_header[frame_header_size];
+
+    write_le(frame_header, static_cast<uint16_t>(type));
+    write_le(frame_header + sizeof(uint16_t), static_cast<uint64_t>(deadline.count()));
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto sequence = ++last_sequence_;
+    const size_t start = pending_.size();
+
+    put_record(pending_, RecordKind::Frame, sequence, frame_header, &frame);
+
+    unacknowledged_[sequence] = Location{ end_offset_ + record_prefix_size + record_header_size + frame_header_size,
+                                          static_cast<uint32_t>(frame.size()), type, deadline };
+    end_offset_ += pending_.size() - start;
+
+    commit(lock, sequence);
+
+    return sequence;
+}
+
+
+void MessageOutbox::commit(std::unique_lock<std::mutex> &lock, uint64_t sequence)
+{
+    while (committed_sequence_ < sequence)
+    {
+        if (committing_)
+        {
+            // Other sender writes the group: this frame is in it or in the next one.
+            committed_.wait(lock);
+            continue;
+        }
+
+        BinData group;
+        const auto group_start = committed_sequence_ + 1;
+        const auto group_sequence = last_sequence_;
+        const auto group_offset = log_size_;
+
+        group.swap(pending_);
+        committing_ = true;
+        lock.unlock();
+
+        bool written = true;
+
+        try
+        {
+            write_all(fd_, group);
+            if (options_.sync && ::fdatasync(fd_) < 0)
+            {
+                TSW_THROW(OutboxException, String("outbox sync failed: ") + std::strerror(errno));
+            }
+        }
+        catch (const OutboxException&)
+        {
+            written = false;
+            // Partially written group isn't recovered.
+            if (::ftruncate(fd_, static_cast<off_t>(group_offset)) < 0) {}
+        }
+
+        lock.lock();
+        committing_ = false;
+        ++commits_;
+
+        if (written)
+        {
+            log_size_ = group_offset + group.size();
+            committed_sequence_ = group_sequence;
+        }
+        else
+        {
+            // Frames of the group are lost: offsets after them are shifted back.
+            for (auto i = unacknowledged_.upper_bound(committed_sequence_);
+                 i != unacknowledged_.end() && i->first <= group_sequence;) i = unacknowledged_.erase(i);
+            for (auto i = unacknowledged_.upper_bound(group_sequence); i != unacknowledged_.end(); ++i)
+            {
+                i->second.offset -= group.size();
+            }
+
+            end_offset_ -= group.size();
+            failed_groups_.emplace_back(group_start, group_sequence);
+            committed_sequence_ = group_sequence;
+        }
+
+        committed_.notify_all();
+    }
+
+    for (const auto &group: failed_groups_)
+    {
+        if (group.first <= sequence && sequence <= group.second) TSW_THROW(OutboxException, "outbox write failed");
+    }
+}
+
+
+void MessageOutbox::acknowledge(uint64_t sequence)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!unacknowledged_.erase(sequence)) return;
+
+    if (unacknowledged_.empty() && !committing_ && end_offset_ > options_.compaction_threshold)
+    {
+        compact();
+        return;
+    }
+
+    const size_t start = pending_.size();
+
+    put_record(pending_, RecordKind::Acknowledgement, sequence);
+    end_offset_ += pending_.size() - start;
+}
+
+
+void MessageOutbox::compact()
+{
+    // All frames are delivered: pending records are acknowledgements only.
+    if (::ftruncate(fd_, 0) < 0) TSW_THROW(OutboxException, String("outbox truncation failed: ") + std::strerror(errno));
+
+    pending_.clear();
+    log_size_ = end_offset_ = 0;
+}
+
+
+void MessageOutbox::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (pending_.empty()) return;
+
+    // Acknowledgements get the sequence of the last frame: they are written with it or after it.
+    commit(lock, ++last_sequence_);
+}
+
+
+size_t MessageOutbox::replay(const ReplayHandler &handler)
+{
+    std::vector<uint64_t> sequences;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (const auto &location: unacknowledged_)
+        {
+            if (location.first > committed_sequence_) break;
+            sequences.push_back(location.first);
+        }
+    }
+
+    size_t replayed = 0;
+    Entry entry;
+
+    for (auto sequence: sequences)
+    {
+        {
+            // Frame is read under the lock: log can't be compacted meanwhile.
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto location = unacknowledged_.find(sequence);
+
+            if (location == unacknowledged_.end()) continue;
+
+            entry.sequence = sequence;
+            entry.type = location->second.type;
+            entry.deadline = location->second.deadline;
+            entry.frame.resize(location->second.size);
+
+            size_t read_size = 0;
+
+            while (read_size < entry.frame.size())
+            {
+                auto result = ::pread(fd_, entry.frame.data() + read_size, entry.frame.size() - read_size,
+                                      static_cast<off_t>(location->second.offset + read_size));
+
+                if (result < 0 && errno == EINTR) continue;
+                if (result <= 0) TSW_THROW(OutboxException, String("outbox read failed: ") + std::strerror(errno));
+                read_size += static_cast<size_t>(result);
+            }
+        }
+
+        if (!handler(entry)) break;
+        ++replayed;
+    }
+
+    return replayed;
+}
+
+
+size_t MessageOutbox::pending_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return unacknowledged_.size();
+}
+
+
+uint64_t MessageOutbox::commits_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return commits_;
+}
+
+} // namespace tsw
@@ -0,0 +1,93 @@
+/**
+  * @file message_pool.h
+  * @author Artiom N.(cl)2017
+  * @brief MessagePool class: recyclable messages of the receive path.
+  *
+  */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tsw/message.h"
+#include "tsw/types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Pool of the received messages.
+ *
+ * Message is returned to the pool, when its last reference is released, with the memory of
+ * its strings and buffer: steady-state receive loop refills the same messages and doesn't allocate.
+ * Messages in use keep the pool alive, so references may outlive the Magistral.
+ */
+class MessagePool : public std::enable_shared_from_this<MessagePool>
+{
+public:
+    // Free messages, which are kept. Others are destroyed on return.
+    static constexpr size_t default_max_free = 64;
+
+public:
+    explicit MessagePool(size_t max_free = default_max_free) : max_free_(max_free)
+    {
+        free_.reserve(max_free_);
+    }
+
+public:
+    /**
+     * @brief Take free message or create new one.
+     * @return message with the single reference.
+     */
+    boost::intrusive_ptr<Message> acquire()
+    {
+        std::unique_ptr<Message> message;
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!free_.empty())
+            {
+                message = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+
+        if (!message) message.reset(new Message(MessageType::ZLast, NameValueMap()));
+
+        message->references_.pool = shared_from_this();
+
+        return boost::intrusive_ptr<Message>(message.release());
+    }
+
+    size_t free_count() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return free_.size();
+    }
+
+private:
+    friend void tsw::intrusive_ptr_release(const Message *message);
+
+    void release(Message *message)
+    {
+        std::unique_ptr<Message> owned(message);
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        if (free_.size() < max_free_) free_.push_back(std::move(owned));
+    }
+
+private:
+    const size_t                            max_free_;
+    mutable std::mutex                      mutex_;
+    std::vector<std::unique_ptr<Message>>   free_;
+};
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,56 @@
+/**
+  * @file msgpack_deserializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MsgPackDeserializer class implementation.
+  *
+  */
+
+#include <memory>
+
+#include <tsw/msgpack_deserializer.h>
+#include <tsw/types.h>
+
+#include "msgpack_impl.h"
+
+
+namespace tsw
+{
+
+MsgPackDeserializer::MsgPackDeserializer() : impl_(new impl::MsgPackDeserializerImpl)
+{}
+
+
+MsgPackDeserializer::~MsgPackDeserializer()
+{}
+
+
+Message MsgPackDeserializer::DeserializeMessage(const BinData &data)
+{
+    return DeserializeMessage(data.data(), data.size());
+}
+
+
+Object MsgPackDeserializer::DeserializeObject(const BinData &data)
+{
+    return impl_->Deserialize(data.data(), data.size());
+}
+
+
+Message MsgPackDeserializer::DeserializeMessage(const BinData::value_type *data, size_t size)
+{
+    return MessageFromObject(impl_->Deserialize(data, size));
+}
+
+
+Object MsgPackDeserializer::DeserializeObject(const BinData::value_type *data, size_t size)
+{
+    return impl_->Deserialize(data, size);
+}
+
+
+MessageType MsgPackDeserializer::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    return impl_->DeserializeMessageType(data, size);
+}
+
+} // namespace tsw
@@ -0,0 +1,487 @@
+/**
+  * @file msgpack_impl.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MessagePack serializer/deserializer implementation.
+  *
+  */
+
+#include <limits>
+
+#include "msgpack_impl.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+//----------------------------------------------------------------------------
+// MsgPackEncoder
+//----------------------------------------------------------------------------
+
+void MsgPackEncoder::start_document(BinData &buffer)
+{
+    buffer.push_back(0xde);
+    write_be<uint16_t>(buffer, 0);
+}
+
+
+void MsgPackEncoder::finish_document(BinData &buffer, size_t fields_count)
+{
+    if (fields_count > std::numeric_limits<uint16_t>::max())
+    {
+        TSW_THROW(CompactCodecException, "too many document fields");
+    }
+
+    buffer[1] = static_cast<uint8_t>(fields_count >> 8);
+    buffer[2] = static_cast<uint8_t>(fields_count);
+}
+
+
+void MsgPackEncoder::write_undefined(BinData &buffer)
+{
+    // fixext 1.
+    buffer.push_back(0xd4);
+    buffer.push_back(static_cast<uint8_t>(ExtType::Undefined));
+    buffer.push_back(0);
+}
+
+
+void MsgPackEncoder::write_null(BinData &buffer)
+{
+    buffer.push_back(0xc0);
+}
+
+
+void MsgPackEncoder::write_bool(BinData &buffer, bool data)
+{
+    buffer.push_back(data ? 0xc3 : 0xc2);
+}
+
+
+void MsgPackEncoder::write_int32(BinData &buffer, int32_t data)
+{
+    if (data >= -32 && data <= 127)
+    {
+        // Positive and negative fixint.
+        buffer.push_back(static_cast<uint8_t>(data));
+    }
+    else if (data >= std::numeric_limits<int8_t>::min() && data <= std::numeric_limits<int8_t>::max())
+    {
+        buffer.push_back(0xd0);
+        buffer.push_back(static_cast<uint8_t>(data));
+    }
+    else if (data >= std::numeric_limits<int16_t>::min() && data <= std::numeric_limits<int16_t>::max())
+    {
+        buffer.push_back(0xd1);
+        write_be(buffer, static_cast<uint16_t>(data));
+    }
+    else
+    {
+        buffer.push_back(0xd2);
+        write_be(buffer, static_cast<uint32_t>(data));
+    }
+}
+
+
+void MsgPackEncoder::write_int64(BinData &buffer, int64_t data)
+{
+    buffer.push_back(0xd3);
+    write_be(buffer, static_cast<uint64_t>(data));
+}
+
+
+void MsgPackEncoder::write_double(BinData &buffer, double data)
+{
+    buffer.push_back(0xcb);
+    write_be(buffer, double_bits(data));
+}
+
+
+void MsgPackEncoder::write_string(BinData &buffer, const char *data, size_t size)
+{
+    if (size < 32)
+    {
+        buffer.push_back(static_cast<uint8_t>(0xa0 | size));
+    }
+    else if (size <= std::numeric_limits<uint8_t>::max())
+    {
+        buffer.push_back(0xd9);
+        buffer.push_back(static_cast<uint8_t>(size));
+    }
+    else if (size <= std::numeric_limits<uint16_t>::max())
+    {
+        buffer.push_back(0xda);
+        write_be(buffer, static_cast<uint16_t>(size));
+    }
+    else
+    {
+        buffer.push_back(0xdb);
+        write_be(buffer, static_cast<uint32_t>(size));
+    }
+
+    write_bytes(buffer, data, size);
+}
+
+
+void MsgPackEncoder::write_binary(BinData &buffer, const uint8_t *data, size_t size)
+{
+    if (size <= std::numeric_limits<uint8_t>::max())
+    {
+        buffer.push_back(0xc4);
+        buffer.push_back(static_cast<uint8_t>(size));
+    }
+    else if (size <= std::numeric_limits<uint16_t>::max())
+    {
+        buffer.push_back(0xc5);
+        write_be(buffer, static_cast<uint16_t>(size));
+    }
+    else
+    {
+        buffer.push_back(0xc6);
+        write_be(buffer, static_cast<uint32_t>(size));
+    }
+
+    write_bytes(buffer, data, size);
+}
+
+
+static void write_ext_header(BinData &buffer, MsgPackEncoder::ExtType type, size_t size)
+{
+    switch (size)
+    {
+        case 1: buffer.push_back(0xd4); break;
+        case 2: buffer.push_back(0xd5); break;
+        case 4: buffer.push_back(0xd6); break;
+        case 8: buffer.push_back(0xd7); break;
+        case 16: buffer.push_back(0xd8); break;
+        default:
+            if (size <= std::numeric_limits<uint8_t>::max())
+            {
+                buffer.push_back(0xc7);
+                buffer.push_back(static_cast<uint8_t>(size));
+            }
+            else if (size <= std::numeric_limits<uint16_t>::max())
+            {
+                buffer.push_back(0xc8);
+                write_be(buffer, static_cast<uint16_t>(size));
+            }
+            else
+            {
+                buffer.push_back(0xc9);
+                write_be(buffer, static_cast<uint32_t>(size));
+            }
+    }
+
+    buffer.push_back(static_cast<uint8_t>(type));
+}
+
+
+void MsgPackEncoder::write_time(BinData &buffer, const Time &data)
+{
+    auto [seconds, nanoseconds] = split_time(data);
+
+    if (seconds >= 0 && (static_cast<uint64_t>(seconds) >> 34) == 0)
+    {
+        if (!nanoseconds && (static_cast<uint64_t>(seconds) >> 32) == 0)
+        {
+            // Timestamp 32.
+            write_ext_header(buffer, ExtType::Timestamp, 4);
+            write_be(buffer, static_cast<uint32_t>(seconds));
+        }
+        else
+        {
+            // Timestamp 64: 30 bits of nanoseconds, 34 bits of seconds.
+            write_ext_header(buffer, ExtType::Timestamp, 8);
+            write_be(buffer, (static_cast<uint64_t>(nanoseconds) << 34) | static_cast<uint64_t>(seconds));
+        }
+    }
+    else
+    {
+        write_ext_header(buffer, ExtType::Timestamp, 12);
+        write_be(buffer, nanoseconds);
+        write_be(buffer, static_cast<uint64_t>(seconds));
+    }
+}
+
+
+void MsgPackEncoder::write_double_array(BinData &buffer, const DoubleArray &data)
+{
+    write_ext_header(buffer, ExtType::DoubleArray, data.size() * sizeof(double));
+    write_packed_le(buffer, data);
+}
+
+
+void MsgPackEncoder::write_int32_array(BinData &buffer, const Int32Array &data)
+{
+    write_ext_header(buffer, ExtType::Int32Array, data.size() * sizeof(int32_t));
+    write_packed_le(buffer, data);
+}
+
+
+void MsgPackEncoder::write_array_header(BinData &buffer, size_t size)
+{
+    if (size < 16)
+    {
+        buffer.push_back(static_cast<uint8_t>(0x90 | size));
+    }
+    else if (size <= std::numeric_limits<uint16_t>::max())
+    {
+        buffer.push_back(0xdc);
+        write_be(buffer, static_cast<uint16_t>(size));
+    }
+    else
+    {
+        buffer.push_back(0xdd);
+        write_be(buffer, static_cast<uint32_t>(size));
+    }
+}
+
+
+void MsgPackEncoder::write_map_header(BinData &buffer, size_t size)
+{
+    if (size < 16)
+    {
+        buffer.push_back(static_cast<uint8_t>(0x80 | size));
+    }
+    else if (size <= std::numeric_limits<uint16_t>::max())
+    {
+        buffer.push_back(0xde);
+        write_be(buffer, static_cast<uint16_t>(size));
+    }
+    else
+    {
+        buffer.push_back(0xdf);
+        write_be(buffer, static_cast<uint32_t>(size));
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// MsgPackDeserializerImpl
+//----------------------------------------------------------------------------
+
+static Value make_integer(int64_t value)
+{
+    if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max())
+    {
+        return static_cast<int32_t>(value);
+    }
+
+    return value;
+}
+
+
+static Value make_integer(uint64_t value)
+{
+    if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+    {
+        TSW_THROW(CompactCodecException, "unsigned integer is out of the Int64 range");
+    }
+
+    return make_integer(static_cast<int64_t>(value));
+}
+
+
+Object MsgPackDeserializerImpl::Deserialize(const BinData::value_type *data, size_t size)
+{
+    CompactReader reader(data, size);
+    auto fields_count = read_map_header(reader);
+    auto result = read_map(reader, fields_count);
+
+    if (!reader.at_end()) TSW_THROW(CompactCodecException, "trailing data after the document");
+
+    return result;
+}
+
+
+MessageType MsgPackDeserializerImpl::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    CompactReader reader(data, size);
+    auto fields_count = read_map_header(reader);
+
+    // Serializer writes the type first: other fields are not decoded.
+    for (size_t i = 0; i < fields_count; ++i)
+    {
+        auto name = read_key(reader);
+        auto value = read_value(reader);
+
+        if (name == "type")
+        {
+            if (!value.is_int32()) TSW_THROW(CompactCodecException, "message type is not an integer");
+            return static_cast<MessageType>(value.as_int32());
+        }
+    }
+
+    TSW_THROW(CompactCodecException, "message has no type");
+}
+
+
+size_t MsgPackDeserializerImpl::read_map_header(CompactReader &reader)
+{
+    uint8_t marker = reader.read_byte();
+
+    if ((marker & 0xf0) == 0x80) return marker & 0x0f;
+    if (marker == 0xde) return reader.read_be<uint16_t>();
+    if (marker == 0xdf) return reader.read_be<uint32_t>();
+
+    TSW_THROW(CompactCodecException, "document is not a map");
+}
+
+
+String MsgPackDeserializerImpl::read_key(CompactReader &reader)
+{
+    uint8_t marker = reader.read_byte();
+    size_t size;
+
+    if ((marker & 0xe0) == 0xa0) size = marker & 0x1f;
+    else if (marker == 0xd9) size = reader.read_byte();
+    else if (marker == 0xda) size = reader.read_be<uint16_t>();
+    else if (marker == 0xdb) size = reader.read_be<uint32_t>();
+    else TSW_THROW(CompactCodecException, "map key is not a string");
+
+    auto data = reader.read_bytes(size);
+
+    return String(reinterpret_cast<const char*>(data), size);
+}
+
+
+Object MsgPackDeserializerImpl::read_map(CompactReader &reader, size_t size)
+{
+    Object result;
+
+    if (size > reader.remaining()) TSW_THROW(CompactCodecException, "map is larger than the data");
+
+    reader.enter();
+    for (size_t i = 0; i < size; ++i)
+    {
+        auto name = read_key(reader);
+
+        result.emplace_hint(result.end(), std::move(name), read_value(reader));
+    }
+    reader.leave();
+
+    return result;
+}
+
+
+ValueArray MsgPackDeserializerImpl::read_array(CompactReader &reader, size_t size)
+{
+    ValueArray result;
+
+    // Every element takes at least one byte: malformed size will not exhaust the memory.
+    if (size > reader.remaining()) TSW_THROW(CompactCodecException, "array is larger than the data");
+
+    reader.enter();
+    result.reserve(size);
+    for (size_t i = 0; i < size; ++i) result.push_back(read_value(reader));
+    reader.leave();
+
+    return result;
+}
+
+
+Value MsgPackDeserializerImpl::read_ext(CompactReader &reader, size_t size)
+{
+    auto type = static_cast<int8_t>(reader.read_byte());
+    auto data = reader.read_bytes(size);
+
+    switch (static_cast<MsgPackEncoder::ExtType>(type))
+    {
+        case MsgPackEncoder::ExtType::Timestamp:
+        {
+            CompactReader timestamp(data, size);
+
+            if (size == 4) return join_time(timestamp.read_be<uint32_t>(), 0);
+            if (size == 8)
+            {
+                uint64_t bits = timestamp.read_be<uint64_t>();
+                return join_time(static_cast<int64_t>(bits & 0x3ffffffffULL), static_cast<uint32_t>(bits >> 34));
+            }
+            if (size == 12)
+            {
+                uint32_t nanoseconds = timestamp.read_be<uint32_t>();
+                return join_time(static_cast<int64_t>(timestamp.read_be<uint64_t>()), nanoseconds);
+            }
+            TSW_THROW(CompactCodecException, "invalid timestamp size");
+        }
+        case MsgPackEncoder::ExtType::Undefined:
+            return Undefined();
+        case MsgPackEncoder::ExtType::DoubleArray:
+            return read_packed_le<DoubleArray>(data, size);
+        case MsgPackEncoder::ExtType::Int32Array:
+            return read_packed_le<Int32Array>(data, size);
+    }
+
+    TSW_THROW(CompactCodecException, "unknown extension type " + std::to_string(static_cast<int>(type)));
+}
+
+
+Value MsgPackDeserializerImpl::read_value(CompactReader &reader)
+{
+    uint8_t marker = reader.read_byte();
+
+    if (marker <= 0x7f) return static_cast<int32_t>(marker);
+    if (marker >= 0xe0) return static_cast<int32_t>(static_cast<int8_t>(marker));
+    if ((marker & 0xf0) == 0x80) return read_map(reader, marker & 0x0f);
+    if ((marker & 0xf0) == 0x90) return read_array(reader, marker & 0x0f);
+    if ((marker & 0xe0) == 0xa0)
+    {
+        size_t size = marker & 0x1f;
+        return String(reinterpret_cast<const char*>(reader.read_bytes(size)), size);
+    }
+
+    auto read_string = [&reader](size_t size)
+    {
+        return String(reinterpret_cast<const char*>(reader.read_bytes(size)), size);
+    };
+
+    auto read_binary = [&reader](size_t size)
+    {
+        auto data = reader.read_bytes(size);
+        return BinData(data, data + size);
+    };
+
+    switch (marker)
+    {
+        case 0xc0: return Null();
+        case 0xc2: return false;
+        case 0xc3: return true;
+        case 0xc4: return read_binary(reader.read_byte());
+        case 0xc5: return read_binary(reader.read_be<uint16_t>());
+        case 0xc6: return read_binary(reader.read_be<uint32_t>());
+        case 0xc7: return read_ext(reader, reader.read_byte());
+        case 0xc8: return read_ext(reader, reader.read_be<uint16_t>());
+        case 0xc9: return read_ext(reader, reader.read_be<uint32_t>());
+        case 0xca: return static_cast<double>(reader.read_float());
+        case 0xcb: return reader.read_double();
+        case 0xcc: return make_integer(static_cast<int64_t>(reader.read_byte()));
+        case 0xcd: return make_integer(static_cast<int64_t>(reader.read_be<uint16_t>()));
+        case 0xce: return make_integer(static_cast<int64_t>(reader.read_be<uint32_t>()));
+        case 0xcf: return make_integer(reader.read_be<uint64_t>());
+        case 0xd0: return static_cast<int32_t>(static_cast<int8_t>(reader.read_byte()));
+        case 0xd1: return static_cast<int32_t>(static_cast<int16_t>(reader.read_be<uint16_t>()));
+        case 0xd2: return static_cast<int32_t>(reader.read_be<uint32_t>());
+        // Int64 type is kept, even if the value is small.
+        case 0xd3: return static_cast<int64_t>(reader.read_be<uint64_t>());
+        case 0xd4: return read_ext(reader, 1);
+        case 0xd5: return read_ext(reader, 2);
+        case 0xd6: return read_ext(reader, 4);
+        case 0xd7: return read_ext(reader, 8);
+        case 0xd8: return read_ext(reader, 16);
+        case 0xd9: return read_string(reader.read_byte());
+        case 0xda: return read_string(reader.read_be<uint16_t>());
+        case 0xdb: return read_string(reader.read_be<uint32_t>());
+        case 0xdc: return read_array(reader, reader.read_be<uint16_t>());
+        case 0xdd: return read_array(reader, reader.read_be<uint32_t>());
+        case 0xde: return read_map(reader, reader.read_be<uint16_t>());
+        case 0xdf: return read_map(reader, reader.read_be<uint32_t>());
+    }
+
+    TSW_THROW(CompactCodecException, "unknown MessagePack marker " + std::to_string(marker));
+}
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,84 @@
+/**
+  * @file msgpack_impl.h
+  * @author Artiom N.(cl)2017
+  * @brief MessagePack serializer/deserializer implementation's classes definition.
+  *
+  */
+
+#pragma once
+
+#include "tsw/message.h"
+#include "tsw/types.h"
+
+#include "compact_codec.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief MessagePack (msgpack.org) items encoder.
+ *
+ * Int32 values are written in the shortest form, Int64 always as int 64, so both types
+ * survive the round trip. Time is the standard timestamp extension, Undefined and packed
+ * arrays are the application extensions.
+ */
+struct MsgPackEncoder
+{
+    enum class ExtType : int8_t
+    {
+        Timestamp = -1,
+        Undefined = 0,
+        DoubleArray = 1,
+        Int32Array = 2
+    };
+
+    // Document is a map16 with the fields count patched at the end:
+    // its first bytes never look like a BSON document length.
+    static void start_document(BinData &buffer);
+    static void finish_document(BinData &buffer, size_t fields_count);
+
+    static void write_undefined(BinData &buffer);
+    static void write_null(BinData &buffer);
+    static void write_bool(BinData &buffer, bool data);
+    static void write_int32(BinData &buffer, int32_t data);
+    static void write_int64(BinData &buffer, int64_t data);
+    static void write_double(BinData &buffer, double data);
+    static void write_string(BinData &buffer, const char *data, size_t size);
+    static void write_binary(BinData &buffer, const uint8_t *data, size_t size);
+    static void write_time(BinData &buffer, const Time &data);
+    static void write_double_array(BinData &buffer, const DoubleArray &data);
+    static void write_int32_array(BinData &buffer, const Int32Array &data);
+    static void write_array_header(BinData &buffer, size_t size);
+    static void write_map_header(BinData &buffer, size_t size);
+};
+
+
+typedef CompactSerializerImpl<MsgPackEncoder> MsgPackSerializerImpl;
+
+
+class MsgPackDeserializerImpl
+{
+public:
+    Object Deserialize(const BinData::value_type *data, size_t size);
+
+    /**
+     * @brief Read the "type" field only.
+     */
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size);
+
+private:
+    Value read_value(CompactReader &reader);
+    Object read_map(CompactReader &reader, size_t size);
+    ValueArray read_array(CompactReader &reader, size_t size);
+    Value read_ext(CompactReader &reader, size_t size);
+    String read_key(CompactReader &reader);
+    size_t read_map_header(CompactReader &reader);
+};
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,63 @@
+/**
+  * @file msgpack_serializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MsgPackSerializer class implementation.
+  *
+  */
+
+#include <memory>
+
+#include <tsw/msgpack_serializer.h>
+#include <tsw/types.h>
+#include <tsw/wire_format.h>
+
+#include "msgpack_impl.h"
+
+
+namespace tsw
+{
+
+MsgPackSerializer::MsgPackSerializer() : impl_(new impl::MsgPackSerializerImpl)
+{}
+
+
+MsgPackSerializer::~MsgPackSerializer()
+{}
+
+
+BinData MsgPackSerializer::SerializeMessage(const Message &message)
+{
+    return Serializer::SerializeMessage<impl::MsgPackSerializerImpl>(message, *impl_);
+}
+
+
+void MsgPackSerializer::SerializeMessageTo(const Message &message, BinData &buffer)
+{
+    impl_->reset(buffer);
+    WriteMessage<impl::MsgPackSerializerImpl>(message, *impl_);
+    impl_->take_buffer(buffer);
+}
+
+
+std::unique_ptr<Serializer> MsgPackSerializer::Clone() const
+{
+    return std::make_unique<MsgPackSerializer>();
+}
+
+
+WireFormat MsgPackSerializer::Format() const
+{
+    return WireFormat::MsgPack;
+}
+
+
+BinData MsgPackSerializer::SerializeObject(const Object &fields)
+{
+    impl_->clear();
+
+    for (const auto &field: fields) impl_->append_field(field.first, field.second);
+
+    return impl_->take_buffer();
+}
+
+} // namespace tsw
@@ -0,0 +1,89 @@
+/**
+  * @file schema_deserializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief SchemaDeserializer class implementation.
+  *
+  */
+
+#include <exception>
+#include <memory>
+#include <string>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/schema_deserializer.h>
+#include <tsw/types.h>
+
+#include "schema_impl.h"
+
+
+namespace tsw
+{
+
+using impl::CompiledScheme;
+
+
+SchemaDeserializer::SchemaDeserializer(std::shared_ptr<const SchemaRegistry> registry) :
+    SchemaDeserializer(registry, std::make_shared<BsonDeserializer>())
+{}
+
+
+SchemaDeserializer::SchemaDeserializer(std::shared_ptr<const SchemaRegistry> registry,
+                                       std::shared_ptr<Deserializer> fallback) :
+    registry_(registry), fallback_(fallback)
+{
+    TSW_ASSERT(registry_ != nullptr);
+    TSW_ASSERT(fallback_ != nullptr);
+}
+
+
+SchemaDeserializer::~SchemaDeserializer()
+{}
+
+
+Message SchemaDeserializer::DeserializeMessage(const BinData &data)
+{
+    return DeserializeMessage(data.data(), data.size());
+}
+
+
+Object SchemaDeserializer::DeserializeObject(const BinData &data)
+{
+    return fallback_->DeserializeObject(data);
+}
+
+
+Message SchemaDeserializer::DeserializeMessage(const BinData::value_type *data, size_t size)
+{
+    if (!CompiledScheme::is_compact(data, size)) return fallback_->DeserializeMessage(data, size);
+
+    auto hash = CompiledScheme::read_hash(data, size);
+    auto scheme = registry_->find(hash);
+
+    if (scheme) return scheme->decode(data, size);
+
+    // Peer has another scheme version: fallback may know it, for example, SchemaDeserializer with the previous registry.
+    try
+    {
+        return fallback_->DeserializeMessage(data, size);
+    }
+    catch (const std::exception&)
+    {
+        TSW_THROW(impl::SchemaException, "message scheme with hash " + std::to_string(hash) + " is unknown");
+    }
+}
+
+
+Object SchemaDeserializer::DeserializeObject(const BinData::value_type *data, size_t size)
+{
+    return fallback_->DeserializeObject(data, size);
+}
+
+
+MessageType SchemaDeserializer::DeserializeMessageType(const BinData::value_type *data, size_t size)
+{
+    if (!CompiledScheme::is_compact(data, size)) return fallback_->DeserializeMessageType(data, size);
+
+    return CompiledScheme::read_message_type(data, size);
+}
+
+} // namespace tsw
@@ -0,0 +1,495 @@
+/**
+  * @file schema_impl.cpp
+  * @author Artiom N.(cl)2017
+  * @brief CompiledScheme class implementation.
+  *
+  */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "tsw/error.h"
+#include "tsw/field.h"
+
+#include "binary_message.h"
+#include "bson_writer.h"
+#include "schema_impl.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+// Last byte has the high bit: BSON document can't start so, its length is positive.
+static const BinData::value_type schema_magic[] = { 'T', 'S', 'C', 0x81 };
+
+static constexpr size_t hash_offset = sizeof(schema_magic);
+static constexpr size_t type_offset = hash_offset + sizeof(uint64_t);
+static constexpr size_t fixed_header_size = type_offset + sizeof(uint16_t);
+
+
+static bool is_positional_type(ValueType type)
+{
+    switch (type)
+    {
+        case ValueType::BinData:
+        case ValueType::Boolean:
+        case ValueType::DoubleNumber:
+        case ValueType::Int32Number:
+        case ValueType::Int64Number:
+        case ValueType::String:
+        case ValueType::Time:
+        case ValueType::DoubleArray:
+        case ValueType::Int32Array:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+// FNV-1a: scheme hash must be the same on all hosts.
+class SchemeHash
+{
+public:
+    void update(const void *data, size_t size)
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash_ ^= bytes[i];
+            hash_ *= 0x100000001b3ULL;
+        }
+    }
+
+    void update(const String &s) { update(s.c_str(), s.size() + 1); }
+    void update(uint8_t b) { update(&b, sizeof(b)); }
+
+    // Zero is reserved for "no scheme".
+    uint64_t value() const { return hash_ ? hash_ : 1; }
+
+private:
+    uint64_t hash_ = 0xcbf29ce484222325ULL;
+};
+
+
+//----------------------------------------------------------------------------
+// Encoding helpers
+//----------------------------------------------------------------------------
+
+class SchemeWriter
+{
+public:
+    explicit SchemeWriter(BinData &buffer) : buffer_(buffer) { buffer_.clear(); }
+
+public:
+    template<typename T>
+    void write_le(T data)
+    {
+        typedef std::make_unsigned_t<T> UInt;
+        auto u = static_cast<UInt>(data);
+
+        for (size_t i = 0; i < sizeof(T); ++i) buffer_.push_back(static_cast<uint8_t>(u >> (i * 8)));
+    }
+
+    void write_double(double data)
+    {
+        uint64_t bits;
+
+        memcpy(&bits, &data, sizeof(bits));
+        write_le(bits);
+    }
+
+    void write_varint(uint64_t data)
+    {
+        while (data >= 0x80)
+        {
+            buffer_.push_back(static_cast<uint8_t>(data | 0x80));
+            data >>= 7;
+        }
+        buffer_.push_back(static_cast<uint8_t>(data));
+    }
+
+    void write_bytes(const void *data, size_t size)
+    {
+        auto d = static_cast<const uint8_t*>(data);
+        buffer_.insert(buffer_.end(), d, d + size);
+    }
+
+    void write_string(const String &data)
+    {
+        write_varint(data.size());
+        write_bytes(data.data(), data.size());
+    }
+
+    template<typename ArrayType>
+    void write_packed(const ArrayType &data)
+    {
+        write_varint(data.size());
+
+        if constexpr (bson_native_byte_order)
+        {
+            write_bytes(data.data(), data.size() * sizeof(typename ArrayType::value_type));
+        }
+        else
+        {
+            for (auto element: data)
+            {
+                if constexpr (std::is_floating_point_v<decltype(element)>) write_double(element);
+                else write_le(element);
+            }
+        }
+    }
+
+    // Reserve zeroed bytes, return their offset.
+    size_t reserve(size_t size)
+    {
+        size_t offset = buffer_.size();
+        buffer_.resize(offset + size, 0);
+        return offset;
+    }
+
+    BinData::value_type &at(size_t offset) { return buffer_[offset]; }
+
+private:
+    BinData &buffer_;
+};
+
+
+class SchemeReader
+{
+public:
+    SchemeReader(const BinData::value_type *data, size_t size) : cur_(data), end_(data + size) {}
+
+public:
+    template<typename T>
+    T read_le()
+    {
+        typedef std::make_unsigned_t<T> UInt;
+        UInt u = 0;
+
+        check(sizeof(T));
+        for (size_t i = 0; i < sizeof(T); ++i) u |= static_cast<UInt>(cur_[i]) << (i * 8);
+        cur_ += sizeof(T);
+
+        return static_cast<T>(u);
+    }
+
+    double read_double()
+    {
+        auto bits = read_le<uint64_t>();
+        double result;
+
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    uint64_t read_varint()
+    {
+        uint64_t result = 0;
+
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            check(1);
+            uint8_t b = *cur_++;
+            result |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return result;
+        }
+
+        TSW_THROW(SchemaException, "incorrect varint in the compact message");
+    }
+
+    const BinData::value_type *read_bytes(size_t size)
+    {
+        check(size);
+        auto result = cur_;
+        cur_ += size;
+        return result;
+    }
+
+    String read_string()
+    {
+        size_t size = read_varint();
+        auto data = read_bytes(size);
+
+        return String(reinterpret_cast<const char*>(data), size);
+    }
+
+    template<typename ArrayType>
+    ArrayType read_packed()
+    {
+        typedef typename ArrayType::value_type T;
+
+        size_t count = read_varint();
+        // Count is checked before the allocation.
+        if (count > static_cast<size_t>(end_ - cur_) / sizeof(T))
+        {
+            TSW_THROW(SchemaException, "compact message is truncated");
+        }
+
+        ArrayType result(count);
+
+        if constexpr (bson_native_byte_order)
+        {
+            memcpy(result.data(), read_bytes(count * sizeof(T)), count * sizeof(T));
+        }
+        else
+        {
+            for (auto &element: result)
+            {
+                if constexpr (std::is_floating_point_v<T>) element = read_double();
+                else element = read_le<T>();
+            }
+        }
+
+        return result;
+    }
+
+    bool at_end() const { return cur_ == end_; }
+
+private:
+    void check(size_t size) const
+    {
+        if (size > static_cast<size_t>(end_ - cur_))
+        {
+            TSW_THROW(SchemaException, "compact message is truncated");
+        }
+    }
+
+private:
+    const BinData::value_type *cur_;
+    const BinData::value_type *end_;
+};
+
+
+//----------------------------------------------------------------------------
+// CompiledScheme
+//----------------------------------------------------------------------------
+
+CompiledScheme::CompiledScheme(MessageType message_type, const EAMetadata &metadata) :
+    message_type_(message_type), name_(metadata.get_name())
+{
+    std::vector<const FieldHeader*> headers;
+
+    for (const auto &f: metadata.get_field_scheme())
+    {
+        const auto &header = f.second;
+
+        if (!is_positional_type(header.type))
+        {
+            TSW_THROW(SchemaException, "field \"" + header.name + "\" of the \"" + name_ +
+                                       "\" can't be encoded positionally");
+        }
+        if (header.name == name_field)
+        {
+            TSW_THROW(SchemaException, String("field name \"") + name_field + "\" is reserved for the activity name");
+        }
+        headers.push_back(&header);
+    }
+
+    // Scheme is ordered by position, UID makes order of the equal positions stable.
+    std::sort(headers.begin(), headers.end(), [](const FieldHeader *a, const FieldHeader *b)
+    {
+        return a->position != b->position ? a->position < b->position : a->uid < b->uid;
+    });
+
+    SchemeHash hash;
+
+    hash.update(static_cast<uint8_t>(message_type_));
+    hash.update(name_);
+
+    fields_.reserve(headers.size());
+    for (auto header: headers)
+    {
+        if (std::any_of(fields_.cbegin(), fields_.cend(), [header](const FieldEntry &e) { return e.name == header->name; }))
+        {
+            TSW_THROW(SchemaException, "field \"" + header->name + "\" of the \"" + name_ + "\" is duplicated");
+        }
+
+        fields_.push_back(FieldEntry{header->name, header->type});
+        hash.update(header->name);
+        hash.update(static_cast<uint8_t>(header->type));
+    }
+
+    hash_ = hash.value();
+}
+
+
+bool CompiledScheme::encode(const Message &message, BinData &buffer) const
+{
+    const auto &fields = message.get_fields();
+    SchemeWriter writer(buffer);
+    size_t fields_found = 0;
+
+    writer.write_bytes(schema_magic, sizeof(schema_magic));
+    writer.write_le(hash_);
+    writer.write_le(static_cast<uint16_t>(message.get_type()));
+    writer.write_le(static_cast<uint64_t>(message.get_receiver_module_uid()));
+    writer.write_le(static_cast<uint64_t>(message.get_sender_module_uid()));
+    writer.write_le(static_cast<int64_t>(message.get_creation_time().count()));
+    writer.write_string(message.get_receiver_module_name());
+    writer.write_string(message.get_receiver_module_class());
+    writer.write_string(message.get_sender_module_name());
+    writer.write_string(message.get_sender_module_class());
+
+    const size_t bitmap = writer.reserve((fields_.size() + 7) / 8);
+
+    for (size_t n = 0; n < fields_.size(); ++n)
+    {
+        const auto &entry = fields_[n];
+        auto field = fields.find(entry.name);
+
+        if (field == fields.end()) continue;
+
+        const Value &value = field->second;
+
+        if (value.value_type() != entry.type) return false;
+
+        ++fields_found;
+        writer.at(bitmap + n / 8) |= static_cast<uint8_t>(1 << (n % 8));
+
+        switch (entry.type)
+        {
+            case ValueType::BinData:
+            {
+                const auto &data = value.as_bindata();
+                writer.write_varint(data.size());
+                writer.write_bytes(data.data(), data.size());
+            }
+            break;
+            case ValueType::Boolean:
+                writer.write_le(static_cast<uint8_t>(value.as_bool()));
+            break;
+            case ValueType::DoubleNumber:
+                writer.write_double(value.as_double());
+            break;
+            case ValueType::Int32Number:
+                writer.write_le(value.as_int32());
+            break;
+            case ValueType::Int64Number:
+                writer.write_le(value.as_int64());
+            break;
+            case ValueType::String:
+                writer.write_string(value.as_string());
+            break;
+            case ValueType::Time:
+                writer.write_le(static_cast<int64_t>(value.as_time().count()));
+            break;
+            case ValueType::DoubleArray:
+                writer.write_packed(value.as_double_array());
+            break;
+            case ValueType::Int32Array:
+                writer.write_packed(value.as_int32_array());
+            break;
+            default:
+                TSW_ASSERT(false);
+        }
+    }
+
+    // Fields, which are not in the scheme, can't be sent positionally.
+    return fields_found + 1 == fields.size();
+}
+
+
+Message CompiledScheme::decode(const BinData::value_type *data, size_t size) const
+{
+    if (read_hash(data, size) != hash_) TSW_THROW(SchemaException, "scheme hash mismatch");
+
+    SchemeReader reader(data + fixed_header_size, size - fixed_header_size);
+    NameValueMap fields;
+
+    const UID receiver_uid = reader.read_le<uint64_t>();
+    const UID sender_uid = reader.read_le<uint64_t>();
+    Time c_time(reader.read_le<int64_t>());
+    String receiver_name = reader.read_string();
+    ModuleClass receiver_class = reader.read_string();
+    String sender_name = reader.read_string();
+    ModuleClass sender_class = reader.read_string();
+    const BinData::value_type *bitmap = reader.read_bytes((fields_.size() + 7) / 8);
+
+    for (size_t n = 0; n < fields_.size(); ++n)
+    {
+        if (!(bitmap[n / 8] & (1 << (n % 8)))) continue;
+
+        const auto &entry = fields_[n];
+        Value &value = fields[entry.name];
+
+        switch (entry.type)
+        {
+            case ValueType::BinData:
+            {
+                size_t length = reader.read_varint();
+                auto bytes = reader.read_bytes(length);
+                value = BinData(bytes, bytes + length);
+            }
+            break;
+            case ValueType::Boolean:
+                value = reader.read_le<uint8_t>() != 0;
+            break;
+            case ValueType::DoubleNumber:
+                value = reader.read_double();
+            break;
+            case ValueType::Int32Number:
+                value = reader.read_le<int32_t>();
+            break;
+            case ValueType::Int64Number:
+                value = reader.read_le<int64_t>();
+            break;
+            case ValueType::String:
+                value = reader.read_string();
+            break;
+            case ValueType::Time:
+                value = Time(reader.read_le<int64_t>());
+            break;
+            case ValueType::DoubleArray:
+                value = reader.read_packed<DoubleArray>();
+            break;
+            case ValueType::Int32Array:
+                value = reader.read_packed<Int32Array>();
+            break;
+            default:
+                TSW_ASSERT(false);
+        }
+    }
+
+    if (!reader.at_end()) TSW_THROW(SchemaException, "compact message has trailing data");
+
+    fields[name_field] = name_;
+
+    return BinaryMessage(read_message_type(data, size), std::move(fields),
+                         receiver_uid, std::move(receiver_name), std::move(receiver_class),
+                         sender_uid, std::move(sender_name), std::move(sender_class),
+                         std::move(c_time));
+}
+
+
+bool CompiledScheme::is_compact(const BinData::value_type *data, size_t size)
+{
+    return size >= fixed_header_size && !memcmp(data, schema_magic, sizeof(schema_magic));
+}
+
+
+uint64_t CompiledScheme::read_hash(const BinData::value_type *data, size_t size)
+{
+    if (!is_compact(data, size)) TSW_THROW(SchemaException, "message is not in the compact form");
+
+    return SchemeReader(data + hash_offset, sizeof(uint64_t)).read_le<uint64_t>();
+}
+
+
+MessageType CompiledScheme::read_message_type(const BinData::value_type *data, size_t size)
+{
+    if (!is_compact(data, size)) TSW_THROW(SchemaException, "message is not in the compact form");
+
+    return static_cast<MessageType>(SchemeReader(data + type_offset, sizeof(uint16_t)).read_le<uint16_t>());
+}
+
+} // namespace impl
+
+} // namespace tsw
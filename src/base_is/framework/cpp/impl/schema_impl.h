@@ -0,0 +1,91 @@
+/**
+  * @file schema_impl.h
+  * @author Artiom N.(cl)2017
+  * @brief CompiledScheme class definition: positional binary codec for the EA fields.
+  *
+  */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "tsw/error.h"
+#include "tsw/message.h"
+#include "tsw/metadata.h"
+#include "tsw/types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+class SchemaException : public Exception
+{
+    using Exception::Exception;
+};
+
+
+/**
+ * @brief Scheme of the event or action, compiled to the positional binary layout.
+ *
+ * Message layout (all numbers are little-endian):
+ * @code
+ * magic[4] scheme_hash:u64 type:u16
+ * receiver_uid:u64 sender_uid:u64 c_time:i64
+ * receiver_name receiver_class sender_name sender_class   (varint length + bytes)
+ * presence_bitmap[(fields_count + 7) / 8]
+ * present field values in the position order, without names
+ * @endcode
+ * Activity name is a part of the scheme and isn't transferred.
+ */
+class CompiledScheme
+{
+public:
+    struct FieldEntry
+    {
+        String      name;
+        ValueType   type;
+    };
+
+public:
+    /**
+     * @throw SchemaException, if scheme has fields, which can't be encoded positionally.
+     */
+    CompiledScheme(MessageType message_type, const EAMetadata &metadata);
+
+public:
+    uint64_t                        hash() const { return hash_; }
+    MessageType                     message_type() const { return message_type_; }
+    const String                    &name() const { return name_; }
+    const std::vector<FieldEntry>   &fields() const { return fields_; }
+
+public:
+    /**
+     * @brief Encode message into the buffer.
+     * @return false, if message fields don't conform to the scheme. Buffer content is undefined then.
+     */
+    bool encode(const Message &message, BinData &buffer) const;
+
+    Message decode(const BinData::value_type *data, size_t size) const;
+
+public:
+    // Activity name field, which selects the scheme.
+    static constexpr const char *name_field = "name";
+
+    static bool is_compact(const BinData::value_type *data, size_t size);
+    static uint64_t read_hash(const BinData::value_type *data, size_t size);
+    static MessageType read_message_type(const BinData::value_type *data, size_t size);
+
+private:
+    MessageType             message_type_;
+    String                  name_;
+    std::vector<FieldEntry> fields_;
+    uint64_t                hash_;
+};
+
+} // namespace impl
+
+} // namespace tsw
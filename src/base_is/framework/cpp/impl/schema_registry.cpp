@@ -0,0 +1,225 @@
+/**
+  * @file schema_registry.cpp
+  * @author Artiom N.(cl)2017
+  * @brief SchemaRegistry class implementation.
+  *
+  */
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include <tsw/schema_registry.h>
+#include <tsw/types.h>
+
+#include "schema_impl.h"
+
+
+namespace tsw
+{
+
+using impl::CompiledScheme;
+
+
+SchemaRegistry::SchemaRegistry()
+{
+}
+
+
+SchemaRegistry::~SchemaRegistry()
+{
+}
+
+
+uint64_t SchemaRegistry::register_scheme(MessageType message_type, const EAMetadata &metadata)
+{
+    SchemePtr scheme;
+
+    try
+    {
+        scheme = std::make_shared<const CompiledScheme>(message_type, metadata);
+    }
+    catch (const impl::SchemaException&)
+    {
+        // Unsupported scheme: messages will be sent by the fallback serializer.
+        unregister_scheme(message_type, metadata.get_name());
+        return 0;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto &named = schemes_[message_type][metadata.get_name()];
+
+    if (named) schemes_by_hash_.erase(named->hash());
+    named = scheme;
+    schemes_by_hash_[scheme->hash()] = scheme;
+
+    return scheme->hash();
+}
+
+
+void SchemaRegistry::unregister_scheme(MessageType message_type, const String &name)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto schemes = schemes_.find(message_type);
+
+    if (schemes == schemes_.end()) return;
+
+    auto scheme = schemes->second.find(name);
+
+    if (scheme == schemes->second.end()) return;
+
+    schemes_by_hash_.erase(scheme->second->hash());
+    schemes->second.erase(scheme);
+}
+
+
+// Activity metadata, as it's announced by the ControllerImpl.
+static bool read_announced_metadata(const Value &entry, std::unique_ptr<EAMetadata> &metadata)
+{
+    if (!entry.is_object()) return false;
+
+    const auto &fields = entry.as_object();
+    auto name = fields.find("name");
+    auto scheme = fields.find("field_scheme");
+
+    if (name == fields.end() || !name->second.is_string() || scheme == fields.end() || !scheme->second.is_object()) return false;
+
+    FieldUIDFieldHeaderMap field_scheme;
+
+    for (const auto &field: scheme->second.as_object())
+    {
+        if (!field.second.is_object()) return false;
+
+        const auto &header = field.second.as_object();
+        auto uid = header.find("uid");
+        auto type = header.find("type");
+        auto field_name = header.find("name");
+        auto position = header.find("position");
+
+        if (uid == header.end() || !uid->second.is_string() || type == header.end() || !type->second.is_int32() ||
+            field_name == header.end() || !field_name->second.is_string() ||
+            position == header.end() || !position->second.is_int32()) return false;
+
+        try
+        {
+            const UID field_uid = std::stoull(uid->second.as_string());
+
+            field_scheme[field_uid] = FieldHeader{ field_uid, static_cast<ValueType>(type->second.as_int32()),
+                                                   field_name->second.as_string(), position->second.as_int32(), String() };
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    metadata.reset(new EAMetadata(name->second.as_string(), nullptr, String(), field_scheme));
+
+    return true;
+}
+
+
+std::vector<uint64_t> SchemaRegistry::register_announced(const Message &announcement)
+{
+    std::vector<uint64_t> result;
+    MessageType activity_type;
+    bool announced;
+
+    switch (announcement.get_type())
+    {
+        case MessageType::AnnounceModuleEvents: activity_type = MessageType::Event; announced = true; break;
+        case MessageType::AnnounceModuleActions: activity_type = MessageType::Action; announced = true; break;
+        case MessageType::DenounceModuleEvents: activity_type = MessageType::Event; announced = false; break;
+        case MessageType::DenounceModuleActions: activity_type = MessageType::Action; announced = false; break;
+        default: return result;
+    }
+
+    const auto &fields = announcement.get_fields();
+    auto entries = fields.find("metadata");
+
+    if (entries == fields.end() || !entries->second.is_array()) return result;
+
+    for (const auto &entry: entries->second.as_array())
+    {
+        if (!announced)
+        {
+            if (entry.is_string()) unregister_scheme(activity_type, entry.as_string());
+            continue;
+        }
+
+        std::unique_ptr<EAMetadata> metadata;
+
+        if (!read_announced_metadata(entry, metadata)) continue;
+
+        if (auto hash = register_scheme(activity_type, *metadata))
+        {
+            confirm_scheme(hash);
+            result.push_back(hash);
+        }
+    }
+
+    return result;
+}
+
+
+void SchemaRegistry::confirm_scheme(uint64_t hash)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    confirmed_.insert(hash);
+}
+
+
+bool SchemaRegistry::is_confirmed(uint64_t hash) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    return confirmed_.count(hash) != 0;
+}
+
+
+bool SchemaRegistry::has_scheme(uint64_t hash) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    return schemes_by_hash_.count(hash) != 0;
+}
+
+
+std::vector<uint64_t> SchemaRegistry::get_hashes() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<uint64_t> result;
+
+    result.reserve(schemes_by_hash_.size());
+    for (const auto &scheme: schemes_by_hash_) result.push_back(scheme.first);
+
+    return result;
+}
+
+
+SchemaRegistry::SchemePtr SchemaRegistry::find(MessageType message_type, const String &name) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto schemes = schemes_.find(message_type);
+
+    if (schemes == schemes_.end()) return nullptr;
+
+    auto scheme = schemes->second.find(name);
+
+    return scheme != schemes->second.end() ? scheme->second : nullptr;
+}
+
+
+SchemaRegistry::SchemePtr SchemaRegistry::find(uint64_t hash) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto scheme = schemes_by_hash_.find(hash);
+
+    return scheme != schemes_by_hash_.end() ? scheme->second : nullptr;
+}
+
+} // namespace tsw
@@ -0,0 +1,96 @@
+/**
+  * @file schema_serializer.cpp
+  * @author Artiom N.(cl)2017
+  * @brief SchemaSerializer class implementation.
+  *
+  */
+
+#include <memory>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/schema_serializer.h>
+#include <tsw/types.h>
+#include <tsw/wire_format.h>
+
+#include "schema_impl.h"
+
+
+namespace tsw
+{
+
+using impl::CompiledScheme;
+
+
+SchemaSerializer::SchemaSerializer(std::shared_ptr<const SchemaRegistry> registry) :
+    SchemaSerializer(registry, std::make_shared<BsonSerializer>())
+{}
+
+
+SchemaSerializer::SchemaSerializer(std::shared_ptr<const SchemaRegistry> registry, std::shared_ptr<Serializer> fallback) :
+    registry_(registry), fallback_(fallback)
+{
+    TSW_ASSERT(registry_ != nullptr);
+    TSW_ASSERT(fallback_ != nullptr);
+}
+
+
+SchemaSerializer::~SchemaSerializer()
+{}
+
+
+BinData SchemaSerializer::SerializeMessage(const Message &message)
+{
+    BinData result;
+
+    SerializeMessageTo(message, result);
+
+    return result;
+}
+
+
+void SchemaSerializer::SerializeMessageTo(const Message &message, BinData &buffer)
+{
+    const auto &fields = message.get_fields();
+    auto name = fields.find(CompiledScheme::name_field);
+
+    // Compact layout has no deadline and identifier: message with them is sent by the fallback serializer.
+    if (!message.has_deadline() && !message.get_id() && name != fields.end() && name->second.is_string())
+    {
+        auto scheme = registry_->find(message.get_type(), name->second.as_string());
+
+        // Peer, which doesn't know the scheme, can't decode the compact frame.
+        if (scheme && registry_->is_confirmed(scheme->hash()) && scheme->encode(message, buffer)) return;
+    }
+
+    fallback_->SerializeMessageTo(message, buffer);
+}
+
+
+BinData SchemaSerializer::SerializeObject(const Object &fields)
+{
+    return fallback_->SerializeObject(fields);
+}
+
+
+std::unique_ptr<Serializer> SchemaSerializer::Clone() const
+{
+    std::shared_ptr<Serializer> fallback = fallback_->Clone();
+
+    if (!fallback) return nullptr;
+
+    return std::make_unique<SchemaSerializer>(registry_, fallback);
+}
+
+
+bool SchemaSerializer::Cloneable() const
+{
+    return fallback_->Cloneable();
+}
+
+
+WireFormat SchemaSerializer::Format() const
+{
+    return WireFormat::Schema;
+}
+
+} // namespace tsw
@@ -5,12 +5,41 @@
   *
   */
 
+#include <utility>
+
 #include <tsw/serializer.h>
 #include <tsw/types.h>
+#include <tsw/wire_format.h>
+
+#include "binary_message.h"
 
 
 namespace tsw
 {
 
+WireFormat Serializer::Format() const
+{
+    return WireFormat::Unknown;
+}
+
+
+void Serializer::SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer)
+{
+    NameValueMap collected;
+
+    write_object(fields, collected);
+
+    BinaryMessage message(envelope.get_type(), std::move(collected),
+                          envelope.get_receiver_module_uid(), String(envelope.get_receiver_module_name()),
+                          ModuleClass(envelope.get_receiver_module_class()),
+                          envelope.get_sender_module_uid(), String(envelope.get_sender_module_name()),
+                          ModuleClass(envelope.get_sender_module_class()),
+                          Time(envelope.get_creation_time()));
+
+    if (envelope.has_deadline()) message.set_deadline(envelope.get_deadline());
+    message.set_id(envelope.get_id());
+
+    SerializeMessageTo(message, buffer);
+}
 
 } // namespace tsw
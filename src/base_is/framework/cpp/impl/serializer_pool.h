@@ -0,0 +1,144 @@
+/**
+  * @file serializer_pool.h
+  * @author Artiom N.(cl)2017
+  * @brief SerializerPool class: reusable per-sender serialization contexts.
+  *
+  */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tsw/serializer.h"
+#include "tsw/types.h"
+#include "tsw/wire_format.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Pool of the serializer clones with their output buffers.
+ *
+ * Every sending thread takes own context, so serialization isn't serialized by a lock:
+ * mutex guards the free list only. Contexts are never destroyed until the pool is, so
+ * buffers keep their capacity and steady-state serialization doesn't allocate memory.
+ *
+ * If the prototype can't be cloned, it's shared between all senders under the lock.
+ */
+class SerializerPool
+{
+public:
+    struct Context
+    {
+        Serializer  *serializer;
+        BinData     buffer;
+        // Compressed buffer.
+        BinData     frame;
+
+    private:
+        friend class SerializerPool;
+        std::unique_ptr<Serializer> owned_serializer_;
+    };
+
+    class Lease
+    {
+    public:
+        Lease(Lease &&) = default;
+        ~Lease() { if (context_) pool_->release(std::move(context_)); }
+
+    public:
+        Context &operator*() const { return *context_; }
+        Context *operator->() const { return context_.get(); }
+
+    private:
+        friend class SerializerPool;
+        Lease(SerializerPool *pool, std::unique_ptr<Context> &&context, std::unique_lock<std::mutex> &&lock) :
+            pool_(pool), context_(std::move(context)), lock_(std::move(lock)) {}
+
+    private:
+        SerializerPool                  *pool_;
+        std::unique_ptr<Context>        context_;
+        // Locked for the non-cloneable prototype only.
+        std::unique_lock<std::mutex>    lock_;
+    };
+
+public:
+    explicit SerializerPool(std::shared_ptr<Serializer> prototype) :
+        prototype_(prototype), cloneable_(prototype->Cloneable()), format_(prototype->Format())
+    {
+    }
+
+public:
+    /**
+     * @brief Format of the serialized messages: WireFormat::Unknown, if it isn't recognized.
+     */
+    WireFormat format() const { return format_; }
+
+    Lease acquire()
+    {
+        std::unique_lock<std::mutex> shared_lock;
+        std::unique_ptr<Context> context;
+
+        if (!cloneable_) shared_lock = std::unique_lock<std::mutex>(shared_mutex_);
+
+        {
+            std::lock_guard<std::mutex> guard(free_mutex_);
+            if (!free_.empty())
+            {
+                context = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+
+        if (!context) context = create_context();
+
+        return Lease(this, std::move(context), std::move(shared_lock));
+    }
+
+private:
+    std::unique_ptr<Context> create_context()
+    {
+        auto context = std::make_unique<Context>();
+
+        if (cloneable_)
+        {
+            context->owned_serializer_ = prototype_->Clone();
+            context->serializer = context->owned_serializer_.get();
+        }
+        else
+        {
+            context->serializer = prototype_.get();
+        }
+
+        std::lock_guard<std::mutex> guard(free_mutex_);
+        // Place for the context return is reserved now: release() will not allocate.
+        free_.reserve(++contexts_count_);
+
+        return context;
+    }
+
+    void release(std::unique_ptr<Context> &&context)
+    {
+        std::lock_guard<std::mutex> guard(free_mutex_);
+        free_.push_back(std::move(context));
+    }
+
+private:
+    std::shared_ptr<Serializer>             prototype_;
+    const bool                              cloneable_;
+    const WireFormat                        format_;
+    std::mutex                              free_mutex_;
+    std::mutex                              shared_mutex_;
+    std::vector<std::unique_ptr<Context>>   free_;
+    size_t                                  contexts_count_ = 0;
+};
+
+} // namespace impl
+
+} // namespace tsw
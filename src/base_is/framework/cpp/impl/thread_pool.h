@@ -0,0 +1,126 @@
+/**
+  * @file thread_pool.h
+  * @author Artiom N.(cl)2017
+  * @brief ThreadPool class: fixed set of the worker threads with the common task queue.
+  *
+  */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace tsw
+{
+
+namespace impl
+{
+
+/**
+ * @brief Workers take the tasks in the posting order. Queued tasks are finished before the pool destruction.
+ */
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+public:
+    /**
+     * @param threads_count workers count, zero: hardware concurrency.
+     */
+    explicit ThreadPool(size_t threads_count = 0) : stopped_(false)
+    {
+        if (!threads_count) threads_count = std::max(std::thread::hardware_concurrency(), 2u);
+
+        for (size_t i = 0; i < threads_count; ++i) threads_.emplace_back(&ThreadPool::worker, this);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+
+        ready_.notify_all();
+        for (auto &thread: threads_) thread.join();
+    }
+
+public:
+    void post(Task &&task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+
+        ready_.notify_one();
+    }
+
+    size_t size() const { return threads_.size(); }
+
+    /**
+     * @brief Return true, if it's called from a worker of this pool: waiting for the pool tasks there may deadlock.
+     */
+    bool is_worker_thread() const { return current_pool() == this; }
+
+    /**
+     * @brief Pool, which is shared by the process.
+     */
+    static std::shared_ptr<ThreadPool> shared()
+    {
+        static auto pool = std::make_shared<ThreadPool>();
+
+        return pool;
+    }
+
+private:
+    static const ThreadPool *&current_pool()
+    {
+        static thread_local const ThreadPool *pool = nullptr;
+
+        return pool;
+    }
+
+    void worker()
+    {
+        current_pool() = this;
+
+        for (;;)
+        {
+            Task task;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+
+                ready_.wait(lock, [this]() { return stopped_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            task();
+        }
+    }
+
+private:
+    std::mutex                  mutex_;
+    std::condition_variable     ready_;
+    std::deque<Task>            tasks_;
+    bool                        stopped_;
+    std::vector<std::thread>    threads_;
+};
+
+} // namespace impl
+
+} // namespace tsw
@@ -0,0 +1,166 @@
+/**
+  * @file wire_format.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Wire formats helpers implementation.
+  *
+  */
+
+#include <algorithm>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/cbor_deserializer.h>
+#include <tsw/cbor_serializer.h>
+#include <tsw/envelope_deserializer.h>
+#include <tsw/envelope_serializer.h>
+#include <tsw/error.h>
+#include <tsw/json_deserializer.h>
+#include <tsw/json_serializer.h>
+#include <tsw/msgpack_deserializer.h>
+#include <tsw/msgpack_serializer.h>
+#include <tsw/schema_deserializer.h>
+#include <tsw/schema_serializer.h>
+#include <tsw/wire_format.h>
+
+#include "envelope_impl.h"
+#include "schema_impl.h"
+
+
+namespace tsw
+{
+
+const char *wire_format_name(WireFormat format)
+{
+    switch (format)
+    {
+        case WireFormat::Bson: return "bson";
+        case WireFormat::Json: return "json";
+        case WireFormat::MsgPack: return "msgpack";
+        case WireFormat::Cbor: return "cbor";
+        case WireFormat::Envelope: return "envelope";
+        case WireFormat::Schema: return "schema";
+        default: return "unknown";
+    }
+}
+
+
+WireFormat wire_format_from_name(const String &name)
+{
+    for (auto format: { WireFormat::Bson, WireFormat::Json, WireFormat::MsgPack, WireFormat::Cbor, WireFormat::Envelope,
+                        WireFormat::Schema })
+    {
+        if (name == wire_format_name(format)) return format;
+    }
+
+    return WireFormat::Unknown;
+}
+
+
+WireFormat detect_wire_format(const BinData::value_type *data, size_t size)
+{
+    if (!size) return WireFormat::Unknown;
+
+    if (size >= 5 && !data[size - 1])
+    {
+        uint32_t length = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+
+        if (length == size) return WireFormat::Bson;
+    }
+
+    EnvelopeHeader header;
+
+    if (read_envelope_header(data, size, header)) return WireFormat::Envelope;
+    if (impl::CompiledScheme::is_compact(data, size)) return WireFormat::Schema;
+
+    switch (data[0])
+    {
+        case 0xde: return WireFormat::MsgPack;
+        case 0xbf: return WireFormat::Cbor;
+        case '{': return WireFormat::Json;
+    }
+
+    return WireFormat::Unknown;
+}
+
+
+bool patch_message_uids(BinData::value_type *data, size_t size, UID sender_module_uid, UID receiver_module_uid)
+{
+    switch (detect_wire_format(data, size))
+    {
+        case WireFormat::Bson:
+        {
+            BsonView envelope(data, size);
+            const std::pair<const char*, UID> uids[] =
+            {
+                { "sender_m_uid", sender_module_uid },
+                { "receiver_m_uid", receiver_module_uid }
+            };
+
+            for (const auto &uid: uids)
+            {
+                auto value = data + envelope.int64_offset(uid.first);
+
+                for (size_t i = 0; i < sizeof(int64_t); ++i) value[i] = static_cast<BinData::value_type>(uid.second >> (8 * i));
+            }
+
+            return true;
+        }
+        case WireFormat::Envelope:
+            impl::patch_envelope_uids(data, sender_module_uid, receiver_module_uid);
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+std::shared_ptr<Serializer> make_serializer(WireFormat format, std::shared_ptr<const SchemaRegistry> registry)
+{
+    switch (format)
+    {
+        case WireFormat::Bson: return std::make_shared<BsonSerializer>();
+        case WireFormat::Json: return std::make_shared<JsonSerializer>(JsonStyle::Compact);
+        case WireFormat::MsgPack: return std::make_shared<MsgPackSerializer>();
+        case WireFormat::Cbor: return std::make_shared<CborSerializer>();
+        case WireFormat::Envelope: return std::make_shared<EnvelopeSerializer>();
+        case WireFormat::Schema:
+            if (!registry) TSW_THROW(Exception, "schema wire format needs the registry");
+            return std::make_shared<SchemaSerializer>(registry);
+        default: TSW_THROW(Exception, "unknown wire format");
+    }
+}
+
+
+std::shared_ptr<Deserializer> make_deserializer(WireFormat format, std::shared_ptr<const SchemaRegistry> registry)
+{
+    switch (format)
+    {
+        case WireFormat::Bson: return std::make_shared<BsonDeserializer>();
+        case WireFormat::Json: return std::make_shared<JsonDeserializer>();
+        case WireFormat::MsgPack: return std::make_shared<MsgPackDeserializer>();
+        case WireFormat::Cbor: return std::make_shared<CborDeserializer>();
+        case WireFormat::Envelope: return std::make_shared<EnvelopeDeserializer>();
+        case WireFormat::Schema:
+            if (!registry) TSW_THROW(Exception, "schema wire format needs the registry");
+            return std::make_shared<SchemaDeserializer>(registry);
+        default: TSW_THROW(Exception, "unknown wire format");
+    }
+}
+
+
+WireFormat choose_wire_format(const ValueArray &offered, const WireFormats &supported)
+{
+    for (const auto &name: offered)
+    {
+        if (!name.is_string()) continue;
+
+        auto format = wire_format_from_name(name.as_string());
+
+        if (format != WireFormat::Unknown &&
+            std::find(supported.begin(), supported.end(), format) != supported.end()) return format;
+    }
+
+    return WireFormat::Unknown;
+}
+
+} // namespace tsw
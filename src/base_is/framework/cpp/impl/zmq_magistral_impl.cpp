@@ -6,6 +6,8 @@
   */
 
 
+#include <cerrno>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -75,7 +77,7 @@ void tsw_zmq_dump(void *socket, int options)
 
 Magistral::MagistralImpl::MagistralImpl(const String& param_string ) :
     connection_string_(set_params_by_init_string(param_string)),
-    ZMQContext_(nullptr), ZMQSocket_(nullptr), recv_timeout_(-1), send_timeout_(-1)
+    ZMQContext_(nullptr), ZMQSocket_(nullptr), recv_timeout_(-1), send_timeout_(-1), failed_frames_(0)
 {
 
 }
@@ -134,24 +136,41 @@ void Magistral::MagistralImpl::deactivate()
 {
     reader_thread_active_ = false;
 
-    std::lock_guard<std::mutex> socket_guard(mutex_);
-    int rc;
+    SentNotices dropped;
 
-    if (ZMQSocket_)
     {
-        rc = zmq_close(ZMQSocket_);
-        ZMQSocket_ = nullptr;
-        TSW_ASSERT(rc == 0);
-    }
+        std::lock_guard<std::mutex> socket_guard(mutex_);
+        int rc;
 
-    if (ZMQContext_)
-    {
-        rc = zmq_ctx_shutdown(ZMQContext_);
-        TSW_ASSERT(rc == 0);
-        rc = zmq_ctx_term(ZMQContext_);
-        ZMQContext_ = nullptr;
-        TSW_ASSERT(rc == 0);
+        {
+            // Queued frames are dropped and reported to their senders, waiting senders are released.
+            std::lock_guard<std::mutex> queue_guard(queue_mutex_);
+            send_queues_.clear([this, &dropped](impl::LaneScheduler<QueuedFrame>::Entry &entry)
+            {
+                failed_frames_.fetch_add(1, std::memory_order_relaxed);
+                if (entry.frame.sent) dropped.emplace_back(std::move(entry.frame.sent), false);
+            });
+            queue_space_.notify_all();
+        }
+
+        if (ZMQSocket_)
+        {
+            rc = zmq_close(ZMQSocket_);
+            ZMQSocket_ = nullptr;
+            TSW_ASSERT(rc == 0);
+        }
+
+        if (ZMQContext_)
+        {
+            rc = zmq_ctx_shutdown(ZMQContext_);
+            TSW_ASSERT(rc == 0);
+            rc = zmq_ctx_term(ZMQContext_);
+            ZMQContext_ = nullptr;
+            TSW_ASSERT(rc == 0);
+        }
     }
+
+    notify_sent(dropped);
 }
 
 
@@ -191,36 +210,96 @@ const uint8_t *Magistral::MagistralImpl::read_id()
 }
 
 
-void Magistral::MagistralImpl::send_data(const BinData &data, int timeout)
+// Expired frame isn't sent: it's counted and dropped. Caller notifies the sender, when the locks are released.
+static bool drop_expired_frame(const QueuedFrame &frame)
+{
+    if (frame.deadline == Time::zero() || std::chrono::system_clock::now().time_since_epoch() < frame.deadline) return false;
+
+    if (frame.expired) frame.expired->fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+
+// Sent handlers may lock the outbox or the caller's state: they are called without the socket and queue locks.
+void Magistral::MagistralImpl::notify_sent(SentNotices &notices)
+{
+    for (auto &notice: notices) notice.first(notice.second);
+    notices.clear();
+}
+
+
+void Magistral::MagistralImpl::send_data(const BinData &data, int timeout, MessageLane lane,
+                                         Time deadline, std::atomic<uint64_t> *expired, SentHandler sent)
 {
     TSW_ASSERT(ZMQContext_ != nullptr);
     TSW_ASSERT(ZMQSocket_ != nullptr);
 
-    // Guard need to be there, before msg_to_send_ fill, because I can use this method
-    // from different threads.
-    std::lock_guard<std::mutex> socket_guard(mutex_);
-
     LOG_TO("magistral", LogLevel::Debug, "Data with size = %ld will be send during %ld ms...",
            data.size(), timeout);
 
-    zmq_msg_t zmsg;
+    const auto start = std::chrono::steady_clock::now();
+    // Frame is copied, before the socket will be locked.
+    QueuedFrame frame{ ZMQFrame(data), deadline, expired, std::move(sent) };
 
-//    if (zmq_msg_init_data(&zmsg, msg_to_send_.data(), msg_to_send_.size(), nullptr, nullptr) == -1)
-//    {
-//        // Not enough memory? Maybe cleaning data vector will help and I can to throw exception.
-//        msg_to_send_.clear();
-//        TSW_THROW(ZMQException);
-//    }
+    bool written = false;
 
-    // Another way, without global message buufer:
-    if (zmq_msg_init_size(&zmsg, data.size()) == -1)
     {
-        // Not enough memory? Maybe cleaning data vector will help and I can to throw exception.
-        msg_to_send_.clear();
-        TSW_THROW(ZMQException);
+        // Socket is free and nothing is queued: frame is sent by the caller.
+        std::unique_lock<std::mutex> socket_guard(mutex_, std::try_to_lock);
+
+        if (socket_guard.owns_lock())
+        {
+            std::unique_lock<std::mutex> queue_guard(queue_mutex_);
+
+            if (send_queues_.empty())
+            {
+                queue_guard.unlock();
+                send_locked(frame.frame, timeout);
+                written = true;
+            }
+        }
+    }
+
+    if (written)
+    {
+        latencies_[static_cast<size_t>(lane)].record(std::chrono::steady_clock::now() - start);
+        if (frame.sent) frame.sent(true);
+        return;
     }
-    memcpy(zmq_msg_data(&zmsg), data.data(), data.size());
 
+    // Socket is busy: frame waits in the lane queue, reader thread sends it.
+    std::unique_lock<std::mutex> queue_guard(queue_mutex_);
+    auto has_space = [this, lane]()
+    {
+        return send_queues_.size(lane) < max_queued_frames_ || !reader_thread_active_;
+    };
+
+    if (timeout < 0)
+    {
+        queue_space_.wait(queue_guard, has_space);
+    }
+    else if (!queue_space_.wait_for(queue_guard, std::chrono::milliseconds(timeout), has_space))
+    {
+        TSW_THROW(ZMQException, String("send queue of the ") + message_lane_name(lane) + " lane is full");
+    }
+
+    if (!reader_thread_active_) TSW_THROW(ZMQException, "magistral is not active");
+
+    // Frame became stale, while the sender was waiting.
+    if (drop_expired_frame(frame))
+    {
+        queue_guard.unlock();
+        if (frame.sent) frame.sent(false);
+        return;
+    }
+
+    send_queues_.push(lane, std::move(frame));
+}
+
+
+void Magistral::MagistralImpl::send_locked(ZMQFrame &frame, int timeout)
+{
     if (timeout != send_timeout_)
     {
         send_timeout_ = timeout;
@@ -230,28 +309,66 @@ void Magistral::MagistralImpl::send_data(const BinData &data, int timeout)
         }
     }
 
-    int msg_size = zmq_msg_size(&zmsg);
+    int msg_size = zmq_msg_size(frame.get());
 
-    /*zmq_pollitem_t poll_items[] =
+    if (zmq_msg_send(frame.get(), ZMQSocket_, 0) != msg_size)
     {
-        { ZMQSocket_, 0, ZMQ_POLLOUT, 0 }
-    };
+        TSW_THROW(ZMQException);
+    }
+
+    // I don't need to close message after successfull `zmq_msg_send` (man zmq_msg_send).
+}
 
-    int rc = 0;
-    while (!rc)
-    {
-        rc = zmq_poll(poll_items, sizeof(poll_items) / sizeof(zmq_pollitem_t), 1000);
-        std::cout << "rc = " << rc << std::endl;
-        if (rc > 0) break;
-        if (rc < 0) throw ZMQException();
-    }*/
 
-    if (zmq_msg_send(&zmsg, ZMQSocket_, 0) != msg_size)
+void Magistral::MagistralImpl::send_queued(SentNotices &notices)
+{
+    std::unique_lock<std::mutex> queue_guard(queue_mutex_);
+    MessageLane lane;
+    bool sent = false;
+
+    while (send_queues_.next(lane))
     {
-        TSW_THROW(ZMQException);
+        auto &entry = send_queues_.front(lane);
+
+        // Stale frame is dropped and doesn't delay the fresh ones.
+        if (drop_expired_frame(entry.frame))
+        {
+            if (entry.frame.sent) notices.emplace_back(std::move(entry.frame.sent), false);
+        }
+        else
+        {
+            if (zmq_msg_send(entry.frame.frame.get(), ZMQSocket_, ZMQ_DONTWAIT) < 0)
+            {
+                // Peer doesn't take more frames now: the rest will be sent on the next cycle.
+                if (zmq_errno() == EAGAIN)
+                {
+                    send_queues_.refund(lane);
+                    break;
+                }
+
+                LOG_TO("magistral", LogLevel::Error, "Frame of the %s lane was not sent: %s",
+                       message_lane_name(lane), zmq_strerror(zmq_errno()));
+                failed_frames_.fetch_add(1, std::memory_order_relaxed);
+                if (entry.frame.sent) notices.emplace_back(std::move(entry.frame.sent), false);
+            }
+            else
+            {
+                if (entry.frame.sent) notices.emplace_back(std::move(entry.frame.sent), true);
+                latencies_[static_cast<size_t>(lane)].record(std::chrono::steady_clock::now() - entry.queued);
+            }
+        }
+
+        send_queues_.pop(lane);
+        sent = true;
     }
 
-    // I don't need to close message after successfull `zmq_msg_send` (man zmq_msg_send).
+    if (sent) queue_space_.notify_all();
+}
+
+
+LatencyHistogram Magistral::MagistralImpl::get_latency(MessageLane lane) const
+{
+    return latencies_[static_cast<size_t>(lane)].histogram();
 }
 
 
@@ -267,40 +384,57 @@ Magistral::MagistralImpl::RecvHandler Magistral::MagistralImpl::get_recv_handler
 }
 
 
-void Magistral::MagistralImpl::recv_multipart(zmq_msg_t &zmsg)
+void Magistral::MagistralImpl::set_part_handler(PartHandler handler)
 {
-    BinData serialized_message;
-    int recv_res = 0;
+    part_handler_ = handler;
+}
 
-    serialized_message.clear();
 
-    do
+void Magistral::MagistralImpl::recv_multipart(zmq_msg_t &zmsg, BinData &serialized_message)
+{
+    bool more = true;
+
+    // First part is already received by the reader.
+    while (more)
     {
-        recv_res = zmq_msg_recv(&zmsg, ZMQSocket_, ZMQ_DONTWAIT);
+        more = zmq_msg_more(&zmsg) && reader_thread_active_;
 
-        if (recv_res > 0)
+        if (part_handler_)
+        {
+            // Part keeps the ZeroMQ message memory: it isn't copied.
+            received_parts_.emplace_back();
+            zmq_msg_move(received_parts_.back().get(), &zmsg);
+        }
+        else
         {
             auto zs = zmq_msg_size(&zmsg);
             auto zd = static_cast<const BinData::value_type*>(zmq_msg_data(&zmsg));
+
             serialized_message.insert(serialized_message.end(), zd, zd + zs);
         }
-        else if (recv_res == 0)
-        {
-            // Router probe.
-            //LOG_TO("magistral", LogLevel::Debug, "Router probe from a client with id = %d", zmq_client_id_);
-        }
-        else // res < 0, error.
+
+        if (more && zmq_msg_recv(&zmsg, ZMQSocket_, ZMQ_DONTWAIT) < 0)
         {
             TSW_THROW(ZMQException);
         }
-    } while(recv_res > 0 && zmq_msg_more(&zmsg) && reader_thread_active_);
+    }
 
     //LOG_TO("magistral", LogLevel::Debug, "Multipart message size = %d from a client with id = %d",
     //       serialized_message.size(), client_id);
-    if (serialized_message.size() && recv_handler_)
+}
+
+
+void Magistral::MagistralImpl::pass_parts()
+{
+    for (size_t i = 0; i < received_parts_.size(); ++i)
     {
-        recv_handler_(serialized_message);
+        auto part = received_parts_[i].get();
+
+        if (!part_handler_(static_cast<const BinData::value_type*>(zmq_msg_data(part)), zmq_msg_size(part),
+                           i + 1 == received_parts_.size())) break;
     }
+
+    received_parts_.clear();
 }
 
 
@@ -310,6 +444,7 @@ void Magistral::MagistralImpl::reader_thread_func()
 
     zmq_msg_t zmsg;
     int recv_res = 0;
+    SentNotices sent_notices;
 
     try
     {
@@ -318,12 +453,14 @@ void Magistral::MagistralImpl::reader_thread_func()
         while (reader_thread_active_)
         {
             socket_guard.lock();
+            send_queued(sent_notices);
 
             int rc = zmq_poll(&poll_item, 1, zmq_poll_delay);
 
             if (!rc)
             {
                 socket_guard.unlock();
+                notify_sent(sent_notices);
                 std::this_thread::yield();
                 continue;
             }
@@ -347,6 +484,8 @@ void Magistral::MagistralImpl::reader_thread_func()
             std::shared_ptr<zmq_msg_t> message_guard(&zmsg, zmq_msg_close);
 
             recv_res = zmq_msg_recv(&zmsg, ZMQSocket_, ZMQ_DONTWAIT);
+            received_.clear();
+            received_parts_.clear();
 
             if (!zmq_msg_more(&zmsg))
             {
@@ -359,7 +498,7 @@ void Magistral::MagistralImpl::reader_thread_func()
                         size_t size = zmq_msg_size(&zmsg);
                         LOG_TO("magistral", LogLevel::Debug, "0x%x received %ld bytes of data from a client with id = 0x%x",
                                (is_client_) ? "cln" : "srv", size, *client_id );
-                        if (!recv_handler_(BinData(data, data + size))) break;
+                        received_.assign(data, data + size);
                     }
                 }
                 else if (recv_res == 0)
@@ -376,9 +515,14 @@ void Magistral::MagistralImpl::reader_thread_func()
             {
                 // It's multipart message. Seldom case.
                 LOG_TO("magistral", LogLevel::Debug, "Multipart message was received from a client with id = 0x%x...", *client_id);
-                recv_multipart(zmsg);
+                recv_multipart(zmsg, received_);
             }
             socket_guard.unlock();
+            notify_sent(sent_notices);
+
+            // Handlers decode the message and may send a reply: socket is not locked.
+            if (!received_parts_.empty()) pass_parts();
+            if (!received_.empty() && recv_handler_ && !recv_handler_(received_)) break;
         } // while
     }
     catch(std::exception &e)
@@ -388,6 +532,8 @@ void Magistral::MagistralImpl::reader_thread_func()
         LOG_TO("magistral", LogLevel::Critical, "Exception with a message: \"%s\"!", e.what());
     }
 
+    // Socket is unlocked: senders of the frames, written before the break, are notified.
+    notify_sent(sent_notices);
     if (reader_thread_active_) deactivate();
 }
 
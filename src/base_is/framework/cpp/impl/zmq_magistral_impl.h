@@ -10,18 +10,26 @@
 
 #include <array>
 #include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <zmq.h>
 
 #include <tsw/deserializer.h>
+#include <tsw/message_lanes.h>
 #include <tsw/serializer.h>
 #include <tsw/types.h>
 
+#include "lane_scheduler.h"
+
 
 namespace tsw
 {
@@ -43,10 +51,57 @@ public:
 };
 
 
+//----------------------------------------------------------------------------
+// ZMQFrame
+//----------------------------------------------------------------------------
+
+// Frame, which waits in the send queue.
+class ZMQFrame
+{
+public:
+    ZMQFrame() { zmq_msg_init(&message_); }
+    explicit ZMQFrame(const BinData &data)
+    {
+        if (zmq_msg_init_size(&message_, data.size()) == -1) TSW_THROW(ZMQException);
+        memcpy(zmq_msg_data(&message_), data.data(), data.size());
+    }
+    ZMQFrame(ZMQFrame &&other)
+    {
+        zmq_msg_init(&message_);
+        zmq_msg_move(&message_, &other.message_);
+    }
+    ZMQFrame(const ZMQFrame&) = delete;
+    ~ZMQFrame() { zmq_msg_close(&message_); }
+
+public:
+    zmq_msg_t *get() { return &message_; }
+
+private:
+    zmq_msg_t message_;
+};
+
+
+// Queued frame with the deadline of its message.
+struct QueuedFrame
+{
+    ZMQFrame                frame;
+    // Zero: frame is sent, whenever the socket will be free.
+    Time                    deadline;
+    // Counter of the expired messages with the frame type or nullptr.
+    std::atomic<uint64_t>   *expired;
+    // Called once: with true, when the frame has been written to the socket, with false, when it was dropped.
+    std::function<void(bool written)> sent;
+};
+
+
 class Magistral::MagistralImpl
 {
 public:
     typedef std::function<bool(const BinData& message)> RecvHandler;
+    typedef std::function<bool(const BinData::value_type* data, size_t size, bool last)> PartHandler;
+    typedef std::function<void(bool written)> SentHandler;
+    // Senders of the written or dropped frames, which are notified after the locks releasing.
+    typedef std::vector<std::pair<SentHandler, bool>> SentNotices;
 
 public:
     MagistralImpl(const String& param_string );
@@ -72,9 +127,24 @@ public:
      * @param fields
      * @param timeout
      * @param receiver_module_uid
-     * @return response, received from the magistral
+     * @param deadline frame, which is queued until the deadline, is dropped and counted in the expired.
+     * @param sent handler, which is called once, if send_data() doesn't throw: with true, when the frame
+     * has been written to the socket, with false, when it was dropped (queued send failed, deactivation, expiry).
+     * @throw ZMQException, if the frame isn't written and can't be queued.
+     */
+    void send_data(const BinData& dat, int timeout, MessageLane lane = MessageLane::Data,
+                   Time deadline = Time::zero(), std::atomic<uint64_t> *expired = nullptr,
+                   SentHandler sent = nullptr);
+
+    /**
+     * @brief Return histogram of the time from the send_data() call to the socket write.
+     */
+    LatencyHistogram get_latency(MessageLane lane) const;
+
+    /**
+     * @brief Return count of the queued frames, which weren't written: send error or deactivation.
      */
-    void send_data(const BinData& dat, int timeout);
+    uint64_t get_failed_count() const { return failed_frames_.load(std::memory_order_relaxed); }
 
     /**
      * @brief Set user message handler.
@@ -88,12 +158,21 @@ public:
      */
     RecvHandler get_recv_handler() const;
 
+    /**
+     * @brief Set handler of the multipart messages parts. Parts are not concatenated, if it's set.
+     * @param handler
+     */
+    void set_part_handler(PartHandler handler);
+
     bool active() const { return reader_thread_active_; }
 
 private:
     // ZeroMQ client identifier size (ROUTER/DEALER pattern).
     static const int max_zmq_id_size_ = 255;
 
+    // Frames in the lane queue, after which senders wait.
+    static const size_t max_queued_frames_ = 1024;
+
 private:
     String set_params_by_init_string(const String &s);
     int create_client();
@@ -102,7 +181,14 @@ private:
 
 private:
     void reader_thread_func();
-    void recv_multipart(zmq_msg_t &zmsg);
+    // Send queued frames by the lanes priority. Socket must be locked.
+    void send_queued(SentNotices &notices);
+    void send_locked(ZMQFrame &frame, int timeout);
+    // Receive the rest of the parts: they are concatenated or kept for the part handler.
+    void recv_multipart(zmq_msg_t &zmsg, BinData &serialized_message);
+    // Pass the kept parts to the part handler. Socket isn't locked.
+    void pass_parts();
+    static void notify_sent(SentNotices &notices);
 
 private:
     bool is_client_;
@@ -116,11 +202,23 @@ private:
     int send_timeout_;
 
     RecvHandler recv_handler_;
+    PartHandler part_handler_;
+    // Received message, which is passed to the handler after the socket unlocking.
+    BinData received_;
+    // Received parts of the multipart message, which are passed to the part handler after the socket unlocking.
+    std::vector<ZMQFrame> received_parts_;
     std::promise<void> reader_promise_;
 
     BinData msg_to_send_;
     std::mutex mutex_;
 
+    // Frames, which were sent, while the socket was busy. Queues are guarded by the queue_mutex_.
+    impl::LaneScheduler<QueuedFrame> send_queues_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_space_;
+    std::array<impl::LatencyRecorder, message_lanes_count> latencies_;
+    std::atomic<uint64_t> failed_frames_;
+
     std::thread reader_thread_;
 };
 
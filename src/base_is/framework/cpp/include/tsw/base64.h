@@ -8,6 +8,8 @@
 #ifndef _TSW_BASE64_H
 #define _TSW_BASE64_H
 
+#include <vector>
+
 #include "types.h"
 
 namespace tsw
@@ -33,6 +35,16 @@ inline BinData from_base64(const BinData::value_type* data, size_t size) { retur
 inline BinData from_base64(const BinData &data) { return from_base64(reinterpret_cast<const char*>(data.data()), data.size()); }
 inline BinData from_base64(const String &data) { return from_base64(data.c_str(), data.size()); }
 
+/// Codec implementation, which is used: "avx2", "sse4.1", "neon" or "scalar".
+const char *base64_engine();
+/// Implementations, which are supported by the CPU, from the fastest.
+std::vector<String> base64_engines();
+/**
+ * @brief Use another implementation, i.e. for the comparison. The fastest one is used by default.
+ * @return false, if the implementation is not supported.
+ */
+bool set_base64_engine(const String &name);
+
 }
 
 #endif // _TSW_BASE64_H
@@ -33,6 +33,8 @@ public:
     Object DeserializeObject(const BinData &data) override;
     Message DeserializeMessage(const BinData::value_type *data, size_t size) override;
     Object DeserializeObject(const BinData::value_type *data, size_t size) override;
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size) override;
+    void DeserializeMessageTo(const BinData::value_type *data, size_t size, Message &message) override;
 
 private:
     std::unique_ptr<impl::BsonDeserializerImpl> bsrec_;
@@ -32,6 +32,11 @@ public:
 public:
     BinData SerializeMessage(const Message &message) override;
     BinData SerializeObject(const Object &fields) override;
+    void SerializeMessageTo(const Message &message, BinData &buffer) override;
+    void SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer) override;
+    std::unique_ptr<Serializer> Clone() const override;
+    bool Cloneable() const override { return true; }
+    WireFormat Format() const override;
 
 private:
     std::unique_ptr<impl::BsonSerializerImpl> bsrec_;
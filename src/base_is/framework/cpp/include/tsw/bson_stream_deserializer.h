@@ -0,0 +1,149 @@
+/**
+  * @file bson_stream_deserializer.h
+  * @author Artiom N.(cl)2017
+  * @brief Incremental BSON message deserializer.
+  *
+  */
+
+#ifndef _TSW_BSON_STREAM_DESERIALIZER_H
+#define _TSW_BSON_STREAM_DESERIALIZER_H
+
+#include <cstdint>
+
+#include "message.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief Receiver of the message parts, decoded by the BsonStreamDeserializer.
+ *
+ * Calls for one message go in the order: envelope, fields and binary chunks in the serialized order, end.
+ */
+class StreamHandler
+{
+public:
+    /**
+     * @brief Message envelope is decoded.
+     * @param envelope message without fields.
+     */
+    virtual void on_envelope(const Message &envelope) = 0;
+
+    /**
+     * @brief Top-level message field is completely received.
+     */
+    virtual void on_field(const String &name, Value &&value) = 0;
+
+    /**
+     * @brief Next part of the large binary field, which is not buffered by the deserializer.
+     * @param name field name.
+     * @param data chunk data, valid only during the call.
+     * @param size chunk size.
+     * @param offset chunk offset in the field data.
+     * @param total_size field data size.
+     */
+    virtual void on_binary_chunk(const String &name, const BinData::value_type *data, size_t size,
+                                 size_t offset, size_t total_size) = 0;
+
+    /**
+     * @brief Message is completely received.
+     */
+    virtual void on_message_end() = 0;
+
+public:
+    virtual ~StreamHandler() = default;
+};
+
+
+/**
+ * @brief Push deserializer of the BSON messages, which accepts data in arbitrary chunks.
+ *
+ * Only the current incomplete element is buffered: memory doesn't depend on the message size.
+ * Binary fields larger than the streaming threshold are passed to the handler as they arrive.
+ * Several messages may follow each other in the stream.
+ */
+class BsonStreamDeserializer
+{
+public:
+    // Binary fields from this size are streamed.
+    static constexpr size_t default_stream_threshold = 64 * 1024;
+    // Limit of the buffered element size.
+    static constexpr size_t default_max_element_size = 16 * 1024 * 1024;
+
+public:
+    explicit BsonStreamDeserializer(StreamHandler &handler, size_t stream_threshold = default_stream_threshold,
+                                    size_t max_element_size = default_max_element_size);
+
+public:
+    /**
+     * @brief Decode the next chunk of the stream. Handler is called for every completed part.
+     * @note Incomplete message is dropped on the decoding or handler error.
+     */
+    void feed(const BinData::value_type *data, size_t size);
+    void feed(const BinData &data) { feed(data.data(), data.size()); }
+
+    /**
+     * @brief Check, that the stream ends on the message boundary.
+     * Deserializer is reset in any case.
+     */
+    void finish();
+
+    /**
+     * @brief Drop the incomplete message.
+     */
+    void reset();
+
+    /**
+     * @brief Return true, if the message is started, but not finished.
+     */
+    bool in_message() const { return state_ != State::DocumentSize || !element_.empty(); }
+
+private:
+    enum class State
+    {
+        DocumentSize,
+        FieldsSize,
+        ElementType,
+        ElementName,
+        ValueSize,
+        Value,
+        BinaryChunks
+    };
+
+private:
+    bool fill(size_t target_size, const BinData::value_type *&data, size_t &size);
+    void start_element_value();
+    void start_value(size_t value_size);
+    void finish_element();
+    void finish_document();
+    void send_envelope();
+
+private:
+    StreamHandler &handler_;
+    const size_t stream_threshold_;
+    const size_t max_element_size_;
+
+    State state_;
+    // Current element: type, name and the value, if it's not streamed.
+    BinData element_;
+    // Value offset in the element and the complete element size.
+    size_t value_offset_;
+    size_t element_size_;
+    // Stream position from the message start.
+    size_t position_;
+    size_t document_end_;
+    size_t fields_end_;
+    bool in_fields_;
+
+    Object envelope_;
+
+    String binary_name_;
+    size_t binary_offset_;
+    size_t binary_size_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_BSON_STREAM_DESERIALIZER_H
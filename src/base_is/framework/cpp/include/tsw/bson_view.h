@@ -0,0 +1,105 @@
+/**
+  * @file bson_view.h
+  * @author Artiom N.(cl)2017
+  * @brief BsonView class definition.
+  *
+  */
+
+#ifndef _TSW_BSON_VIEW_H
+#define _TSW_BSON_VIEW_H
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief The BsonView class, implements lazy read-only access to a BSON document.
+ *
+ * View doesn't decode the document on creation: every field is found and decoded on demand,
+ * so the caller, which needs a couple of fields, doesn't pay for the whole NameValueMap.
+ * Scalar getters and sub-document views don't allocate memory.
+ *
+ * @note
+ * View doesn't own the buffer, buffer must outlive the view.
+ * Field search is linear, call build_index() before multiple lookups in a large document.
+ */
+class BsonView
+{
+public:
+    BsonView() : data_(nullptr), size_(0) {}
+    BsonView(const BinData::value_type *data, size_t size);
+    explicit BsonView(const BinData &data) : BsonView(data.data(), data.size()) {}
+
+public:
+    const BinData::value_type   *data() const { return data_; }
+    size_t                      size() const { return size_; }
+    bool                        empty() const;
+
+public:
+    bool                has_field(const char *name) const;
+
+    /**
+     * @brief Return type of the field, as it will be returned by the get_value().
+     * @param name field name.
+     * @return field type or ValueType::Undefined, if field doesn't exist.
+     */
+    ValueType           field_type(const char *name) const;
+
+    bool                as_bool(const char *name) const;
+    double              as_double(const char *name) const;
+    int32_t             as_int32(const char *name) const;
+    int64_t             as_int64(const char *name) const;
+    std::string_view    as_string(const char *name) const;
+    Time                as_time(const char *name) const;
+    BinData             as_bindata(const char *name) const;
+    DoubleArray         as_double_array(const char *name) const;
+    Int32Array          as_int32_array(const char *name) const;
+
+    /**
+     * @brief Return view of the embedded object or array.
+     */
+    BsonView            as_view(const char *name) const;
+
+    /**
+     * @brief Return offset of the int64 field value from the document start: fixed-width value may be patched in place.
+     */
+    size_t              int64_offset(const char *name) const;
+
+    /**
+     * @brief Decode one field.
+     * @return field value or Undefined, if field doesn't exist.
+     */
+    Value               get_value(const char *name) const;
+
+    /**
+     * @brief Decode the whole document.
+     */
+    NameValueMap        to_object() const;
+
+public:
+    /**
+     * @brief Build offsets index of the top-level fields to speed up the subsequent lookups.
+     */
+    void build_index();
+
+private:
+    const BinData::value_type *find(const char *name) const;
+    const BinData::value_type *find_existing(const char *name) const;
+
+private:
+    typedef std::pair<std::string_view, const BinData::value_type*> IndexEntry;
+
+    const BinData::value_type   *data_;
+    size_t                      size_;
+    std::vector<IndexEntry>     index_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_BSON_VIEW_H
@@ -0,0 +1,44 @@
+/**
+  * @file cbor_deserializer.h
+  * @author Artiom N.(cl)2017
+  * @brief CborDeserializer class definition.
+  *
+  */
+
+#ifndef _TSW_CBOR_DESERIALIZER_H
+#define _TSW_CBOR_DESERIALIZER_H
+
+#include <memory>
+
+#include "deserializer.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+class CborDeserializerImpl;
+}
+
+class CborDeserializer : public Deserializer
+{
+public:
+    CborDeserializer();
+    ~CborDeserializer();
+
+public:
+    Message DeserializeMessage(const BinData &data) override;
+    Object DeserializeObject(const BinData &data) override;
+    Message DeserializeMessage(const BinData::value_type *data, size_t size) override;
+    Object DeserializeObject(const BinData::value_type *data, size_t size) override;
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size) override;
+
+private:
+    std::unique_ptr<impl::CborDeserializerImpl> impl_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_CBOR_DESERIALIZER_H
@@ -0,0 +1,50 @@
+/**
+  * @file cbor_serializer.h
+  * @author Artiom N.(cl)2017
+  * @brief CborSerializer class definition.
+  *
+  */
+
+#ifndef _TSW_CBOR_SERIALIZER_H
+#define _TSW_CBOR_SERIALIZER_H
+
+#include <memory>
+
+#include "message.h"
+#include "serializer.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+template<typename Encoder> class CompactSerializerImpl;
+struct CborEncoder;
+}
+
+/**
+ * @brief CBOR serializer: compact binary format with the full Value types coverage.
+ */
+class CborSerializer: public Serializer
+{
+public:
+    CborSerializer();
+    ~CborSerializer();
+
+public:
+    BinData SerializeMessage(const Message &message) override;
+    BinData SerializeObject(const Object &fields) override;
+    void SerializeMessageTo(const Message &message, BinData &buffer) override;
+    std::unique_ptr<Serializer> Clone() const override;
+    bool Cloneable() const override { return true; }
+    WireFormat Format() const override;
+
+private:
+    std::unique_ptr<impl::CompactSerializerImpl<impl::CborEncoder>> impl_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_CBOR_SERIALIZER_H
@@ -0,0 +1,115 @@
+/**
+  * @file compression.h
+  * @author Artiom N.(cl)2017
+  * @brief Magistral frames compression and its negotiation helpers.
+  *
+  */
+
+#ifndef _TSW_COMPRESSION_H
+#define _TSW_COMPRESSION_H
+
+#include <memory>
+#include <vector>
+
+#include "error.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief Error of the frame compression or decompression: corrupted frame, unknown dictionary.
+ */
+class CompressionException : public Exception
+{
+    using Exception::Exception;
+};
+
+
+enum class Compression : uint8_t
+{
+    None,
+    Lz4,
+    Zstd
+};
+
+
+typedef std::vector<Compression> Compressions;
+
+
+/// Compression name, used in the handshake.
+const char *compression_name(Compression compression);
+/// @return compression or Compression::None.
+Compression compression_from_name(const String &name);
+
+/// Compressions, which are built in the library.
+Compressions supported_compressions();
+
+/**
+ * @brief Choose compression for the peer: the first offered one, which is supported.
+ * @param offered compression names in the peer's preference order.
+ * @return compression or Compression::None.
+ */
+Compression choose_compression(const ValueArray &offered, const Compressions &supported);
+
+/**
+ * @brief Default dictionary: serialized message envelope keys in the BSON and JSON forms.
+ */
+const BinData &default_compression_dictionary();
+
+
+/**
+ * @brief Compressor of the Magistral frames.
+ *
+ * Compressed frame starts with the header: "TZ", flags byte with the compression and the dictionary bit,
+ * 0xff (BSON document can't start so), uint32 source size and uint32 dictionary identifier, if dictionary is used.
+ * Both sides must have the same dictionary. Compressor may be used from several threads at once.
+ */
+class FrameCompressor
+{
+public:
+    // Frames, which are less, are sent as is.
+    static constexpr size_t default_threshold = 512;
+    // Frames, which are larger after decompression, are rejected: the same limit, as of the chunked transfer.
+    static constexpr size_t default_max_frame_size = 256 * 1024 * 1024;
+
+public:
+    explicit FrameCompressor(Compression compression = Compression::None, size_t threshold = default_threshold,
+                             const BinData &dictionary = default_compression_dictionary(),
+                             size_t max_frame_size = default_max_frame_size);
+    ~FrameCompressor();
+
+public:
+    Compression get_compression() const { return compression_; }
+
+    /**
+     * @brief Compress the frame, if it's not less than the threshold and compression decreases it.
+     * @return true, if output contains compressed frame.
+     */
+    bool compress(const BinData::value_type *data, size_t size, BinData &output) const;
+    bool compress(const BinData &data, BinData &output) const { return compress(data.data(), data.size(), output); }
+
+    /**
+     * @brief Decompress frame with any supported compression.
+     * @throw CompressionException, if the frame is corrupted or its declared size exceeds the maximum frame size.
+     */
+    void decompress(const BinData::value_type *data, size_t size, BinData &output) const;
+
+    static bool is_compressed(const BinData::value_type *data, size_t size);
+
+private:
+    struct Dictionaries;
+
+private:
+    const Compression compression_;
+    const size_t threshold_;
+    const size_t max_frame_size_;
+    const BinData dictionary_;
+    const uint32_t dictionary_id_;
+    std::unique_ptr<Dictionaries> dictionaries_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_COMPRESSION_H
@@ -8,6 +8,10 @@
 #ifndef _TSW_DESERIALIZER_H
 #define _TSW_DESERIALIZER_H
 
+#include <memory>
+#include <string_view>
+
+#include "bson_view.h"
 #include "message.h"
 #include "types.h"
 
@@ -23,11 +27,35 @@ public:
     virtual Message DeserializeMessage(const BinData::value_type *data, size_t size) = 0;
     virtual Object DeserializeObject(const BinData::value_type *data, size_t size) = 0;
 
+    /**
+     * @brief Return type of the serialized message, used for the routing.
+     * @note Default implementation deserializes the whole message.
+     */
+    virtual MessageType DeserializeMessageType(const BinData::value_type *data, size_t size);
+
+    /**
+     * @brief Deserialize message into the existing one: recycled message keeps its memory.
+     * @note Default implementation replaces the message with the deserialized one.
+     */
+    virtual void DeserializeMessageTo(const BinData::value_type *data, size_t size, Message &message);
+
 public:
     virtual ~Deserializer() = default;
 
 protected:
     Message MessageFromObject(Object &&obj);
+    Message MessageFromView(const BsonView &envelope, std::shared_ptr<BinData> buffer);
+    // Copy the BSON message into the buffer of the message and refill it in place.
+    void AssignMessageFromView(const BinData::value_type *data, size_t size, Message &message);
+    // Unshared buffer of the message, which is refilled: previous fields are dropped.
+    BinData &RecycleBuffer(Message &message);
+    // Strings are assigned, not replaced: their capacity is kept.
+    void AssignEnvelope(Message &message, MessageType message_type,
+                        UID receiver_module_uid, std::string_view receiver_module_name,
+                        std::string_view receiver_module_class,
+                        UID sender_module_uid, std::string_view sender_module_name,
+                        std::string_view sender_module_class,
+                        Time creation_time, Time deadline, UID message_id, const BsonView &fields_view);
 };
 
 } // namespace tsw
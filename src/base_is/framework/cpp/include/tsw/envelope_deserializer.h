@@ -0,0 +1,55 @@
+/**
+  * @file envelope_deserializer.h
+  * @author Artiom N.(cl)2017
+  * @brief EnvelopeDeserializer class definition.
+  *
+  */
+
+#ifndef _TSW_ENVELOPE_DESERIALIZER_H
+#define _TSW_ENVELOPE_DESERIALIZER_H
+
+#include <memory>
+
+#include "deserializer.h"
+#include "envelope_header.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+class BsonDeserializerImpl;
+}
+
+/**
+ * @brief Deserializer of the messages with the fixed binary header.
+ *
+ * Message type is read from the header, fields are decoded lazily from the BSON body.
+ */
+class EnvelopeDeserializer : public Deserializer
+{
+public:
+    /**
+     * @param names names, which the peer doesn't write inline, or nullptr.
+     */
+    explicit EnvelopeDeserializer(std::shared_ptr<const EnvelopeNames> names = nullptr);
+    ~EnvelopeDeserializer();
+
+public:
+    Message DeserializeMessage(const BinData &data) override;
+    Object DeserializeObject(const BinData &data) override;
+    Message DeserializeMessage(const BinData::value_type *data, size_t size) override;
+    Object DeserializeObject(const BinData::value_type *data, size_t size) override;
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size) override;
+    void DeserializeMessageTo(const BinData::value_type *data, size_t size, Message &message) override;
+
+private:
+    std::shared_ptr<const EnvelopeNames> names_;
+    std::unique_ptr<impl::BsonDeserializerImpl> bsrec_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_ENVELOPE_DESERIALIZER_H
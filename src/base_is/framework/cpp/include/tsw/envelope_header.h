@@ -0,0 +1,113 @@
+/**
+  * @file envelope_header.h
+  * @author Artiom N.(cl)2017
+  * @brief Fixed binary envelope header: layout, peeking and interned names.
+  *
+  */
+
+#ifndef _TSW_ENVELOPE_HEADER_H
+#define _TSW_ENVELOPE_HEADER_H
+
+#include <map>
+#include <shared_mutex>
+#include <string_view>
+
+#include "message.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief Message envelope, read from the fixed header without touching the body.
+ *
+ * Frame layout (all numbers are little-endian):
+ * @code
+ * "TE" version:u8 0xff type:u16 flags:u16
+ * sender_uid:u64 receiver_uid:u64 c_time:i64
+ * sender_name_id:u32 sender_class_id:u32 receiver_name_id:u32 receiver_class_id:u32
+ * body_offset:u32 body_size:u32
+ * deadline:i64, if flags have HasDeadline
+ * message_id:u64, if flags have HasId
+ * inline names (u16 length + bytes), which flags mark
+ * body: message fields as the BSON document
+ * @endcode
+ * Name is written inline, unless it's interned in the serializer's EnvelopeNames.
+ */
+struct EnvelopeHeader
+{
+    // Flags of the names, which follow the header.
+    enum : uint16_t
+    {
+        InlineSenderName = 0x01,
+        InlineSenderClass = 0x02,
+        InlineReceiverName = 0x04,
+        InlineReceiverClass = 0x08,
+        HasDeadline = 0x10,
+        HasId = 0x20
+    };
+
+    // Version 2: optional deadline and message identifier.
+    static constexpr uint8_t current_version = 2;
+    static constexpr size_t size = 56;
+
+    uint8_t     version;
+    uint16_t    flags;
+    MessageType type;
+    UID         sender_uid;
+    UID         receiver_uid;
+    Time        creation_time;
+    // Zero, if message has no deadline.
+    Time        deadline;
+    // Zero, if message has no identifier.
+    UID         message_id;
+    uint32_t    sender_name_id;
+    uint32_t    sender_class_id;
+    uint32_t    receiver_name_id;
+    uint32_t    receiver_class_id;
+    uint32_t    body_offset;
+    uint32_t    body_size;
+};
+
+
+/**
+ * @brief Read header of the frame.
+ * @return false, if frame isn't an enveloped message or is truncated.
+ */
+bool read_envelope_header(const BinData::value_type *data, size_t size, EnvelopeHeader &header);
+
+/**
+ * @brief Identifier of the module name or class: routers compare identifiers, not strings.
+ * @return 32-bit FNV-1a hash or 0 for the empty name.
+ */
+uint32_t envelope_name_id(std::string_view name);
+
+
+/**
+ * @brief Names, interned by both sides: they are sent as identifiers only.
+ *
+ * Registry may be used from several threads.
+ */
+class EnvelopeNames
+{
+public:
+    /**
+     * @brief Intern the name.
+     * @throw Exception, if other name has the same identifier.
+     */
+    uint32_t add(const String &name);
+
+    /**
+     * @return name or nullptr, if it's not interned.
+     */
+    const String *find(uint32_t id) const;
+
+private:
+    mutable std::shared_mutex       mutex_;
+    std::map<uint32_t, String>      names_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_ENVELOPE_HEADER_H
@@ -0,0 +1,58 @@
+/**
+  * @file envelope_serializer.h
+  * @author Artiom N.(cl)2017
+  * @brief EnvelopeSerializer class definition.
+  *
+  */
+
+#ifndef _TSW_ENVELOPE_SERIALIZER_H
+#define _TSW_ENVELOPE_SERIALIZER_H
+
+#include <memory>
+
+#include "envelope_header.h"
+#include "serializer.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+class BsonSerializerImpl;
+}
+
+/**
+ * @brief Serializer, which writes the envelope as a fixed binary header and fields as the BSON body.
+ *
+ * Routers read the header only, see EnvelopeHeader. Objects are serialized to BSON.
+ */
+class EnvelopeSerializer: public Serializer
+{
+public:
+    /**
+     * @param names names, which aren't written inline, or nullptr.
+     */
+    explicit EnvelopeSerializer(std::shared_ptr<const EnvelopeNames> names = nullptr);
+    ~EnvelopeSerializer();
+
+public:
+    BinData SerializeMessage(const Message &message) override;
+    BinData SerializeObject(const Object &fields) override;
+    void SerializeMessageTo(const Message &message, BinData &buffer) override;
+    void SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer) override;
+    std::unique_ptr<Serializer> Clone() const override;
+    bool Cloneable() const override { return true; }
+    WireFormat Format() const override;
+
+private:
+    std::shared_ptr<const EnvelopeNames> names_;
+    std::unique_ptr<impl::BsonSerializerImpl> bsrec_;
+    // Body is encoded here and appended after the header.
+    BinData body_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_ENVELOPE_SERIALIZER_H
@@ -12,6 +12,7 @@
 #include <memory>
 
 #include "event.h"
+#include "handler_execution.h"
 #include "magistral.h"
 #include "metadata.h"
 #include "types.h"
@@ -73,6 +74,27 @@ public:
     */
    void generate_event(const Module &module, const String& event_name, NameValueMap fields);
 
+   /**
+    * @brief Call the event subscribers by the execution policy.
+    * @param module module, which generated the event. Handlers, which aren't joined, get its copy.
+    * @param event
+    */
+   void dispatch_event(Module &module, const Event& event);
+
+   /**
+    * @brief Set the subscribers execution: sequential or concurrent on the shared thread pool.
+    * Must be called before the events dispatching.
+    * @param policy
+    */
+   void set_execution_policy(const HandlerExecutionPolicy& policy);
+
+   /**
+    * @brief Return timings of the event subscribers.
+    * @param module
+    * @param event_name
+    */
+   HandlerTimings get_handler_timings(const Module &module, const String& event_name) const;
+
 private:
    class EventControllerImpl;
    std::unique_ptr<EventControllerImpl> controller_;
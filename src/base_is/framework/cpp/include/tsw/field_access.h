@@ -0,0 +1,106 @@
+/**
+  * @file field_access.h
+  * @author Artiom N.(cl)2017
+  * @brief FieldWriter and FieldReader interfaces: direct fields encoding without Value.
+  *
+  */
+
+#ifndef _TSW_FIELD_ACCESS_H
+#define _TSW_FIELD_ACCESS_H
+
+#include <functional>
+
+#include "bson_view.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+class FieldWriter;
+class FieldReader;
+class Message;
+
+typedef std::function<void(FieldWriter &writer)> FieldsWriter;
+typedef std::function<void(FieldReader &reader)> FieldsReader;
+
+
+/**
+ * @brief Format independent fields encoder.
+ */
+class FieldWriter
+{
+public:
+    virtual ~FieldWriter() = default;
+
+public:
+    virtual void write(const char *name, bool data) = 0;
+    virtual void write(const char *name, int32_t data) = 0;
+    virtual void write(const char *name, int64_t data) = 0;
+    virtual void write(const char *name, double data) = 0;
+    virtual void write(const char *name, const String &data) = 0;
+    virtual void write(const char *name, const BinData &data) = 0;
+    virtual void write(const char *name, const Time &data) = 0;
+    virtual void write(const char *name, const DoubleArray &data) = 0;
+    virtual void write(const char *name, const Int32Array &data) = 0;
+    virtual void write(const char *name, const Value &data) = 0;
+
+    // Prevent the pointer to bool conversion.
+    void write(const char *name, const String::value_type *data) { write(name, String(data)); }
+
+    virtual void start_object(const char *name) = 0;
+    virtual void finish_object() = 0;
+};
+
+
+/**
+ * @brief Format independent fields decoder.
+ *
+ * Read methods return false, if field is absent, and throw, if field has another type.
+ * Integer field is read into the wider integer or double: text formats don't keep the integer width.
+ */
+class FieldReader
+{
+public:
+    virtual ~FieldReader() = default;
+
+public:
+    virtual bool read(const char *name, bool &data) = 0;
+    virtual bool read(const char *name, int32_t &data) = 0;
+    virtual bool read(const char *name, int64_t &data) = 0;
+    virtual bool read(const char *name, double &data) = 0;
+    virtual bool read(const char *name, String &data) = 0;
+    virtual bool read(const char *name, BinData &data) = 0;
+    virtual bool read(const char *name, Time &data) = 0;
+    virtual bool read(const char *name, DoubleArray &data) = 0;
+    virtual bool read(const char *name, Int32Array &data) = 0;
+    virtual bool read(const char *name, Value &data) = 0;
+
+    virtual bool read_object(const char *name, const FieldsReader &reader) = 0;
+};
+
+
+/// Write fields as a BSON document.
+void write_bson(const FieldsWriter &fields, BinData &buffer);
+/// Read fields from the BSON document.
+void read_bson(const BsonView &document, const FieldsReader &fields);
+
+/// Write fields as a JSON object.
+void write_json(const FieldsWriter &fields, BinData &buffer);
+/// Read fields from the JSON object.
+void read_json(const BinData::value_type *data, size_t size, const FieldsReader &fields);
+
+void write_object(const FieldsWriter &fields, Object &object);
+void read_object(const Object &object, const FieldsReader &fields);
+
+/**
+ * @brief Read message fields, if the message "name" field is equal to the name.
+ *
+ * Received BSON messages are read from the buffer, without fields decoding.
+ * @return false, if message has another name.
+ */
+bool read_message(const Message &message, const char *name, const FieldsReader &fields);
+
+} // namespace tsw
+
+#endif // _TSW_FIELD_ACCESS_H
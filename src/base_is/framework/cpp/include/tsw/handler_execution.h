@@ -0,0 +1,65 @@
+/**
+  * @file handler_execution.h
+  * @author Artiom N.(cl)2017
+  * @brief Execution policy of the activity handlers and their timing.
+  *
+  */
+
+#ifndef _TSW_HANDLER_EXECUTION_H
+#define _TSW_HANDLER_EXECUTION_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "latency_histogram.h"
+
+
+namespace tsw
+{
+
+enum class HandlerExecution : uint8_t
+{
+    // Handlers are called one by one in the caller's thread.
+    Sequential,
+    // Handlers are called concurrently on the shared thread pool, caller waits for them.
+    Join,
+    // Handlers are called concurrently on the shared thread pool, caller doesn't wait (fire-and-forget).
+    Detach
+};
+
+
+struct HandlerExecutionPolicy
+{
+    HandlerExecution            execution = HandlerExecution::Sequential;
+    // Join: caller waits not longer, unfinished handlers are counted late and finish in the pool. Negative: no limit.
+    std::chrono::milliseconds   join_timeout{-1};
+    // Pool calls of one handler, which may run at once. Further calls are skipped: slow handler
+    // doesn't take all pool threads from the others. Zero: no limit.
+    size_t                      max_handler_calls = 1;
+};
+
+
+/**
+ * @brief Timing of the handler calls.
+ */
+struct HandlerTiming
+{
+    uint64_t                    calls = 0;
+    // Calls, which were skipped, because the handler was busy.
+    uint64_t                    skipped = 0;
+    // Calls, which weren't finished until the join timeout.
+    uint64_t                    late = 0;
+    // Calls, which threw an exception.
+    uint64_t                    failed = 0;
+    std::chrono::nanoseconds    total_time{0};
+    std::chrono::nanoseconds    max_time{0};
+    LatencyHistogram            histogram;
+};
+
+/// Timings of the activity handlers in the subscription order.
+typedef std::vector<HandlerTiming> HandlerTimings;
+
+} // namespace tsw
+
+#endif // _TSW_HANDLER_EXECUTION_H
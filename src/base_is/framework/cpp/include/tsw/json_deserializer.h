@@ -31,6 +31,13 @@ public:
     Object DeserializeObject(const BinData &data) override;
     Message DeserializeMessage(const BinData::value_type *data, size_t size) override;
     Object DeserializeObject(const BinData::value_type *data, size_t size) override;
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size) override;
+
+    /**
+     * @brief Deserialize in the buffer memory, which is modified: strings are not copied twice.
+     */
+    Message DeserializeMessageInsitu(BinData &data);
+    Object DeserializeObjectInsitu(BinData &data);
 
 private:
     std::unique_ptr<impl::JsonDeserializerImpl> jsrec_;
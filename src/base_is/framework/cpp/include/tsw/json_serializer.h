@@ -9,6 +9,7 @@
 #define _TSW_JSON_SERIALIZER_H
 
 #include <memory>
+#include <ostream>
 
 #include "message.h"
 #include "serializer.h"
@@ -23,16 +24,40 @@ namespace impl
 struct JsonSerializerImpl;
 }
 
+/// Pretty JSON is for humans, compact is for the other programs.
+enum class JsonStyle
+{
+    Pretty,
+    Compact
+};
+
+
 class JsonSerializer: public Serializer
 {
-    JsonSerializer();
+public:
+    explicit JsonSerializer(JsonStyle style = JsonStyle::Pretty);
     ~JsonSerializer();
 
 public:
     BinData SerializeMessage(const Message &message) override;
     BinData SerializeObject(const Object &fields) override;
+    void SerializeMessageTo(const Message &message, BinData &buffer) override;
+    void SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer) override;
+    std::unique_ptr<Serializer> Clone() const override;
+    bool Cloneable() const override { return true; }
+    WireFormat Format() const override;
+
+    /**
+     * @brief Write document to the stream by chunks, without the whole document in the memory.
+     */
+    void SerializeMessageTo(const Message &message, std::ostream &stream);
+    void SerializeObjectTo(const Object &fields, std::ostream &stream);
+
+public:
+    JsonStyle get_style() const { return style_; }
 
 private:
+    JsonStyle style_;
     std::unique_ptr<impl::JsonSerializerImpl> jsrec_;
 };
 
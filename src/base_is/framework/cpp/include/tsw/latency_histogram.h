@@ -0,0 +1,45 @@
+/**
+  * @file latency_histogram.h
+  * @author Artiom N.(cl)2017
+  * @brief LatencyHistogram struct: latencies of the lanes and of the handlers.
+  *
+  */
+
+#ifndef _TSW_LATENCY_HISTOGRAM_H
+#define _TSW_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace tsw
+{
+
+/**
+ * @brief Histogram of the latencies: time from the sending call to the socket write, handler run time.
+ *
+ * Bucket 0 counts latencies less than 1 us, bucket i counts latencies in [2^(i-1), 2^i) us,
+ * the last bucket counts all larger ones.
+ */
+struct LatencyHistogram
+{
+    static constexpr size_t buckets_count = 24;
+
+    std::array<uint64_t, buckets_count> buckets{};
+
+    uint64_t count() const;
+
+    /**
+     * @brief Return upper bound of the bucket, which contains the percentile.
+     * @param percentile value in [0, 100].
+     */
+    std::chrono::microseconds percentile(double percentile) const;
+
+    static size_t bucket(std::chrono::nanoseconds latency);
+};
+
+} // namespace tsw
+
+#endif // _TSW_LATENCY_HISTOGRAM_H
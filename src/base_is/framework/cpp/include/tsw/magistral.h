@@ -8,11 +8,16 @@
 #ifndef _TSW_MAGISTRAL_H
 #define _TSW_MAGISTRAL_H
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <list>
 #include <map>
 #include <memory>
-#include <list>
+#include <vector>
 
 #include "deserializer.h"
+#include "field_access.h"
 #include "message.h"
 #include "serializer.h"
 #include "types.h"
@@ -21,6 +26,44 @@
 namespace tsw
 {
 
+// Declared only: users include the headers of the features, which they use.
+class BsonStreamDeserializer;
+class FrameCompressor;
+class MessageCapture;
+class MessageOutbox;
+class SchemaRegistry;
+class StreamHandler;
+struct LatencyHistogram;
+
+enum class Compression : uint8_t;
+enum class MessageLane : uint8_t;
+enum class WireFormat;
+
+typedef std::vector<Compression> Compressions;
+typedef std::vector<WireFormat> WireFormats;
+
+namespace impl
+{
+class DuplicateFilter;
+class MessagePool;
+class SerializerPool;
+class TransferAssembler;
+}
+
+
+/**
+ * @brief State of the chunked message sending, which allows to resume it after the error.
+ */
+struct ChunkedTransfer
+{
+    // Zero: identifier will be generated on the first sending.
+    UID transfer_id = 0;
+    // Identifier, given to the message without it, when the outbox is set. Resumed transfer keeps it.
+    UID message_id = 0;
+    // Count of the frames, which were written to the socket.
+    size_t sent_frames = 0;
+};
+
 /**
  * @brief The Magistral class, implements main bus for modules communication.
  *
@@ -35,38 +78,92 @@ namespace tsw
 class Magistral
 {
 public:
-    /**
-     * @brief Magistral class constructor
-     * @param magistral_param_string string, consisting of two parts as follows:<br>
-     *   `type:transport://address` (similar to ZeroMQ endpoint string).<br>
-     *   transport: tcp, ipc.<br>
-     *   type: client, server.
-     * @param serializer serializer to create binary data from a message.
-     * @param parser parser to deserialize binary data to a message.
-     * @code
-     * Magistral m("client:tcp://localhost:12345");
-     * Magistral magistral("server:ipc:///tmp/feeds/0");
-     * @endcode
-     */
-    Magistral(const String& magistral_param_string, bool activate_on_creation,
-              std::shared_ptr<Serializer> serializer, std::shared_ptr<Deserializer> deserializer);
-    Magistral(const String& magistral_param_string, bool activate_on_creation = true);
-    Magistral() = delete;
-    Magistral(Magistral& magistral) = delete;
-    virtual ~Magistral();
+   /**
+    * @brief Magistral class constructor
+    * @param magistral_param_string string, consisting of two parts as follows:<br>
+    *   `type:transport://address` (similar to ZeroMQ endpoint string).<br>
+    *   transport: tcp, ipc.<br>
+    *   type: client, server.
+    * @param serializer serializer to create binary data from a message.
+    * @param parser parser to deserialize binary data to a message.
+    * @code
+    * Magistral m("client:tcp://localhost:12345");
+    * Magistral magistral("server:ipc:///tmp/feeds/0");
+    * @endcode
+    */
+   Magistral(const String& magistral_param_string, bool activate_on_creation,
+             std::shared_ptr<Serializer> serializer, std::shared_ptr<Deserializer> deserializer);
+   Magistral(const String& magistral_param_string, bool activate_on_creation = true);
+   Magistral() = delete;
+   Magistral(Magistral& magistral) = delete;
+   virtual ~Magistral();
 
 public:
-    void activate();
-    void deactivate();
-    bool active() const;
+   void activate();
+   void deactivate();
+   bool active() const;
+
+   // Default size of the chunk frame data.
+   static constexpr size_t default_chunk_size = 1024 * 1024;
 
    /**
     * @brief Send message and block until respond will be received or timeout exceed.
+    * Message with binary fields larger than the chunk size is sent by chunks.
+    * Message with the deadline is dropped, if it's expired before the sending or while it's queued.
+    *
+    * Call returns, when the frame is written to the socket or queued. Queued frame, which isn't written
+    * later (send error or deactivation), is logged and counted by the get_failed_count(): with the outbox
+    * it's kept there and resent.
     * @param msg
     * @param timeout
+    * @throw ZMQException, if the frame isn't written and can't be queued: queue is full until the timeout,
+    * magistral isn't active.
     */
    void send_message(const Message& msg, int timeout = -1);
 
+   /**
+    * @brief Relay the received message to the receiver without re-serialization.
+    *
+    * Received frame is sent in its format, only the receiver UID in it is replaced: fields aren't
+    * decoded and encoded again. Message, which doesn't keep its frame (it was created locally,
+    * reassembled from chunks or received as JSON, MessagePack or CBOR), or frame in another format,
+    * than the sent messages have, is serialized as usual.
+    * @param msg received message.
+    * @param receiver_module_uid new receiver or -1 for the subscribers.
+    * @param timeout
+    */
+   void forward_message(const Message& msg, UID receiver_module_uid, int timeout = -1);
+
+   /**
+    * @brief Send message by frames: head with the small fields, then chunks of the large binary fields.
+    *
+    * Every frame is sent separately, so another messages are interleaved with the chunks.
+    * Receiver reassembles the message or passes the chunks to the stream handler.
+    * Call returns, when all frames are written to the socket.
+    * @param msg
+    * @param transfer transfer state: after the error the same message is resent from the first frame,
+    * which wasn't written. Queued frames, which were dropped by the deactivation, are resent too.
+    * @param timeout
+    * @throw ZMQException, if any frame wasn't written.
+    */
+   void send_chunked(const Message& msg, ChunkedTransfer& transfer, int timeout = -1);
+
+   /**
+    * @brief Send the already serialized message, for example, the captured one.
+    * Frame is compressed and queued, as usual.
+    * @param message_type
+    * @param frame uncompressed frame in any accepted wire format.
+    * @param timeout
+    */
+   void send_serialized(MessageType message_type, const BinData& frame, int timeout = -1);
+
+   /**
+    * @brief Set size of the chunk frame data. Binary fields, which are larger, are sent by chunks.
+    * @param chunk_size
+    */
+   void set_chunk_size(size_t chunk_size);
+   size_t get_chunk_size() const;
+
    /**
     * @brief Send message and block until respond will be received or timeout exceed.
     * @param message_type
@@ -86,6 +183,123 @@ public:
    void send_message(const MessageType message_type, NameValueMap&& fields, UID receiver_module_uid, int timeout = -1);
    void send_message(const MessageType message_type, const NameValueMap& fields, UID receiver_module_uid, int timeout = -1);
 
+   /**
+    * @brief Send message with the directly written fields.
+    *
+    * Message is sent as by the send_message(): expired one is dropped, it gets the identifier, when the outbox
+    * is set, and the frame, which has the binary fields larger than the chunk size, is sent by chunks.
+    * @param envelope message without fields: its type, receiver, deadline and identifier are sent.
+    * @param fields
+    * @param timeout
+    */
+   void send_fields(const Message& envelope, const FieldsWriter& fields, int timeout = -1);
+   void send_fields(const MessageType message_type, UID receiver_module_uid, const FieldsWriter& fields,
+                    int timeout = -1);
+
+   /**
+    * @brief Send TSW_MESSAGE struct: fields are encoded without the NameValueMap.
+    * @param message
+    * @param message_type
+    * @param receiver_module_uid
+    * @param timeout
+    */
+   template<typename T>
+   void send(const T& message, const MessageType message_type = MessageType::Event,
+             UID receiver_module_uid = -1, int timeout = -1)
+   {
+       send(message, Message(message_type, NameValueMap(), receiver_module_uid), timeout);
+   }
+
+   /**
+    * @brief Send TSW_MESSAGE struct with the envelope: type, receiver, deadline and identifier of the message.
+    * @param message
+    * @param envelope message without fields.
+    * @param timeout
+    */
+   template<typename T>
+   void send(const T& message, const Message& envelope, int timeout = -1)
+   {
+       send_typed(envelope, T::message_name, [&message](FieldWriter& writer) { write_fields(writer, message); }, timeout);
+   }
+
+   /**
+    * @brief Add handler of the TSW_MESSAGE struct.
+    * Messages with another name are passed to the next handlers.
+    * @param handler
+    * @param message_type
+    */
+   template<typename T>
+   void on(std::function<bool(const T&)> handler, const MessageType message_type = MessageType::Event)
+   {
+       add_message_handler(message_type, [handler](const Message& message)
+       {
+           T typed;
+
+           if (!read_message(message, T::message_name,
+                             [&typed](FieldReader& reader) { read_fields(reader, typed); })) return true;
+
+           return handler(typed);
+       });
+   }
+
+   /**
+    * @brief Set formats, which are accepted from the peer and may be chosen for sending.
+    *
+    * Received messages in these formats are decoded by the format's deserializer,
+    * other ones by the Magistral deserializer. Must be called before the activation.
+    * @param formats formats in the preference order.
+    */
+   void set_wire_formats(const WireFormats& formats);
+
+   /**
+    * @brief Set schemes of the WireFormat::Schema.
+    *
+    * Schemes of the received activity announcements are registered in it and the denounced ones are removed.
+    * Activities are sent compact only by the schemes, which the peer has confirmed: in the negotiation reply or
+    * in the reply to the announcement. Must be called before the set_wire_formats().
+    * @param registry registry or nullptr to use the schema format nowhere.
+    */
+   void set_schema_registry(std::shared_ptr<SchemaRegistry> registry);
+   std::shared_ptr<SchemaRegistry> get_schema_registry() const;
+
+   /**
+    * @brief Offer wire formats and compressions to the peer.
+    *
+    * Peer replies with the chosen format and compression, then this side sends with them. Each side negotiates
+    * its own sending format, so the peer without negotiation support keeps the current one. Registered schemes
+    * are offered too: peer confirms the ones, which it knows.
+    * @param timeout
+    */
+   void negotiate_wire_format(int timeout = -1);
+
+   /**
+    * @brief Set compressions, which may be offered to the peer and chosen for it.
+    * Received frames are decompressed with any supported compression. Must be called before the activation.
+    * @param compressions compressions in the preference order.
+    * @param threshold frames, which are less, are not compressed: FrameCompressor::default_threshold by default.
+    */
+   void set_compressions(const Compressions& compressions);
+   void set_compressions(const Compressions& compressions, size_t threshold);
+
+   /**
+    * @brief Set dictionary for the compression. Both sides must use the same one.
+    * Must be called before the activation.
+    * @param dictionary dictionary or empty data to compress without it.
+    */
+   void set_compression_dictionary(const BinData& dictionary);
+
+   /**
+    * @brief Switch compression of the sent frames.
+    * @param compression
+    */
+   void use_compression(Compression compression);
+
+   /**
+    * @brief Switch format of the sent messages.
+    * @param format
+    */
+   void use_wire_format(WireFormat format);
+
    /**
     * @brief Add user message handler.
     * @param handler
@@ -100,6 +314,88 @@ public:
    void remove_message_handler(MessageHandler handler);
    void remove_message_handler(MessageType message_type, MessageHandler handler);
 
+   /**
+    * @brief Set handler of the multipart BSON messages.
+    *
+    * Parts are decoded as they arrive, without concatenation: large binary fields are passed
+    * to the handler in chunks. Messages, sent by chunks, are passed to it too.
+    * Message handlers don't get these messages.
+    * Must be called before the activation.
+    * @param handler handler or nullptr to concatenate parts, as usual.
+    */
+   void set_stream_handler(std::shared_ptr<StreamHandler> handler);
+
+   /**
+    * @brief Set priority lane of the sent messages with the type.
+    *
+    * While the socket is busy, frames wait in the queues of their lanes. Queues are sent by the
+    * weighted round robin, control lane first: health checks aren't delayed by the queued events.
+    * Must be called before the activation.
+    * @param message_type
+    * @param lane
+    */
+   void set_message_lane(MessageType message_type, MessageLane lane);
+   MessageLane get_message_lane(MessageType message_type) const;
+
+   /**
+    * @brief Return histogram of the time from the sending call to the socket write for the lane.
+    */
+   LatencyHistogram get_lane_latency(MessageLane lane) const;
+
+   /**
+    * @brief Return count of the messages with the type, which were dropped after their deadline.
+    *
+    * Sent messages are dropped before the serialization and in the send queue,
+    * received ones before the handlers call.
+    */
+   uint64_t get_expired_count(MessageType message_type) const;
+
+   /**
+    * @brief Return count of the queued frames, which weren't written: send error or deactivation.
+    */
+   uint64_t get_failed_count() const;
+
+   /**
+    * @brief Keep the sent frames in the persistent outbox, until they are written to the socket.
+    *
+    * Frame is committed to the outbox before the sending: if the peer is down, it's kept and resent
+    * on the activation or by the replay_outbox(). Sent messages get identifiers and the receiver drops
+    * the duplicates, so the delivery is at-least-once, but messages are handled once.
+    * Message without identifier, passed to the send_message(), gets it in the serialized frame.
+    * @param outbox outbox or nullptr to send without it.
+    */
+   void set_outbox(std::shared_ptr<MessageOutbox> outbox);
+
+   /**
+    * @brief Resend frames, which are kept in the outbox.
+    * Replay is stopped on the first failed sending. Expired frames are dropped.
+    * @param timeout
+    * @return count of the resent frames.
+    */
+   size_t replay_outbox(int timeout = -1);
+
+   /**
+    * @brief Return count of the received duplicates, which were dropped.
+    */
+   uint64_t get_duplicate_count() const;
+
+   /**
+    * @brief Return count of the received frames, which were dropped, because they can't be decompressed or decoded.
+    */
+   uint64_t get_corrupted_count() const;
+
+   /**
+    * @brief Write the sent and received frames into the capture.
+    *
+    * Frames are written uncompressed with the time of the sending or the receiving call, so they may be
+    * replayed by the CaptureReplayer. Multipart messages, passed to the stream handler, aren't captured.
+    * @param capture capture or nullptr to stop the capturing.
+    */
+   void set_capture(std::shared_ptr<MessageCapture> capture);
+
+   // Timeout of the outbox replay on the activation, in milliseconds.
+   static constexpr int outbox_replay_timeout = 1000;
+
    /**
     * @brief Return default message handler.
     * @return message handler address.
@@ -109,12 +405,63 @@ public:
 private:
    bool default_recv_handler(const BinData& reply);
    bool default_message_handler(const Message& reply);
+   bool dispatch_message(const Message& message);
+   // Send the TSW_MESSAGE fields after the message name field.
+   void send_typed(const Message& envelope, const char* message_name, const FieldsWriter& fields, int timeout);
+   // Sent handler gets the write status of the frame, see MagistralImpl::send_data().
+   void send_frame(const Message& msg, int timeout, std::function<void(bool written)> sent = nullptr);
+   void send_buffer(MessageType message_type, const Time& deadline, const BinData& buffer, BinData& frame, int timeout,
+                    std::function<void(bool written)> sent = nullptr);
+   void send_compressed(MessageType message_type, const Time& deadline, const BinData& buffer, BinData& frame,
+                        int timeout, std::function<void(bool written)> sent);
+   // Send the frame, committed to the outbox. It's acknowledged, when it's written to the socket.
+   bool send_logged(const std::shared_ptr<MessageOutbox>& outbox, MessageType message_type, const Time& deadline,
+                    uint64_t sequence, const BinData& buffer, BinData& frame, int timeout,
+                    std::function<void(bool written)> sent = nullptr);
+   // Send the message without identifier, giving it the new one.
+   void send_identified(const Message& msg, int timeout);
+   // Give identifier to the new message, if it may be resent.
+   void identify(Message& msg);
+   UID next_message_id();
+   // Count the expired message.
+   bool drop_expired(const Message& msg);
+   bool stream_part_handler(const BinData::value_type* data, size_t size, bool last);
 
 private:
    class MagistralImpl;
    std::shared_ptr<Serializer> serializer_;
    std::shared_ptr<Deserializer> deserializer_;
+   // Serializer clones for the concurrent senders. Pool is replaced atomically, when the format is switched.
+   std::shared_ptr<impl::SerializerPool> send_contexts_;
+   WireFormats wire_formats_;
+   std::shared_ptr<SchemaRegistry> schema_registry_;
+   std::map<WireFormat, std::shared_ptr<Deserializer>> format_deserializers_;
+   Compressions compressions_;
+   size_t compression_threshold_;
+   BinData compression_dictionary_;
+   // Compressors are replaced atomically: sending one, when the compression is switched,
+   // receiving one, when the dictionary is changed, while the reader thread decompresses.
+   std::shared_ptr<FrameCompressor> compressor_;
+   std::shared_ptr<FrameCompressor> decompressor_;
+   BinData decompressed_;
    std::map<MessageType, std::list<MessageHandler>> message_handlers_;
+   std::array<MessageLane, static_cast<size_t>(MessageType::ZLast)> message_lanes_;
+   std::array<std::atomic<uint64_t>, static_cast<size_t>(MessageType::ZLast)> expired_messages_{};
+   // Outbox is replaced atomically: it's used by the senders and the reader thread.
+   std::shared_ptr<MessageOutbox> outbox_;
+   // Capture is replaced atomically: it's written by the senders and the reader thread.
+   std::shared_ptr<MessageCapture> capture_;
+   // Identifiers of the sent messages start from a random number: they don't repeat after the restart.
+   std::atomic<UID> message_ids_;
+   std::unique_ptr<impl::DuplicateFilter> duplicates_;
+   std::atomic<uint64_t> duplicate_messages_;
+   std::atomic<uint64_t> corrupted_frames_;
+   // Received messages are recycled: handlers, which keep them, call Message::retain().
+   std::shared_ptr<impl::MessagePool> received_messages_;
+   std::shared_ptr<StreamHandler> stream_handler_;
+   std::unique_ptr<BsonStreamDeserializer> stream_deserializer_;
+   size_t chunk_size_;
+   std::unique_ptr<impl::TransferAssembler> transfer_assembler_;
    std::unique_ptr<MagistralImpl> magistral_;
 };
 
@@ -8,9 +8,15 @@
 #ifndef _TSW_MESSAGE_H
 #define _TSW_MESSAGE_H
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <type_traits>
 
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
+#include "bson_view.h"
 #include "module.h"
 #include "types.h"
 
@@ -37,6 +43,8 @@ enum class MessageType : uint16_t
     SubscribeToEvents,
     SystemStarted,
     UnsubscribeFromEvents,
+    // Frame of the chunked message transfer, handled by the Magistral.
+    DataTransfer,
     ZLast
 };
 
@@ -44,6 +52,13 @@ enum class MessageType : uint16_t
 class Magistral;
 class Message;
 typedef std::function<bool(const Message& message)> MessageHandler;
+/// Reference to the message, which is kept after the handler call.
+typedef boost::intrusive_ptr<const Message> MessagePtr;
+
+namespace impl
+{
+class MessagePool;
+}
 
 
 class Message
@@ -59,8 +74,15 @@ public:
             const String& receiver_module_name);
     Message(const MessageType message_type, const NameValueMap& fields,
             const String& receiver_module_name);
+    // Fields are moved with the message: deserializers return messages by value.
+    Message(const Message&) = default;
+    Message(Message&&) = default;
     virtual ~Message();
 
+    // References of the assigned message are kept.
+    Message& operator=(const Message&) = default;
+    Message& operator=(Message&&) = default;
+
 public:
    const Time&          get_creation_time() const;
    const MessageType&   get_type() const;
@@ -72,6 +94,54 @@ public:
    const ModuleClass&   get_receiver_module_class() const;
    const NameValueMap&  get_fields() const;
 
+   /**
+    * @brief Set identifier, which lets the receiver drop the duplicates of the resent message.
+    * @param id identifier or zero for the message without it.
+    */
+   void                 set_id(const UID& id);
+   const UID&           get_id() const;
+
+   /**
+    * @brief Set the time to live: message is dropped, if it's not delivered until the creation time plus TTL.
+    * @param ttl
+    */
+   void                 set_ttl(const Time& ttl);
+
+   /**
+    * @brief Set the absolute deadline: time since the epoch of the system clock, as the creation time.
+    * @param deadline deadline or zero to deliver the message whenever.
+    */
+   void                 set_deadline(const Time& deadline);
+   const Time&          get_deadline() const;
+   bool                 has_deadline() const;
+   bool                 is_expired() const;
+
+   /**
+    * @brief Return time, which is left to handle the message.
+    * @return zero, if message is expired, or Time::max(), if it has no deadline.
+    */
+   Time                 get_remaining_time() const;
+
+   /**
+    * @brief Return message fields without decoding.
+    * @return lazy view over the received buffer or empty view, if message wasn't received in the BSON form.
+    */
+   const BsonView&      get_fields_view() const;
+
+   /**
+    * @brief Return the received frame, which the message was decoded from.
+    * @return frame or nullptr, if message was created locally or received not in the BSON or envelope form.
+    */
+   const BinData*       get_received_frame() const;
+
+   /**
+    * @brief Take the reference to the message, which outlives the handler call.
+    *
+    * Received messages are pooled and reused after the dispatch: handler, which keeps a message,
+    * must take a reference. Message, which isn't reference counted, is copied.
+    */
+   MessagePtr           retain() const;
+
 protected:
    Message(const MessageType message_type, NameValueMap&& fields,
            const UID receiver_module_uid, String&& receiver_module_name,
@@ -85,22 +155,76 @@ protected:
            const UID sender_module_uid, const String& sender_module_name,
            const ModuleClass& sender_module_class,
            const Time& creation_time);
+   Message(const MessageType message_type, const BsonView& fields_view,
+           std::shared_ptr<BinData> fields_buffer,
+           const UID receiver_module_uid, String&& receiver_module_name,
+           ModuleClass&& receiver_module_class,
+           const UID sender_module_uid, String&& sender_module_name,
+           ModuleClass&& sender_module_class,
+           Time&& creation_time);
    void set_sender_module_uid(const UID& uid);
    void set_sender_module_name(const String& module_name);
    void set_sender_module_class(const ModuleClass& module_class);
 
 private:
-   const MessageType    message_type_;
+   friend class Deserializer;
+   friend class impl::MessagePool;
+   friend void intrusive_ptr_add_ref(const Message *message);
+   friend void intrusive_ptr_release(const Message *message);
+
+   // Intrusive references counter isn't copied with the message.
+   struct References
+   {
+       References() = default;
+       References(const References&) {}
+       References& operator=(const References&) { return *this; }
+
+       std::atomic<uint32_t>               count{0};
+       // Pool, which the message is returned to, or nullptr for the message in the heap.
+       std::shared_ptr<impl::MessagePool>  pool;
+   };
+
+   // Concurrent handlers may call get_fields() at once: fields are decoded under the lock once.
+   struct FieldsDecoding
+   {
+       FieldsDecoding(bool is_decoded) : decoded(is_decoded) {}
+       FieldsDecoding(const FieldsDecoding& other) : decoded(other.decoded.load(std::memory_order_acquire)) {}
+       FieldsDecoding& operator=(const FieldsDecoding& other)
+       {
+           decoded.store(other.decoded.load(std::memory_order_acquire), std::memory_order_release);
+           return *this;
+       }
+
+       std::atomic<bool>   decoded;
+       std::mutex          mutex;
+   };
+
+private:
+   MessageType          message_type_;
    UID                  sender_module_uid_;
    String               sender_module_name_;
    ModuleClass          sender_module_class_;
-   const UID            receiver_module_uid_;
-   const String         receiver_module_name_;
-   const ModuleClass    receiver_module_class_;
-   const Time           creation_time_;
-   const NameValueMap   fields_;
+   UID                  receiver_module_uid_;
+   String               receiver_module_name_;
+   ModuleClass          receiver_module_class_;
+   Time                 creation_time_;
+   // Zero: message has no deadline.
+   Time                 deadline_;
+   // Zero: message has no identifier.
+   UID                  id_;
+   // Fields of the received message are decoded on the first get_fields() call.
+   mutable NameValueMap fields_;
+   mutable FieldsDecoding fields_decoded_;
+   BsonView             fields_view_;
+   // Keeps buffer of the fields_view_ alive. Pooled message reuses it, if nobody else refers to it.
+   std::shared_ptr<BinData> fields_buffer_;
+   mutable References   references_;
 };
 
+
+void intrusive_ptr_add_ref(const Message *message);
+void intrusive_ptr_release(const Message *message);
+
 } // namespace tsw
 
 #endif //_MESSAGE_H
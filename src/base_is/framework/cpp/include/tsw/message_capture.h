@@ -0,0 +1,196 @@
+/**
+  * @file message_capture.h
+  * @author Artiom N.(cl)2017
+  * @brief Capture of the Magistral frames and its replay.
+  *
+  */
+
+#ifndef _TSW_MESSAGE_CAPTURE_H
+#define _TSW_MESSAGE_CAPTURE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+#include "message.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+enum class CaptureDirection : uint8_t
+{
+    Received = 0,
+    Sent = 1
+};
+
+
+/**
+ * @brief Captured frame: data points to the mapped capture file.
+ */
+struct CapturedFrame
+{
+    // Since the capture start.
+    std::chrono::nanoseconds        time;
+    CaptureDirection                direction;
+    MessageType                     type;
+    const BinData::value_type       *data;
+    size_t                          size;
+};
+
+
+/**
+ * @brief Writer of the captured frames into the memory-mapped file.
+ *
+ * Frames are serialized messages: sent ones before the compression, received ones after the decompression.
+ * File grows by segments and is truncated to the written size on the closing. After the crash
+ * zero tail of the last segment is left: reader stops on it.
+ *
+ * File layout (all numbers are little-endian):
+ * @code
+ * header: magic "TSWCAP01" start_time:i64 (nanoseconds since the epoch)
+ * record: time:u64 (nanoseconds since the start) size:u32 type:u16 direction:u8 frame bytes
+ * @endcode
+ * Capture may be used from several threads.
+ */
+class MessageCapture
+{
+public:
+    static constexpr size_t default_segment_size = 64 * 1024 * 1024;
+
+public:
+    /**
+     * @brief Create the capture file. Existing file is overwritten.
+     * @throw Exception, if file can't be created.
+     */
+    explicit MessageCapture(const Path &path, size_t segment_size = default_segment_size);
+    MessageCapture(const MessageCapture&) = delete;
+    ~MessageCapture();
+
+public:
+    /**
+     * @brief Write the frame with the current time.
+     * @throw Exception, if file can't be extended.
+     */
+    void record(CaptureDirection direction, MessageType type, const BinData::value_type *data, size_t size);
+    void record(CaptureDirection direction, MessageType type, const BinData &frame)
+    {
+        record(direction, type, frame.data(), frame.size());
+    }
+
+    /**
+     * @brief Unmap and truncate the file. Frames, which are recorded after it, are skipped.
+     */
+    void close();
+
+    uint64_t frames_count() const;
+
+    // Written bytes with the header.
+    size_t size() const;
+
+private:
+    // Map the file with the capacity for the required size. Mutex must be locked.
+    void reserve(size_t required);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+private:
+    const size_t                    segment_size_;
+    const Clock::time_point         start_;
+    int                             fd_;
+    BinData::value_type             *map_;
+    size_t                          capacity_;
+    size_t                          size_;
+    uint64_t                        frames_;
+    mutable std::mutex              mutex_;
+};
+
+
+/**
+ * @brief Reader of the capture file. File is mapped read-only: frames aren't copied.
+ */
+class CaptureReader
+{
+public:
+    /**
+     * @brief Map the capture file.
+     * @throw Exception, if file can't be opened or it isn't a capture.
+     */
+    explicit CaptureReader(const Path &path);
+    CaptureReader(const CaptureReader&) = delete;
+    ~CaptureReader();
+
+public:
+    /**
+     * @brief Read the next frame.
+     * @return false on the end of the capture or on the torn record.
+     */
+    bool next(CapturedFrame &frame);
+
+    void rewind();
+
+    // Capture start, since the epoch.
+    Time get_start_time() const;
+
+private:
+    int                             fd_;
+    const BinData::value_type       *map_;
+    size_t                          size_;
+    size_t                          offset_;
+    Time                            start_time_;
+};
+
+
+/**
+ * @brief Replay of the captured frames with the original pace, scaled pace or as fast as possible.
+ *
+ * Frames of the chosen direction are passed to the sink, for example, to the Magistral::send_serialized().
+ */
+class CaptureReplayer
+{
+public:
+    typedef std::function<void(const CapturedFrame &frame)> FrameSink;
+
+    struct Options
+    {
+        // Pace multiplier: 1 - original pace, 2 - twice faster, 0 - as fast as possible.
+        double              speed = 1;
+        CaptureDirection    direction = CaptureDirection::Sent;
+    };
+
+    struct Statistics
+    {
+        uint64_t                    frames = 0;
+        uint64_t                    bytes = 0;
+        std::chrono::nanoseconds    elapsed{0};
+        // Maximal delay of the frame sending after its scheduled time: sink doesn't keep up, if it grows.
+        std::chrono::nanoseconds    max_lag{0};
+    };
+
+public:
+    explicit CaptureReplayer(CaptureReader &reader);
+    CaptureReplayer(CaptureReader &reader, const Options &options);
+
+public:
+    /**
+     * @brief Pass the frames to the sink from the capture start, until the end or the stop() call.
+     */
+    Statistics run(const FrameSink &sink);
+
+    /**
+     * @brief Stop the running replay. May be called from another thread.
+     */
+    void stop();
+
+private:
+    CaptureReader           &reader_;
+    const Options           options_;
+    std::atomic_bool        stopped_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_MESSAGE_CAPTURE_H
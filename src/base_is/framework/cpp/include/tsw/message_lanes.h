@@ -0,0 +1,51 @@
+/**
+  * @file message_lanes.h
+  * @author Artiom N.(cl)2017
+  * @brief Priority lanes of the sent messages.
+  *
+  */
+
+#ifndef _TSW_MESSAGE_LANES_H
+#define _TSW_MESSAGE_LANES_H
+
+#include <array>
+#include <cstdint>
+
+#include "latency_histogram.h"
+#include "message.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief Priority class of the sent message. Every lane has own send queue.
+ */
+enum class MessageLane : uint8_t
+{
+    // Handshakes, integration, subscriptions and errors.
+    Control,
+    // Events, actions and replies.
+    Data,
+    // Chunks of the large messages.
+    Bulk
+};
+
+
+constexpr size_t message_lanes_count = 3;
+
+/// Frames, which the lane may send in a row, when other lanes have frames too.
+typedef std::array<unsigned, message_lanes_count> LaneWeights;
+
+
+const char *message_lane_name(MessageLane lane);
+
+/// Lane of the message type, used by default.
+MessageLane default_message_lane(MessageType message_type);
+
+/// Control lane sends 16 frames, while data lane sends 4 and bulk lane sends 1.
+const LaneWeights &default_lane_weights();
+
+} // namespace tsw
+
+#endif // _TSW_MESSAGE_LANES_H
@@ -0,0 +1,144 @@
+/**
+  * @file message_outbox.h
+  * @author Artiom N.(cl)2017
+  * @brief MessageOutbox class definition: persistent log of the sent frames.
+  *
+  */
+
+#ifndef _TSW_MESSAGE_OUTBOX_H
+#define _TSW_MESSAGE_OUTBOX_H
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "message.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief Append-only log of the sent frames: messages aren't lost, while the peer is down.
+ *
+ * Frame is appended and committed before the sending and acknowledged after it has been written to the socket.
+ * Unacknowledged frames are replayed after the reconnection or the restart: delivery is at-least-once,
+ * receiver drops the duplicates by the message identifier.
+ * Concurrent appends are committed by groups: one sender writes and syncs the frames of all waiting ones.
+ * Log is a plain file, not an EJDB collection: frames are only appended and read back in order on the replay,
+ * B+tree storage would add the index updates and page writes per frame without any lookup to serve.
+ *
+ * Log record (all numbers are little-endian):
+ * @code
+ * size:u32 crc32:u32 kind:u8 sequence:u64
+ * frame record: type:u16 deadline:i64 frame bytes
+ * @endcode
+ * Size and CRC cover the rest of the record. Torn record at the end of the log is truncated on the opening.
+ * Outbox may be used from several threads.
+ */
+class MessageOutbox
+{
+public:
+    struct Options
+    {
+        // Sync the log on every commit. Without it frames survive the process crash, but not the OS one.
+        bool    sync = true;
+        // Log is truncated, when all frames are acknowledged and it's larger.
+        size_t  compaction_threshold = 16 * 1024 * 1024;
+    };
+
+    struct Entry
+    {
+        uint64_t    sequence;
+        MessageType type;
+        Time        deadline;
+        BinData     frame;
+    };
+
+    // Returns false to stop the replay.
+    typedef std::function<bool(const Entry &entry)> ReplayHandler;
+
+public:
+    /**
+     * @brief Open or create the log and recover the unacknowledged frames.
+     * @throw Exception, if log can't be opened.
+     */
+    explicit MessageOutbox(const Path &path);
+    MessageOutbox(const Path &path, const Options &options);
+    MessageOutbox(const MessageOutbox&) = delete;
+    ~MessageOutbox();
+
+public:
+    /**
+     * @brief Append frame and wait, until it's committed.
+     * @return sequence number of the frame.
+     * @throw Exception, if the log write fails.
+     */
+    uint64_t append(MessageType type, const Time &deadline, const BinData &frame);
+
+    /**
+     * @brief Mark the frame delivered.
+     *
+     * Acknowledgement is written with the next commit: if it's lost, frame is replayed once more.
+     */
+    void acknowledge(uint64_t sequence);
+
+    /**
+     * @brief Pass unacknowledged frames to the handler in the sequence order.
+     * @return count of the frames, which were passed.
+     */
+    size_t replay(const ReplayHandler &handler);
+
+    /**
+     * @brief Write the pending acknowledgements.
+     */
+    void flush();
+
+    size_t pending_count() const;
+
+    /// Count of the log writes: appends per commit show the group commit efficiency.
+    uint64_t commits_count() const;
+
+private:
+    struct Location
+    {
+        // Offset of the frame bytes in the log.
+        uint64_t    offset;
+        uint32_t    size;
+        MessageType type;
+        Time        deadline;
+    };
+
+private:
+    void recover();
+    // Write the pending records. Lock is released for the write.
+    void commit(std::unique_lock<std::mutex> &lock, uint64_t sequence);
+    void compact();
+
+private:
+    const Path                      path_;
+    const Options                   options_;
+    int                             fd_;
+
+    mutable std::mutex              mutex_;
+    std::condition_variable         committed_;
+    // Records, which aren't written yet.
+    BinData                         pending_;
+    bool                            committing_;
+    uint64_t                        last_sequence_;
+    uint64_t                        committed_sequence_;
+    // Sequences of the failed writes: their senders get the error.
+    std::vector<std::pair<uint64_t, uint64_t>> failed_groups_;
+    // Size of the written log and offset of the next record after the pending ones.
+    uint64_t                        log_size_;
+    uint64_t                        end_offset_;
+    uint64_t                        commits_;
+    std::map<uint64_t, Location>    unacknowledged_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_MESSAGE_OUTBOX_H
@@ -0,0 +1,44 @@
+/**
+  * @file msgpack_deserializer.h
+  * @author Artiom N.(cl)2017
+  * @brief MsgPackDeserializer class definition.
+  *
+  */
+
+#ifndef _TSW_MSGPACK_DESERIALIZER_H
+#define _TSW_MSGPACK_DESERIALIZER_H
+
+#include <memory>
+
+#include "deserializer.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+class MsgPackDeserializerImpl;
+}
+
+class MsgPackDeserializer : public Deserializer
+{
+public:
+    MsgPackDeserializer();
+    ~MsgPackDeserializer();
+
+public:
+    Message DeserializeMessage(const BinData &data) override;
+    Object DeserializeObject(const BinData &data) override;
+    Message DeserializeMessage(const BinData::value_type *data, size_t size) override;
+    Object DeserializeObject(const BinData::value_type *data, size_t size) override;
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size) override;
+
+private:
+    std::unique_ptr<impl::MsgPackDeserializerImpl> impl_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_MSGPACK_DESERIALIZER_H
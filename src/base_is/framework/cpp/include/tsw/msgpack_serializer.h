@@ -0,0 +1,50 @@
+/**
+  * @file msgpack_serializer.h
+  * @author Artiom N.(cl)2017
+  * @brief MsgPackSerializer class definition.
+  *
+  */
+
+#ifndef _TSW_MSGPACK_SERIALIZER_H
+#define _TSW_MSGPACK_SERIALIZER_H
+
+#include <memory>
+
+#include "message.h"
+#include "serializer.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+template<typename Encoder> class CompactSerializerImpl;
+struct MsgPackEncoder;
+}
+
+/**
+ * @brief MessagePack serializer: compact binary format with the full Value types coverage.
+ */
+class MsgPackSerializer: public Serializer
+{
+public:
+    MsgPackSerializer();
+    ~MsgPackSerializer();
+
+public:
+    BinData SerializeMessage(const Message &message) override;
+    BinData SerializeObject(const Object &fields) override;
+    void SerializeMessageTo(const Message &message, BinData &buffer) override;
+    std::unique_ptr<Serializer> Clone() const override;
+    bool Cloneable() const override { return true; }
+    WireFormat Format() const override;
+
+private:
+    std::unique_ptr<impl::CompactSerializerImpl<impl::MsgPackEncoder>> impl_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_MSGPACK_SERIALIZER_H
@@ -0,0 +1,48 @@
+/**
+  * @file schema_deserializer.h
+  * @author Artiom N.(cl)2017
+  * @brief SchemaDeserializer class definition.
+  *
+  */
+
+#ifndef _TSW_SCHEMA_DESERIALIZER_H
+#define _TSW_SCHEMA_DESERIALIZER_H
+
+#include <memory>
+
+#include "deserializer.h"
+#include "schema_registry.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief Deserializer for the SchemaSerializer output.
+ *
+ * Positionally encoded messages are decoded with the scheme from the registry,
+ * other data and messages with the unknown scheme are passed to the fallback deserializer.
+ */
+class SchemaDeserializer : public Deserializer
+{
+public:
+    explicit SchemaDeserializer(std::shared_ptr<const SchemaRegistry> registry);
+    SchemaDeserializer(std::shared_ptr<const SchemaRegistry> registry, std::shared_ptr<Deserializer> fallback);
+    ~SchemaDeserializer();
+
+public:
+    Message DeserializeMessage(const BinData &data) override;
+    Object DeserializeObject(const BinData &data) override;
+    Message DeserializeMessage(const BinData::value_type *data, size_t size) override;
+    Object DeserializeObject(const BinData::value_type *data, size_t size) override;
+    MessageType DeserializeMessageType(const BinData::value_type *data, size_t size) override;
+
+private:
+    std::shared_ptr<const SchemaRegistry> registry_;
+    std::shared_ptr<Deserializer> fallback_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_SCHEMA_DESERIALIZER_H
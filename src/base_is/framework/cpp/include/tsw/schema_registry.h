@@ -0,0 +1,85 @@
+/**
+  * @file schema_registry.h
+  * @author Artiom N.(cl)2017
+  * @brief SchemaRegistry class definition.
+  *
+  */
+
+#ifndef _TSW_SCHEMA_REGISTRY_H
+#define _TSW_SCHEMA_REGISTRY_H
+
+#include <map>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <vector>
+
+#include "message.h"
+#include "metadata.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+namespace impl
+{
+class CompiledScheme;
+}
+
+/**
+ * @brief Compiled EA field schemes, shared by the SchemaSerializer and SchemaDeserializer.
+ *
+ * Both sides register the announced metadata. Scheme is identified on the wire by a hash
+ * of its layout, so the peer with the other scheme version will not decode fields wrong.
+ * Scheme is used for sending only after the peer has confirmed it: until then messages are
+ * sent by the fallback serializer. Registry may be used from several threads.
+ */
+class SchemaRegistry
+{
+public:
+    SchemaRegistry();
+    ~SchemaRegistry();
+
+public:
+    /**
+     * @brief Compile and register the activity scheme.
+     * @return scheme hash or 0, if scheme can't be compiled: such messages are sent as is.
+     */
+    uint64_t register_scheme(MessageType message_type, const EAMetadata &metadata);
+    void unregister_scheme(MessageType message_type, const String &name);
+
+    /**
+     * @brief Register schemes of the announced activities or unregister schemes of the denounced ones.
+     * @param announcement AnnounceModuleEvents, AnnounceModuleActions, DenounceModuleEvents or
+     * DenounceModuleActions message. Other messages and malformed entries are ignored.
+     * Announced schemes are confirmed: the announcer has them.
+     * @return hashes of the registered schemes.
+     */
+    std::vector<uint64_t> register_announced(const Message &announcement);
+
+    /**
+     * @brief Mark the scheme as known by the peer.
+     */
+    void confirm_scheme(uint64_t hash);
+    bool is_confirmed(uint64_t hash) const;
+
+    bool has_scheme(uint64_t hash) const;
+    std::vector<uint64_t> get_hashes() const;
+
+    std::shared_ptr<const impl::CompiledScheme> find(MessageType message_type, const String &name) const;
+    std::shared_ptr<const impl::CompiledScheme> find(uint64_t hash) const;
+
+private:
+    typedef std::shared_ptr<const impl::CompiledScheme> SchemePtr;
+
+private:
+    mutable std::shared_mutex                           mutex_;
+    std::map<MessageType, std::map<String, SchemePtr>>  schemes_;
+    std::map<uint64_t, SchemePtr>                       schemes_by_hash_;
+    std::set<uint64_t>                                  confirmed_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_SCHEMA_REGISTRY_H
@@ -0,0 +1,51 @@
+/**
+  * @file schema_serializer.h
+  * @author Artiom N.(cl)2017
+  * @brief SchemaSerializer class definition.
+  *
+  */
+
+#ifndef _TSW_SCHEMA_SERIALIZER_H
+#define _TSW_SCHEMA_SERIALIZER_H
+
+#include <memory>
+
+#include "message.h"
+#include "schema_registry.h"
+#include "serializer.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+/**
+ * @brief Serializer, which encodes events and actions with the registered scheme positionally.
+ *
+ * Message is selected by its type and the "name" field. Messages without scheme or with the scheme,
+ * which the peer hasn't confirmed, with fields, which don't conform to the scheme, with the deadline or identifier are serialized by the fallback
+ * serializer.
+ */
+class SchemaSerializer: public Serializer
+{
+public:
+    explicit SchemaSerializer(std::shared_ptr<const SchemaRegistry> registry);
+    SchemaSerializer(std::shared_ptr<const SchemaRegistry> registry, std::shared_ptr<Serializer> fallback);
+    ~SchemaSerializer();
+
+public:
+    BinData SerializeMessage(const Message &message) override;
+    BinData SerializeObject(const Object &fields) override;
+    void SerializeMessageTo(const Message &message, BinData &buffer) override;
+    std::unique_ptr<Serializer> Clone() const override;
+    bool Cloneable() const override;
+    WireFormat Format() const override;
+
+private:
+    std::shared_ptr<const SchemaRegistry> registry_;
+    std::shared_ptr<Serializer> fallback_;
+};
+
+} // namespace tsw
+
+#endif // _TSW_SCHEMA_SERIALIZER_H
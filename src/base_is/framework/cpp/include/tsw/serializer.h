@@ -8,6 +8,9 @@
 #ifndef _TSW_SERIALIZER_H
 #define _TSW_SERIALIZER_H
 
+#include <memory>
+
+#include "field_access.h"
 #include "message.h"
 #include "types.h"
 
@@ -15,12 +18,46 @@
 namespace tsw
 {
 
+enum class WireFormat;
+
+
 class Serializer
 {
 public:
     virtual BinData SerializeMessage(const Message &message) = 0;
     virtual BinData SerializeObject(const Object &object) = 0;
 
+    /**
+     * @brief Serialize message into the caller's buffer.
+     *
+     * Buffer content is replaced, but its memory is reused: serializing to the same buffer
+     * doesn't allocate, when the buffer is large enough.
+     */
+    virtual void SerializeMessageTo(const Message &message, BinData &buffer) { buffer = SerializeMessage(message); }
+
+    /**
+     * @brief Create a new serializer of the same type.
+     *
+     * Serializers keep an encoding state and can't be used from several threads at once:
+     * every thread needs own clone. Cloneable() tells, whether the serializer can be cloned, without cloning.
+     * @return new serializer or nullptr, if serializer can't be cloned.
+     */
+    virtual std::unique_ptr<Serializer> Clone() const { return nullptr; }
+    virtual bool Cloneable() const { return false; }
+
+    /**
+     * @brief Return format of the serialized messages.
+     * @return format or WireFormat::Unknown, if the messages can't be recognized by the detect_wire_format().
+     */
+    virtual WireFormat Format() const;
+
+    /**
+     * @brief Serialize message with the envelope of the given message and the directly written fields.
+     *
+     * Default implementation collects fields into the Object.
+     */
+    virtual void SerializeFieldsTo(const Message &envelope, const FieldsWriter &fields, BinData &buffer);
+
 public:
     virtual ~Serializer() = default;
 
@@ -29,21 +66,32 @@ protected:
     BinData SerializeMessage(const Message &message, Serializer &serializer)
     {
         serializer.clear();
+        WriteMessage(message, serializer);
+
+        return serializer.take_buffer();
+    }
+
+    template<typename Serializer>
+    void WriteMessage(const Message &message, Serializer &serializer)
+    {
+        WriteEnvelope(message, serializer);
+        serializer.append_field("fields", message.get_fields());
+    }
 
+    template<typename Serializer>
+    void WriteEnvelope(const Message &message, Serializer &serializer)
+    {
         serializer.append_field("type", static_cast<int>(message.get_type()));
         serializer.append_field("sender_m_uid", static_cast<int64_t>(message.get_sender_module_uid()));
         serializer.append_field("sender_m_name", message.get_sender_module_name());
         serializer.append_field("sender_m_class", message.get_sender_module_class());
-        serializer.append_field("receiver_m_uid", static_cast<int64_t>(message.get_sender_module_uid()));
-        serializer.append_field("receiver_m_name", message.get_sender_module_name());
-        serializer.append_field("receiver_m_class", message.get_sender_module_class());
+        serializer.append_field("receiver_m_uid", static_cast<int64_t>(message.get_receiver_module_uid()));
+        serializer.append_field("receiver_m_name", message.get_receiver_module_name());
+        serializer.append_field("receiver_m_class", message.get_receiver_module_class());
         serializer.append_field("c_time", message.get_creation_time());
-        serializer.append_field("fields", message.get_fields());
-
-        return serializer.get_buffer();
+        if (message.has_deadline()) serializer.append_field("deadline", message.get_deadline());
+        if (message.get_id()) serializer.append_field("m_id", static_cast<int64_t>(message.get_id()));
     }
-
-
 };
 
 } // namespace tsw
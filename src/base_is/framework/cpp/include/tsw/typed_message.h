@@ -0,0 +1,222 @@
+/**
+  * @file typed_message.h
+  * @author Artiom N.(cl)2017
+  * @brief TSW_MESSAGE macro: plain structs with the generated fields (de)serialization.
+  *
+  */
+
+#ifndef _TSW_TYPED_MESSAGE_H
+#define _TSW_TYPED_MESSAGE_H
+
+#include <type_traits>
+#include <utility>
+
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/tuple/elem.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <boost/preprocessor/variadic/to_seq.hpp>
+
+#include "bson_view.h"
+#include "field_access.h"
+#include "types.h"
+
+
+#define TSW_MESSAGE_DECLARE_FIELD(r, data, field) \
+    BOOST_PP_TUPLE_ELEM(2, 0, field) BOOST_PP_TUPLE_ELEM(2, 1, field){};
+
+#define TSW_MESSAGE_VISIT_FIELD(r, visitor, field) \
+    visitor(BOOST_PP_STRINGIZE(BOOST_PP_TUPLE_ELEM(2, 1, field)), BOOST_PP_TUPLE_ELEM(2, 1, field));
+
+#define TSW_MESSAGE_CHECK_FIELD(r, data, field)                                                                  \
+    static_assert(!tsw::detail::is_message_name_field(BOOST_PP_STRINGIZE(BOOST_PP_TUPLE_ELEM(2, 1, field))),     \
+                  "field \"" BOOST_PP_STRINGIZE(BOOST_PP_TUPLE_ELEM(2, 1, field)) "\" is reserved for the message name");
+
+/**
+ * @brief Define the message struct.
+ *
+ * Field types are: bool, int32_t, int64_t, double, String, BinData, Time, DoubleArray, Int32Array,
+ * Value and another typed message (nested object). Type must not contain commas.
+ * Field can't be named "name": message name is written with this key.
+ * @code
+ * TSW_MESSAGE(SensorEvent, (int32_t, counter), (double, value), (tsw::String, unit))
+ *
+ * magistral.send(SensorEvent{1, 0.5, "V"});
+ * magistral.on<SensorEvent>([](const SensorEvent &e) { return e.value > 0; });
+ * @endcode
+ */
+#define TSW_MESSAGE(NAME, ...)                                                                          \
+struct NAME                                                                                             \
+{                                                                                                       \
+    BOOST_PP_SEQ_FOR_EACH(TSW_MESSAGE_DECLARE_FIELD, _, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))          \
+    BOOST_PP_SEQ_FOR_EACH(TSW_MESSAGE_CHECK_FIELD, _, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))            \
+                                                                                                        \
+    static constexpr const char *message_name = #NAME;                                                  \
+                                                                                                        \
+    template<typename Visitor>                                                                          \
+    void visit_fields(Visitor &&visitor)                                                                \
+    {                                                                                                   \
+        BOOST_PP_SEQ_FOR_EACH(TSW_MESSAGE_VISIT_FIELD, visitor, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))  \
+    }                                                                                                   \
+                                                                                                        \
+    template<typename Visitor>                                                                          \
+    void visit_fields(Visitor &&visitor) const                                                          \
+    {                                                                                                   \
+        BOOST_PP_SEQ_FOR_EACH(TSW_MESSAGE_VISIT_FIELD, visitor, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))  \
+    }                                                                                                   \
+};
+
+
+namespace tsw
+{
+
+// Message field with the typed message name.
+constexpr const char *typed_message_name_field = "name";
+
+
+template<typename T, typename = void>
+struct is_typed_message : std::false_type {};
+
+template<typename T>
+struct is_typed_message<T, std::void_t<decltype(T::message_name)>> : std::true_type {};
+
+
+template<typename T>
+void write_fields(FieldWriter &writer, const T &message);
+
+template<typename T>
+void read_fields(FieldReader &reader, T &message);
+
+
+namespace detail
+{
+
+constexpr bool is_message_name_field(const char *name, const char *reserved = typed_message_name_field)
+{
+    return *name == *reserved && (!*name || is_message_name_field(name + 1, reserved + 1));
+}
+
+
+template<typename T>
+inline void write_field(FieldWriter &writer, const char *name, const T &data)
+{
+    if constexpr (is_typed_message<T>::value)
+    {
+        writer.start_object(name);
+        write_fields(writer, data);
+        writer.finish_object();
+    }
+    else
+    {
+        writer.write(name, data);
+    }
+}
+
+
+template<typename T>
+inline void read_field(FieldReader &reader, const char *name, T &data)
+{
+    if constexpr (is_typed_message<T>::value)
+    {
+        reader.read_object(name, [&data](FieldReader &nested) { read_fields(nested, data); });
+    }
+    else
+    {
+        // Absent fields keep their values.
+        reader.read(name, data);
+    }
+}
+
+} // namespace detail
+
+
+template<typename T>
+void write_fields(FieldWriter &writer, const T &message)
+{
+    static_assert(is_typed_message<T>::value, "T must be defined with TSW_MESSAGE");
+    message.visit_fields([&writer](const char *name, const auto &field) { detail::write_field(writer, name, field); });
+}
+
+
+template<typename T>
+void read_fields(FieldReader &reader, T &message)
+{
+    static_assert(is_typed_message<T>::value, "T must be defined with TSW_MESSAGE");
+    message.visit_fields([&reader](const char *name, auto &field) { detail::read_field(reader, name, field); });
+}
+
+
+template<typename T>
+BinData to_bson(const T &message)
+{
+    BinData result;
+
+    write_bson([&message](FieldWriter &writer) { write_fields(writer, message); }, result);
+
+    return result;
+}
+
+
+template<typename T>
+T from_bson(const BsonView &document)
+{
+    T result;
+
+    read_bson(document, [&result](FieldReader &reader) { read_fields(reader, result); });
+
+    return result;
+}
+
+
+template<typename T>
+T from_bson(const BinData &data)
+{
+    return from_bson<T>(BsonView(data.data(), data.size()));
+}
+
+
+template<typename T>
+BinData to_json(const T &message)
+{
+    BinData result;
+
+    write_json([&message](FieldWriter &writer) { write_fields(writer, message); }, result);
+
+    return result;
+}
+
+
+template<typename T>
+T from_json(const BinData &data)
+{
+    T result;
+
+    read_json(data.data(), data.size(), [&result](FieldReader &reader) { read_fields(reader, result); });
+
+    return result;
+}
+
+
+template<typename T>
+Object to_object(const T &message)
+{
+    Object result;
+
+    write_object([&message](FieldWriter &writer) { write_fields(writer, message); }, result);
+
+    return result;
+}
+
+
+template<typename T>
+T from_object(const Object &object)
+{
+    T result;
+
+    read_object(object, [&result](FieldReader &reader) { read_fields(reader, result); });
+
+    return result;
+}
+
+} // namespace tsw
+
+#endif // _TSW_TYPED_MESSAGE_H
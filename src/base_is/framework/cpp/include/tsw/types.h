@@ -68,6 +68,9 @@ typedef std::chrono::nanoseconds    Time;
 
 typedef std::vector<Value>          ValueArray;
 typedef std::vector<String>         StringArray;
+// Packed numeric arrays: contiguous storage without the per-element Value overhead.
+typedef std::vector<double>         DoubleArray;
+typedef std::vector<int32_t>        Int32Array;
 //typedef std::pair<String, Value>    NameValue;
 
 typedef std::list<Value>            ValueList;
@@ -85,13 +88,15 @@ TSW_STRONG_TYPEDEF(monostate, Null)
 
 enum class ValueType
 {
-    Undefined, Null, Array, BinData, Boolean, DoubleNumber, Int32Number, Int64Number, String, Time, Object
+    Undefined, Null, Array, BinData, Boolean, DoubleNumber, Int32Number, Int64Number, String, Time, Object,
+    DoubleArray, Int32Array
 };
 
 // Types ordnung muss to be same with a ValueType ordnung.
 // Undefined need to be first: a default-constructed Value is undefined.
 /// Base for the Value class
-typedef std::variant<Undefined, Null, ValueArray, BinData, bool, double, int32_t, int64_t, String, Time, Object> ValueBase;
+typedef std::variant<Undefined, Null, ValueArray, BinData, bool, double, int32_t, int64_t, String, Time, Object,
+                     DoubleArray, Int32Array> ValueBase;
 
 
 /**
@@ -114,7 +119,9 @@ public:
     bool is_bool() const { return value_type() == ValueType::Boolean; }
     bool is_bindata() const { return value_type() == ValueType::BinData; }
     bool is_double() const { return value_type() == ValueType::DoubleNumber; }
+    bool is_double_array() const { return value_type() == ValueType::DoubleArray; }
     bool is_int32() const { return value_type() == ValueType::Int32Number; }
+    bool is_int32_array() const { return value_type() == ValueType::Int32Array; }
     bool is_int64() const { return value_type() == ValueType::Int64Number; }
     bool is_null() const { return value_type() == ValueType::Null; }
     bool is_object() const { return value_type() == ValueType::Object; }
@@ -127,7 +134,11 @@ public:
     BinData             &as_bindata()  { return as<BinData>(); }
     const BinData       &as_bindata() const { return as<BinData>(); }
     double              as_double() const  { return as<double>(); }
+    DoubleArray         &as_double_array()  { return as<DoubleArray>(); }
+    const DoubleArray   &as_double_array() const  { return as<DoubleArray>(); }
     int32_t             as_int32() const  { return as<int32_t>(); }
+    Int32Array          &as_int32_array()  { return as<Int32Array>(); }
+    const Int32Array    &as_int32_array() const  { return as<Int32Array>(); }
     int64_t             as_int64() const  { return as<int64_t>(); }
     Object              &as_object()  { return as<Object>(); }
     const Object        &as_object() const { return as<Object>(); }
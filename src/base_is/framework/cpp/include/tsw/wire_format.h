@@ -0,0 +1,78 @@
+/**
+  * @file wire_format.h
+  * @author Artiom N.(cl)2017
+  * @brief Wire formats: recognition, serializers factory and negotiation helpers.
+  *
+  */
+
+#ifndef _TSW_WIRE_FORMAT_H
+#define _TSW_WIRE_FORMAT_H
+
+#include <memory>
+#include <vector>
+
+#include "deserializer.h"
+#include "serializer.h"
+#include "types.h"
+
+
+namespace tsw
+{
+
+class SchemaRegistry;
+
+
+enum class WireFormat
+{
+    Unknown,
+    Bson,
+    Json,
+    MsgPack,
+    Cbor,
+    Envelope,
+    // Messages with the registered scheme are compiled positionally, other ones are BSON.
+    Schema
+};
+
+
+typedef std::vector<WireFormat> WireFormats;
+
+
+/// Format name, used in the handshake.
+const char *wire_format_name(WireFormat format);
+/// @return format or WireFormat::Unknown.
+WireFormat wire_format_from_name(const String &name);
+
+/**
+ * @brief Recognize format of the serialized message.
+ *
+ * Serializers write documents with the distinct first bytes: BSON starts with its length
+ * and ends with zero, MessagePack is a map16, CBOR is an indefinite map, JSON is an object,
+ * enveloped message starts with "TE" and 0xff in the fourth byte, schema compiled one starts with "TSC" and 0x81.
+ */
+WireFormat detect_wire_format(const BinData::value_type *data, size_t size);
+
+/**
+ * @brief Replace sender and receiver UIDs of the serialized message in place, without decoding of the fields.
+ * @return false, if the format doesn't keep UIDs in the fixed-width fields (JSON, MessagePack and CBOR).
+ */
+bool patch_message_uids(BinData::value_type *data, size_t size, UID sender_module_uid, UID receiver_module_uid);
+
+/**
+ * @brief Create serializer or deserializer of the format.
+ * @param registry schemes of the WireFormat::Schema, other formats don't need it.
+ * @throw Exception, if format is unknown or the schema format has no registry.
+ */
+std::shared_ptr<Serializer> make_serializer(WireFormat format, std::shared_ptr<const SchemaRegistry> registry = nullptr);
+std::shared_ptr<Deserializer> make_deserializer(WireFormat format, std::shared_ptr<const SchemaRegistry> registry = nullptr);
+
+/**
+ * @brief Choose format for the peer: the first offered one, which is supported.
+ * @param offered format names in the peer's preference order.
+ * @return format or WireFormat::Unknown.
+ */
+WireFormat choose_wire_format(const ValueArray &offered, const WireFormats &supported);
+
+} // namespace tsw
+
+#endif // _TSW_WIRE_FORMAT_H
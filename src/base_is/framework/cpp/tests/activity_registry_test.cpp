@@ -0,0 +1,122 @@
+/**
+  * @file activity_registry_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief ActivityRegistry tests.
+  *
+  */
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <tsw/metadata.h>
+
+#include <impl/activity_registry.h>
+
+#include "tests_common.h"
+
+
+typedef std::function<bool(int&)> TestHandler;
+typedef tsw::impl::ActivityRegistry<TestHandler> TestRegistry;
+
+
+static bool increment(int &counter) { ++counter; return true; }
+static bool decrement(int &counter) { --counter; return true; }
+
+
+static tsw::EAMetadataList make_metadata(size_t count, size_t first = 0)
+{
+    tsw::EAMetadataList result;
+
+    for (size_t i = first; i < first + count; ++i)
+    {
+        result.emplace_back("activity_" + std::to_string(i), nullptr, "", tsw::FieldUIDFieldHeaderMap());
+    }
+
+    return result;
+}
+
+
+static void run_handlers(const TestRegistry &registry, tsw::UID module_uid, const tsw::String &name, int &counter)
+{
+    auto handlers = registry.get_handlers(module_uid, name);
+
+    if (!handlers) return;
+
+    for (const auto &handler: *handlers) handler(counter);
+}
+
+
+TEST(ActivityRegistry, Handlers)
+{
+    TestRegistry registry;
+    int counter = 0;
+
+    EXPECT_FALSE(registry.add_handler(1, "activity_0", increment));
+
+    registry.append(1, make_metadata(2));
+    registry.append(2, make_metadata(1));
+    EXPECT_EQ(registry.size(), 3u);
+
+    EXPECT_TRUE(registry.add_handler(1, "activity_0", increment));
+    EXPECT_TRUE(registry.add_handler(1, "activity_0", increment));
+    EXPECT_TRUE(registry.add_handler(1, "activity_1", decrement));
+
+    // Snapshot isn't changed by the later subscriptions.
+    auto snapshot = registry.get_handlers(1, "activity_0");
+
+    registry.remove_handler(1, "activity_0", increment);
+    EXPECT_EQ(snapshot->size(), 2u);
+    EXPECT_EQ(registry.get_handlers(1, "activity_0")->size(), 0u);
+
+    EXPECT_TRUE(registry.add_handler(1, "activity_0", increment));
+    run_handlers(registry, 1, "activity_0", counter);
+    run_handlers(registry, 1, "activity_1", counter);
+    run_handlers(registry, 2, "activity_0", counter);
+    EXPECT_EQ(counter, 0);
+
+    // Announced again: handlers are kept.
+    registry.append(1, make_metadata(1));
+    EXPECT_EQ(registry.get_handlers(1, "activity_0")->size(), 1u);
+
+    registry.remove(1, tsw::StringList{ "activity_0" });
+    EXPECT_EQ(registry.get_handlers(1, "activity_0"), nullptr);
+    EXPECT_NE(registry.get_handlers(1, "activity_1"), nullptr);
+
+    registry.remove(1, tsw::StringList{ "activity_1" });
+    EXPECT_EQ(registry.get_module(1), nullptr);
+    EXPECT_EQ(registry.size(), 1u);
+}
+
+
+TEST(ActivityRegistry, ConcurrentReads)
+{
+    TestRegistry registry;
+    std::atomic_bool done(false);
+    std::vector<std::thread> readers;
+
+    registry.append(1, make_metadata(100));
+
+    for (int t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&]()
+        {
+            int counter = 0;
+
+            while (!done) run_handlers(registry, 1, "activity_" + std::to_string(counter & 63), counter);
+        });
+    }
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        registry.add_handler(1, "activity_" + std::to_string(i % 64), increment);
+        registry.append(1, make_metadata(1, 100 + i));
+        registry.remove_handler(1, "activity_" + std::to_string(i % 64), increment);
+    }
+
+    done = true;
+    for (auto &reader: readers) reader.join();
+
+    EXPECT_EQ(registry.size(), 1100u);
+}
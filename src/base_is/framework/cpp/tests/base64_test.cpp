@@ -8,8 +8,10 @@
 #include "tests_common.h"
 
 #include <algorithm>
+#include <random>
 
 #include <tsw/base64.h>
+#include <tsw/error.h>
 #include <fstream>
 
 
@@ -122,6 +124,16 @@ TEST(Base64, Test)
     EXPECT_TRUE(tsw::is_base64(b64_prefix + base64_as_string));
     EXPECT_TRUE(tsw::is_base64(b64_prefix + base64_as_string));
     EXPECT_TRUE(tsw::is_base64(b64_prefix + base64_very_long_data));
+
+    // Line breaks are between the groups, padding is only at the end.
+    EXPECT_TRUE(tsw::is_base64(b64_prefix + "YWJj\r\nZA=="));
+    EXPECT_TRUE(tsw::is_base64(b64_prefix + "YWJjZGU="));
+    EXPECT_FALSE(tsw::is_base64(b64_prefix + "YWJjZA==\n"));
+    EXPECT_FALSE(tsw::is_base64(b64_prefix + "YWJjZA=="  "YWJj"));
+    EXPECT_FALSE(tsw::is_base64(b64_prefix + "YWJjZ==="));
+    EXPECT_FALSE(tsw::is_base64(b64_prefix + "YW\nJj"));
+    EXPECT_FALSE(tsw::is_base64(b64_prefix + "YWJj\r"));
+    EXPECT_FALSE(tsw::is_base64(b64_prefix + "YWJjZA="));
 }
 
 
@@ -221,3 +233,59 @@ TEST(Base64, Decode)
                             tsw::from_base64(base64_very_long_data).data(),
                             boost::size(very_long_data)));
 }
+
+
+TEST(Base64, LineBreaks)
+{
+    for (size_t size: {48, 49, 53, 54, 55, 108, 109, 1000})
+    {
+        auto text = tsw::to_base64(tsw::BinData(size, 0x41));
+
+        // Padding is counted without the line breaks.
+        EXPECT_EQ((text.size() - b64_prefix.size() - std::count(text.begin(), text.end(), '\n') + 1) % 4, 0) << size;
+        EXPECT_TRUE(tsw::is_base64(text)) << size;
+        EXPECT_NE(text.back(), '\n');
+        EXPECT_EQ(tsw::from_base64(text), tsw::BinData(size, 0x41));
+    }
+}
+
+
+TEST(Base64, Engines)
+{
+    std::mt19937 generator(7);
+    const tsw::String default_engine = tsw::base64_engine();
+
+    ASSERT_EQ(tsw::base64_engines().front(), default_engine);
+    ASSERT_EQ(tsw::base64_engines().back(), "scalar");
+    EXPECT_FALSE(tsw::set_base64_engine("mmx"));
+
+    // All implementations give the same results.
+    for (size_t size = 0; size < 300; ++size)
+    {
+        tsw::BinData data(size);
+        for (auto &b: data) b = static_cast<tsw::BinData::value_type>(generator());
+
+        ASSERT_TRUE(tsw::set_base64_engine("scalar"));
+        const auto expected = tsw::to_base64(data);
+        const auto expected_no_lb = tsw::to_base64_no_lb(data);
+
+        for (const auto &engine: tsw::base64_engines())
+        {
+            ASSERT_TRUE(tsw::set_base64_engine(engine));
+            EXPECT_EQ(tsw::to_base64(data), expected) << engine << ", size " << size;
+            EXPECT_EQ(tsw::to_base64_no_lb(data), expected_no_lb) << engine << ", size " << size;
+            EXPECT_EQ(tsw::from_base64(expected), data) << engine << ", size " << size;
+            EXPECT_EQ(tsw::from_base64(expected_no_lb), data) << engine << ", size " << size;
+
+            // Invalid character inside of the vectorized block.
+            if (size > 100)
+            {
+                auto broken = expected_no_lb;
+                broken[size / 2] = '*';
+                EXPECT_THROW(tsw::from_base64(broken), tsw::Exception) << engine;
+            }
+        }
+    }
+
+    tsw::set_base64_engine(default_engine);
+}
@@ -480,3 +480,44 @@ TEST(BsonImpl, ComplexSerialization)
     bd = bson_simpl.get_buffer();
     EXPECT_FALSE(ArraysMatch(bson_test_complex, bd.data(), bd.size()));
 }
+
+
+TEST(BsonImpl, LargeArrayOrder)
+{
+    tsw::impl::BsonSerializerImpl bson_simpl;
+    tsw::impl::BsonDeserializerImpl bson_dsimpl;
+    tsw::ValueArray samples;
+
+    for (int32_t i = 0; i < 25; ++i) samples.push_back(i);
+
+    bson_simpl.append_field("samples", samples);
+    auto bd = bson_simpl.get_buffer();
+    auto v = bson_dsimpl.Deserialize(bd.data(), bd.size());
+
+    ASSERT_TRUE(v["samples"].is_array());
+    // Elements order must be kept for the arrays with more than 10 elements.
+    EXPECT_EQ(v["samples"].as_array(), samples);
+}
+
+
+TEST(BsonImpl, PackedArrays)
+{
+    tsw::impl::BsonSerializerImpl bson_simpl;
+    tsw::impl::BsonDeserializerImpl bson_dsimpl;
+    tsw::DoubleArray doubles{0.0, -1.5, 3.25, 1e300};
+    tsw::Int32Array ints{0, -1, 2147483647, -2147483647 - 1};
+
+    bson_simpl.append_field("doubles", doubles);
+    bson_simpl.append_field("ints", tsw::Value(ints));
+    bson_simpl.append_field("empty", tsw::DoubleArray());
+
+    auto bd = bson_simpl.get_buffer();
+    auto v = bson_dsimpl.Deserialize(bd.data(), bd.size());
+
+    ASSERT_TRUE(v["doubles"].is_double_array());
+    EXPECT_EQ(v["doubles"].as_double_array(), doubles);
+    ASSERT_TRUE(v["ints"].is_int32_array());
+    EXPECT_EQ(v["ints"].as_int32_array(), ints);
+    ASSERT_TRUE(v["empty"].is_double_array());
+    EXPECT_TRUE(v["empty"].as_double_array().empty());
+}
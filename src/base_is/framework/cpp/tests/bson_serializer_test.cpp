@@ -5,10 +5,68 @@
   *
   */
 
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/message.h>
+
 #include "tests_common.h"
 
 
+static tsw::NameValueMap test_fields()
+{
+    return tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("uid", tsw::Value(int64_t(54321098000l))),
+        std::make_pair("data", tsw::BinData(64, 0xaa)),
+        std::make_pair("samples", tsw::ValueArray{1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0}),
+        std::make_pair("meta", tsw::Object{std::make_pair("a", "b"), std::make_pair("enabled", true)})
+    };
+}
+
+
 TEST(BsonSerializer, CorrectSerialization)
 {
+    tsw::BsonSerializer serializer;
+    tsw::BsonDeserializer deserializer;
+    tsw::Message message(tsw::MessageType::Event, test_fields());
+
+    auto data = serializer.SerializeMessage(message);
+    auto result = deserializer.DeserializeMessage(data);
+
+    EXPECT_EQ(result.get_type(), tsw::MessageType::Event);
+    EXPECT_EQ(result.get_creation_time(), message.get_creation_time());
+    EXPECT_EQ(result.get_fields_view().as_string("name"), "sensor_event");
+    EXPECT_EQ(result.get_fields(), message.get_fields());
+
+    // Serializer must be reusable after the buffer was taken.
+    EXPECT_EQ(serializer.SerializeMessage(message), data);
+    EXPECT_EQ(deserializer.DeserializeObject(serializer.SerializeObject(message.get_fields())), message.get_fields());
+}
+
+
+TEST(BsonSerializer, SerializeToBuffer)
+{
+    tsw::BsonSerializer serializer;
+    tsw::Message message(tsw::MessageType::Event, test_fields());
+    tsw::BinData buffer;
+
+    serializer.SerializeMessageTo(message, buffer);
+    EXPECT_EQ(buffer, serializer.SerializeMessage(message));
+
+    // Buffer memory is reused by the next serialization.
+    auto data = buffer.data();
+    auto capacity = buffer.capacity();
+
+    serializer.SerializeMessageTo(message, buffer);
+    EXPECT_EQ(buffer.data(), data);
+    EXPECT_EQ(buffer.capacity(), capacity);
+    EXPECT_EQ(tsw::BsonDeserializer().DeserializeMessage(buffer).get_fields(), message.get_fields());
 
+    auto clone = serializer.Clone();
+    EXPECT_TRUE(serializer.Cloneable());
+    ASSERT_NE(clone, nullptr);
+    EXPECT_EQ(clone->SerializeMessage(message), buffer);
 }
@@ -0,0 +1,189 @@
+/**
+  * @file bson_stream_deserializer_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief BsonStreamDeserializer tests.
+  *
+  */
+
+#include <algorithm>
+#include <memory>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/bson_stream_deserializer.h>
+#include <tsw/error.h>
+#include <tsw/message.h>
+
+#include "tests_common.h"
+
+
+// Collects decoded parts. Binary chunks are concatenated.
+class RecordingHandler : public tsw::StreamHandler
+{
+public:
+    void on_envelope(const tsw::Message &envelope) override
+    {
+        envelope_.reset(new tsw::Message(envelope));
+        EXPECT_TRUE(envelope.get_fields().empty());
+    }
+
+    void on_field(const tsw::String &name, tsw::Value &&value) override
+    {
+        EXPECT_TRUE(envelope_ != nullptr);
+        fields_[name] = std::move(value);
+    }
+
+    void on_binary_chunk(const tsw::String &name, const tsw::BinData::value_type *data, size_t size,
+                         size_t offset, size_t total_size) override
+    {
+        if (!offset) binaries_[name] = tsw::BinData();
+
+        auto &binary = binaries_[name].as_bindata();
+
+        EXPECT_EQ(binary.size(), offset);
+        binary.insert(binary.end(), data, data + size);
+        EXPECT_LE(binary.size(), total_size);
+        max_chunk_size_ = std::max(max_chunk_size_, size);
+    }
+
+    void on_message_end() override
+    {
+        ++messages_count_;
+    }
+
+public:
+    std::unique_ptr<tsw::Message> envelope_;
+    tsw::NameValueMap fields_;
+    tsw::NameValueMap binaries_;
+    size_t max_chunk_size_ = 0;
+    size_t messages_count_ = 0;
+};
+
+
+static tsw::Message test_message(size_t binary_size)
+{
+    return tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "stream_event"),
+        std::make_pair("counter", 123),
+        std::make_pair("big_counter", int64_t(-100000000000)),
+        std::make_pair("value", 0.777),
+        std::make_pair("flag", true),
+        std::make_pair("null", tsw::Null()),
+        std::make_pair("m_time", tsw::Time(1500000000123456789)),
+        std::make_pair("object", tsw::Object{ {"nested", tsw::Object{ {"a", 1} }}, {"b", "c"} }),
+        std::make_pair("array", tsw::ValueArray{1, "two", 3.0}),
+        std::make_pair("samples", tsw::DoubleArray(100, 0.5)),
+        std::make_pair("raw", tsw::BinData(binary_size, 0x55))
+    }, 10);
+}
+
+
+TEST(BsonStreamDeserializer, Chunks)
+{
+    auto message = test_message(100);
+    auto data = tsw::BsonSerializer().SerializeMessage(message);
+
+    for (size_t chunk_size: { size_t(1), size_t(7), size_t(64), data.size() })
+    {
+        RecordingHandler handler;
+        tsw::BsonStreamDeserializer deserializer(handler);
+
+        for (size_t offset = 0; offset < data.size(); offset += chunk_size)
+        {
+            deserializer.feed(data.data() + offset, std::min(chunk_size, data.size() - offset));
+        }
+        deserializer.finish();
+
+        ASSERT_TRUE(handler.envelope_ != nullptr);
+        EXPECT_EQ(handler.envelope_->get_type(), message.get_type());
+        EXPECT_EQ(handler.envelope_->get_creation_time(), message.get_creation_time());
+        EXPECT_EQ(handler.envelope_->get_sender_module_uid(), message.get_sender_module_uid());
+        EXPECT_EQ(handler.fields_, message.get_fields()) << chunk_size;
+        EXPECT_TRUE(handler.binaries_.empty());
+        EXPECT_EQ(handler.messages_count_, 1u);
+        EXPECT_FALSE(deserializer.in_message());
+    }
+}
+
+
+TEST(BsonStreamDeserializer, BinaryStreaming)
+{
+    const size_t binary_size = 1024 * 1024;
+    const size_t part_size = 4096;
+    auto message = test_message(binary_size);
+    auto data = tsw::BsonSerializer().SerializeMessage(message);
+    RecordingHandler handler;
+
+    // Element limit is much less, than the message: binary field is not buffered.
+    tsw::BsonStreamDeserializer deserializer(handler, 1024, 2048);
+
+    for (size_t offset = 0; offset < data.size(); offset += part_size)
+    {
+        deserializer.feed(data.data() + offset, std::min(part_size, data.size() - offset));
+    }
+    deserializer.finish();
+
+    auto fields = message.get_fields();
+
+    EXPECT_EQ(handler.binaries_["raw"], fields["raw"]);
+    EXPECT_LE(handler.max_chunk_size_, part_size);
+    fields.erase("raw");
+    EXPECT_EQ(handler.fields_, fields);
+    EXPECT_EQ(handler.messages_count_, 1u);
+
+    // Without streaming binary field exceeds the limit.
+    tsw::BsonStreamDeserializer limited(handler, binary_size + 1, 2048);
+    EXPECT_THROW(limited.feed(data), tsw::Exception);
+    EXPECT_FALSE(limited.in_message());
+}
+
+
+TEST(BsonStreamDeserializer, SeveralMessages)
+{
+    tsw::BsonSerializer serializer;
+    auto data = serializer.SerializeMessage(test_message(10));
+    auto second = serializer.SerializeMessage(tsw::Message(tsw::MessageType::Action, tsw::NameValueMap()));
+
+    data.insert(data.end(), second.begin(), second.end());
+
+    RecordingHandler handler;
+    tsw::BsonStreamDeserializer deserializer(handler);
+
+    deserializer.feed(data);
+    deserializer.finish();
+
+    EXPECT_EQ(handler.messages_count_, 2u);
+    EXPECT_EQ(handler.envelope_->get_type(), tsw::MessageType::Action);
+}
+
+
+TEST(BsonStreamDeserializer, MalformedData)
+{
+    auto data = tsw::BsonSerializer().SerializeMessage(test_message(10));
+    RecordingHandler handler;
+    tsw::BsonStreamDeserializer deserializer(handler);
+
+    // Truncated message.
+    deserializer.feed(data.data(), data.size() - 1);
+    EXPECT_TRUE(deserializer.in_message());
+    EXPECT_THROW(deserializer.finish(), tsw::Exception);
+    EXPECT_FALSE(deserializer.in_message());
+
+    // Message size, which doesn't match the elements.
+    auto wrong_size = data;
+    wrong_size[0] += 1;
+    EXPECT_THROW(deserializer.feed(wrong_size), tsw::Exception);
+
+    wrong_size[0] -= 2;
+    EXPECT_THROW(deserializer.feed(wrong_size), tsw::Exception);
+
+    // Object without the message envelope.
+    auto object = tsw::BsonSerializer().SerializeObject(tsw::Object{ {"a", 1} });
+    EXPECT_THROW(deserializer.feed(object), tsw::Exception);
+
+    // Deserializer is usable after the errors.
+    handler.fields_.clear();
+    deserializer.feed(data);
+    deserializer.finish();
+    EXPECT_EQ(handler.fields_, test_message(10).get_fields());
+}
@@ -0,0 +1,137 @@
+/**
+  * @file bson_view_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief BsonView tests.
+  *
+  */
+
+#include <tsw/bson_view.h>
+#include <tsw/error.h>
+
+#include "tests_common.h"
+
+
+// "test": { "a": "b", "b": -100000000000 }
+static const tsw::BinData::value_type bson_test_a_b_b_m1[] =
+{
+    0x24, 0x00, 0x00, 0x00, 0x03, 0x74, 0x65, 0x73,
+    0x74, 0x00, 0x19, 0x00, 0x00, 0x00, 0x02, 0x61,
+    0x00, 0x02, 0x00, 0x00, 0x00, 0x62, 0x00, 0x12,
+    0x62, 0x00, 0x00, 0x18, 0x89, 0xB7, 0xE8, 0xFF,
+    0xFF, 0xFF, 0x00, 0x00
+};
+
+
+// "test_arr": ["aaa", 123, true],
+// "test_list": [123, "bbb", true, -1L]
+static const tsw::BinData::value_type bson_test_containers[] =
+{
+    0x5B, 0x00, 0x00, 0x00, 0x04, 0x74, 0x65, 0x73,
+    0x74, 0x5F, 0x61, 0x72, 0x72, 0x00, 0x1B, 0x00,
+    0x00, 0x00, 0x02, 0x30, 0x00, 0x04, 0x00, 0x00,
+    0x00, 0x61, 0x61, 0x61, 0x00, 0x10, 0x31, 0x00,
+    0x7B, 0x00, 0x00, 0x00, 0x08, 0x32, 0x00, 0x01,
+    0x00, 0x04, 0x74, 0x65, 0x73, 0x74, 0x5F, 0x6C,
+    0x69, 0x73, 0x74, 0x00, 0x26, 0x00, 0x00, 0x00,
+    0x10, 0x30, 0x00, 0x7B, 0x00, 0x00, 0x00, 0x02,
+    0x31, 0x00, 0x04, 0x00, 0x00, 0x00, 0x62, 0x62,
+    0x62, 0x00, 0x08, 0x32, 0x00, 0x01, 0x12, 0x33,
+    0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x00
+};
+
+
+TEST(BsonView, Empty)
+{
+    tsw::BsonView v;
+
+    EXPECT_TRUE(v.empty());
+    EXPECT_FALSE(v.has_field("test"));
+    EXPECT_EQ(v.field_type("test"), tsw::ValueType::Undefined);
+    EXPECT_TRUE(v.get_value("test").is_undefined());
+    EXPECT_TRUE(v.to_object().empty());
+    EXPECT_THROW(v.as_int32("test"), tsw::Exception);
+}
+
+
+TEST(BsonView, IncorrectSize)
+{
+    EXPECT_THROW(tsw::BsonView(bson_test_a_b_b_m1, sizeof(bson_test_a_b_b_m1) - 1), tsw::Exception);
+    EXPECT_THROW(tsw::BsonView(bson_test_a_b_b_m1, 3), tsw::Exception);
+}
+
+
+TEST(BsonView, CorruptedSizes)
+{
+    tsw::BinData data(bson_test_a_b_b_m1, bson_test_a_b_b_m1 + sizeof(bson_test_a_b_b_m1));
+
+    // Nested document is larger, than the parent.
+    data[10] = 0x30;
+    EXPECT_THROW(tsw::BsonView(data.data(), data.size()).as_view("test"), tsw::Exception);
+
+    data[10] = 0x19;
+
+    auto nested = tsw::BsonView(data.data(), data.size()).as_view("test");
+
+    // String length prefix is out of the document or doesn't include the trailing zero.
+    data[17] = 0x7f;
+    EXPECT_THROW(nested.as_string("a"), tsw::Exception);
+    data[17] = 0;
+    EXPECT_THROW(nested.as_string("a"), tsw::Exception);
+}
+
+
+TEST(BsonView, NestedObject)
+{
+    tsw::BsonView v(bson_test_a_b_b_m1, sizeof(bson_test_a_b_b_m1));
+
+    ASSERT_TRUE(v.has_field("test"));
+    EXPECT_FALSE(v.has_field("a"));
+    EXPECT_EQ(v.field_type("test"), tsw::ValueType::Object);
+
+    auto nested = v.as_view("test");
+
+    EXPECT_EQ(nested.field_type("a"), tsw::ValueType::String);
+    EXPECT_EQ(nested.as_string("a"), "b");
+    EXPECT_EQ(nested.field_type("b"), tsw::ValueType::Int64Number);
+    EXPECT_EQ(nested.as_int64("b"), -100000000000);
+    EXPECT_THROW(nested.as_int32("b"), tsw::Exception);
+    EXPECT_THROW(nested.as_int64("c"), tsw::Exception);
+
+    auto obj = v.to_object();
+    ASSERT_TRUE(obj["test"].is_object());
+    EXPECT_EQ(obj["test"].as_object()["a"].as_string(), "b");
+}
+
+
+TEST(BsonView, Containers)
+{
+    tsw::BsonView v(bson_test_containers, sizeof(bson_test_containers));
+
+    EXPECT_EQ(v.field_type("test_arr"), tsw::ValueType::Array);
+
+    auto arr = v.as_view("test_arr");
+    EXPECT_EQ(arr.as_string("0"), "aaa");
+    EXPECT_EQ(arr.as_int32("1"), 123);
+    EXPECT_TRUE(arr.as_bool("2"));
+
+    tsw::Value list = v.get_value("test_list");
+    ASSERT_TRUE(list.is_array());
+    ASSERT_EQ(list.as_array().size(), 4);
+    EXPECT_EQ(list.as_array()[3].as_int64(), -1);
+}
+
+
+TEST(BsonView, Index)
+{
+    tsw::BsonView v(bson_test_containers, sizeof(bson_test_containers));
+    auto list = v.as_view("test_list");
+
+    list.build_index();
+
+    EXPECT_EQ(list.as_int32("0"), 123);
+    EXPECT_EQ(list.as_string("1"), "bbb");
+    EXPECT_TRUE(list.as_bool("2"));
+    EXPECT_EQ(list.as_int64("3"), -1);
+    EXPECT_FALSE(list.has_field("4"));
+}
@@ -0,0 +1,230 @@
+/**
+  * @file chunked_transfer_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief TransferSplitter and TransferAssembler tests.
+  *
+  */
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/error.h>
+#include <tsw/message.h>
+
+#include <impl/chunked_transfer.h>
+
+#include "tests_common.h"
+
+
+static const size_t chunk_size = 64 * 1024;
+
+
+static tsw::Message large_message(size_t binary_size)
+{
+    tsw::BinData data(binary_size);
+
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<tsw::BinData::value_type>(i * 7);
+
+    return tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "large_event"),
+        std::make_pair("counter", 123),
+        std::make_pair("small", tsw::BinData(100, 0x55)),
+        std::make_pair("large", data),
+        std::make_pair("second_large", tsw::BinData(chunk_size + 1, 0x11))
+    }, 10);
+}
+
+
+// Frames, passed through the wire format.
+static std::vector<tsw::Message> split(const tsw::Message &message, tsw::UID transfer_id)
+{
+    tsw::impl::TransferSplitter splitter(message, transfer_id, chunk_size);
+    tsw::BsonSerializer serializer;
+    tsw::BsonDeserializer deserializer;
+    std::vector<tsw::Message> result;
+
+    for (size_t i = 0; i < splitter.frames_count(); ++i)
+    {
+        auto data = serializer.SerializeMessage(splitter.frame(i));
+
+        EXPECT_LE(data.size(), chunk_size + 1024);
+        result.push_back(deserializer.DeserializeMessage(data));
+    }
+
+    return result;
+}
+
+
+TEST(ChunkedTransfer, Split)
+{
+    auto message = large_message(3 * chunk_size + 100);
+
+    EXPECT_TRUE(tsw::impl::TransferSplitter::need_split(message, chunk_size));
+    EXPECT_FALSE(tsw::impl::TransferSplitter::need_split(message, 4 * chunk_size));
+
+    tsw::impl::TransferSplitter splitter(message, 1, chunk_size);
+
+    // Head, four chunks of the "large" and two of the "second_large".
+    EXPECT_EQ(splitter.frames_count(), 7u);
+
+    auto head = splitter.frame(0);
+
+    EXPECT_EQ(head.get_type(), tsw::MessageType::DataTransfer);
+    EXPECT_EQ(head.get_receiver_module_uid(), message.get_receiver_module_uid());
+    EXPECT_EQ(head.get_fields().at("fields").as_object().size(), 3u);
+    EXPECT_THROW(splitter.frame(7), std::out_of_range);
+}
+
+
+TEST(ChunkedTransfer, Reassembly)
+{
+    auto message = large_message(3 * chunk_size + 100);
+    std::vector<tsw::Message> received;
+    tsw::impl::TransferAssembler assembler([&received](const tsw::Message &m) { received.push_back(m); return true; });
+
+    message.set_ttl(std::chrono::seconds(60));
+
+    // Frames of two transfers are interleaved.
+    auto first = split(message, 1);
+    auto second = split(message, 2);
+
+    for (size_t i = 0; i < first.size(); ++i)
+    {
+        EXPECT_TRUE(assembler.add_frame(first[i]));
+        EXPECT_TRUE(assembler.add_frame(second[i]));
+    }
+
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(assembler.transfers_count(), 0u);
+
+    for (const auto &result: received)
+    {
+        EXPECT_EQ(result.get_type(), message.get_type());
+        EXPECT_EQ(result.get_creation_time(), message.get_creation_time());
+        EXPECT_EQ(result.get_deadline(), message.get_deadline());
+        EXPECT_EQ(result.get_sender_module_uid(), message.get_sender_module_uid());
+        EXPECT_EQ(result.get_fields(), message.get_fields());
+    }
+}
+
+
+TEST(ChunkedTransfer, Resume)
+{
+    auto message = large_message(3 * chunk_size);
+    size_t received = 0;
+    tsw::impl::TransferAssembler assembler([&](const tsw::Message &m)
+    {
+        EXPECT_EQ(m.get_fields(), message.get_fields());
+        ++received;
+        return true;
+    });
+    auto frames = split(message, 1);
+
+    // Sender doesn't know, whether the third frame was delivered: it's repeated with the head.
+    for (size_t i = 0; i < 3; ++i) assembler.add_frame(frames[i]);
+    assembler.add_frame(frames[0]);
+    for (size_t i = 2; i < frames.size(); ++i) assembler.add_frame(frames[i]);
+
+    EXPECT_EQ(received, 1u);
+
+    // Lost chunk breaks the transfer, but not the receiving.
+    assembler.add_frame(frames[0]);
+    EXPECT_TRUE(assembler.add_frame(frames[2]));
+    EXPECT_EQ(assembler.transfers_count(), 0u);
+    EXPECT_EQ(assembler.dropped_count(), 1u);
+
+    // Rest of the dropped transfer is ignored.
+    EXPECT_TRUE(assembler.add_frame(frames[3]));
+    EXPECT_EQ(received, 1u);
+}
+
+
+TEST(ChunkedTransfer, Streaming)
+{
+    class Handler : public tsw::StreamHandler
+    {
+    public:
+        void on_envelope(const tsw::Message &envelope) override { type = envelope.get_type(); }
+        void on_field(const tsw::String &name, tsw::Value &&value) override { fields[name] = std::move(value); }
+        void on_binary_chunk(const tsw::String &name, const tsw::BinData::value_type *data, size_t size,
+                             size_t offset, size_t total_size) override
+        {
+            if (!offset) fields[name] = tsw::BinData();
+
+            auto &binary = fields[name].as_bindata();
+
+            EXPECT_EQ(binary.size(), offset);
+            EXPECT_LE(size, chunk_size);
+            binary.insert(binary.end(), data, data + size);
+            EXPECT_LE(binary.size(), total_size);
+        }
+        void on_message_end() override { ++messages_count; }
+
+    public:
+        tsw::MessageType type = tsw::MessageType::ZLast;
+        tsw::NameValueMap fields;
+        size_t messages_count = 0;
+    } handler;
+
+    auto message = large_message(2 * chunk_size + 1);
+    tsw::impl::TransferAssembler assembler([](const tsw::Message&) { ADD_FAILURE(); return true; });
+
+    assembler.set_stream_handler(&handler);
+
+    for (const auto &frame: split(message, 1)) assembler.add_frame(frame);
+
+    EXPECT_EQ(handler.messages_count, 1u);
+    EXPECT_EQ(handler.type, message.get_type());
+    EXPECT_EQ(handler.fields, message.get_fields());
+}
+
+
+TEST(ChunkedTransfer, TransfersLimit)
+{
+    auto message = large_message(chunk_size + 1);
+    size_t received = 0;
+    tsw::impl::TransferAssembler assembler([&received](const tsw::Message&) { ++received; return true; }, 2);
+
+    auto first = split(message, 1);
+
+    assembler.add_frame(first[0]);
+    assembler.add_frame(split(message, 2)[0]);
+    assembler.add_frame(split(message, 3)[0]);
+    EXPECT_EQ(assembler.transfers_count(), 2u);
+
+    // The oldest transfer was dropped.
+    for (size_t i = 1; i < first.size(); ++i) assembler.add_frame(first[i]);
+    EXPECT_EQ(received, 0u);
+
+    EXPECT_TRUE(assembler.add_frame(tsw::Message(tsw::MessageType::DataTransfer, tsw::NameValueMap())));
+    EXPECT_EQ(assembler.dropped_count(), 1u);
+}
+
+
+TEST(ChunkedTransfer, SizeLimit)
+{
+    auto message = large_message(2 * chunk_size);
+    size_t received = 0;
+    tsw::impl::TransferAssembler assembler([&received](const tsw::Message&) { ++received; return true; },
+                                           tsw::impl::TransferAssembler::default_max_transfers, 2 * chunk_size);
+
+    // Head announces more, than the limit: transfer isn't started, its chunks are ignored.
+    for (const auto &frame: split(message, 1)) EXPECT_TRUE(assembler.add_frame(frame));
+
+    EXPECT_EQ(received, 0u);
+    EXPECT_EQ(assembler.transfers_count(), 0u);
+    EXPECT_EQ(assembler.dropped_count(), 1u);
+
+    // Forged negative size.
+    auto head = split(message, 2)[0];
+    auto fields = head.get_fields();
+
+    fields["binaries"].as_object().begin()->second = int64_t(-1);
+    EXPECT_TRUE(assembler.add_frame(tsw::Message(tsw::MessageType::DataTransfer, fields)));
+    EXPECT_EQ(assembler.transfers_count(), 0u);
+    EXPECT_EQ(assembler.dropped_count(), 2u);
+}
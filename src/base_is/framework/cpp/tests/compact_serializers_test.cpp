@@ -0,0 +1,188 @@
+/**
+  * @file compact_serializers_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MessagePack and CBOR serializers and deserializers tests.
+  *
+  */
+
+#include <limits>
+
+#include <tsw/cbor_deserializer.h>
+#include <tsw/cbor_serializer.h>
+#include <tsw/error.h>
+#include <tsw/message.h>
+#include <tsw/msgpack_deserializer.h>
+#include <tsw/msgpack_serializer.h>
+
+#include "tests_common.h"
+
+
+static tsw::NameValueMap all_types_fields()
+{
+    return tsw::NameValueMap
+    {
+        std::make_pair("undefined", tsw::Value()),
+        std::make_pair("null", tsw::Null()),
+        std::make_pair("true", true),
+        std::make_pair("false", false),
+        std::make_pair("int32_small", 5),
+        std::make_pair("int32_negative", -100000),
+        std::make_pair("int32_max", std::numeric_limits<int32_t>::max()),
+        std::make_pair("int32_min", std::numeric_limits<int32_t>::min()),
+        std::make_pair("int64_small", int64_t(7)),
+        std::make_pair("int64_max", std::numeric_limits<int64_t>::max()),
+        std::make_pair("int64_min", std::numeric_limits<int64_t>::min()),
+        std::make_pair("double", 0.777),
+        std::make_pair("string", "test string"),
+        std::make_pair("long_string", tsw::String(70000, 'x')),
+        std::make_pair("bindata", tsw::BinData{0x00, 0x01, 0xff}),
+        std::make_pair("time", tsw::Time(1500000000123456789)),
+        std::make_pair("time_seconds", tsw::Time(1500000000000000000)),
+        std::make_pair("time_negative", tsw::Time(-1500000001)),
+        std::make_pair("time_far", tsw::Time(std::numeric_limits<int64_t>::max())),
+        std::make_pair("array", tsw::ValueArray{1, "two", 3.0, tsw::ValueArray{}, tsw::Null()}),
+        std::make_pair("object", tsw::Object{ {"nested", tsw::Object{ {"a", 1} }}, {"b", "c"} }),
+        std::make_pair("double_array", tsw::DoubleArray{1.0, -2.5, 3.25}),
+        std::make_pair("int32_array", tsw::Int32Array{1, -2, 3}),
+        std::make_pair("empty_double_array", tsw::DoubleArray{})
+    };
+}
+
+
+template<typename Codec>
+class CompactSerializerTest : public ::testing::Test
+{
+protected:
+    typename Codec::first_type serializer_;
+    typename Codec::second_type deserializer_;
+};
+
+typedef ::testing::Types<std::pair<tsw::MsgPackSerializer, tsw::MsgPackDeserializer>,
+                         std::pair<tsw::CborSerializer, tsw::CborDeserializer>> CompactCodecs;
+TYPED_TEST_CASE(CompactSerializerTest, CompactCodecs);
+
+
+TYPED_TEST(CompactSerializerTest, ObjectRoundTrip)
+{
+    auto fields = all_types_fields();
+    auto data = this->serializer_.SerializeObject(fields);
+    auto result = this->deserializer_.DeserializeObject(data);
+
+    EXPECT_EQ(result, fields);
+
+    // Types are kept, not only values.
+    EXPECT_TRUE(result["int64_small"].is_int64());
+    EXPECT_TRUE(result["int32_small"].is_int32());
+    EXPECT_TRUE(result["undefined"].is_undefined());
+    EXPECT_TRUE(result["null"].is_null());
+    EXPECT_TRUE(result["time"].is_time());
+
+    EXPECT_EQ(this->deserializer_.DeserializeObject(this->serializer_.SerializeObject(tsw::Object())), tsw::Object());
+}
+
+
+TYPED_TEST(CompactSerializerTest, MessageRoundTrip)
+{
+    tsw::Message message(tsw::MessageType::Event, all_types_fields());
+    tsw::BinData buffer;
+
+    this->serializer_.SerializeMessageTo(message, buffer);
+    EXPECT_EQ(buffer, this->serializer_.SerializeMessage(message));
+    EXPECT_EQ(this->deserializer_.DeserializeMessageType(buffer.data(), buffer.size()), tsw::MessageType::Event);
+
+    auto result = this->deserializer_.DeserializeMessage(buffer);
+
+    EXPECT_EQ(result.get_type(), message.get_type());
+    EXPECT_EQ(result.get_creation_time(), message.get_creation_time());
+    EXPECT_EQ(result.get_sender_module_uid(), message.get_sender_module_uid());
+    EXPECT_EQ(result.get_fields(), message.get_fields());
+}
+
+
+TYPED_TEST(CompactSerializerTest, MalformedData)
+{
+    auto data = this->serializer_.SerializeObject(all_types_fields());
+
+    // Every truncation is detected.
+    for (size_t size = 0; size < data.size(); size += 97)
+    {
+        EXPECT_THROW(this->deserializer_.DeserializeObject(data.data(), size), tsw::Exception);
+    }
+
+    data.push_back(0);
+    EXPECT_THROW(this->deserializer_.DeserializeObject(data), tsw::Exception);
+
+    // Too deep nesting.
+    tsw::Value deep = tsw::ValueArray{};
+    for (int i = 0; i < 200; ++i) deep = tsw::ValueArray{deep};
+    data = this->serializer_.SerializeObject(tsw::Object{ {"deep", deep} });
+    EXPECT_THROW(this->deserializer_.DeserializeObject(data), tsw::Exception);
+}
+
+
+TEST(MsgPackSerializer, Encoding)
+{
+    tsw::MsgPackSerializer serializer;
+
+    // map16 document, fixstr key, positive fixint.
+    EXPECT_EQ(serializer.SerializeObject(tsw::Object{ {"a", 1} }), (tsw::BinData{0xde, 0x00, 0x01, 0xa1, 'a', 0x01}));
+    // Int64 is always int 64.
+    EXPECT_EQ(serializer.SerializeObject(tsw::Object{ {"a", int64_t(1)} }),
+              (tsw::BinData{0xde, 0x00, 0x01, 0xa1, 'a', 0xd3, 0, 0, 0, 0, 0, 0, 0, 0x01}));
+    // Timestamp 32.
+    EXPECT_EQ(serializer.SerializeObject(tsw::Object{ {"t", tsw::Time(1000000000)} }),
+              (tsw::BinData{0xde, 0x00, 0x01, 0xa1, 't', 0xd6, 0xff, 0, 0, 0, 0x01}));
+}
+
+
+TEST(MsgPackDeserializer, ForeignIntegers)
+{
+    tsw::MsgPackDeserializer deserializer;
+
+    // uint 32, which is out of the Int32 range, and uint 8.
+    auto result = deserializer.DeserializeObject(tsw::BinData{0x82, 0xa1, 'a', 0xce, 0xff, 0xff, 0xff, 0xff,
+                                                                    0xa1, 'b', 0xcc, 0x80});
+
+    EXPECT_EQ(result["a"], tsw::Value(int64_t(0xffffffff)));
+    EXPECT_EQ(result["b"], tsw::Value(128));
+
+    // uint 64 out of the Int64 range.
+    EXPECT_THROW(deserializer.DeserializeObject(tsw::BinData{0x81, 0xa1, 'a', 0xcf, 0xff, 0, 0, 0, 0, 0, 0, 0}),
+                 tsw::Exception);
+}
+
+
+TEST(CborSerializer, Encoding)
+{
+    tsw::CborSerializer serializer;
+
+    // Indefinite map document.
+    EXPECT_EQ(serializer.SerializeObject(tsw::Object{ {"a", -1} }), (tsw::BinData{0xbf, 0x61, 'a', 0x20, 0xff}));
+    // Int64 is always with 8 bytes argument.
+    EXPECT_EQ(serializer.SerializeObject(tsw::Object{ {"a", int64_t(1)} }),
+              (tsw::BinData{0xbf, 0x61, 'a', 0x1b, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff}));
+    // Extended time tag.
+    EXPECT_EQ(serializer.SerializeObject(tsw::Object{ {"t", tsw::Time(1000000000)} }),
+              (tsw::BinData{0xbf, 0x61, 't', 0xd9, 0x03, 0xe9, 0xa1, 0x01, 0x1b, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff}));
+}
+
+
+TEST(CborDeserializer, ForeignItems)
+{
+    tsw::CborDeserializer deserializer;
+
+    // Definite map: half float, epoch time, indefinite string chunks and an unknown tag.
+    auto result = deserializer.DeserializeObject(tsw::BinData{0xa4,
+                                                              0x61, 'h', 0xf9, 0x3c, 0x00,
+                                                              0x61, 't', 0xc1, 0x1a, 0x00, 0x00, 0x00, 0x02,
+                                                              0x61, 's', 0x7f, 0x61, 'a', 0x62, 'b', 'c', 0xff,
+                                                              0x61, 'u', 0xd8, 0x20, 0x61, 'x'});
+
+    EXPECT_EQ(result["h"], tsw::Value(1.0));
+    EXPECT_EQ(result["t"], tsw::Value(tsw::Time(2000000000)));
+    EXPECT_EQ(result["s"], tsw::Value("abc"));
+    EXPECT_EQ(result["u"], tsw::Value("x"));
+
+    // Keys must be strings.
+    EXPECT_THROW(deserializer.DeserializeObject(tsw::BinData{0xa1, 0x01, 0x01}), tsw::Exception);
+}
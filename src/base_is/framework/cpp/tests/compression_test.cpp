@@ -0,0 +1,144 @@
+/**
+  * @file compression_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Magistral frames compression tests.
+  *
+  */
+
+#include <random>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/compression.h>
+#include <tsw/error.h>
+#include <tsw/json_serializer.h>
+#include <tsw/message.h>
+#include <tsw/wire_format.h>
+
+#include "tests_common.h"
+
+
+static tsw::Message typical_message()
+{
+    return tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("unit", "V"),
+        std::make_pair("m_time", tsw::Time(1500000000123456789)),
+        std::make_pair("description", "Sensor measurement, sensor measurement, sensor measurement"),
+        std::make_pair("samples", tsw::ValueArray(50, tsw::Object{ {"value", 1.0}, {"valid", true} }))
+    });
+}
+
+
+TEST(Compression, Names)
+{
+    for (auto compression: { tsw::Compression::Lz4, tsw::Compression::Zstd })
+    {
+        EXPECT_EQ(tsw::compression_from_name(tsw::compression_name(compression)), compression);
+    }
+
+    EXPECT_EQ(tsw::compression_from_name("gzip"), tsw::Compression::None);
+
+    const tsw::Compressions supported{ tsw::Compression::Lz4 };
+
+    EXPECT_EQ(tsw::choose_compression(tsw::ValueArray{"zstd", 1, "lz4"}, supported), tsw::Compression::Lz4);
+    EXPECT_EQ(tsw::choose_compression(tsw::ValueArray{"zstd"}, supported), tsw::Compression::None);
+}
+
+
+TEST(Compression, RoundTrip)
+{
+    auto bson = tsw::BsonSerializer().SerializeMessage(typical_message());
+    auto json = tsw::JsonSerializer(tsw::JsonStyle::Compact).SerializeMessage(typical_message());
+
+    for (auto compression: tsw::supported_compressions())
+    {
+        for (const auto &dictionary: { tsw::default_compression_dictionary(), tsw::BinData() })
+        {
+            tsw::FrameCompressor compressor(compression, tsw::FrameCompressor::default_threshold, dictionary);
+
+            for (const auto &data: { bson, json })
+            {
+                tsw::BinData frame;
+                tsw::BinData result;
+
+                ASSERT_TRUE(compressor.compress(data, frame)) << tsw::compression_name(compression);
+                EXPECT_LT(frame.size(), data.size());
+                EXPECT_TRUE(tsw::FrameCompressor::is_compressed(frame.data(), frame.size()));
+                EXPECT_EQ(tsw::detect_wire_format(frame.data(), frame.size()), tsw::WireFormat::Unknown);
+
+                // Any compressor with the same dictionary decompresses any compression.
+                tsw::FrameCompressor(tsw::Compression::None, 0, dictionary).decompress(frame.data(), frame.size(), result);
+                EXPECT_EQ(result, data);
+            }
+        }
+    }
+
+    EXPECT_FALSE(tsw::FrameCompressor::is_compressed(bson.data(), bson.size()));
+}
+
+
+TEST(Compression, Threshold)
+{
+    auto data = tsw::BsonSerializer().SerializeMessage(typical_message());
+    tsw::BinData frame;
+
+    EXPECT_FALSE(tsw::FrameCompressor().compress(data, frame));
+
+    for (auto compression: tsw::supported_compressions())
+    {
+        EXPECT_FALSE(tsw::FrameCompressor(compression, data.size() + 1).compress(data, frame));
+
+        // Incompressible data is sent as is.
+        std::mt19937 generator(1);
+        tsw::BinData random(4096);
+
+        for (auto &c: random) c = static_cast<tsw::BinData::value_type>(generator());
+        EXPECT_FALSE(tsw::FrameCompressor(compression).compress(random, frame));
+    }
+
+    EXPECT_THROW(tsw::FrameCompressor(static_cast<tsw::Compression>(15)), tsw::Exception);
+}
+
+
+TEST(Compression, MalformedFrames)
+{
+    auto data = tsw::BsonSerializer().SerializeMessage(typical_message());
+
+    for (auto compression: tsw::supported_compressions())
+    {
+        tsw::FrameCompressor compressor(compression);
+        tsw::BinData frame;
+        tsw::BinData result;
+
+        ASSERT_TRUE(compressor.compress(data, frame));
+
+        // Another dictionary.
+        EXPECT_THROW(tsw::FrameCompressor(compression, 0, tsw::BinData(100, 'x')).decompress(frame.data(), frame.size(), result),
+                     tsw::Exception);
+        EXPECT_THROW(tsw::FrameCompressor(compression, 0, tsw::BinData()).decompress(frame.data(), frame.size(), result),
+                     tsw::Exception);
+
+        // Truncated frame.
+        EXPECT_THROW(compressor.decompress(frame.data(), frame.size() - 1, result), tsw::CompressionException);
+
+        // Declared size exceeds the limit: frame isn't allocated.
+        EXPECT_THROW(tsw::FrameCompressor(compression, 0, tsw::default_compression_dictionary(), data.size() - 1).
+                     decompress(frame.data(), frame.size(), result), tsw::CompressionException);
+        EXPECT_FALSE(tsw::FrameCompressor(compression, 0, tsw::default_compression_dictionary(), data.size() - 1).
+                     compress(data, frame));
+
+        ASSERT_TRUE(compressor.compress(data, frame));
+        frame[4] = frame[5] = frame[6] = frame[7] = 0x7f;
+        EXPECT_THROW(compressor.decompress(frame.data(), frame.size(), result), tsw::CompressionException);
+
+        // Wrong source size.
+        ASSERT_TRUE(compressor.compress(data, frame));
+        frame[4] += 1;
+        EXPECT_THROW(compressor.decompress(frame.data(), frame.size(), result), tsw::Exception);
+    }
+
+    EXPECT_THROW(tsw::FrameCompressor().decompress(data.data(), data.size(), data), tsw::Exception);
+}
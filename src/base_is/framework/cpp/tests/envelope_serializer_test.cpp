@@ -0,0 +1,165 @@
+/**
+  * @file envelope_serializer_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief EnvelopeSerializer and EnvelopeDeserializer tests.
+  *
+  */
+
+#include <chrono>
+#include <memory>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/envelope_deserializer.h>
+#include <tsw/envelope_header.h>
+#include <tsw/envelope_serializer.h>
+#include <tsw/error.h>
+#include <tsw/message.h>
+
+#include <impl/binary_message.h>
+
+#include "tests_common.h"
+
+
+static tsw::Message enveloped_message()
+{
+    return tsw::BinaryMessage(tsw::MessageType::Action, tsw::NameValueMap
+    {
+        std::make_pair("name", "set_mode"),
+        std::make_pair("mode", "auto"),
+        std::make_pair("samples", tsw::DoubleArray(10, 0.5)),
+        std::make_pair("parameters", tsw::Object{ {"timeout", int64_t(5000)}, {"force", false} })
+    },
+    12, "receiver_module", "receiver_class",
+    34, "sender_module", "sender_class",
+    tsw::Time(1500000000123456789));
+}
+
+
+static void expect_envelope_eq(const tsw::Message &result, const tsw::Message &expected)
+{
+    EXPECT_EQ(result.get_type(), expected.get_type());
+    EXPECT_EQ(result.get_sender_module_uid(), expected.get_sender_module_uid());
+    EXPECT_EQ(result.get_sender_module_name(), expected.get_sender_module_name());
+    EXPECT_EQ(result.get_sender_module_class(), expected.get_sender_module_class());
+    EXPECT_EQ(result.get_receiver_module_uid(), expected.get_receiver_module_uid());
+    EXPECT_EQ(result.get_receiver_module_name(), expected.get_receiver_module_name());
+    EXPECT_EQ(result.get_receiver_module_class(), expected.get_receiver_module_class());
+    EXPECT_EQ(result.get_creation_time(), expected.get_creation_time());
+    EXPECT_EQ(result.get_fields(), expected.get_fields());
+}
+
+
+TEST(EnvelopeSerializer, RoundTrip)
+{
+    auto message = enveloped_message();
+    tsw::EnvelopeSerializer serializer;
+    tsw::EnvelopeDeserializer deserializer;
+    auto data = serializer.SerializeMessage(message);
+    auto result = deserializer.DeserializeMessage(data);
+
+    expect_envelope_eq(result, message);
+    EXPECT_EQ(deserializer.DeserializeMessageType(data.data(), data.size()), tsw::MessageType::Action);
+
+    // Received message is forwarded as is.
+    EXPECT_EQ(serializer.SerializeMessage(result), data);
+
+    // Refill in place.
+    tsw::Message refilled(tsw::MessageType::Event, tsw::NameValueMap{ std::make_pair("name", "other") });
+
+    deserializer.DeserializeMessageTo(data.data(), data.size(), refilled);
+    expect_envelope_eq(refilled, message);
+
+    // Directly written fields.
+    tsw::BinData written;
+
+    serializer.SerializeFieldsTo(message, [](tsw::FieldWriter &writer)
+    {
+        writer.write("name", tsw::String("set_mode"));
+    }, written);
+    EXPECT_EQ(deserializer.DeserializeMessage(written).get_fields(), tsw::NameValueMap({ std::make_pair("name", "set_mode") }));
+}
+
+
+TEST(EnvelopeSerializer, HeaderPeek)
+{
+    auto message = enveloped_message();
+    auto data = tsw::EnvelopeSerializer().SerializeMessage(message);
+    tsw::EnvelopeHeader header;
+
+    ASSERT_TRUE(tsw::read_envelope_header(data.data(), data.size(), header));
+    EXPECT_EQ(header.version, tsw::EnvelopeHeader::current_version);
+    EXPECT_EQ(header.type, tsw::MessageType::Action);
+    EXPECT_EQ(header.sender_uid, 34u);
+    EXPECT_EQ(header.receiver_uid, 12u);
+    EXPECT_EQ(header.creation_time, message.get_creation_time());
+    EXPECT_EQ(header.deadline, tsw::Time::zero());
+    EXPECT_EQ(header.sender_name_id, tsw::envelope_name_id("sender_module"));
+    EXPECT_EQ(header.receiver_class_id, tsw::envelope_name_id("receiver_class"));
+    EXPECT_EQ(header.body_offset + header.body_size, data.size());
+    EXPECT_EQ(tsw::BsonView(data.data() + header.body_offset, header.body_size).to_object(), message.get_fields());
+
+    // Not an envelope or truncated.
+    auto bson = tsw::BsonSerializer().SerializeMessage(message);
+
+    EXPECT_FALSE(tsw::read_envelope_header(bson.data(), bson.size(), header));
+    EXPECT_FALSE(tsw::read_envelope_header(data.data(), tsw::EnvelopeHeader::size - 1, header));
+    EXPECT_FALSE(tsw::read_envelope_header(data.data(), data.size() - 1, header));
+    EXPECT_THROW(tsw::EnvelopeDeserializer().DeserializeMessage(bson), tsw::Exception);
+}
+
+
+TEST(EnvelopeSerializer, InternedNames)
+{
+    auto names = std::make_shared<tsw::EnvelopeNames>();
+    auto message = enveloped_message();
+
+    for (auto name: { "sender_module", "sender_class", "receiver_class" })
+    {
+        EXPECT_EQ(names->add(name), tsw::envelope_name_id(name));
+    }
+    EXPECT_EQ(names->add("sender_module"), tsw::envelope_name_id("sender_module"));
+    EXPECT_EQ(tsw::envelope_name_id(""), 0u);
+
+    auto inline_data = tsw::EnvelopeSerializer().SerializeMessage(message);
+    auto data = tsw::EnvelopeSerializer(names).SerializeMessage(message);
+    tsw::EnvelopeHeader header;
+
+    ASSERT_TRUE(tsw::read_envelope_header(data.data(), data.size(), header));
+    EXPECT_EQ(header.flags, tsw::EnvelopeHeader::InlineReceiverName);
+    EXPECT_LT(data.size(), inline_data.size());
+
+    expect_envelope_eq(tsw::EnvelopeDeserializer(names).DeserializeMessage(data), message);
+    expect_envelope_eq(tsw::EnvelopeDeserializer(names).DeserializeMessage(inline_data), message);
+
+    // Peer doesn't know the names.
+    EXPECT_THROW(tsw::EnvelopeDeserializer().DeserializeMessage(data), tsw::Exception);
+}
+
+
+TEST(EnvelopeSerializer, Deadline)
+{
+    auto message = enveloped_message();
+    tsw::EnvelopeSerializer serializer;
+    tsw::EnvelopeDeserializer deserializer;
+
+    message.set_ttl(std::chrono::milliseconds(1500));
+
+    auto data = serializer.SerializeMessage(message);
+    tsw::EnvelopeHeader header;
+
+    ASSERT_TRUE(tsw::read_envelope_header(data.data(), data.size(), header));
+    EXPECT_TRUE(header.flags & tsw::EnvelopeHeader::HasDeadline);
+    EXPECT_EQ(header.deadline, message.get_deadline());
+
+    auto result = deserializer.DeserializeMessage(data);
+
+    expect_envelope_eq(result, message);
+    EXPECT_EQ(result.get_deadline(), message.get_deadline());
+
+    // Recycled message doesn't keep the deadline of the previous one.
+    auto without_deadline = serializer.SerializeMessage(enveloped_message());
+
+    deserializer.DeserializeMessageTo(without_deadline.data(), without_deadline.size(), result);
+    expect_envelope_eq(result, enveloped_message());
+    EXPECT_FALSE(result.has_deadline());
+}
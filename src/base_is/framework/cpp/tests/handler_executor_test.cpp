@@ -0,0 +1,179 @@
+/**
+  * @file handler_executor_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief HandlerExecutor and ThreadPool tests.
+  *
+  */
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <impl/handler_executor.h>
+#include <impl/thread_pool.h>
+
+#include "tests_common.h"
+
+
+typedef std::function<void(std::atomic<int>&)> TestHandler;
+typedef tsw::impl::Subscription<TestHandler> TestSubscription;
+typedef std::vector<TestSubscription> TestHandlers;
+
+
+static const auto handler_delay = std::chrono::milliseconds(50);
+
+
+static std::shared_ptr<const TestHandlers> make_handlers(size_t count, TestHandler handler)
+{
+    TestHandlers result;
+
+    // Every subscription has own state, as the subscribed ones.
+    for (size_t i = 0; i < count; ++i) result.emplace_back(handler);
+
+    return std::make_shared<const TestHandlers>(std::move(result));
+}
+
+
+static std::chrono::milliseconds run_handlers(tsw::impl::HandlerExecutor &executor,
+                                              const std::shared_ptr<const TestHandlers> &handlers,
+                                              std::atomic<int> &counter)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    executor.run(handlers, [&counter](const TestHandler &handler) { handler(counter); });
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+
+static void slow_handler(std::atomic<int> &counter)
+{
+    std::this_thread::sleep_for(handler_delay);
+    ++counter;
+}
+
+
+TEST(ThreadPool, Tasks)
+{
+    std::atomic<int> counter(0);
+
+    {
+        tsw::impl::ThreadPool pool(2);
+
+        EXPECT_EQ(pool.size(), 2u);
+        EXPECT_FALSE(pool.is_worker_thread());
+
+        for (int i = 0; i < 100; ++i) pool.post([&counter]() { ++counter; });
+        pool.post([&pool, &counter]() { if (pool.is_worker_thread()) counter += 1000; });
+    }
+
+    // Queued tasks are finished before the destruction.
+    EXPECT_EQ(counter, 1100);
+}
+
+
+TEST(HandlerExecutor, Sequential)
+{
+    tsw::impl::HandlerExecutor executor;
+    std::atomic<int> counter(0);
+    auto handlers = make_handlers(3, slow_handler);
+
+    EXPECT_FALSE(executor.is_detached());
+    EXPECT_GE(run_handlers(executor, handlers, counter), 3 * handler_delay);
+    EXPECT_EQ(counter, 3);
+
+    auto timing = (*handlers)[0].state->timing();
+
+    EXPECT_EQ(timing.calls, 1u);
+    EXPECT_GE(timing.max_time, handler_delay);
+    EXPECT_EQ(timing.total_time, timing.max_time);
+    EXPECT_EQ(timing.histogram.count(), 1u);
+
+    auto failing = make_handlers(1, [](std::atomic<int>&) { throw std::runtime_error("handler error"); });
+
+    EXPECT_THROW(run_handlers(executor, failing, counter), std::runtime_error);
+    EXPECT_EQ((*failing)[0].state->timing().failed, 1u);
+}
+
+
+TEST(HandlerExecutor, Join)
+{
+    tsw::impl::HandlerExecutor executor;
+    tsw::HandlerExecutionPolicy policy;
+    std::atomic<int> counter(0);
+    auto handlers = make_handlers(4, slow_handler);
+
+    policy.execution = tsw::HandlerExecution::Join;
+    executor.set_policy(policy);
+    EXPECT_FALSE(executor.is_detached());
+
+    // Handlers run concurrently, caller waits for all of them.
+    auto elapsed = run_handlers(executor, handlers, counter);
+
+    EXPECT_EQ(counter, 4);
+    EXPECT_GE(elapsed, handler_delay);
+
+    // Exception doesn't reach the caller and doesn't stop the other handlers.
+    auto failing = std::make_shared<const TestHandlers>(TestHandlers
+    {
+        TestSubscription([](std::atomic<int>&) { throw std::runtime_error("handler error"); }),
+        TestSubscription([](std::atomic<int> &counter) { ++counter; })
+    });
+
+    run_handlers(executor, failing, counter);
+    EXPECT_EQ(counter, 5);
+    EXPECT_EQ((*failing)[0].state->timing().failed, 1u);
+}
+
+
+TEST(HandlerExecutor, Isolation)
+{
+    tsw::impl::HandlerExecutor executor;
+    tsw::HandlerExecutionPolicy policy;
+    std::atomic<int> counter(0);
+    std::atomic<int> fast_counter(0);
+    auto slow = make_handlers(1, slow_handler);
+    auto fast = make_handlers(1, [&fast_counter](std::atomic<int>&) { ++fast_counter; });
+
+    policy.execution = tsw::HandlerExecution::Join;
+    policy.join_timeout = handler_delay / 5;
+    executor.set_policy(policy);
+    EXPECT_TRUE(executor.is_detached());
+
+    // Caller doesn't wait for the slow handler, its next calls are skipped, while it runs.
+    for (int i = 0; i < 4; ++i) run_handlers(executor, slow, counter);
+    for (int i = 0; i < 10; ++i) run_handlers(executor, fast, counter);
+
+    EXPECT_EQ(fast_counter, 10);
+
+    std::this_thread::sleep_for(2 * handler_delay);
+
+    auto timing = (*slow)[0].state->timing();
+
+    EXPECT_EQ(counter, 1);
+    EXPECT_EQ(timing.calls, 1u);
+    EXPECT_EQ(timing.skipped, 3u);
+    EXPECT_EQ(timing.late, 1u);
+}
+
+
+TEST(HandlerExecutor, Detach)
+{
+    tsw::impl::HandlerExecutor executor;
+    tsw::HandlerExecutionPolicy policy;
+    auto counter = std::make_shared<std::atomic<int>>(0);
+    auto handlers = make_handlers(4, slow_handler);
+
+    policy.execution = tsw::HandlerExecution::Detach;
+    policy.max_handler_calls = 0;
+    executor.set_policy(policy);
+    EXPECT_TRUE(executor.is_detached());
+
+    executor.run(handlers, [counter](const TestHandler &handler) { handler(*counter); });
+
+    std::this_thread::sleep_for(4 * handler_delay);
+    EXPECT_EQ(*counter, 4);
+}
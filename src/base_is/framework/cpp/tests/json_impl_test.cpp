@@ -6,10 +6,17 @@
   */
 
 #include <chrono>
+#include <ctime>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 
 #include <boost/variant.hpp>
 
+#include <tsw/base64.h>
+#include <tsw/error.h>
+
 #include <impl/json_impl.h>
 
 #include "tests_common.h"
@@ -410,3 +417,120 @@ TEST(JsonImpl, ComplexSerialization)
     bd = json_simpl.get_buffer();
     EXPECT_FALSE(ArraysMatch(json_test_complex, bd.data(), bd.size()));
 }
+
+
+TEST(JsonImpl, FormatTime)
+{
+    char buffer[tsw::impl::JsonSerializerImpl::max_time_length];
+
+    // Same output, as the put_time() formatting had.
+    for (int64_t seconds: { int64_t(0), int64_t(951782400), int64_t(1506883943), int64_t(4107542399) })
+    {
+        for (int64_t ns: { 0, 5, 123456789 })
+        {
+            tsw::Time t = std::chrono::seconds(seconds) + tsw::Time(ns);
+            std::time_t tm = seconds;
+            std::stringstream ss;
+
+            ss << std::put_time(std::gmtime(&tm), "%FT%T") << "." << ns << "Z";
+            EXPECT_EQ(tsw::String(buffer, tsw::impl::JsonSerializerImpl::format_time(t, buffer)), ss.str());
+        }
+    }
+
+    auto size = tsw::impl::JsonSerializerImpl::format_time(std::chrono::seconds(-86401), buffer);
+    EXPECT_EQ(tsw::String(buffer, size), "1969-12-30T23:59:59.0Z");
+
+    auto max_size = tsw::impl::JsonSerializerImpl::format_time(tsw::Time(std::numeric_limits<int64_t>::max()), buffer);
+    EXPECT_EQ(tsw::String(buffer, max_size), "2262-04-11T23:47:16.854775807Z");
+}
+
+
+TEST(JsonImpl, CompactBuffer)
+{
+    tsw::impl::JsonSerializerImpl json_simpl(false);
+    tsw::BinData buffer(1024);
+    const auto capacity = buffer.capacity();
+
+    json_simpl.reset(buffer);
+    json_simpl.append_field("a", 1);
+    json_simpl.append_field("b", tsw::ValueArray{"x", tsw::Null()});
+    json_simpl.take_buffer(buffer);
+
+    EXPECT_EQ(tsw::String(buffer.begin(), buffer.end()), R"_({"a":1,"b":["x",null]})_");
+    EXPECT_GE(buffer.capacity(), capacity);
+
+    // Empty document after the taken one.
+    EXPECT_EQ(json_simpl.take_buffer(), (tsw::BinData{'{', '}'}));
+}
+
+
+TEST(JsonImpl, ParseTime)
+{
+    char buffer[tsw::impl::JsonSerializerImpl::max_time_length];
+    tsw::Time result;
+
+    for (int64_t ns: { int64_t(0), int64_t(951782400123456789), int64_t(1506883943000000005),
+                       std::numeric_limits<int64_t>::max(), int64_t(-86401000000000) })
+    {
+        auto size = tsw::impl::JsonSerializerImpl::format_time(tsw::Time(ns), buffer);
+
+        ASSERT_TRUE(tsw::impl::JsonDeserializerImpl::parse_time(buffer, size, result)) << tsw::String(buffer, size);
+        EXPECT_EQ(result.count(), ns);
+    }
+
+    const tsw::String time_strings[] = { "P2017Y10M01DT18H52M23S.7Z", "2017-10-01T18:52:23.000000007Z" };
+
+    for (const auto &s: time_strings)
+    {
+        ASSERT_TRUE(tsw::impl::JsonDeserializerImpl::parse_time(s.c_str(), s.size(), result)) << s;
+        EXPECT_EQ(result.count(), 1506883943000000007);
+    }
+
+    const tsw::String not_time_strings[] = { "", "test", "2017-10-01T18:52:23Z", "2017-10-01T18:52:23.Z",
+                                             "2017-10-01 18:52:23.0Z", "2017-13-01T18:52:23.0Z",
+                                             "2017-10-01T18:52:23.0Zx", "2017-10-01T18:52:23.1234567890Z",
+                                             "x2017-10-01T18:52:23.0Z" };
+
+    for (const auto &s: not_time_strings)
+    {
+        EXPECT_FALSE(tsw::impl::JsonDeserializerImpl::parse_time(s.c_str(), s.size(), result)) << s;
+    }
+}
+
+
+TEST(JsonImpl, SaxDeserialization)
+{
+    const tsw::String document = R"_({"a": [1, -2, 3000000000, 9223372036854775807, 1.5, null, true, {"x": "y"}],)_"
+                                 R"_( "b": {"c": {"d": []}, "e": "line\nbreak \"quoted\""}, "a": "last wins",)_"
+                                 R"_( "t": "2017-10-01T18:52:23.7Z", "bin": "BASE64:\nYWJj"})_";
+    tsw::BinData data(document.begin(), document.end());
+    tsw::impl::JsonDeserializerImpl json_dsimpl;
+
+    auto result = json_dsimpl.Deserialize(data.data(), data.size());
+
+    EXPECT_EQ(result["a"], tsw::Value("last wins"));
+    EXPECT_EQ(result["b"], tsw::Value(tsw::Object{ {"c", tsw::Object{ {"d", tsw::ValueArray{}} }},
+                                                   {"e", "line\nbreak \"quoted\""} }));
+    EXPECT_TRUE(result["t"].is_time());
+    EXPECT_EQ(result["bin"], tsw::Value(tsw::BinData{'a', 'b', 'c'}));
+
+    // In place parsing gives the same result.
+    auto insitu_data = data;
+    EXPECT_EQ(json_dsimpl.DeserializeInsitu(insitu_data), result);
+
+    const tsw::String array_document = R"_({"a": [1, -2, 3000000000, 9223372036854775807, 1.5, null, true, {"x": "y"}]})_";
+    auto array = json_dsimpl.Deserialize(reinterpret_cast<const tsw::BinData::value_type*>(array_document.c_str()),
+                                         array_document.size())["a"];
+
+    EXPECT_EQ(array, tsw::Value(tsw::ValueArray{1, -2, int64_t(3000000000), std::numeric_limits<int64_t>::max(), 1.5,
+                                                tsw::Null(), true, tsw::Object{ {"x", "y"} }}));
+    EXPECT_TRUE(array.as_array()[0].is_int32());
+    EXPECT_TRUE(array.as_array()[2].is_int64());
+
+    // Document must be an object.
+    for (const tsw::String &not_object: { "[1, 2]", "5", "\"s\"", "{\"a\": 1", "" })
+    {
+        EXPECT_THROW(json_dsimpl.Deserialize(reinterpret_cast<const tsw::BinData::value_type*>(not_object.c_str()),
+                                             not_object.size()), tsw::Exception) << not_object;
+    }
+}
@@ -1,14 +1,107 @@
 /**
-  * @file son_serializer_test.cpp
+  * @file json_serializer_test.cpp
   * @author Artiom N.(cl)2017
   * @brief JSON serializer tests.
   *
   */
 
+#include <sstream>
+
+#include <tsw/error.h>
+#include <tsw/json_deserializer.h>
+#include <tsw/json_serializer.h>
+#include <tsw/message.h>
+
 #include "tests_common.h"
 
 
+static tsw::Message test_message()
+{
+    return tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("m_time", tsw::Time(1500000000123456789)),
+        std::make_pair("raw", tsw::BinData{0x00, 0x01, 0xff}),
+        std::make_pair("nested", tsw::Object{ {"a", tsw::ValueArray{1, "two", true}} })
+    });
+}
+
+
 TEST(JsonSerializer, CorrectSerialization)
 {
+    tsw::JsonSerializer serializer;
+    tsw::JsonDeserializer deserializer;
+    auto message = test_message();
+    auto data = serializer.SerializeMessage(message);
+    auto result = deserializer.DeserializeMessage(data);
+
+    EXPECT_EQ(result.get_type(), message.get_type());
+    EXPECT_EQ(result.get_creation_time(), message.get_creation_time());
+    EXPECT_EQ(result.get_fields(), message.get_fields());
+}
+
+
+TEST(JsonSerializer, CompactStyle)
+{
+    tsw::JsonSerializer pretty;
+    tsw::JsonSerializer compact(tsw::JsonStyle::Compact);
+    tsw::JsonDeserializer deserializer;
+    auto message = test_message();
+    auto pretty_data = pretty.SerializeMessage(message);
+    auto compact_data = compact.SerializeMessage(message);
+
+    EXPECT_LT(compact_data.size(), pretty_data.size());
+    EXPECT_EQ(std::find(compact_data.begin(), compact_data.end(), '\n'), compact_data.end());
+    EXPECT_EQ(deserializer.DeserializeMessage(compact_data).get_fields(), message.get_fields());
+    EXPECT_EQ(deserializer.DeserializeObject(compact.SerializeObject(message.get_fields())), message.get_fields());
+    EXPECT_EQ(dynamic_cast<tsw::JsonSerializer&>(*compact.Clone()).get_style(), tsw::JsonStyle::Compact);
+}
+
+
+TEST(JsonSerializer, SerializeToBufferAndStream)
+{
+    tsw::JsonSerializer serializer(tsw::JsonStyle::Compact);
+    auto message = test_message();
+    tsw::BinData buffer;
+
+    serializer.SerializeMessageTo(message, buffer);
+    EXPECT_EQ(buffer, serializer.SerializeMessage(message));
+
+    // Buffer is reused.
+    const auto *memory = buffer.data();
+    serializer.SerializeMessageTo(message, buffer);
+    serializer.SerializeMessageTo(message, buffer);
+    EXPECT_EQ(buffer.data(), memory);
+
+    std::stringstream stream;
+    serializer.SerializeMessageTo(message, stream);
+    EXPECT_EQ(stream.str(), tsw::String(buffer.begin(), buffer.end()));
+
+    // Object, which is larger than the output chunk.
+    tsw::Object large{ {"samples", tsw::DoubleArray(50000, 0.125)}, {"name", "large"} };
+    std::stringstream large_stream;
+    serializer.SerializeObjectTo(large, large_stream);
+    auto data = serializer.SerializeObject(large);
+    EXPECT_EQ(large_stream.str(), tsw::String(data.begin(), data.end()));
+}
+
+
+TEST(JsonSerializer, MessageType)
+{
+    tsw::JsonSerializer serializer;
+    tsw::JsonDeserializer deserializer;
+    tsw::Message message(tsw::MessageType::Action, tsw::NameValueMap{ {"name", "action"}, {"nested", tsw::Object{ {"type", 1} }} });
+    auto data = serializer.SerializeMessage(message);
+
+    EXPECT_EQ(deserializer.DeserializeMessageType(data.data(), data.size()), tsw::MessageType::Action);
+
+    const tsw::String no_type = "{\"fields\": {\"type\": 1}}";
+    const tsw::String malformed = "{\"fields\": {\"name\": ";
 
+    EXPECT_THROW(deserializer.DeserializeMessageType(reinterpret_cast<const tsw::BinData::value_type*>(no_type.data()),
+                                                     no_type.size()), tsw::Exception);
+    EXPECT_THROW(deserializer.DeserializeMessageType(reinterpret_cast<const tsw::BinData::value_type*>(malformed.data()),
+                                                     malformed.size()), tsw::Exception);
 }
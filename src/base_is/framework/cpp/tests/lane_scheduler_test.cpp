@@ -0,0 +1,160 @@
+/**
+  * @file lane_scheduler_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Priority lanes and LaneScheduler tests.
+  *
+  */
+
+#include <chrono>
+#include <vector>
+
+#include <tsw/message_lanes.h>
+
+#include <impl/lane_scheduler.h>
+
+#include "tests_common.h"
+
+
+using tsw::MessageLane;
+
+
+static std::vector<int> drain(tsw::impl::LaneScheduler<int> &scheduler)
+{
+    std::vector<int> result;
+    MessageLane lane;
+
+    while (scheduler.next(lane))
+    {
+        result.push_back(scheduler.front(lane).frame);
+        scheduler.pop(lane);
+    }
+
+    return result;
+}
+
+
+TEST(MessageLanes, Defaults)
+{
+    EXPECT_EQ(tsw::default_message_lane(tsw::MessageType::EchoRequest), MessageLane::Control);
+    EXPECT_EQ(tsw::default_message_lane(tsw::MessageType::IntegrateModule), MessageLane::Control);
+    EXPECT_EQ(tsw::default_message_lane(tsw::MessageType::SubscribeToEvents), MessageLane::Control);
+    EXPECT_EQ(tsw::default_message_lane(tsw::MessageType::Error), MessageLane::Control);
+    EXPECT_EQ(tsw::default_message_lane(tsw::MessageType::Event), MessageLane::Data);
+    EXPECT_EQ(tsw::default_message_lane(tsw::MessageType::Action), MessageLane::Data);
+    EXPECT_EQ(tsw::default_message_lane(tsw::MessageType::DataTransfer), MessageLane::Bulk);
+    EXPECT_STREQ(tsw::message_lane_name(MessageLane::Bulk), "bulk");
+}
+
+
+TEST(LaneScheduler, ControlGoesAhead)
+{
+    tsw::impl::LaneScheduler<int> scheduler;
+
+    for (int i = 0; i < 100; ++i) scheduler.push(MessageLane::Data, 1000 + i);
+    scheduler.push(MessageLane::Control, 1);
+    scheduler.push(MessageLane::Control, 2);
+
+    auto order = drain(scheduler);
+
+    ASSERT_EQ(order.size(), 102u);
+    EXPECT_EQ(order[0], 1);
+    EXPECT_EQ(order[1], 2);
+    // FIFO inside the lane.
+    EXPECT_EQ(order[2], 1000);
+    EXPECT_EQ(order.back(), 1099);
+    EXPECT_TRUE(scheduler.empty());
+}
+
+
+TEST(LaneScheduler, Weights)
+{
+    tsw::impl::LaneScheduler<int> scheduler(tsw::LaneWeights{ 3, 2, 1 });
+
+    for (int i = 0; i < 10; ++i)
+    {
+        scheduler.push(MessageLane::Control, 0);
+        scheduler.push(MessageLane::Data, 1);
+        scheduler.push(MessageLane::Bulk, 2);
+    }
+
+    EXPECT_EQ(scheduler.size(MessageLane::Data), 10u);
+
+    auto order = drain(scheduler);
+
+    // Every round: three control frames, two data frames, one bulk frame.
+    const std::vector<int> first_rounds{ 0, 0, 0, 1, 1, 2, 0, 0, 0, 1, 1, 2 };
+
+    EXPECT_EQ(std::vector<int>(order.begin(), order.begin() + first_rounds.size()), first_rounds);
+
+    // Bulk isn't starved by the control flood.
+    tsw::impl::LaneScheduler<int> flooded;
+    MessageLane lane;
+    size_t position = 0;
+
+    for (int i = 0; i < 1000; ++i) flooded.push(MessageLane::Control, 0);
+    flooded.push(MessageLane::Bulk, 2);
+
+    while (flooded.next(lane) && lane != MessageLane::Bulk)
+    {
+        flooded.pop(lane);
+        ++position;
+    }
+
+    EXPECT_EQ(position, tsw::default_lane_weights()[0]);
+}
+
+
+TEST(LaneScheduler, RefundAndClear)
+{
+    tsw::impl::LaneScheduler<int> scheduler(tsw::LaneWeights{ 2, 1, 1 });
+    MessageLane lane;
+
+    for (int i = 0; i < 4; ++i) scheduler.push(MessageLane::Control, 0);
+    scheduler.push(MessageLane::Data, 1);
+
+    // Frame, which wasn't taken by the peer, doesn't spend the lane credit.
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(scheduler.next(lane));
+        EXPECT_EQ(lane, MessageLane::Control);
+        scheduler.refund(lane);
+    }
+
+    auto order = drain(scheduler);
+
+    EXPECT_EQ(order, std::vector<int>({ 0, 0, 1, 0, 0 }));
+
+    // Dropped frames are reported.
+    std::vector<int> dropped;
+
+    scheduler.push(MessageLane::Bulk, 2);
+    scheduler.push(MessageLane::Control, 0);
+    scheduler.clear([&dropped](tsw::impl::LaneScheduler<int>::Entry &entry) { dropped.push_back(entry.frame); });
+
+    EXPECT_EQ(dropped, std::vector<int>({ 0, 2 }));
+    EXPECT_TRUE(scheduler.empty());
+}
+
+
+TEST(LatencyHistogram, Buckets)
+{
+    using namespace std::chrono;
+
+    EXPECT_EQ(tsw::LatencyHistogram::bucket(nanoseconds(500)), 0u);
+    EXPECT_EQ(tsw::LatencyHistogram::bucket(microseconds(1)), 1u);
+    EXPECT_EQ(tsw::LatencyHistogram::bucket(microseconds(3)), 2u);
+    EXPECT_EQ(tsw::LatencyHistogram::bucket(microseconds(1000)), 10u);
+    EXPECT_EQ(tsw::LatencyHistogram::bucket(hours(1)), tsw::LatencyHistogram::buckets_count - 1);
+
+    tsw::impl::LatencyRecorder recorder;
+
+    for (int i = 0; i < 99; ++i) recorder.record(microseconds(3));
+    recorder.record(microseconds(1000));
+
+    auto histogram = recorder.histogram();
+
+    EXPECT_EQ(histogram.count(), 100u);
+    EXPECT_EQ(histogram.percentile(50), microseconds(4));
+    EXPECT_EQ(histogram.percentile(100), microseconds(1024));
+    EXPECT_EQ(tsw::LatencyHistogram().percentile(99), microseconds(0));
+}
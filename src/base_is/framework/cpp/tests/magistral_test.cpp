@@ -5,11 +5,23 @@
   *
   */
 
+#include <atomic>
+#include <filesystem>
+#include <memory>
 #include <thread>
 
+#include <tsw/bson_serializer.h>
+#include <tsw/compression.h>
 #include <tsw/error.h>
 #include <tsw/message.h>
 #include <tsw/magistral.h>
+#include <tsw/message_capture.h>
+#include <tsw/message_outbox.h>
+#include <tsw/metadata.h>
+#include <tsw/schema_registry.h>
+#include <tsw/schema_serializer.h>
+#include <tsw/typed_message.h>
+#include <tsw/wire_format.h>
 
 #include <impl/zmq_magistral_impl.h>
 
@@ -17,6 +29,9 @@
 #include "tests_common.h"
 
 
+TSW_MESSAGE(TypedSample, (int32_t, counter), (tsw::BinData, data))
+
+
 class MagistralConnectionTest : public ::testing::Test {
 protected:
     void SetUp()
@@ -94,3 +109,420 @@ TEST_F(MagistralConnectionTest, SimpleConnection)
 {
 
 }
+
+
+TEST(Magistral, WireFormatNegotiation)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33221", false);
+    s.set_wire_formats({ tsw::WireFormat::Cbor, tsw::WireFormat::Bson });
+    s.add_message_handler(tsw::MessageType::Event, [&received](const tsw::Message &msg) -> bool
+    {
+        if (msg.get_fields().at("counter") == tsw::Value(123)) ++received;
+        return true;
+    });
+    s.activate();
+
+    tsw::Magistral c("client:tcp://127.0.0.1:33221", false);
+    c.set_wire_formats({ tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor, tsw::WireFormat::Bson });
+    c.activate();
+
+    // Client sends in BSON until the reply, then in CBOR: server decodes both.
+    c.negotiate_wire_format(50);
+    c.send_message(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 123} }, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    c.send_message(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 123} }, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 2);
+
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, Forwarding)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33221");
+    tsw::Magistral c("client:tcp://127.0.0.1:33221");
+    const tsw::NameValueMap fields{ {"counter", 123}, {"data", tsw::BinData(1000, 1)} };
+
+    // Server relays the event back to the client's module.
+    s.add_message_handler(tsw::MessageType::Event, [&s](const tsw::Message &msg) -> bool
+    {
+        s.forward_message(msg, 77, 50);
+        return true;
+    });
+    c.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message &msg) -> bool
+    {
+        if (msg.get_receiver_module_uid() == 77 && msg.get_fields() == fields) ++received;
+        return true;
+    });
+
+    c.send_message(tsw::MessageType::Event, fields, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 1);
+    EXPECT_EQ(c.get_lane_latency(tsw::MessageLane::Data).count(), 1u);
+    EXPECT_EQ(s.get_lane_latency(tsw::MessageLane::Data).count(), 1u);
+
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, ForwardingReserialized)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33226", false);
+    tsw::Magistral c("client:tcp://127.0.0.1:33226", false);
+    const tsw::NameValueMap fields{ {"counter", 123}, {"data", tsw::BinData(1000, 1)} };
+    tsw::Message message(tsw::MessageType::Event, fields, "receiver");
+
+    message.set_ttl(std::chrono::seconds(10));
+    message.set_id(42);
+
+    // Server sends in CBOR: BSON frame of the client can't be relayed as is.
+    s.use_wire_format(tsw::WireFormat::Cbor);
+    c.set_wire_formats({ tsw::WireFormat::Cbor, tsw::WireFormat::Bson });
+
+    s.add_message_handler(tsw::MessageType::Event, [&s](const tsw::Message &msg) -> bool
+    {
+        s.forward_message(msg, 77, 50);
+        return true;
+    });
+    c.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message &msg) -> bool
+    {
+        if (msg.get_receiver_module_uid() == 77 && msg.get_receiver_module_name() == "receiver" &&
+            msg.get_fields() == fields && msg.get_deadline() == message.get_deadline() &&
+            msg.get_id() == message.get_id()) ++received;
+        return true;
+    });
+
+    s.activate();
+    c.activate();
+
+    c.send_message(message, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 1);
+
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, Expiry)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33222");
+    tsw::Magistral c("client:tcp://127.0.0.1:33222");
+
+    s.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message &msg) -> bool
+    {
+        if (msg.get_remaining_time() > std::chrono::seconds(0)) ++received;
+        return true;
+    });
+
+    tsw::Message fresh(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 1} });
+    tsw::Message stale(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 2} });
+
+    fresh.set_ttl(std::chrono::seconds(10));
+    stale.set_deadline(stale.get_creation_time() - std::chrono::seconds(1));
+
+    c.send_message(fresh, 50);
+    c.send_message(stale, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 1);
+    EXPECT_EQ(c.get_expired_count(tsw::MessageType::Event), 1u);
+    EXPECT_EQ(s.get_expired_count(tsw::MessageType::Event), 0u);
+
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, OutboxReplay)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33223");
+    tsw::Magistral c("client:tcp://127.0.0.1:33223");
+    const auto path = std::filesystem::temp_directory_path() / "tsw_magistral_outbox.log";
+    tsw::Message message(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 1} });
+
+    s.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message&) -> bool
+    {
+        ++received;
+        return true;
+    });
+
+    // The same message is left in the outbox twice: after the crash and after the lost acknowledgement.
+    message.set_id(42);
+
+    const auto frame = tsw::BsonSerializer().SerializeMessage(message);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        std::filesystem::remove(path);
+
+        auto outbox = std::make_shared<tsw::MessageOutbox>(path);
+
+        outbox->append(message.get_type(), tsw::Time::zero(), frame);
+        c.set_outbox(outbox);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        EXPECT_EQ(outbox->pending_count(), 0u);
+    }
+
+    EXPECT_EQ(received, 1);
+    EXPECT_EQ(s.get_duplicate_count(), 1u);
+
+    c.set_outbox(nullptr);
+    std::filesystem::remove(path);
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, CaptureReplay)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33224");
+    tsw::Magistral c("client:tcp://127.0.0.1:33224");
+    const auto path = std::filesystem::temp_directory_path() / "tsw_magistral_capture.cap";
+
+    s.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message&) -> bool
+    {
+        ++received;
+        return true;
+    });
+
+    auto capture = std::make_shared<tsw::MessageCapture>(path);
+
+    s.set_capture(capture);
+    for (int i = 0; i < 3; ++i) c.send_message(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", i} });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    s.set_capture(nullptr);
+    capture->close();
+
+    EXPECT_EQ(received, 3);
+
+    // Server receives the captured load again.
+    tsw::CaptureReader reader(path);
+    tsw::CaptureReplayer::Options options;
+
+    options.speed = 0;
+    options.direction = tsw::CaptureDirection::Received;
+
+    auto statistics = tsw::CaptureReplayer(reader, options).run([&c](const tsw::CapturedFrame &frame)
+    {
+        c.send_serialized(frame.type, tsw::BinData(frame.data, frame.data + frame.size));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(statistics.frames, 3u);
+    EXPECT_EQ(received, 6);
+
+    std::filesystem::remove(path);
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, ChunkedResume)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33225");
+    tsw::Magistral c("client:tcp://127.0.0.1:33225");
+    const tsw::NameValueMap fields{ {"counter", 1}, {"data", tsw::BinData(4 * 1024 * 1024, 7)} };
+
+    s.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message &msg) -> bool
+    {
+        if (msg.get_fields() == fields) ++received;
+        return true;
+    });
+
+    c.set_chunk_size(1024);
+
+    tsw::Message message(tsw::MessageType::Event, fields);
+    tsw::ChunkedTransfer transfer;
+    std::atomic_bool flooding(true);
+
+    // Flood keeps the socket busy: chunks are queued, when the client is deactivated.
+    std::thread flood([&]()
+    {
+        while (flooding)
+        {
+            try
+            {
+                c.send_message(tsw::MessageType::EchoRequest, tsw::NameValueMap{}, 10);
+            }
+            catch (const tsw::ZMQException&)
+            {
+            }
+        }
+    });
+
+    std::thread breaker([&c]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        c.deactivate();
+    });
+
+    try
+    {
+        c.send_chunked(message, transfer, 1000);
+    }
+    catch (const tsw::ZMQException&)
+    {
+    }
+
+    breaker.join();
+    flooding = false;
+    flood.join();
+
+    // Progress covers only the written frames, dropped ones are resent.
+    c.activate();
+    c.send_chunked(message, transfer, 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    EXPECT_EQ(received, 1);
+
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, CorruptedFrame)
+{
+    std::atomic<int> received(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33227");
+    tsw::Magistral c("client:tcp://127.0.0.1:33227");
+
+    s.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message&) -> bool
+    {
+        ++received;
+        return true;
+    });
+
+    tsw::BinData frame;
+
+    ASSERT_TRUE(tsw::FrameCompressor(tsw::Compression::Lz4, 0).compress(
+        tsw::BsonSerializer().SerializeMessage(tsw::Message(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 1} })),
+        frame));
+
+    // Wrong source size: frame is dropped, the reader goes on.
+    frame[4] += 1;
+    c.send_serialized(tsw::MessageType::Event, frame, 50);
+
+    // Truncated document: frame can't be decoded.
+    frame = tsw::BsonSerializer().SerializeMessage(tsw::Message(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 3} }));
+    frame.resize(frame.size() / 2);
+    c.send_serialized(tsw::MessageType::Event, frame, 50);
+
+    c.send_message(tsw::MessageType::Event, tsw::NameValueMap{ {"counter", 2} }, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 1);
+    EXPECT_EQ(s.get_corrupted_count(), 2u);
+
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, SchemeConfirmation)
+{
+    std::atomic<int> received(0);
+    auto server_registry = std::make_shared<tsw::SchemaRegistry>();
+    auto client_registry = std::make_shared<tsw::SchemaRegistry>();
+    const tsw::EAMetadata metadata("sample_event", nullptr, "", tsw::FieldUIDFieldHeaderMap
+    {
+        { 1, tsw::FieldHeader{ 1, tsw::ValueType::Int32Number, "counter", 0, "" } }
+    });
+    const tsw::NameValueMap fields{ {"name", tsw::String("sample_event")}, {"counter", 1} };
+    auto hash = client_registry->register_scheme(tsw::MessageType::Event, metadata);
+
+    tsw::Magistral s("server:tcp://127.0.0.1:33229", false);
+    s.set_schema_registry(server_registry);
+    s.set_wire_formats({ tsw::WireFormat::Schema, tsw::WireFormat::Bson });
+    s.add_message_handler(tsw::MessageType::Event, [&](const tsw::Message&) -> bool
+    {
+        ++received;
+        return true;
+    });
+    s.activate();
+
+    tsw::Magistral c("client:tcp://127.0.0.1:33229", false);
+    c.set_schema_registry(client_registry);
+    c.set_wire_formats({ tsw::WireFormat::Schema, tsw::WireFormat::Bson });
+    c.activate();
+
+    // Server doesn't know the scheme: client sends in BSON.
+    c.negotiate_wire_format(50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(client_registry->is_confirmed(hash));
+    c.send_message(tsw::MessageType::Event, fields, 50);
+
+    // Compact frame with the unknown scheme is dropped, the reader goes on.
+    auto forced_registry = std::make_shared<tsw::SchemaRegistry>();
+    forced_registry->confirm_scheme(forced_registry->register_scheme(tsw::MessageType::Event, metadata));
+    c.send_serialized(tsw::MessageType::Event,
+                      tsw::SchemaSerializer(forced_registry).SerializeMessage(tsw::Message(tsw::MessageType::Event, fields)), 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 1);
+    EXPECT_EQ(s.get_corrupted_count(), 1u);
+
+    // Server has got the scheme and confirms it: client sends compact.
+    server_registry->register_scheme(tsw::MessageType::Event, metadata);
+    c.negotiate_wire_format(50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_TRUE(client_registry->is_confirmed(hash));
+    c.send_message(tsw::MessageType::Event, fields, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 2);
+    EXPECT_EQ(s.get_corrupted_count(), 1u);
+
+    c.deactivate();
+    s.deactivate();
+}
+
+
+TEST(Magistral, TypedMessage)
+{
+    std::atomic<int> received(0);
+    std::atomic<size_t> received_size(0);
+    tsw::Magistral s("server:tcp://127.0.0.1:33228");
+    tsw::Magistral c("client:tcp://127.0.0.1:33228");
+
+    s.on<TypedSample>([&](const TypedSample &sample)
+    {
+        ++received;
+        received_size += sample.data.size();
+        return true;
+    });
+
+    tsw::Message fresh(tsw::MessageType::Event, tsw::NameValueMap());
+    tsw::Message stale(tsw::MessageType::Event, tsw::NameValueMap());
+
+    fresh.set_ttl(std::chrono::seconds(10));
+    stale.set_deadline(stale.get_creation_time() - std::chrono::seconds(1));
+
+    c.set_chunk_size(1024);
+    c.send(TypedSample{1, tsw::BinData(16, 1)}, fresh, 50);
+    c.send(TypedSample{2, tsw::BinData(16, 2)}, stale, 50);
+    // Binary field, which is larger than the chunk, is sent by chunks.
+    c.send(TypedSample{3, tsw::BinData(4096, 3)}, fresh, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    EXPECT_EQ(received, 2);
+    EXPECT_EQ(received_size, 16u + 4096u);
+    EXPECT_EQ(c.get_expired_count(tsw::MessageType::Event), 1u);
+
+    c.deactivate();
+    s.deactivate();
+}
@@ -0,0 +1,175 @@
+/**
+  * @file message_capture_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MessageCapture, CaptureReader and CaptureReplayer tests.
+  *
+  */
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <tsw/error.h>
+#include <tsw/message_capture.h>
+
+#include "tests_common.h"
+
+
+// Capture file, which is removed after the test.
+class CaptureFile
+{
+public:
+    CaptureFile() :
+        path_(std::filesystem::temp_directory_path() / ("tsw_capture_" + std::to_string(::getpid()) + "_" +
+                                                       std::to_string(counter_++) + ".cap"))
+    {}
+    ~CaptureFile() { std::filesystem::remove(path_); }
+
+    const tsw::Path &path() const { return path_; }
+
+private:
+    static std::atomic<int> counter_;
+    tsw::Path path_;
+};
+
+std::atomic<int> CaptureFile::counter_(0);
+
+
+TEST(MessageCapture, Read)
+{
+    CaptureFile file;
+
+    {
+        // Small segments: file is remapped on the growth.
+        tsw::MessageCapture capture(file.path(), 256);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            capture.record(i % 2 ? tsw::CaptureDirection::Received : tsw::CaptureDirection::Sent,
+                           tsw::MessageType::Event, tsw::BinData(static_cast<size_t>(i + 1), static_cast<uint8_t>(i)));
+        }
+
+        EXPECT_EQ(capture.frames_count(), 100u);
+    }
+
+    tsw::CaptureReader reader(file.path());
+    tsw::CapturedFrame frame;
+    std::chrono::nanoseconds last_time(0);
+    int count = 0;
+
+    while (reader.next(frame))
+    {
+        EXPECT_EQ(frame.size, static_cast<size_t>(count + 1));
+        EXPECT_EQ(frame.data[0], count);
+        EXPECT_EQ(frame.type, tsw::MessageType::Event);
+        EXPECT_EQ(frame.direction, count % 2 ? tsw::CaptureDirection::Received : tsw::CaptureDirection::Sent);
+        EXPECT_GE(frame.time, last_time);
+        last_time = frame.time;
+        ++count;
+    }
+
+    EXPECT_EQ(count, 100);
+    EXPECT_GT(reader.get_start_time(), tsw::Time::zero());
+
+    reader.rewind();
+    ASSERT_TRUE(reader.next(frame));
+    EXPECT_EQ(frame.size, 1u);
+}
+
+
+TEST(MessageCapture, NotClosed)
+{
+    CaptureFile file;
+    tsw::MessageCapture capture(file.path(), 4096);
+
+    capture.record(tsw::CaptureDirection::Sent, tsw::MessageType::Action, tsw::BinData(10, 1));
+    capture.record(tsw::CaptureDirection::Sent, tsw::MessageType::Reply, tsw::BinData(20, 2));
+
+    // Frames are seen in the shared mapping, zero tail of the segment is skipped.
+    tsw::CaptureReader reader(file.path());
+    tsw::CapturedFrame frame;
+    std::vector<tsw::MessageType> types;
+
+    while (reader.next(frame)) types.push_back(frame.type);
+
+    EXPECT_EQ(types, (std::vector<tsw::MessageType>{ tsw::MessageType::Action, tsw::MessageType::Reply }));
+
+    capture.close();
+    EXPECT_EQ(std::filesystem::file_size(file.path()), capture.size());
+
+    // Frames after the closing are skipped.
+    capture.record(tsw::CaptureDirection::Sent, tsw::MessageType::Reply, tsw::BinData(20, 2));
+    EXPECT_EQ(capture.frames_count(), 2u);
+
+    EXPECT_THROW(tsw::CaptureReader(file.path().string() + ".absent"), tsw::Exception);
+}
+
+
+TEST(CaptureReplayer, Pace)
+{
+    CaptureFile file;
+    const auto gap = std::chrono::milliseconds(20);
+
+    {
+        tsw::MessageCapture capture(file.path());
+
+        for (int i = 0; i < 5; ++i)
+        {
+            capture.record(tsw::CaptureDirection::Sent, tsw::MessageType::Event, tsw::BinData(8, static_cast<uint8_t>(i)));
+            capture.record(tsw::CaptureDirection::Received, tsw::MessageType::Reply, tsw::BinData(4, 0));
+            std::this_thread::sleep_for(gap);
+        }
+    }
+
+    tsw::CaptureReader reader(file.path());
+    std::vector<uint8_t> replayed;
+    auto sink = [&replayed](const tsw::CapturedFrame &frame) { replayed.push_back(frame.data[0]); };
+
+    // Original pace: four gaps between the first and the last frame.
+    tsw::CaptureReplayer original(reader);
+    auto statistics = original.run(sink);
+
+    EXPECT_EQ(statistics.frames, 5u);
+    EXPECT_EQ(statistics.bytes, 40u);
+    EXPECT_GE(statistics.elapsed, 4 * gap);
+    EXPECT_EQ(replayed, (std::vector<uint8_t>{ 0, 1, 2, 3, 4 }));
+
+    tsw::CaptureReplayer::Options options;
+
+    options.speed = 4;
+    statistics = tsw::CaptureReplayer(reader, options).run(sink);
+    EXPECT_EQ(statistics.frames, 5u);
+    EXPECT_GE(statistics.elapsed, gap);
+
+    options.speed = 0;
+    options.direction = tsw::CaptureDirection::Received;
+    statistics = tsw::CaptureReplayer(reader, options).run(sink);
+    EXPECT_EQ(statistics.frames, 5u);
+    EXPECT_EQ(statistics.bytes, 20u);
+}
+
+
+TEST(CaptureReplayer, Stop)
+{
+    CaptureFile file;
+
+    {
+        tsw::MessageCapture capture(file.path());
+
+        for (int i = 0; i < 10; ++i) capture.record(tsw::CaptureDirection::Sent, tsw::MessageType::Event, tsw::BinData(1, 0));
+    }
+
+    tsw::CaptureReader reader(file.path());
+    tsw::CaptureReplayer::Options options;
+
+    options.speed = 0;
+
+    tsw::CaptureReplayer replayer(reader, options);
+    auto statistics = replayer.run([&replayer](const tsw::CapturedFrame&) { replayer.stop(); });
+
+    EXPECT_EQ(statistics.frames, 1u);
+}
@@ -0,0 +1,175 @@
+/**
+  * @file message_outbox_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief MessageOutbox and DuplicateFilter tests.
+  *
+  */
+
+#include <atomic>
+#include <filesystem>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <tsw/bson_serializer.h>
+#include <tsw/message.h>
+#include <tsw/message_outbox.h>
+
+#include <impl/duplicate_filter.h>
+
+#include "tests_common.h"
+
+
+// Outbox file, which is removed after the test.
+class OutboxFile
+{
+public:
+    OutboxFile() :
+        path_(std::filesystem::temp_directory_path() / ("tsw_outbox_" + std::to_string(::getpid()) + "_" +
+                                                       std::to_string(counter_++) + ".log"))
+    {
+        std::filesystem::remove(path_);
+    }
+    ~OutboxFile() { std::filesystem::remove(path_); }
+
+    const tsw::Path &path() const { return path_; }
+    size_t size() const { return std::filesystem::file_size(path_); }
+
+private:
+    static std::atomic<int> counter_;
+    tsw::Path path_;
+};
+
+std::atomic<int> OutboxFile::counter_(0);
+
+
+static std::vector<tsw::MessageOutbox::Entry> replay_all(tsw::MessageOutbox &outbox)
+{
+    std::vector<tsw::MessageOutbox::Entry> result;
+
+    outbox.replay([&result](const tsw::MessageOutbox::Entry &entry) { result.push_back(entry); return true; });
+
+    return result;
+}
+
+
+TEST(MessageOutbox, Replay)
+{
+    OutboxFile file;
+    const tsw::Time deadline(1500000000123456789);
+    uint64_t second;
+
+    {
+        tsw::MessageOutbox outbox(file.path());
+
+        outbox.append(tsw::MessageType::Event, tsw::Time::zero(), tsw::BinData(100, 1));
+        second = outbox.append(tsw::MessageType::Action, tsw::Time::zero(), tsw::BinData(200, 2));
+        outbox.append(tsw::MessageType::Reply, deadline, tsw::BinData(300, 3));
+        outbox.acknowledge(second);
+
+        EXPECT_EQ(outbox.pending_count(), 2u);
+    }
+
+    // Unacknowledged frames survive the reopening.
+    tsw::MessageOutbox outbox(file.path());
+    auto entries = replay_all(outbox);
+
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_LT(entries[0].sequence, entries[1].sequence);
+    EXPECT_EQ(entries[0].type, tsw::MessageType::Event);
+    EXPECT_EQ(entries[0].frame, tsw::BinData(100, 1));
+    EXPECT_EQ(entries[1].type, tsw::MessageType::Reply);
+    EXPECT_EQ(entries[1].deadline, deadline);
+    EXPECT_EQ(entries[1].frame, tsw::BinData(300, 3));
+
+    // Replay is stopped by the handler.
+    EXPECT_EQ(outbox.replay([](const tsw::MessageOutbox::Entry&) { return false; }), 0u);
+
+    // Sequences continue after the recovered ones.
+    EXPECT_GT(outbox.append(tsw::MessageType::Event, tsw::Time::zero(), tsw::BinData(10, 4)), entries[1].sequence);
+}
+
+
+TEST(MessageOutbox, TornRecord)
+{
+    OutboxFile file;
+
+    {
+        tsw::MessageOutbox outbox(file.path());
+
+        outbox.append(tsw::MessageType::Event, tsw::Time::zero(), tsw::BinData(100, 1));
+        outbox.append(tsw::MessageType::Event, tsw::Time::zero(), tsw::BinData(100, 2));
+    }
+
+    // Crash in the middle of the second record.
+    std::filesystem::resize_file(file.path(), file.size() - 10);
+
+    tsw::MessageOutbox outbox(file.path());
+    auto entries = replay_all(outbox);
+
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].frame, tsw::BinData(100, 1));
+
+    outbox.append(tsw::MessageType::Event, tsw::Time::zero(), tsw::BinData(100, 3));
+
+    EXPECT_EQ(replay_all(outbox).back().frame, tsw::BinData(100, 3));
+}
+
+
+TEST(MessageOutbox, GroupCommit)
+{
+    OutboxFile file;
+    tsw::MessageOutbox::Options options;
+    const size_t threads_count = 8;
+    const size_t appends = 100;
+
+    options.compaction_threshold = 0;
+
+    tsw::MessageOutbox outbox(file.path(), options);
+    std::vector<std::thread> threads;
+    std::vector<std::vector<uint64_t>> sequences(threads_count);
+
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&outbox, &sequences, t]()
+        {
+            for (size_t i = 0; i < appends; ++i)
+            {
+                sequences[t].push_back(outbox.append(tsw::MessageType::Event, tsw::Time::zero(), tsw::BinData(64, t)));
+            }
+        });
+    }
+
+    for (auto &thread: threads) thread.join();
+
+    std::set<uint64_t> unique;
+
+    for (const auto &thread_sequences: sequences) unique.insert(thread_sequences.begin(), thread_sequences.end());
+
+    EXPECT_EQ(unique.size(), threads_count * appends);
+    EXPECT_EQ(outbox.pending_count(), threads_count * appends);
+    EXPECT_LE(outbox.commits_count(), threads_count * appends);
+
+    // Log is truncated, when everything is delivered.
+    for (auto sequence: unique) outbox.acknowledge(sequence);
+
+    EXPECT_EQ(outbox.pending_count(), 0u);
+    EXPECT_EQ(file.size(), 0u);
+    EXPECT_TRUE(replay_all(outbox).empty());
+}
+
+
+TEST(DuplicateFilter, Window)
+{
+    tsw::impl::DuplicateFilter filter(2);
+
+    EXPECT_FALSE(filter.is_duplicate(1, 100));
+    EXPECT_TRUE(filter.is_duplicate(1, 100));
+    // Same identifier from the other sender.
+    EXPECT_FALSE(filter.is_duplicate(2, 100));
+    EXPECT_FALSE(filter.is_duplicate(1, 101));
+    // Oldest identifier has left the window.
+    EXPECT_FALSE(filter.is_duplicate(1, 100));
+}
@@ -0,0 +1,313 @@
+/**
+  * @file message_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Message construction and recycling tests.
+  *
+  */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/deserializer.h>
+#include <tsw/json_deserializer.h>
+#include <tsw/json_serializer.h>
+#include <tsw/message.h>
+
+#include <impl/message_pool.h>
+
+#include "tests_common.h"
+
+
+// Allocations counter of the test thread: copies of the fields tree are visible as allocations,
+// allocations of the other threads (thread pool, Magistral readers) aren't counted.
+static thread_local size_t allocations_count = 0;
+
+
+void *operator new(size_t size)
+{
+    ++allocations_count;
+
+    if (void *p = std::malloc(size ? size : 1)) return p;
+
+    throw std::bad_alloc();
+}
+
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+
+class AllocationsCounter
+{
+public:
+    AllocationsCounter() : start_(allocations_count) {}
+
+public:
+    size_t count() const { return allocations_count - start_; }
+
+private:
+    const size_t start_;
+};
+
+
+// Exposes the protected construction from the decoded object.
+class ObjectDeserializer : public tsw::Deserializer
+{
+public:
+    using Deserializer::MessageFromObject;
+
+    tsw::Message DeserializeMessage(const tsw::BinData&) override { throw std::logic_error("not implemented"); }
+    tsw::Object DeserializeObject(const tsw::BinData&) override { return tsw::Object(); }
+    tsw::Message DeserializeMessage(const tsw::BinData::value_type*, size_t) override { throw std::logic_error("not implemented"); }
+    tsw::Object DeserializeObject(const tsw::BinData::value_type*, size_t) override { return tsw::Object(); }
+};
+
+
+static tsw::NameValueMap large_fields()
+{
+    tsw::NameValueMap result;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        result["field_with_a_long_name_" + std::to_string(i)] = tsw::Object
+        {
+            { "string", tsw::String(100, 'x') },
+            { "array", tsw::ValueArray{ 1, "two", tsw::BinData(100, 3) } }
+        };
+    }
+
+    return result;
+}
+
+
+TEST(Message, MoveConstruction)
+{
+    auto fields = large_fields();
+    auto expected = fields;
+
+    AllocationsCounter counter;
+    tsw::Message message(tsw::MessageType::Event, std::move(fields), 10);
+    tsw::Message moved(std::move(message));
+
+    EXPECT_EQ(counter.count(), 0u);
+    EXPECT_EQ(moved.get_fields(), expected);
+    EXPECT_EQ(moved.get_receiver_module_uid(), 10u);
+}
+
+
+TEST(Message, FromObject)
+{
+    auto fields = large_fields();
+    tsw::Object envelope
+    {
+        { "type", static_cast<int>(tsw::MessageType::Action) },
+        { "sender_m_uid", int64_t(1) },
+        { "sender_m_name", tsw::String(100, 's') },
+        { "sender_m_class", "class" },
+        { "receiver_m_uid", int64_t(2) },
+        { "receiver_m_name", tsw::String(100, 'r') },
+        { "receiver_m_class", "class" },
+        { "c_time", tsw::Time(1500000000123456789) },
+        { "fields", fields }
+    };
+
+    AllocationsCounter counter;
+    auto message = ObjectDeserializer().MessageFromObject(std::move(envelope));
+
+    // Only the lookup keys may be allocated, but not the fields and names.
+    EXPECT_LT(counter.count(), 10u);
+    EXPECT_EQ(message.get_type(), tsw::MessageType::Action);
+    EXPECT_EQ(message.get_sender_module_name(), tsw::String(100, 's'));
+    EXPECT_EQ(message.get_receiver_module_name(), tsw::String(100, 'r'));
+    EXPECT_EQ(message.get_fields(), fields);
+}
+
+
+TEST(Message, Deadline)
+{
+    tsw::Message message(tsw::MessageType::Event, tsw::NameValueMap{ {"value", 1} });
+
+    EXPECT_FALSE(message.has_deadline());
+    EXPECT_FALSE(message.is_expired());
+    EXPECT_EQ(message.get_remaining_time(), tsw::Time::max());
+
+    message.set_ttl(std::chrono::seconds(60));
+
+    EXPECT_EQ(message.get_deadline(), message.get_creation_time() + std::chrono::seconds(60));
+    EXPECT_FALSE(message.is_expired());
+    EXPECT_GT(message.get_remaining_time(), std::chrono::seconds(59));
+    EXPECT_LE(message.get_remaining_time(), std::chrono::seconds(60));
+
+    // Deadline is absolute: it's kept in the copy.
+    tsw::Message late(message);
+
+    late.set_deadline(message.get_creation_time() - std::chrono::milliseconds(1));
+
+    EXPECT_TRUE(late.is_expired());
+    EXPECT_EQ(late.get_remaining_time(), tsw::Time::zero());
+}
+
+
+static tsw::BinData received_event(const tsw::String &name)
+{
+    return tsw::BsonSerializer().SerializeMessage(tsw::Message(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", name),
+        std::make_pair("value", 0.777),
+        std::make_pair("data", tsw::BinData(1000, 1))
+    }, 10));
+}
+
+
+TEST(Message, ConcurrentFieldsDecoding)
+{
+    auto pool = std::make_shared<tsw::impl::MessagePool>();
+    tsw::BsonDeserializer deserializer;
+    auto data = received_event("sensor_event");
+
+    // Concurrent handlers get the same fields of the received message.
+    for (int i = 0; i < 100; ++i)
+    {
+        auto message = pool->acquire();
+        std::atomic<int> matched(0);
+        std::vector<std::thread> handlers;
+
+        deserializer.DeserializeMessageTo(data.data(), data.size(), *message);
+
+        for (int t = 0; t < 4; ++t)
+        {
+            handlers.emplace_back([&message, &matched]()
+            {
+                const auto &fields = message->get_fields();
+
+                if (&fields == &message->get_fields() && fields.at("name").as_string() == "sensor_event") ++matched;
+            });
+        }
+
+        for (auto &handler: handlers) handler.join();
+
+        EXPECT_EQ(matched, 4);
+    }
+}
+
+
+TEST(MessagePool, Recycling)
+{
+    auto pool = std::make_shared<tsw::impl::MessagePool>();
+    tsw::BsonDeserializer deserializer;
+    auto data = received_event("sensor_event");
+    const tsw::Message *address = nullptr;
+
+    {
+        auto message = pool->acquire();
+
+        deserializer.DeserializeMessageTo(data.data(), data.size(), *message);
+        EXPECT_EQ(message->get_type(), tsw::MessageType::Event);
+        EXPECT_EQ(message->get_fields().at("name").as_string(), "sensor_event");
+        address = message.get();
+    }
+
+    EXPECT_EQ(pool->free_count(), 1u);
+
+    // Steady state: the same message with the same buffer.
+    AllocationsCounter counter;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        auto message = pool->acquire();
+
+        deserializer.DeserializeMessageTo(data.data(), data.size(), *message);
+        EXPECT_EQ(message.get(), address);
+        EXPECT_EQ(message->get_type(), tsw::MessageType::Event);
+        EXPECT_EQ(message->get_fields_view().as_string("name"), "sensor_event");
+    }
+
+    EXPECT_EQ(counter.count(), 0u);
+}
+
+
+TEST(MessagePool, Retain)
+{
+    auto pool = std::make_shared<tsw::impl::MessagePool>();
+    tsw::BsonDeserializer deserializer;
+    auto first = received_event("first");
+    auto second = received_event("second");
+    tsw::MessagePtr retained;
+
+    {
+        auto message = pool->acquire();
+
+        deserializer.DeserializeMessageTo(first.data(), first.size(), *message);
+        retained = message->retain();
+        EXPECT_EQ(retained.get(), message.get());
+    }
+
+    // Retained message isn't reused.
+    EXPECT_EQ(pool->free_count(), 0u);
+
+    {
+        auto message = pool->acquire();
+
+        EXPECT_NE(message.get(), retained.get());
+        deserializer.DeserializeMessageTo(second.data(), second.size(), *message);
+    }
+
+    EXPECT_EQ(retained->get_fields_view().as_string("name"), "first");
+
+    // Copy shares the buffer, which isn't overwritten then.
+    tsw::Message copy(*retained);
+
+    retained.reset();
+    EXPECT_EQ(pool->free_count(), 2u);
+
+    for (auto i = 0; i < 2; ++i)
+    {
+        auto message = pool->acquire();
+        deserializer.DeserializeMessageTo(second.data(), second.size(), *message);
+    }
+
+    EXPECT_EQ(copy.get_fields().at("name").as_string(), "first");
+
+    // Message, which isn't reference counted, is copied.
+    auto kept = copy.retain();
+
+    EXPECT_NE(kept.get(), &copy);
+    EXPECT_EQ(kept->retain().get(), kept.get());
+    EXPECT_EQ(kept->get_fields(), copy.get_fields());
+}
+
+
+TEST(MessagePool, OutlivesPool)
+{
+    auto pool = std::make_shared<tsw::impl::MessagePool>(1);
+    auto data = tsw::JsonSerializer().SerializeMessage(tsw::Message(tsw::MessageType::Action, tsw::NameValueMap
+    {
+        std::make_pair("name", "action")
+    }));
+    auto first = pool->acquire();
+    auto second = pool->acquire();
+
+    // Default implementation replaces the message.
+    tsw::JsonDeserializer().DeserializeMessageTo(data.data(), data.size(), *first);
+    EXPECT_EQ(first->get_type(), tsw::MessageType::Action);
+
+    second.reset();
+    EXPECT_EQ(pool->free_count(), 1u);
+
+    pool.reset();
+    EXPECT_EQ(first->get_fields().at("name").as_string(), "action");
+}
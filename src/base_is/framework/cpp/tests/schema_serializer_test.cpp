@@ -0,0 +1,268 @@
+/**
+  * @file schema_serializer_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Schema-based serializer and deserializer tests.
+  *
+  */
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/error.h>
+#include <tsw/message.h>
+#include <tsw/metadata.h>
+#include <tsw/schema_deserializer.h>
+#include <tsw/schema_registry.h>
+#include <tsw/schema_serializer.h>
+
+#include "tests_common.h"
+
+
+static tsw::EAMetadata sensor_event_metadata()
+{
+    return tsw::EAMetadata("sensor_event", nullptr, "Sensor measurement",
+    tsw::FieldUIDFieldHeaderMap
+    {
+        { 1, tsw::FieldHeader{ 1, tsw::ValueType::DoubleNumber, "value", 1, "Measured value" } },
+        { 2, tsw::FieldHeader{ 2, tsw::ValueType::Int32Number, "counter", 0, "Measurement number" } },
+        { 3, tsw::FieldHeader{ 3, tsw::ValueType::String, "unit", 2, "Value unit" } },
+        { 4, tsw::FieldHeader{ 4, tsw::ValueType::Time, "m_time", 3, "Measurement time" } },
+        { 5, tsw::FieldHeader{ 5, tsw::ValueType::DoubleArray, "samples", 4, "Raw samples" } }
+    });
+}
+
+
+static tsw::NameValueMap sensor_event_fields()
+{
+    return tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("unit", "V"),
+        std::make_pair("m_time", tsw::Time(1500000000123456789)),
+        std::make_pair("samples", tsw::DoubleArray{1.0, 2.0, 3.0, 4.0})
+    };
+}
+
+
+class SchemaSerializerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        registry_ = std::make_shared<tsw::SchemaRegistry>();
+        hash_ = registry_->register_scheme(tsw::MessageType::Event, sensor_event_metadata());
+        registry_->confirm_scheme(hash_);
+    }
+
+protected:
+    std::shared_ptr<tsw::SchemaRegistry> registry_;
+    uint64_t hash_;
+};
+
+
+TEST_F(SchemaSerializerTest, Registration)
+{
+    EXPECT_NE(hash_, 0);
+    EXPECT_TRUE(registry_->has_scheme(hash_));
+    EXPECT_NE(registry_->find(tsw::MessageType::Event, "sensor_event"), nullptr);
+    EXPECT_EQ(registry_->find(tsw::MessageType::Action, "sensor_event"), nullptr);
+
+    // Object fields can't be positional.
+    tsw::EAMetadata complex("complex", nullptr, "", tsw::FieldUIDFieldHeaderMap
+    {
+        { 1, tsw::FieldHeader{ 1, tsw::ValueType::Object, "obj", 0, "" } }
+    });
+    EXPECT_EQ(registry_->register_scheme(tsw::MessageType::Event, complex), 0);
+
+    registry_->unregister_scheme(tsw::MessageType::Event, "sensor_event");
+    EXPECT_FALSE(registry_->has_scheme(hash_));
+}
+
+
+TEST_F(SchemaSerializerTest, RoundTrip)
+{
+    tsw::SchemaSerializer serializer(registry_);
+    tsw::SchemaDeserializer deserializer(registry_);
+    tsw::Message message(tsw::MessageType::Event, sensor_event_fields());
+
+    auto data = serializer.SerializeMessage(message);
+    auto bson_data = tsw::BsonSerializer().SerializeMessage(message);
+
+    EXPECT_LT(data.size() * 2, bson_data.size());
+    EXPECT_EQ(deserializer.DeserializeMessageType(data.data(), data.size()), tsw::MessageType::Event);
+
+    auto result = deserializer.DeserializeMessage(data);
+
+    EXPECT_EQ(result.get_type(), tsw::MessageType::Event);
+    EXPECT_EQ(result.get_creation_time(), message.get_creation_time());
+    EXPECT_EQ(result.get_fields(), message.get_fields());
+
+    // Absent fields are allowed.
+    auto fields = sensor_event_fields();
+    fields.erase("unit");
+    auto partial = deserializer.DeserializeMessage(serializer.SerializeMessage(tsw::Message(tsw::MessageType::Event, fields)));
+    EXPECT_EQ(partial.get_fields(), fields);
+}
+
+
+TEST_F(SchemaSerializerTest, Fallback)
+{
+    tsw::SchemaSerializer serializer(registry_);
+    tsw::SchemaDeserializer deserializer(registry_);
+    tsw::BsonDeserializer bson_deserializer;
+
+    auto check_bson = [&](const tsw::NameValueMap &fields)
+    {
+        auto data = serializer.SerializeMessage(tsw::Message(tsw::MessageType::Event, fields));
+
+        EXPECT_NO_THROW(bson_deserializer.DeserializeMessage(data));
+        EXPECT_EQ(deserializer.DeserializeMessage(data).get_fields(), fields);
+    };
+
+    auto fields = sensor_event_fields();
+    fields["extra"] = 1;
+    check_bson(fields);
+
+    fields = sensor_event_fields();
+    fields["counter"] = int64_t(123);
+    check_bson(fields);
+
+    fields = sensor_event_fields();
+    fields["name"] = "unknown_event";
+    check_bson(fields);
+}
+
+
+TEST_F(SchemaSerializerTest, Confirmation)
+{
+    auto peer_registry = std::make_shared<tsw::SchemaRegistry>();
+    tsw::Message message(tsw::MessageType::Event, sensor_event_fields());
+
+    peer_registry->register_scheme(tsw::MessageType::Event, sensor_event_metadata());
+    EXPECT_EQ(peer_registry->get_hashes(), std::vector<uint64_t>{ hash_ });
+    EXPECT_FALSE(peer_registry->is_confirmed(hash_));
+
+    // Peer may not know the scheme yet.
+    auto data = tsw::SchemaSerializer(peer_registry).SerializeMessage(message);
+    EXPECT_EQ(tsw::BsonDeserializer().DeserializeMessage(data).get_fields(), message.get_fields());
+
+    peer_registry->confirm_scheme(hash_);
+    data = tsw::SchemaSerializer(peer_registry).SerializeMessage(message);
+    EXPECT_EQ(data, tsw::SchemaSerializer(registry_).SerializeMessage(message));
+}
+
+
+TEST_F(SchemaSerializerTest, Deadline)
+{
+    tsw::SchemaSerializer serializer(registry_);
+    tsw::SchemaDeserializer deserializer(registry_);
+    tsw::Message message(tsw::MessageType::Event, sensor_event_fields());
+
+    message.set_ttl(std::chrono::seconds(10));
+
+    auto data = serializer.SerializeMessage(message);
+
+    EXPECT_NO_THROW(tsw::BsonDeserializer().DeserializeMessage(data));
+
+    auto result = deserializer.DeserializeMessage(data);
+
+    EXPECT_TRUE(result.has_deadline());
+    EXPECT_EQ(result.get_deadline(), message.get_deadline());
+    EXPECT_EQ(result.get_fields(), message.get_fields());
+}
+
+
+TEST_F(SchemaSerializerTest, Identifier)
+{
+    tsw::SchemaSerializer serializer(registry_);
+    tsw::SchemaDeserializer deserializer(registry_);
+    tsw::Message message(tsw::MessageType::Event, sensor_event_fields());
+
+    // Receiver drops the resent duplicates by the identifier.
+    message.set_id(42);
+
+    auto result = deserializer.DeserializeMessage(serializer.SerializeMessage(message));
+
+    EXPECT_EQ(result.get_id(), 42u);
+    EXPECT_EQ(result.get_fields(), message.get_fields());
+}
+
+
+TEST_F(SchemaSerializerTest, SchemeMismatch)
+{
+    tsw::SchemaSerializer serializer(registry_);
+    auto peer_registry = std::make_shared<tsw::SchemaRegistry>();
+    auto metadata = sensor_event_metadata();
+    auto scheme = metadata.get_field_scheme();
+
+    // Peer has another version of the scheme.
+    scheme[5].type = tsw::ValueType::Int32Array;
+    peer_registry->register_scheme(tsw::MessageType::Event, tsw::EAMetadata("sensor_event", nullptr, "", scheme));
+
+    auto data = serializer.SerializeMessage(tsw::Message(tsw::MessageType::Event, sensor_event_fields()));
+
+    EXPECT_THROW(tsw::SchemaDeserializer(peer_registry).DeserializeMessage(data), tsw::Exception);
+
+    // Peer, which keeps the previous schemes version, decodes by the fallback.
+    auto previous = std::make_shared<tsw::SchemaDeserializer>(registry_);
+
+    EXPECT_EQ(tsw::SchemaDeserializer(peer_registry, previous).DeserializeMessage(data).get_fields(), sensor_event_fields());
+
+    data.resize(data.size() - 1);
+    EXPECT_THROW(tsw::SchemaDeserializer(registry_).DeserializeMessage(data), tsw::Exception);
+}
+
+
+TEST_F(SchemaSerializerTest, Announcement)
+{
+    auto peer_registry = std::make_shared<tsw::SchemaRegistry>();
+    auto metadata = sensor_event_metadata();
+    tsw::Object field_scheme;
+
+    // Module announcement, as it's sent by the controller.
+    for (const auto &field: metadata.get_field_scheme())
+    {
+        field_scheme[std::to_string(field.first)] = tsw::Object
+        {
+            {"uid", std::to_string(field.second.uid)},
+            {"type", static_cast<int32_t>(field.second.type)},
+            {"name", field.second.name},
+            {"position", field.second.position},
+            {"description", field.second.description}
+        };
+    }
+
+    tsw::Message announcement(tsw::MessageType::AnnounceModuleEvents, tsw::NameValueMap
+    {
+        std::make_pair("metadata", tsw::ValueArray
+        {
+            tsw::Object{ {"name", "sensor_event"}, {"description", "Sensor measurement"}, {"field_scheme", field_scheme} },
+            tsw::Object{ {"name", tsw::String("broken_event")} }
+        })
+    });
+
+    EXPECT_EQ(peer_registry->register_announced(announcement), std::vector<uint64_t>{ hash_ });
+    EXPECT_TRUE(peer_registry->has_scheme(hash_));
+    EXPECT_TRUE(peer_registry->is_confirmed(hash_));
+    EXPECT_EQ(peer_registry->find(tsw::MessageType::Action, "sensor_event"), nullptr);
+
+    auto data = tsw::SchemaSerializer(registry_).SerializeMessage(tsw::Message(tsw::MessageType::Event, sensor_event_fields()));
+
+    EXPECT_EQ(tsw::SchemaDeserializer(peer_registry).DeserializeMessage(data).get_fields(), sensor_event_fields());
+
+    // Activities are not announcements.
+    EXPECT_TRUE(peer_registry->register_announced(tsw::Message(tsw::MessageType::Event, sensor_event_fields())).empty());
+
+    peer_registry->register_announced(tsw::Message(tsw::MessageType::DenounceModuleEvents, tsw::NameValueMap
+    {
+        std::make_pair("metadata", tsw::ValueArray{ "sensor_event" })
+    }));
+
+    EXPECT_FALSE(peer_registry->has_scheme(hash_));
+}
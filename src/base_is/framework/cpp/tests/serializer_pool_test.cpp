@@ -0,0 +1,110 @@
+/**
+  * @file serializer_pool_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief SerializerPool tests.
+  *
+  */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/envelope_serializer.h>
+#include <tsw/message.h>
+#include <tsw/wire_format.h>
+
+#include <impl/serializer_pool.h>
+
+#include "tests_common.h"
+
+
+class SingleSerializer : public tsw::BsonSerializer
+{
+public:
+    std::unique_ptr<tsw::Serializer> Clone() const override { return nullptr; }
+    bool Cloneable() const override { return false; }
+};
+
+
+// Serialize messages from the several threads.
+static void serialize_in_threads(tsw::impl::SerializerPool &pool, size_t threads_count, size_t iterations,
+                                 std::atomic<size_t> &errors)
+{
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&pool, &errors, t, iterations]()
+        {
+            tsw::BsonDeserializer deserializer;
+            tsw::Message message(tsw::MessageType::Event, tsw::NameValueMap
+            {
+                std::make_pair("thread", static_cast<int32_t>(t)),
+                std::make_pair("samples", tsw::DoubleArray(32, 0.5))
+            });
+
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                auto context = pool.acquire();
+                context->serializer->SerializeMessageTo(message, context->buffer);
+                if (i % 1000) continue;
+
+                // Check, that another thread didn't corrupt the buffer.
+                auto fields = deserializer.DeserializeObject(context->buffer)["fields"].as_object();
+                if (fields["thread"].as_int32() != static_cast<int32_t>(t)) ++errors;
+            }
+        });
+    }
+
+    for (auto &thread: threads) thread.join();
+}
+
+
+TEST(SerializerPool, ConcurrentSerialization)
+{
+    tsw::impl::SerializerPool pool(std::make_shared<tsw::BsonSerializer>());
+    std::atomic<size_t> errors(0);
+    const size_t threads_count = std::max(2u, std::thread::hardware_concurrency());
+
+    serialize_in_threads(pool, threads_count, 50000, errors);
+    EXPECT_EQ(errors, 0);
+}
+
+
+TEST(SerializerPool, NonCloneableSerializer)
+{
+    tsw::impl::SerializerPool pool(std::make_shared<SingleSerializer>());
+    std::atomic<size_t> errors(0);
+
+    serialize_in_threads(pool, 4, 5000, errors);
+    EXPECT_EQ(errors, 0);
+}
+
+
+TEST(SerializerPool, Format)
+{
+    EXPECT_EQ(tsw::impl::SerializerPool(std::make_shared<tsw::BsonSerializer>()).format(), tsw::WireFormat::Bson);
+    EXPECT_EQ(tsw::impl::SerializerPool(tsw::make_serializer(tsw::WireFormat::Cbor)).format(), tsw::WireFormat::Cbor);
+    EXPECT_EQ(tsw::impl::SerializerPool(tsw::make_serializer(tsw::WireFormat::Json)).format(), tsw::WireFormat::Json);
+    EXPECT_EQ(tsw::impl::SerializerPool(std::make_shared<tsw::EnvelopeSerializer>()).format(), tsw::WireFormat::Envelope);
+}
+
+
+TEST(SerializerPool, ContextReuse)
+{
+    tsw::impl::SerializerPool pool(std::make_shared<tsw::BsonSerializer>());
+    const tsw::Serializer *serializer;
+
+    {
+        auto context = pool.acquire();
+        serializer = context->serializer;
+        context->serializer->SerializeMessageTo(tsw::Message(tsw::MessageType::Event, tsw::Object()), context->buffer);
+    }
+
+    auto context = pool.acquire();
+    EXPECT_EQ(context->serializer, serializer);
+    EXPECT_FALSE(context->buffer.empty());
+}
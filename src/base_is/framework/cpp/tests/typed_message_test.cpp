@@ -0,0 +1,217 @@
+/**
+  * @file typed_message_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief TSW_MESSAGE structs and direct fields (de)serialization tests.
+  *
+  */
+
+#include <chrono>
+
+#include <tsw/bson_deserializer.h>
+#include <tsw/bson_serializer.h>
+#include <tsw/error.h>
+#include <tsw/message.h>
+#include <tsw/typed_message.h>
+#include <tsw/wire_format.h>
+
+#include "tests_common.h"
+
+
+TSW_MESSAGE(Position, (double, x), (double, y))
+
+TSW_MESSAGE(SensorEvent,
+            (int32_t, counter),
+            (int64_t, sequence),
+            (double, value),
+            (bool, valid),
+            (tsw::String, unit),
+            (tsw::Time, m_time),
+            (tsw::BinData, raw),
+            (tsw::DoubleArray, samples),
+            (tsw::Int32Array, codes),
+            (Position, position))
+
+
+static SensorEvent sensor_event()
+{
+    SensorEvent event;
+
+    event.counter = 123;
+    event.sequence = 1LL << 40;
+    event.value = 0.777;
+    event.valid = true;
+    event.unit = "V";
+    event.m_time = tsw::Time(1500000000123456789);
+    event.raw = {0x01, 0x00, 0xff};
+    event.samples = {1.0, 2.5, -3.0};
+    event.codes = {1, -2, 3};
+    event.position = Position{10.5, -20.25};
+
+    return event;
+}
+
+
+static void expect_equal(const SensorEvent &a, const SensorEvent &b)
+{
+    EXPECT_EQ(a.counter, b.counter);
+    EXPECT_EQ(a.sequence, b.sequence);
+    EXPECT_EQ(a.value, b.value);
+    EXPECT_EQ(a.valid, b.valid);
+    EXPECT_EQ(a.unit, b.unit);
+    EXPECT_EQ(a.m_time, b.m_time);
+    EXPECT_EQ(a.raw, b.raw);
+    EXPECT_EQ(a.samples, b.samples);
+    EXPECT_EQ(a.codes, b.codes);
+    EXPECT_EQ(a.position.x, b.position.x);
+    EXPECT_EQ(a.position.y, b.position.y);
+}
+
+
+TEST(TypedMessage, Traits)
+{
+    EXPECT_TRUE(tsw::is_typed_message<SensorEvent>::value);
+    EXPECT_FALSE(tsw::is_typed_message<tsw::Object>::value);
+    EXPECT_STREQ(SensorEvent::message_name, "SensorEvent");
+
+    // TSW_MESSAGE with such field isn't compiled.
+    static_assert(tsw::detail::is_message_name_field("name"));
+    static_assert(!tsw::detail::is_message_name_field("names"));
+    static_assert(!tsw::detail::is_message_name_field("nam"));
+}
+
+
+TEST(TypedMessage, ObjectRoundTrip)
+{
+    auto event = sensor_event();
+    auto object = tsw::to_object(event);
+
+    EXPECT_EQ(object["counter"], tsw::Value(123));
+    EXPECT_EQ(object["unit"], tsw::Value("V"));
+    EXPECT_EQ(object["position"].as_object()["y"], tsw::Value(-20.25));
+
+    expect_equal(tsw::from_object<SensorEvent>(object), event);
+
+    // Absent fields keep defaults, fields with another type are rejected.
+    object.erase("unit");
+    EXPECT_EQ(tsw::from_object<SensorEvent>(object).unit, "");
+    object["counter"] = "123";
+    EXPECT_THROW(tsw::from_object<SensorEvent>(object), tsw::Exception);
+}
+
+
+TEST(TypedMessage, BsonRoundTrip)
+{
+    auto event = sensor_event();
+    auto data = tsw::to_bson(event);
+
+    expect_equal(tsw::from_bson<SensorEvent>(data), event);
+
+    // Direct encoding keeps the declaration order, but has the same content, as the Object encoding.
+    EXPECT_EQ(data.size(), tsw::BsonSerializer().SerializeObject(tsw::to_object(event)).size());
+    EXPECT_EQ(tsw::BsonDeserializer().DeserializeObject(data), tsw::to_object(event));
+}
+
+
+TEST(TypedMessage, SerializeFields)
+{
+    auto event = sensor_event();
+    tsw::BsonSerializer serializer;
+    tsw::BsonDeserializer deserializer;
+    tsw::Message envelope(tsw::MessageType::Event, tsw::NameValueMap(), -1);
+    tsw::BinData buffer;
+
+    serializer.SerializeFieldsTo(envelope, [&event](tsw::FieldWriter &writer)
+    {
+        writer.write(tsw::typed_message_name_field, SensorEvent::message_name);
+        tsw::write_fields(writer, event);
+    }, buffer);
+
+    auto message = deserializer.DeserializeMessage(buffer);
+    auto expected = tsw::to_object(event);
+
+    expected[tsw::typed_message_name_field] = SensorEvent::message_name;
+
+    EXPECT_EQ(message.get_type(), tsw::MessageType::Event);
+    EXPECT_EQ(message.get_creation_time(), envelope.get_creation_time());
+
+    SensorEvent result;
+    EXPECT_TRUE(tsw::read_message(message, SensorEvent::message_name,
+                                  [&result](tsw::FieldReader &reader) { tsw::read_fields(reader, result); }));
+    expect_equal(result, event);
+    EXPECT_FALSE(tsw::read_message(message, Position::message_name, [](tsw::FieldReader&) {}));
+
+    EXPECT_EQ(message.get_fields(), expected);
+
+    // Message, created from the Object, is read by the same way.
+    tsw::Message plain(tsw::MessageType::Event, expected);
+    SensorEvent plain_result;
+    EXPECT_TRUE(tsw::read_message(plain, SensorEvent::message_name,
+                                  [&plain_result](tsw::FieldReader &reader) { tsw::read_fields(reader, plain_result); }));
+    expect_equal(plain_result, event);
+}
+
+
+TEST(TypedMessage, SerializeFieldsEnvelope)
+{
+    tsw::Message envelope(tsw::MessageType::Event, tsw::NameValueMap(), 5);
+
+    envelope.set_ttl(std::chrono::seconds(10));
+    envelope.set_id(42);
+
+    // Deadline and identifier are kept by the direct and by the collecting encoding.
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::Cbor })
+    {
+        tsw::BinData buffer;
+
+        tsw::make_serializer(format)->SerializeFieldsTo(envelope, [](tsw::FieldWriter &writer)
+        {
+            writer.write("counter", int32_t(1));
+        }, buffer);
+
+        auto message = tsw::make_deserializer(format)->DeserializeMessage(buffer);
+
+        EXPECT_EQ(message.get_receiver_module_uid(), 5);
+        EXPECT_EQ(message.get_deadline(), envelope.get_deadline());
+        EXPECT_EQ(message.get_id(), 42u);
+        EXPECT_EQ(message.get_fields().at("counter"), tsw::Value(1));
+    }
+}
+
+
+TEST(TypedMessage, JsonRoundTrip)
+{
+    auto event = sensor_event();
+
+    expect_equal(tsw::from_json<SensorEvent>(tsw::to_json(event)), event);
+}
+
+
+TEST(TypedMessage, WireFormats)
+{
+    auto event = sensor_event();
+    tsw::Message envelope(tsw::MessageType::Event, tsw::NameValueMap(), -1);
+
+    // Small integers, which text and compact formats decode as Int32, are widened.
+    event.sequence = 7;
+    event.value = 2.0;
+
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::Json, tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor,
+                        tsw::WireFormat::Envelope })
+    {
+        tsw::BinData buffer;
+
+        tsw::make_serializer(format)->SerializeFieldsTo(envelope, [&event](tsw::FieldWriter &writer)
+        {
+            writer.write(tsw::typed_message_name_field, SensorEvent::message_name);
+            tsw::write_fields(writer, event);
+        }, buffer);
+
+        auto message = tsw::make_deserializer(format)->DeserializeMessage(buffer);
+        SensorEvent result;
+
+        EXPECT_TRUE(tsw::read_message(message, SensorEvent::message_name,
+                                      [&result](tsw::FieldReader &reader) { tsw::read_fields(reader, result); }))
+            << tsw::wire_format_name(format);
+        expect_equal(result, event);
+    }
+}
@@ -173,3 +173,21 @@ TEST(Value, ObjectValue)
     EXPECT_EQ(v1.value_type(), tsw::ValueType::Object);
     EXPECT_NE(v1.value_type(), tsw::ValueType::String);
 }
+
+
+TEST(Value, PackedArrayValue)
+{
+    tsw::Value v1 = tsw::DoubleArray{0.5, 1.5, -2.0};
+    tsw::Value v2 = tsw::Int32Array{1, 2, 3};
+
+    EXPECT_TRUE(v1.is_double_array());
+    EXPECT_FALSE(v1.is_array());
+    EXPECT_EQ(v1.value_type(), tsw::ValueType::DoubleArray);
+    EXPECT_EQ(v1.as_double_array()[2], -2.0);
+
+    EXPECT_TRUE(v2.is_int32_array());
+    EXPECT_EQ(v2.value_type(), tsw::ValueType::Int32Array);
+    EXPECT_NO_THROW(v2.as_int32_array().push_back(4));
+    EXPECT_EQ(v2.as_int32_array().size(), 4);
+    EXPECT_THROW(v2.as_double_array(), std::bad_variant_access);
+}
@@ -0,0 +1,228 @@
+/**
+  * @file wire_format_test.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Wire formats recognition, negotiation and comparison tests.
+  *
+  */
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <tsw/error.h>
+#include <tsw/message.h>
+#include <tsw/metadata.h>
+#include <tsw/schema_registry.h>
+#include <tsw/wire_format.h>
+
+#include "tests_common.h"
+
+
+// Typical bus traffic: small events, actions with the parameters, module descriptions and bulk samples.
+static std::vector<tsw::Message> messages_mix()
+{
+    std::vector<tsw::Message> result;
+
+    result.emplace_back(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "sensor_event"),
+        std::make_pair("value", 0.777),
+        std::make_pair("counter", 123),
+        std::make_pair("unit", "V"),
+        std::make_pair("m_time", tsw::Time(1500000000123456789))
+    });
+
+    result.emplace_back(tsw::MessageType::Action, tsw::NameValueMap
+    {
+        std::make_pair("name", "set_mode"),
+        std::make_pair("mode", "auto"),
+        std::make_pair("timeout", int64_t(5000)),
+        std::make_pair("force", false)
+    });
+
+    result.emplace_back(tsw::MessageType::IntegrateModule, tsw::NameValueMap
+    {
+        std::make_pair("name", "module_description"),
+        std::make_pair("events", tsw::ValueArray
+        {
+            tsw::Object{ {"name", "sensor_event"}, {"description", "Sensor measurement"}, {"fields_count", 5} },
+            tsw::Object{ {"name", "alarm"}, {"description", "Sensor alarm"}, {"fields_count", 2} }
+        }),
+        std::make_pair("actions", tsw::ValueArray
+        {
+            tsw::Object{ {"name", "set_mode"}, {"description", "Set sensor mode"}, {"fields_count", 3} }
+        })
+    });
+
+    result.emplace_back(tsw::MessageType::Event, tsw::NameValueMap
+    {
+        std::make_pair("name", "samples_event"),
+        std::make_pair("samples", tsw::DoubleArray(1000, 0.5)),
+        std::make_pair("raw", tsw::BinData(512, 0x55))
+    });
+
+    return result;
+}
+
+
+TEST(WireFormat, Names)
+{
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::Json, tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor,
+                        tsw::WireFormat::Envelope, tsw::WireFormat::Schema })
+    {
+        EXPECT_EQ(tsw::wire_format_from_name(tsw::wire_format_name(format)), format);
+    }
+
+    EXPECT_EQ(tsw::wire_format_from_name("xml"), tsw::WireFormat::Unknown);
+}
+
+
+TEST(WireFormat, Detection)
+{
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor })
+    {
+        auto serializer = tsw::make_serializer(format);
+
+        for (const auto &message: messages_mix())
+        {
+            auto data = serializer->SerializeMessage(message);
+            EXPECT_EQ(tsw::detect_wire_format(data.data(), data.size()), format) << tsw::wire_format_name(format);
+        }
+
+        auto data = serializer->SerializeObject(tsw::Object());
+        EXPECT_EQ(tsw::detect_wire_format(data.data(), data.size()), format) << tsw::wire_format_name(format);
+    }
+
+    // Enveloped objects are BSON documents.
+    auto serializer = tsw::make_serializer(tsw::WireFormat::Envelope);
+
+    for (const auto &message: messages_mix())
+    {
+        auto data = serializer->SerializeMessage(message);
+        EXPECT_EQ(tsw::detect_wire_format(data.data(), data.size()), tsw::WireFormat::Envelope);
+    }
+
+    // Compact frames are encoded by the registered and confirmed schemes only.
+    auto registry = std::make_shared<tsw::SchemaRegistry>();
+
+    registry->confirm_scheme(registry->register_scheme(tsw::MessageType::Event, tsw::EAMetadata("sensor_event", nullptr, "",
+    tsw::FieldUIDFieldHeaderMap
+    {
+        { 1, tsw::FieldHeader{ 1, tsw::ValueType::DoubleNumber, "value", 0, "" } }
+    })));
+
+    EXPECT_THROW(tsw::make_serializer(tsw::WireFormat::Schema), tsw::Exception);
+
+    auto data = tsw::make_serializer(tsw::WireFormat::Schema, registry)->SerializeMessage(tsw::Message(tsw::MessageType::Event,
+                tsw::NameValueMap{ std::make_pair("name", "sensor_event"), std::make_pair("value", 0.777) }));
+    EXPECT_EQ(tsw::detect_wire_format(data.data(), data.size()), tsw::WireFormat::Schema);
+
+    const tsw::BinData garbage{'x', 'y', 'z'};
+    EXPECT_EQ(tsw::detect_wire_format(garbage.data(), garbage.size()), tsw::WireFormat::Unknown);
+    EXPECT_EQ(tsw::detect_wire_format(garbage.data(), 0), tsw::WireFormat::Unknown);
+}
+
+
+TEST(WireFormat, Choice)
+{
+    const tsw::WireFormats supported{ tsw::WireFormat::Bson, tsw::WireFormat::Cbor };
+
+    // Offering side preference wins.
+    EXPECT_EQ(tsw::choose_wire_format(tsw::ValueArray{"msgpack", "cbor", "bson"}, supported), tsw::WireFormat::Cbor);
+    EXPECT_EQ(tsw::choose_wire_format(tsw::ValueArray{"xml", 1, "bson"}, supported), tsw::WireFormat::Bson);
+    EXPECT_EQ(tsw::choose_wire_format(tsw::ValueArray{"msgpack"}, supported), tsw::WireFormat::Unknown);
+    EXPECT_EQ(tsw::choose_wire_format(tsw::ValueArray{"cbor"}, tsw::WireFormats()), tsw::WireFormat::Unknown);
+}
+
+
+TEST(WireFormat, Deadline)
+{
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::Json, tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor,
+                        tsw::WireFormat::Envelope })
+    {
+        auto message = messages_mix().front();
+        auto serializer = tsw::make_serializer(format);
+        auto deserializer = tsw::make_deserializer(format);
+
+        EXPECT_FALSE(deserializer->DeserializeMessage(serializer->SerializeMessage(message)).has_deadline())
+            << tsw::wire_format_name(format);
+
+        message.set_ttl(std::chrono::seconds(5));
+
+        auto data = serializer->SerializeMessage(message);
+
+        EXPECT_EQ(deserializer->DeserializeMessage(data).get_deadline(), message.get_deadline())
+            << tsw::wire_format_name(format);
+
+        // Recycled message gets the deadline too.
+        tsw::Message recycled(tsw::MessageType::Event, tsw::NameValueMap());
+
+        deserializer->DeserializeMessageTo(data.data(), data.size(), recycled);
+        EXPECT_EQ(recycled.get_deadline(), message.get_deadline()) << tsw::wire_format_name(format);
+    }
+}
+
+
+TEST(WireFormat, MessageId)
+{
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::Json, tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor,
+                        tsw::WireFormat::Envelope })
+    {
+        auto message = messages_mix().front();
+        auto serializer = tsw::make_serializer(format);
+        auto deserializer = tsw::make_deserializer(format);
+
+        EXPECT_EQ(deserializer->DeserializeMessage(serializer->SerializeMessage(message)).get_id(), 0u)
+            << tsw::wire_format_name(format);
+
+        message.set_id(0x123456789abcdefull);
+        message.set_ttl(std::chrono::seconds(5));
+
+        auto data = serializer->SerializeMessage(message);
+        auto result = deserializer->DeserializeMessage(data);
+
+        EXPECT_EQ(result.get_id(), message.get_id()) << tsw::wire_format_name(format);
+        EXPECT_EQ(result.get_deadline(), message.get_deadline()) << tsw::wire_format_name(format);
+
+        tsw::Message recycled(tsw::MessageType::Event, tsw::NameValueMap());
+
+        recycled.set_id(1);
+        deserializer->DeserializeMessageTo(data.data(), data.size(), recycled);
+        EXPECT_EQ(recycled.get_id(), message.get_id()) << tsw::wire_format_name(format);
+    }
+}
+
+
+TEST(WireFormat, PatchUids)
+{
+    for (auto format: { tsw::WireFormat::Bson, tsw::WireFormat::Envelope })
+    {
+        auto deserializer = tsw::make_deserializer(format);
+
+        for (const auto &message: messages_mix())
+        {
+            auto data = tsw::make_serializer(format)->SerializeMessage(message);
+            auto received = deserializer->DeserializeMessage(data);
+
+            ASSERT_NE(received.get_received_frame(), nullptr);
+            EXPECT_EQ(*received.get_received_frame(), data);
+
+            ASSERT_TRUE(tsw::patch_message_uids(data.data(), data.size(), 11, 22)) << tsw::wire_format_name(format);
+
+            auto result = deserializer->DeserializeMessage(data);
+
+            EXPECT_EQ(result.get_sender_module_uid(), 11u);
+            EXPECT_EQ(result.get_receiver_module_uid(), 22u);
+            EXPECT_EQ(result.get_type(), message.get_type());
+            EXPECT_EQ(result.get_fields(), message.get_fields());
+        }
+    }
+
+    for (auto format: { tsw::WireFormat::Json, tsw::WireFormat::MsgPack, tsw::WireFormat::Cbor })
+    {
+        auto data = tsw::make_serializer(format)->SerializeMessage(messages_mix().front());
+
+        EXPECT_FALSE(tsw::patch_message_uids(data.data(), data.size(), 11, 22));
+        EXPECT_EQ(tsw::make_deserializer(format)->DeserializeMessage(data).get_received_frame(), nullptr);
+    }
+}
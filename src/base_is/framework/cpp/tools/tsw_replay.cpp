@@ -0,0 +1,100 @@
+/**
+  * @file tsw_replay.cpp
+  * @author Artiom N.(cl)2017
+  * @brief Replay of the captured Magistral frames against the endpoint for the load testing.
+  *
+  * @code
+  * tsw_replay --speed 4 traffic.cap client:tcp://localhost:12345
+  * tsw_replay --max --received server.cap client:ipc:///tmp/feeds/0
+  * @endcode
+  * Frames, which were expired or had identifiers, are dropped by the receiver as they were in the capture:
+  * counters of the expired and duplicate messages show them.
+  */
+
+#include <chrono>
+#include <csignal>
+#include <iostream>
+
+#include <args.hxx>
+
+#include <tsw/magistral.h>
+#include <tsw/message_capture.h>
+
+
+static tsw::CaptureReplayer *running_replayer = nullptr;
+
+
+static void stop_replay(int)
+{
+    if (running_replayer) running_replayer->stop();
+}
+
+
+int main(int argc, const char *argv[])
+{
+    args::ArgumentParser parser("Replay captured Magistral frames against the endpoint.");
+    args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
+    args::ValueFlag<double> speed(parser, "speed", "Pace multiplier, 1 is the original pace", {'s', "speed"}, 1);
+    args::Flag max_speed(parser, "max", "Send frames as fast as possible", {'m', "max"});
+    args::Flag received(parser, "received", "Replay received frames instead of the sent ones", {'r', "received"});
+    args::ValueFlag<int> timeout(parser, "timeout", "Sending timeout in milliseconds", {'t', "timeout"}, -1);
+    args::Positional<std::string> capture_path(parser, "capture", "Capture file", args::Options::Required);
+    args::Positional<std::string> endpoint(parser, "endpoint", "Magistral endpoint, i.e. client:tcp://localhost:12345",
+                                           args::Options::Required);
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::Error &e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    try
+    {
+        tsw::CaptureReader reader(args::get(capture_path));
+        tsw::CaptureReplayer::Options options;
+
+        options.speed = max_speed ? 0 : args::get(speed);
+        options.direction = received ? tsw::CaptureDirection::Received : tsw::CaptureDirection::Sent;
+
+        tsw::Magistral magistral(args::get(endpoint));
+        tsw::CaptureReplayer replayer(reader, options);
+        tsw::BinData frame;
+        const int send_timeout = args::get(timeout);
+
+        running_replayer = &replayer;
+        std::signal(SIGINT, stop_replay);
+
+        auto statistics = replayer.run([&](const tsw::CapturedFrame &captured)
+        {
+            frame.assign(captured.data, captured.data + captured.size);
+            magistral.send_serialized(captured.type, frame, send_timeout);
+        });
+
+        running_replayer = nullptr;
+
+        const auto elapsed = std::chrono::duration<double>(statistics.elapsed).count();
+
+        std::cout << "frames: " << statistics.frames << ", bytes: " << statistics.bytes
+                  << ", elapsed: " << elapsed << " s";
+        if (elapsed > 0) std::cout << ", rate: " << static_cast<uint64_t>(statistics.frames / elapsed) << " frames/s";
+        std::cout << ", max lag: " << std::chrono::duration_cast<std::chrono::microseconds>(statistics.max_lag).count()
+                  << " us" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}